@@ -13,6 +13,7 @@
 
 #include <omp.h>
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN 1
 #define NOMINMAX
 #define _WIN32_WINNT 0x0601
@@ -23,6 +24,15 @@ int64_t timestamp() {
 	::QueryPerformanceCounter(&ctr);
 	return ctr.QuadPart;
 }
+#else
+#include <time.h>
+
+int64_t timestamp() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
 
 //---------------------------------------------------------------
 enum E_MOT_TRK { POS, ROT, SCL };
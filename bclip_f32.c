@@ -3,11 +3,49 @@
 
 /* Convert track data in Houdini bclip files into 32-bit floats. */
 
+/*
+ * The top-level packets are indexed in one pass, the output size is known
+ * from the track packet headers, and the converted clip is written straight
+ * into a mapping of the output file. Samples are swapped, narrowed and
+ * swapped back two or four at a time (SSE2/NEON), the result is the same
+ * as a per-sample (float) cast.
+ * With -dir all .bclip files in a directory are converted by a pool of
+ * threads (POSIX builds need -pthread).
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#	define _GNU_SOURCE
+#endif
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN 1
+#	define NOMINMAX
+#	include <Windows.h>
+#else
+#	include <dirent.h>
+#	include <fcntl.h>
+#	include <pthread.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#if !defined(BCLIP_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#	define BCLIP_SIMD_SSE2 1
+#	include <emmintrin.h>
+#elif !defined(BCLIP_NO_SIMD) && (defined(__aarch64__) || defined(_M_ARM64))
+#	define BCLIP_SIMD_NEON 1
+#	include <arm_neon.h>
+#endif
+
+#define BCLIP_MAX_TAG (0x10)
+#define BCLIP_MAX_THREADS (256)
+
 static const char* s_pSig = "bclp";
 
 static uint32_t hbinU32(const uint8_t* pMem) {
@@ -28,10 +66,6 @@ static uint16_t hbinU16(const uint8_t* pMem) {
 	return (b0 | (b1 << 8));
 }
 
-static int16_t hbinI16(const uint8_t* pMem) {
-	return (int16_t)hbinU16(pMem);
-}
-
 static float hbinF32(const uint8_t* pMem) {
 	float f;
 	uint32_t u = hbinU32(pMem);
@@ -39,69 +73,96 @@ static float hbinF32(const uint8_t* pMem) {
 	return f;
 }
 
-static float hbinF64(const uint8_t* pMem) {
+static double hbinF64(const uint8_t* pMem) {
 	double d;
-	int i;
-	uint8_t b[8];
-	/* assume LE */
-	for (i = 0; i < 8; ++i) {
-		b[7 - i] = pMem[i];
-	}
-	memcpy(&d, b, sizeof(double));
+	uint64_t u = ((uint64_t)hbinU32(pMem) << 32) | hbinU32(pMem + 4);
+	memcpy(&d, &u, sizeof(double));
 	return d;
 }
 
-static size_t file_size(FILE* pFile) {
-	size_t size = 0;
-	if (pFile) {
-		long fpos = ftell(pFile);
-		if (fpos >= 0) {
-			if (fseek(pFile, 0, SEEK_END) == 0) {
-				long flen = ftell(pFile);
-				if (flen >= 0) {
-					size = (size_t)flen;
-				}
-			}
-			fseek(pFile, fpos, SEEK_SET);
-		}
-	}
-	return size;
+static void patch_u32(uint8_t* pDst, const uint32_t x) {
+	pDst[0] = (uint8_t)((x >> 24) & 0xFF);
+	pDst[1] = (uint8_t)((x >> 16) & 0xFF);
+	pDst[2] = (uint8_t)((x >> 8) & 0xFF);
+	pDst[3] = (uint8_t)(x & 0xFF);
 }
 
-static size_t file_read(FILE* pFile, void* pDst, size_t size) {
-	size_t nread = 0;
-	if (pFile && pDst && size > 0) {
-		nread = fread(pDst, 1, size, pFile);
-	}
-	return nread;
-}
+typedef struct _BIN_MAP {
+	uint8_t* pMem;
+	size_t size;
+	void* hMap;
+} BIN_MAP;
 
-static void* bin_load(const char* pPath, size_t* pSize) {
-	void* pData = NULL;
-	size_t size = 0;
-	if (pPath) {
-		FILE* pFile = fopen(pPath, "rb");
-		if (pFile) {
-			size = file_size(pFile);
-			if (size > 0) {
-				pData = malloc(size);
-				if (pData) {
-					fseek(pFile, 0, SEEK_SET);
-					size = file_read(pFile, pData, size);
-				}
-			}
-			fclose(pFile);
+/* read-only mapping of a file, or a writable one of a new file of the given size */
+static int bin_map(BIN_MAP* pMap, const char* pPath, size_t newSize) {
+	memset(pMap, 0, sizeof(BIN_MAP));
+	if (!pPath) return 0;
+#if defined(_WIN32)
+	{
+		int wr = newSize > 0;
+		HANDLE hFile = CreateFileA(pPath, wr ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, wr ? 0 : FILE_SHARE_READ, NULL,
+		                           wr ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		LARGE_INTEGER len;
+		HANDLE hMap = NULL;
+		if (hFile == INVALID_HANDLE_VALUE) return 0;
+		len.QuadPart = (LONGLONG)newSize;
+		if (wr || (GetFileSizeEx(hFile, &len) && len.QuadPart > 0)) {
+			hMap = CreateFileMappingA(hFile, NULL, wr ? PAGE_READWRITE : PAGE_READONLY, (DWORD)(len.QuadPart >> 32), (DWORD)len.QuadPart, NULL);
+		}
+		CloseHandle(hFile);
+		if (!hMap) return 0;
+		pMap->pMem = (uint8_t*)MapViewOfFile(hMap, wr ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+		if (!pMap->pMem) {
+			CloseHandle(hMap);
+			return 0;
 		}
+		pMap->size = (size_t)len.QuadPart;
+		pMap->hMap = hMap;
 	}
-	if (pSize) {
-		*pSize = size;
+#else
+	{
+		struct stat st;
+		void* pMem = MAP_FAILED;
+		int wr = newSize > 0;
+		int fd = wr ? open(pPath, O_RDWR | O_CREAT | O_TRUNC, 0644) : open(pPath, O_RDONLY);
+		if (fd < 0) return 0;
+		if (wr) {
+			if (ftruncate(fd, (off_t)newSize) == 0) {
+				pMem = mmap(NULL, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			}
+		} else if (fstat(fd, &st) == 0 && st.st_size > 0) {
+			newSize = (size_t)st.st_size;
+			pMem = mmap(NULL, newSize, PROT_READ, MAP_SHARED, fd, 0);
+		}
+		close(fd);
+		if (pMem == MAP_FAILED) return 0;
+		pMap->pMem = (uint8_t*)pMem;
+		pMap->size = newSize;
 	}
-	return pData;
+#endif
+	return 1;
+}
+
+static void bin_unmap(BIN_MAP* pMap) {
+	if (!pMap->pMem) return;
+#if defined(_WIN32)
+	UnmapViewOfFile(pMap->pMem);
+	CloseHandle((HANDLE)pMap->hMap);
+#else
+	munmap(pMap->pMem, pMap->size);
+#endif
+	memset(pMap, 0, sizeof(BIN_MAP));
 }
 
-static int bclip_valid(const void* pBclip) {
+/* top-level packets by tag, filled in one pass over the file */
+typedef struct _BCLIP_IDX {
+	const uint8_t* pPkts[BCLIP_MAX_TAG];
+	size_t size;
+} BCLIP_IDX;
+
+static int bclip_valid(const void* pBclip, size_t size) {
 	int res = 0;
-	if (pBclip) {
+	if (pBclip && size >= 0x10) {
 		if (memcmp(pBclip, s_pSig, 4) == 0) {
 			res = 1;
 		}
@@ -109,144 +170,158 @@ static int bclip_valid(const void* pBclip) {
 	return res;
 }
 
-static const uint8_t* bclip_find_pkt(const void* pBclip, const int32_t pktTag) {
-	const uint8_t* pPkt = NULL;
-	if (bclip_valid(pBclip)) {
-		const uint8_t* pTop = (const uint8_t*)pBclip;
-		const uint8_t* pMem = pTop + 4;
-		while (1) {
-			int32_t pktSize = hbinI32(pMem);
-			if (pktSize > 0) {
-				uint16_t tag = hbinU16(pMem + 4);
-				if (tag != 0xF) { break; }
-				tag = hbinU16(pMem + 6);
-				if (tag == pktTag) { pPkt = pMem; break; }
-				if (tag == 0) { /* END */ break; }
-				pMem += pktSize;
-			} else {
-				break;
-			}
+static int bclip_index(BCLIP_IDX* pIdx, const void* pBclip, size_t size) {
+	const uint8_t* pTop = (const uint8_t*)pBclip;
+	size_t offs = 4;
+	memset(pIdx, 0, sizeof(BCLIP_IDX));
+	if (!bclip_valid(pBclip, size)) return 0;
+	pIdx->size = size;
+	while (offs + 8 <= size) {
+		const uint8_t* pMem = pTop + offs;
+		uint32_t pktSize = hbinU32(pMem);
+		uint16_t tag;
+		if (pktSize < 8 || pktSize > size - offs) break;
+		if (hbinU16(pMem + 4) != 0xF) break;
+		tag = hbinU16(pMem + 6);
+		if (tag < BCLIP_MAX_TAG && !pIdx->pPkts[tag]) {
+			pIdx->pPkts[tag] = pMem;
 		}
+		if (tag == 0) { /* END */ break; }
+		offs += pktSize;
 	}
-	return pPkt;
+	return 1;
 }
 
-static int32_t bclip_version(const void* pBclip) {
-	int32_t ver = 0;
-	const uint8_t* pVer = bclip_find_pkt(pBclip, 9);
-	if (pVer) { ver = hbinI32(pVer + 8); }
-	return ver;
+/* packet with at least minSize bytes, NULL if absent */
+static const uint8_t* bclip_pkt(const BCLIP_IDX* pIdx, const int32_t pktTag, const uint32_t minSize) {
+	const uint8_t* pPkt = pIdx->pPkts[pktTag];
+	return pPkt && hbinU32(pPkt) >= minSize ? pPkt : NULL;
 }
 
-static int bclip_is_data_f64(const void* pBclip) {
-	int res = 0;
-	const uint8_t* pTyp = bclip_find_pkt(pBclip, 8);
-	if (pTyp) { res = !!pTyp[8]; }
-	return res;
+static int32_t bclip_version(const BCLIP_IDX* pIdx) {
+	const uint8_t* pVer = bclip_pkt(pIdx, 9, 12);
+	return pVer ? hbinI32(pVer + 8) : 0;
 }
 
-static int bclip_is_info_f64(const void* pBclip) {
-	int res = 0;
-	const uint8_t* pTyp = bclip_find_pkt(pBclip, 0xA);
-	if (pTyp) { res = !!pTyp[8]; }
-	return res;
+static int bclip_is_data_f64(const BCLIP_IDX* pIdx) {
+	const uint8_t* pTyp = bclip_pkt(pIdx, 8, 9);
+	return pTyp ? !!pTyp[8] : 0;
 }
 
-static float bclip_sample_rate(const void* pBclip) {
-	float rate = 0.0f;
-	const uint8_t* pRate = bclip_find_pkt(pBclip, 1);
-	if (pRate) {
-		if (bclip_is_info_f64(pBclip)) {
-			rate = (float)hbinF64(pRate + 8);
-		} else {
-			rate = hbinF32(pRate + 8);
-		}
-	}
-	return rate;
+static int bclip_is_info_f64(const BCLIP_IDX* pIdx) {
+	const uint8_t* pTyp = bclip_pkt(pIdx, 0xA, 9);
+	return pTyp ? !!pTyp[8] : 0;
 }
 
-static float bclip_start_index(const void* pBclip) {
-	float start = 0.0f;
-	const uint8_t* pStart = bclip_find_pkt(pBclip, 2);
-	if (pStart) {
-		if (bclip_is_info_f64(pBclip)) {
-			start = (float)hbinF64(pStart + 8);
-		} else {
-			start = hbinF32(pStart + 8);
-		}
-	}
-	return start;
+static float bclip_info_val(const BCLIP_IDX* pIdx, const int32_t pktTag) {
+	int f64 = bclip_is_info_f64(pIdx);
+	const uint8_t* pVal = bclip_pkt(pIdx, pktTag, f64 ? 16 : 12);
+	if (!pVal) return 0.0f;
+	return f64 ? (float)hbinF64(pVal + 8) : hbinF32(pVal + 8);
 }
 
-static int32_t bclip_track_length(const void* pBclip) {
-	int32_t len = 0;
-	const uint8_t* pLen = bclip_find_pkt(pBclip, 3);
-	if (pLen) { len = hbinI32(pLen + 8); }
-	return len;
+static float bclip_sample_rate(const BCLIP_IDX* pIdx) {
+	return bclip_info_val(pIdx, 1);
 }
 
-static int32_t bclip_num_tracks(const void* pBclip) {
-	int32_t num = 0;
-	const uint8_t* pTrk = bclip_find_pkt(pBclip, 5);
-	if (pTrk) { num = hbinI32(pTrk + 8); }
-	return num;
+static float bclip_start_index(const BCLIP_IDX* pIdx) {
+	return bclip_info_val(pIdx, 2);
 }
 
-static uint32_t bclip_track_data_size(const void* pBclip) {
-	uint32_t size = 0;
-	const uint8_t* pTrk = bclip_find_pkt(pBclip, 5);
-	if (pTrk) { size = hbinU32(pTrk); }
-	return size;
+static int32_t bclip_track_length(const BCLIP_IDX* pIdx) {
+	const uint8_t* pLen = bclip_pkt(pIdx, 3, 12);
+	return pLen ? hbinI32(pLen + 8) : 0;
 }
 
-static void patch_u32(uint8_t* pDst, const uint32_t x) {
-	pDst[0] = (uint8_t)((x >> 24) & 0xFF);
-	pDst[1] = (uint8_t)((x >> 16) & 0xFF);
-	pDst[2] = (uint8_t)((x >> 8) & 0xFF);
-	pDst[3] = (uint8_t)(x & 0xFF);
+static int32_t bclip_num_tracks(const BCLIP_IDX* pIdx) {
+	const uint8_t* pTrk = bclip_pkt(pIdx, 5, 12);
+	return pTrk ? hbinI32(pTrk + 8) : 0;
+}
+
+static uint32_t bclip_track_data_size(const BCLIP_IDX* pIdx) {
+	const uint8_t* pTrk = bclip_pkt(pIdx, 5, 12);
+	return pTrk ? hbinU32(pTrk) : 0;
+}
+
+/* big-endian f64 -> big-endian f32 */
+static void cvt_smps(uint8_t* pDst, const uint8_t* pSrc, int32_t nsmp) {
+	int32_t i = 0;
+#if defined(BCLIP_SIMD_SSE2)
+	for (; i + 4 <= nsmp; i += 4) {
+		__m128i v0 = _mm_loadu_si128((const __m128i*)(pSrc + i*8));
+		__m128i v1 = _mm_loadu_si128((const __m128i*)(pSrc + i*8 + 16));
+		__m128 f;
+		__m128i u;
+		/* reverse the words of each double, then the bytes of each word */
+		v0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v0, 0x1B), 0x1B);
+		v1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v1, 0x1B), 0x1B);
+		v0 = _mm_or_si128(_mm_slli_epi16(v0, 8), _mm_srli_epi16(v0, 8));
+		v1 = _mm_or_si128(_mm_slli_epi16(v1, 8), _mm_srli_epi16(v1, 8));
+		f = _mm_movelh_ps(_mm_cvtpd_ps(_mm_castsi128_pd(v0)), _mm_cvtpd_ps(_mm_castsi128_pd(v1)));
+		u = _mm_castps_si128(f);
+		u = _mm_shufflehi_epi16(_mm_shufflelo_epi16(u, 0xB1), 0xB1);
+		u = _mm_or_si128(_mm_slli_epi16(u, 8), _mm_srli_epi16(u, 8));
+		_mm_storeu_si128((__m128i*)(pDst + i*4), u);
+	}
+#elif defined(BCLIP_SIMD_NEON)
+	for (; i + 4 <= nsmp; i += 4) {
+		float64x2_t d0 = vreinterpretq_f64_u8(vrev64q_u8(vld1q_u8(pSrc + i*8)));
+		float64x2_t d1 = vreinterpretq_f64_u8(vrev64q_u8(vld1q_u8(pSrc + i*8 + 16)));
+		float32x4_t f = vcvt_high_f32_f64(vcvt_f32_f64(d0), d1);
+		vst1q_u8(pDst + i*4, vrev32q_u8(vreinterpretq_u8_f32(f)));
+	}
+#endif
+	for (; i < nsmp; ++i) {
+		float smp = (float)hbinF64(pSrc + i*8);
+		uint32_t u;
+		memcpy(&u, &smp, sizeof(float));
+		patch_u32(pDst + i*4, u);
+	}
 }
 
-static uint8_t* cvt_trk_data(uint8_t* pBuf, const void* pBclip) {
-	const uint8_t* pTrk = NULL;
-	uint8_t* pDst = pBuf;
+/*
+ * Walks the track packets of the TRACKS packet: NAME and END are copied,
+ * DATA is converted, other packets are dropped. With pDst NULL only the
+ * converted size is computed; 0 if the packets are malformed.
+ */
+static size_t cvt_trk_data(uint8_t* pDst, const BCLIP_IDX* pIdx) {
+	const uint8_t* pTrk = bclip_pkt(pIdx, 5, 0xC);
+	const uint8_t* pTrkEnd;
+	size_t size = 0xC;
 	int32_t i;
-	int32_t j;
-	int32_t ntrk = 0;
-	int32_t nsmp = 0;
-	if (!pBuf) return NULL;
-	if (!bclip_valid(pBclip)) return NULL;
-	if (!bclip_is_data_f64(pBclip)) return NULL;
-
-	pTrk = bclip_find_pkt(pBclip, 5);
-	if (!pTrk) return NULL;
-	memcpy(pDst, pTrk, 0xC);
-	pDst += 0xC;
+	int32_t ntrk = bclip_num_tracks(pIdx);
+	int32_t nsmp = bclip_track_length(pIdx);
+	if (!pTrk || !bclip_is_data_f64(pIdx) || ntrk < 0 || nsmp < 0) return 0;
+	pTrkEnd = pTrk + hbinU32(pTrk);
+	if (pDst) {
+		memcpy(pDst, pTrk, 0xC);
+	}
 	pTrk += 0xC;
-	ntrk = bclip_num_tracks(pBclip);
-	nsmp = bclip_track_length(pBclip);
 	for (i = 0; i < ntrk; ++i) {
 		while (1) {
-			int32_t pktLen = hbinI32(pTrk);
-			int32_t pktTag = hbinU16(pTrk + 4);
-			if (pktTag != 0x10) return NULL;
+			uint32_t pktLen;
+			int32_t pktTag;
+			if (pTrkEnd - pTrk < 8) return 0;
+			pktLen = hbinU32(pTrk);
+			if (pktLen < 8 || pktLen > (size_t)(pTrkEnd - pTrk)) return 0;
+			if (hbinU16(pTrk + 4) != 0x10) return 0;
 			pktTag = hbinU16(pTrk + 6);
 			if (pktTag == 1 || pktTag == 0) {
 				/* copy NAME, END */
-				memcpy(pDst, pTrk, pktLen);
-				pDst += pktLen;
+				if (pDst) {
+					memcpy(pDst + size, pTrk, pktLen);
+				}
+				size += pktLen;
 			} else if (pktTag == 2) {
 				/* convert DATA */
-				uint8_t* pData = pDst;
-				memcpy(pDst, pTrk, 8);
-				pDst += 8;
-				const uint8_t* pSrc = pTrk + 8;
-				for (j = 0; j < nsmp; ++j) {
-					float smp = (float)hbinF64(pSrc);
-					patch_u32(pDst, ((uint32_t*)&smp)[0]);
-					pDst += 4;
-					pSrc += 8;
+				uint32_t dataLen = 8 + (uint32_t)nsmp*4;
+				if (pktLen < 8 + (uint64_t)nsmp*8) return 0;
+				if (pDst) {
+					memcpy(pDst + size, pTrk, 8);
+					patch_u32(pDst + size, dataLen);
+					cvt_smps(pDst + size + 8, pTrk + 8, nsmp);
 				}
-				patch_u32(pData, (uint32_t)(pDst - pData));
+				size += dataLen;
 			}
 			pTrk += pktLen;
 			if (pktTag == 0) { /* END */
@@ -254,127 +329,322 @@ static uint8_t* cvt_trk_data(uint8_t* pBuf, const void* pBclip) {
 			}
 		}
 	}
-	patch_u32(pBuf, (uint32_t)(pDst - pBuf));
-	return pDst;
+	if (size > UINT32_MAX) return 0;
+	if (pDst) {
+		patch_u32(pDst, (uint32_t)size);
+	}
+	return size;
+}
+
+static const uint16_t s_infoPkts[] = {
+	0x9, /* VERSION */
+	0xA, /* FLOATFIELDDATATYPE */
+	0x1, /* SAMPLERATE */
+	0x2, /* START */
+	0x8, /* TRACKDATATYPE */
+	0x3  /* TRACKLENGTH */
+};
+
+#define NUM_INFO_PKTS (sizeof(s_infoPkts) / sizeof(s_infoPkts[0]))
+
+static size_t cvt_size(const BCLIP_IDX* pIdx) {
+	size_t size = 4;
+	size_t trkSize = cvt_trk_data(NULL, pIdx);
+	size_t i;
+	if (!trkSize) return 0;
+	for (i = 0; i < NUM_INFO_PKTS; ++i) {
+		const uint8_t* pInfoPkt = bclip_pkt(pIdx, s_infoPkts[i], 9);
+		if (!pInfoPkt) return 0;
+		size += hbinU32(pInfoPkt);
+	}
+	return size + trkSize + 8;
 }
 
-static uint8_t* buf_alloc(const size_t size) {
-	return (uint8_t*)malloc(size);
+static void cvt_clip(uint8_t* pDst, const BCLIP_IDX* pIdx) {
+	static const uint8_t end[] = {0, 0, 0, 8, 0, 0xF, 0, 0};
+	size_t i;
+	memcpy(pDst, s_pSig, 4);
+	pDst += 4;
+	for (i = 0; i < NUM_INFO_PKTS; ++i) {
+		const uint8_t* pInfoPkt = pIdx->pPkts[s_infoPkts[i]];
+		uint32_t infoPktLen = hbinU32(pInfoPkt);
+		memcpy(pDst, pInfoPkt, infoPktLen);
+		if (s_infoPkts[i] == 8) {
+			/* TRACKDATATYPE */
+			pDst[8] = 0;
+		}
+		pDst += infoPktLen;
+	}
+	pDst += cvt_trk_data(pDst, pIdx);
+	memcpy(pDst, end, 8);
 }
 
-static void buf_free(uint8_t* pBuf) {
-	if (pBuf) {
-		free(pBuf);
+static void print_info(const BCLIP_IDX* pIdx) {
+	int32_t ver = bclip_version(pIdx);
+	int infoF64 = bclip_is_info_f64(pIdx);
+	int dataF64 = bclip_is_data_f64(pIdx);
+	float fps = bclip_sample_rate(pIdx);
+	float start = bclip_start_index(pIdx);
+	int32_t tlen = bclip_track_length(pIdx);
+	int32_t ntrk = bclip_num_tracks(pIdx);
+	printf("bclip: %zu bytes\n", pIdx->size);
+	printf("version: %d, infoF64: %s, dataF64: %s\n",
+	       ver, infoF64 ? "yes" : "no", dataF64 ? "yes" : "no");
+	if (fps > 1.0f) {
+		printf("FPS: %.2f\n", fps);
+	} else {
+		printf("FPS: %.10f\n", fps);
+	}
+	printf("start: %.2f\n", start);
+	printf("length: %d (0x%x)\n", tlen, tlen);
+	printf("num tracks: %d (0x%x)\n", ntrk, ntrk);
+	if (dataF64) {
+		printf("trk data size: (0x%x) bytes\n", bclip_track_data_size(pIdx));
 	}
 }
 
-static int exec_cvt(const char* pInPath, const char* pOutPath) {
+/* replaces pDstPath, which may be the file being converted */
+static int file_replace(const char* pSrcPath, const char* pDstPath) {
+#if defined(_WIN32)
+	return !!MoveFileExA(pSrcPath, pDstPath, MOVEFILE_REPLACE_EXISTING);
+#else
+	return rename(pSrcPath, pDstPath) == 0;
+#endif
+}
+
+/*
+ * 0: converted, -1: can't read the input, -2: not a bclip,
+ * -3: no f64 data (nothing to convert), -4: malformed tracks,
+ * -5: can't write the output.
+ * The output is written to <out_path>.tmp and renamed over out_path once
+ * the input is unmapped, so in and out may be the same file.
+ */
+static int exec_cvt(const char* pInPath, const char* pOutPath, int verbose) {
 	int res = 0;
-	int32_t ver = 0;
-	int infoF64 = 0;
-	int dataF64 = 0;
-	float fps = 0.0f;
-	float start = 0.0f;
-	int32_t tlen = 0;
-	int32_t ntrk = 0;
-	void* pBclip = NULL;
-	size_t bclipSize = 0;
-	if (pInPath) {
-		pBclip = bin_load(pInPath, &bclipSize);
-		if (pBclip) {
-			if (bclipSize < 0x10 || !bclip_valid(pBclip)) {
-				res = -2;
-			} else {
-				ver = bclip_version(pBclip);
-				infoF64 = bclip_is_info_f64(pBclip);
-				dataF64 = bclip_is_data_f64(pBclip);
-				fps = bclip_sample_rate(pBclip);
-				start = bclip_start_index(pBclip);
-				tlen = bclip_track_length(pBclip);
-				ntrk = bclip_num_tracks(pBclip);
-				printf("bclip: %ld bytes\n", bclipSize);
-				printf("version: %d, infoF64: %s, dataF64: %s\n",
-				       ver, infoF64 ? "yes" : "no", dataF64 ? "yes" : "no");
-				if (fps > 1.0f) {
-					printf("FPS: %.2f\n", fps);
-				} else {
-					printf("FPS: %.10f\n", fps);
+	BIN_MAP in;
+	BCLIP_IDX idx;
+	char* pTmpPath = NULL;
+	if (!pInPath) return 0;
+	if (!bin_map(&in, pInPath, 0)) return -1;
+	if (!bclip_index(&idx, in.pMem, in.size)) {
+		res = -2;
+	} else {
+		if (verbose) {
+			print_info(&idx);
+		}
+		if (bclip_is_data_f64(&idx) && pOutPath) {
+			size_t outSize = cvt_size(&idx);
+			if (outSize > 0) {
+				BIN_MAP out;
+				size_t pathLen = strlen(pOutPath);
+				pTmpPath = (char*)malloc(pathLen + 5);
+				if (pTmpPath) {
+					memcpy(pTmpPath, pOutPath, pathLen);
+					strcpy(pTmpPath + pathLen, ".tmp");
 				}
-				printf("start: %.2f\n", start);
-				printf("length: %d (0x%x)\n", tlen, tlen);
-				printf("num tracks: %d (0x%x)\n", ntrk, ntrk);
-				if (dataF64 && pOutPath) {
-					size_t i;
-					static uint16_t infoPkts[] = {
-						0x9, /* VERSION */
-						0xA, /* FLOATFIELDDATATYPE */
-						0x1, /* SAMPLERATE */
-						0x2, /* START */
-						0x8, /* TRACKDATATYPE */
-						0x3  /* TRACKLENGTH */
-					};
-					size_t numInfoPkts = sizeof(infoPkts) / sizeof(infoPkts[0]);
-					uint32_t orgTrkSize = bclip_track_data_size(pBclip);
-					printf("trk data size: (0x%x) bytes\n", orgTrkSize);
-					uint32_t tmpSize = 4;
-					for (i = 0; i < numInfoPkts; ++i) {
-						int32_t infoPktTag = infoPkts[i];
-						const uint8_t* pInfoPkt = bclip_find_pkt(pBclip, infoPktTag);
-						if (pInfoPkt) {
-							tmpSize += hbinU32(pInfoPkt);
-						} else {
-							tmpSize = 0;
-							break;
-						}
-					}
-					if (tmpSize > 0) {
-						FILE* pOut = NULL;
-						uint8_t* pBuf = NULL;
-						tmpSize += orgTrkSize + 8;
-						pBuf = buf_alloc(tmpSize);
-						if (pBuf) {
-							uint8_t* pDst = pBuf;
-							memcpy(pDst, s_pSig, 4);
-							pDst += 4;
-							for (i = 0; i < numInfoPkts; ++i) {
-								int32_t infoPktTag = infoPkts[i];
-								const uint8_t* pInfoPkt = bclip_find_pkt(pBclip, infoPktTag);
-								if (pInfoPkt) {
-									uint32_t infoPktLen = hbinU32(pInfoPkt);
-									memcpy(pDst, pInfoPkt, infoPktLen);
-									if (infoPktTag == 8) {
-										/* TRACKDATATYPE */
-										pDst[8] = 0;
-									}
-									pDst += infoPktLen;
-								}
-							}
-							pDst = cvt_trk_data(pDst, pBclip);
-							pOut = fopen(pOutPath, "wb");
-							if (pOut) {
-								static uint8_t end[] = {0, 0, 0, 8, 0, 0xF, 0, 0};
-								memcpy(pDst, end, 8);
-								pDst += 8;
-								size_t outSize = (size_t)(pDst - pBuf);
-								fwrite(pBuf, 1, outSize, pOut);
-								fclose(pOut);
-							}
-							buf_free(pBuf);
-							pBuf = NULL;
-						}
-					}
+				if (pTmpPath && bin_map(&out, pTmpPath, outSize)) {
+					cvt_clip(out.pMem, &idx);
+					bin_unmap(&out);
 				} else {
-					res = -3;
+					res = -5;
 				}
+			} else {
+				res = -4;
 			}
 		} else {
-			res = -1;
+			res = -3;
+		}
+	}
+	bin_unmap(&in);
+	if (pTmpPath) {
+		if (res == 0 && !file_replace(pTmpPath, pOutPath)) {
+			res = -5;
+		}
+		if (res != 0) {
+			remove(pTmpPath);
+		}
+		free(pTmpPath);
+	}
+	return res;
+}
+
+typedef struct _CVT_BATCH {
+	char** ppIn;
+	char** ppOut;
+	int nfile;
+	int next;
+	int nerr;
+#if defined(_WIN32)
+	CRITICAL_SECTION lock;
+#else
+	pthread_mutex_t lock;
+#endif
+} CVT_BATCH;
+
+#if defined(_WIN32)
+#	define BATCH_LOCK(_b) EnterCriticalSection(&(_b)->lock)
+#	define BATCH_UNLOCK(_b) LeaveCriticalSection(&(_b)->lock)
+#else
+#	define BATCH_LOCK(_b) pthread_mutex_lock(&(_b)->lock)
+#	define BATCH_UNLOCK(_b) pthread_mutex_unlock(&(_b)->lock)
+#endif
+
+static void batch_work(CVT_BATCH* pBatch) {
+	while (1) {
+		int i, res;
+		BATCH_LOCK(pBatch);
+		i = pBatch->next++;
+		BATCH_UNLOCK(pBatch);
+		if (i >= pBatch->nfile) break;
+		res = exec_cvt(pBatch->ppIn[i], pBatch->ppOut[i], 0);
+		if (res != 0) {
+			fprintf(stderr, "%s: error %d\n", pBatch->ppIn[i], res);
+			BATCH_LOCK(pBatch);
+			++pBatch->nerr;
+			BATCH_UNLOCK(pBatch);
 		}
 	}
-	if (pBclip) {
-		free(pBclip);
-		pBclip = NULL;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI batch_func(LPVOID pData) {
+	batch_work((CVT_BATCH*)pData);
+	return 0;
+}
+#else
+static void* batch_func(void* pData) {
+	batch_work((CVT_BATCH*)pData);
+	return NULL;
+}
+#endif
+
+static int cpu_count(void) {
+	int n = 1;
+#if defined(_WIN32)
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	n = (int)si.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return n < 1 ? 1 : n;
+}
+
+static int has_ext(const char* pName, const char* pExt) {
+	size_t len = strlen(pName);
+	size_t extLen = strlen(pExt);
+	return len > extLen && strcmp(pName + len - extLen, pExt) == 0;
+}
+
+static char* path_cat(const char* pDir, const char* pName) {
+	size_t dirLen = strlen(pDir);
+	char* pPath = (char*)malloc(dirLen + strlen(pName) + 2);
+	if (pPath) {
+		memcpy(pPath, pDir, dirLen);
+		pPath[dirLen] = '/';
+		strcpy(pPath + dirLen + 1, pName);
 	}
+	return pPath;
+}
+
+static int batch_add(CVT_BATCH* pBatch, int* pMaxFile, const char* pInDir, const char* pOutDir, const char* pName) {
+	if (!has_ext(pName, ".bclip")) return 1;
+	if (pBatch->nfile >= *pMaxFile) {
+		int maxFile = *pMaxFile ? *pMaxFile * 2 : 256;
+		char** ppIn = (char**)realloc(pBatch->ppIn, maxFile * sizeof(char*));
+		char** ppOut;
+		if (!ppIn) return 0;
+		pBatch->ppIn = ppIn;
+		ppOut = (char**)realloc(pBatch->ppOut, maxFile * sizeof(char*));
+		if (!ppOut) return 0;
+		pBatch->ppOut = ppOut;
+		*pMaxFile = maxFile;
+	}
+	pBatch->ppIn[pBatch->nfile] = path_cat(pInDir, pName);
+	pBatch->ppOut[pBatch->nfile] = path_cat(pOutDir, pName);
+	++pBatch->nfile;
+	return pBatch->ppIn[pBatch->nfile - 1] && pBatch->ppOut[pBatch->nfile - 1];
+}
+
+static int batch_list(CVT_BATCH* pBatch, const char* pInDir, const char* pOutDir) {
+	int maxFile = 0;
+	int ok = 1;
+#if defined(_WIN32)
+	WIN32_FIND_DATAA fd;
+	char* pMask = path_cat(pInDir, "*.bclip");
+	HANDLE hFind = pMask ? FindFirstFileA(pMask, &fd) : INVALID_HANDLE_VALUE;
+	free(pMask);
+	if (hFind == INVALID_HANDLE_VALUE) return 0;
+	do {
+		if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+			ok = batch_add(pBatch, &maxFile, pInDir, pOutDir, fd.cFileName);
+		}
+	} while (ok && FindNextFileA(hFind, &fd));
+	FindClose(hFind);
+#else
+	struct dirent* pEnt;
+	DIR* pDir = opendir(pInDir);
+	if (!pDir) return 0;
+	while (ok && (pEnt = readdir(pDir)) != NULL) {
+		ok = batch_add(pBatch, &maxFile, pInDir, pOutDir, pEnt->d_name);
+	}
+	closedir(pDir);
+#endif
+	return ok;
+}
+
+static int exec_batch(const char* pInDir, const char* pOutDir, int nthr) {
+	CVT_BATCH batch;
+	int i, res;
+	int nstarted = 1;
+	memset(&batch, 0, sizeof(CVT_BATCH));
+	if (!batch_list(&batch, pInDir, pOutDir)) {
+		res = -1;
+	} else {
+#if defined(_WIN32)
+		HANDLE hThreads[BCLIP_MAX_THREADS];
+		InitializeCriticalSection(&batch.lock);
+#else
+		pthread_t threads[BCLIP_MAX_THREADS];
+		pthread_mutex_init(&batch.lock, NULL);
+#endif
+		if (nthr <= 0) nthr = cpu_count();
+		if (nthr > BCLIP_MAX_THREADS) nthr = BCLIP_MAX_THREADS;
+		if (nthr > batch.nfile) nthr = batch.nfile > 0 ? batch.nfile : 1;
+		/* the calling thread is the first worker and takes over what failed threads would do */
+		while (nstarted < nthr) {
+#if defined(_WIN32)
+			hThreads[nstarted] = CreateThread(NULL, 0, batch_func, &batch, 0, NULL);
+			if (!hThreads[nstarted]) break;
+#else
+			if (pthread_create(&threads[nstarted], NULL, batch_func, &batch) != 0) break;
+#endif
+			++nstarted;
+		}
+		nthr = nstarted;
+		batch_work(&batch);
+		for (i = 1; i < nthr; ++i) {
+#if defined(_WIN32)
+			WaitForSingleObject(hThreads[i], INFINITE);
+			CloseHandle(hThreads[i]);
+#else
+			pthread_join(threads[i], NULL);
+#endif
+		}
+#if defined(_WIN32)
+		DeleteCriticalSection(&batch.lock);
+#else
+		pthread_mutex_destroy(&batch.lock);
+#endif
+		printf("%d files, %d errors, %d threads\n", batch.nfile, batch.nerr, nthr);
+		res = batch.nerr ? -6 : 0;
+	}
+	for (i = 0; i < batch.nfile; ++i) {
+		free(batch.ppIn[i]);
+		free(batch.ppOut[i]);
+	}
+	free(batch.ppIn);
+	free(batch.ppOut);
 	return res;
 }
 
@@ -384,11 +654,16 @@ int main(int argc, char* argv[]) {
 	const char* pOutPath = NULL;
 	if (argc < 2) {
 		printf("bclip_f32 <in_path> <out_path>\n");
+		printf("bclip_f32 -dir <in_dir> <out_dir> [num_threads]\n");
 		return -1;
 	}
+	if (strcmp(argv[1], "-dir") == 0) {
+		if (argc < 4) return -1;
+		return exec_batch(argv[2], argv[3], argc > 4 ? atoi(argv[4]) : 0);
+	}
 	pInPath = argv[1];
 	if (argc > 2) {
 		pOutPath = argv[2];
 	}
-	return exec_cvt(pInPath, pOutPath);
+	return exec_cvt(pInPath, pOutPath, 1);
 }
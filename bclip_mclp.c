@@ -0,0 +1,86 @@
+/*
+ * Motion Clip: Houdini .bclip to .mclp converter
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ *
+ * bclip_mclp <in.bclip> <out.mclp> [clip_name]
+ *
+ * The bclip is mapped and its tracks are decoded once into channel arrays,
+ * node:tx style channels are grouped into nodes as cMotClipWriter does and
+ * the builder writes the clip from the arrays in place.
+ * Build with motbclip.c mothclip.c motbuild.c motclip.c
+ * (POSIX builds need -pthread).
+ */
+
+#ifdef _MSC_VER
+#	define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "motbclip.h"
+
+/* file name without directories and extension, as hclip.cs names clips */
+static void clipname(char* pName, size_t size, const char* pPath) {
+	const char* pBase = pPath;
+	const char* p;
+	size_t len;
+	for (p = pPath; *p; ++p) {
+		if (*p == '/' || *p == '\\') pBase = p + 1;
+	}
+	p = strrchr(pBase, '.');
+	len = p ? (size_t)(p - pBase) : strlen(pBase);
+	if (len >= size) len = size - 1;
+	memcpy(pName, pBase, len);
+	pName[len] = 0;
+}
+
+static int convert(const char* pInPath, const char* pOutPath, const char* pName) {
+	MOT_HCLIP hclip;
+	MOT_CLIP_BUILDER* pBld;
+	MOT_CLIP* pClip = NULL;
+	FILE* pOut;
+	int nnod = -1;
+	int res = 0;
+	if (!motBClipLoad(&hclip, pInPath)) {
+		fprintf(stderr, "%s: not a valid bclip\n", pInPath);
+		return -1;
+	}
+	pBld = motClipBuilderCreate(pName, hclip.nfrm, hclip.rate);
+	if (pBld) {
+		nnod = motHClipBuild(&hclip, pBld);
+		if (nnod > 0) {
+			pClip = motClipBuilderWrite(pBld, NULL, 0);
+		}
+	}
+	if (!pClip) {
+		fprintf(stderr, "%s: conversion failed\n", pInPath);
+		res = -2;
+	} else {
+		pOut = fopen(pOutPath, "wb");
+		if (pOut && fwrite(pClip, pClip->size, 1, pOut) == 1) {
+			printf("%s: %d tracks, %d frames, %d nodes, %d bytes\n", pOutPath, hclip.ntrk, hclip.nfrm, nnod, (int)pClip->size);
+		} else {
+			fprintf(stderr, "%s: write failed\n", pOutPath);
+			res = -3;
+		}
+		if (pOut) fclose(pOut);
+	}
+	free(pClip);
+	motClipBuilderDestroy(pBld);
+	motHClipFree(&hclip);
+	return res;
+}
+
+int main(int argc, char* argv[]) {
+	/* MOT_STRING keeps one byte for the length */
+	char name[sizeof(MOT_STRING) - 1];
+	if (argc < 3) {
+		printf("bclip_mclp <in.bclip> <out.mclp> [clip_name]\n");
+		return -1;
+	}
+	if (argc > 3) {
+		strncpy(name, argv[3], sizeof(name) - 1);
+		name[sizeof(name) - 1] = 0;
+	} else {
+		clipname(name, sizeof(name), argv[1]);
+	}
+	return convert(argv[1], argv[2], name);
+}
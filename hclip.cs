@@ -1388,7 +1388,7 @@ public class cMotClipWriter {
 			nodeTop[i] = bw.BaseStream.Position;
 			node.WriteInfo(bw);
 		}
-		PatchCur(0x14); // <- hash
+		PatchCur(mFileTop + 0x14); // <- hash
 		for (int i = 0; i < n; ++i) {
 			bw.Write(mNodeNamesLst.mHash[i]);
 		}
@@ -1396,11 +1396,11 @@ public class cMotClipWriter {
 			cNode node = mNodes[i];
 			node.WriteData(bw, nodeTop[i] + 0x40);
 		}
-		PatchCur(0x18); // <- eval
+		PatchCur(mFileTop + 0x18); // <- eval
 		mEvalInfo.Write(bw);
-		PatchCur(0x1C); // <- seq
+		PatchCur(mFileTop + 0x1C); // <- seq
 		WriteSeq();
-		PatchCur(0x4); // size
+		PatchCur(mFileTop + 0x4); // size
 		mBW = null;
 	}
 
@@ -2059,12 +2059,56 @@ public class cMotLibWriter {
 		}
 	}
 	
+	protected static void Patch(BinaryWriter bw, long libTop, long offs) {
+		nUtl.Patch32(bw, libTop + offs, (int)(bw.BaseStream.Position - libTop));
+	}
+
 	public void Write(BinaryWriter bw) {
 		int nclips = mEntries.Count;
 		int nnodes = mNodeNames.Count;
-		bw.Write(DEFS.MOT_LIB_ID);
-		bw.Write(nclips);
-		bw.Write(nnodes);
+		var clipNames = new cStrList();
+		foreach (cEntry entry in mEntries) {
+			clipNames.Add(entry.mMotClip.mSrc.mName);
+		}
+		var nodeNames = new cStrList();
+		foreach (string nodeName in mNodeNames) {
+			nodeNames.Add(nodeName);
+		}
+		long top = bw.BaseStream.Position;
+		/* +00 */ bw.Write(DEFS.MOT_LIB_ID);
+		/* +04 */ bw.Write(nclips);
+		/* +08 */ bw.Write(nnodes);
+		/* +0C */ bw.Write((uint)0); // size
+		/* +10 */ bw.Write((uint)0); // -> clips
+		/* +14 */ bw.Write((uint)0); // -> hash
+		/* +18 */ bw.Write((uint)0); // -> nodes
+		/* +1C */ bw.Write((uint)0); // -> node hash
+		Patch(bw, top, 0x10); // <- clips
+		long clipsTop = bw.BaseStream.Position - top;
+		for (int i = 0; i < nclips; ++i) {
+			bw.Write((uint)0);
+		}
+		Patch(bw, top, 0x14); // <- hash
+		for (int i = 0; i < nclips; ++i) {
+			bw.Write(clipNames.mHash[i]);
+		}
+		Patch(bw, top, 0x18); // <- nodes
+		for (int i = 0; i < nnodes; ++i) {
+			nUtl.WriteFixStr(bw, nodeNames.mStr[i]);
+		}
+		Patch(bw, top, 0x1C); // <- node hash
+		for (int i = 0; i < nnodes; ++i) {
+			bw.Write(nodeNames.mHash[i]);
+		}
+		/* clips in name hash order, 16-byte aligned */
+		for (int i = 0; i < nclips; ++i) {
+			while (((bw.BaseStream.Position - top) & 0xF) != 0) {
+				bw.Write((byte)0);
+			}
+			Patch(bw, top, clipsTop + i*4);
+			mEntries[clipNames.mOrd[i]].mMotClip.Write(bw);
+		}
+		Patch(bw, top, 0xC); // size
 	}
 	
 	public void Save(string fpath) {
@@ -2111,9 +2155,20 @@ public class HClipTool {
 		
 		if (args.ArgNum < 1) {
 			Console.Error.WriteLine("hclip -[logvecs|quads] <motion.clip>");
+			Console.Error.WriteLine("hclip -lib:<motion.mlib> <motion1.clip> ...");
 			return -1;
 		}
 		
+		string libPath = args.GetOpt("lib", "");
+		if (libPath.Length > 0) {
+			var lib = new cMotLibWriter();
+			for (int i = 0; i < args.ArgNum; ++i) {
+				lib.AddHouClip(args.GetArg(i));
+			}
+			lib.Save(libPath);
+			return 0;
+		}
+
 		string clpPath = args.GetArg(0);
 		var clip = new cHouClip();
 		clip.Load(clpPath);
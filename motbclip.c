@@ -0,0 +1,374 @@
+/*
+ * Motion Clip Houdini .bclip reader
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ *
+ * The top-level packets are indexed in one pass, the tracks are then
+ * walked once: each DATA packet is byte-swapped (and narrowed from f64)
+ * straight into its slot of the track-major value array, names go into
+ * one pool. NAME packets are a u16 length and the characters; payloads
+ * that do not start with a fitting length are taken as raw characters.
+ * All sizes are checked against the enclosing packet.
+ * The random access reader makes the same walk without decoding; each
+ * table entry keeps the file offset of the samples, so reading a track or
+ * a range of it touches only those pages of the mapping.
+ */
+
+#include "motbclip.h"
+
+#define BCLIP_MAX_TAG (0x10)
+
+typedef struct _BCLIP_HDR {
+	const uint8_t* pPkts[BCLIP_MAX_TAG];
+	const uint8_t* pTrk;    /* first track packet */
+	const uint8_t* pTrkEnd;
+	int            dataF64;
+	int            nfrm;
+	int            ntrk;
+	float          rate;
+	float          start;
+} BCLIP_HDR;
+
+typedef struct _BCLIP_TRK {
+	const uint8_t* pName;
+	uint32_t       nameLen;
+	const uint8_t* pData; /* NULL: no DATA packet */
+} BCLIP_TRK;
+
+static uint32_t hbinU32(const uint8_t* pMem) {
+	return ((uint32_t)pMem[0] << 24) | ((uint32_t)pMem[1] << 16) | ((uint32_t)pMem[2] << 8) | pMem[3];
+}
+
+static uint16_t hbinU16(const uint8_t* pMem) {
+	return (uint16_t)((pMem[0] << 8) | pMem[1]);
+}
+
+static float hbinF32(const uint8_t* pMem) {
+	float f;
+	uint32_t u = hbinU32(pMem);
+	memcpy(&f, &u, sizeof(float));
+	return f;
+}
+
+static double hbinF64(const uint8_t* pMem) {
+	double d;
+	uint64_t u = ((uint64_t)hbinU32(pMem) << 32) | hbinU32(pMem + 4);
+	memcpy(&d, &u, sizeof(double));
+	return d;
+}
+
+/* payload of an info packet of at least minSize bytes, NULL if absent */
+static const uint8_t* infopkt(const BCLIP_HDR* pHdr, int tag, uint32_t minSize) {
+	const uint8_t* pPkt = pHdr->pPkts[tag];
+	return pPkt && hbinU32(pPkt) >= 8 + minSize ? pPkt + 8 : NULL;
+}
+
+static float infoval(const BCLIP_HDR* pHdr, int tag, int infoF64) {
+	const uint8_t* pVal = infopkt(pHdr, tag, infoF64 ? 8 : 4);
+	if (!pVal) return 0.0f;
+	return infoF64 ? (float)hbinF64(pVal) : hbinF32(pVal);
+}
+
+static int bclipheader(BCLIP_HDR* pHdr, const uint8_t* pTop, size_t size) {
+	const uint8_t* pVal;
+	size_t offs = 4;
+	int infoF64;
+	memset(pHdr, 0, sizeof(BCLIP_HDR));
+	if (!pTop || size < 0x10 || memcmp(pTop, "bclp", 4) != 0) return 0;
+	while (offs + 8 <= size) {
+		const uint8_t* pPkt = pTop + offs;
+		uint32_t pktSize = hbinU32(pPkt);
+		uint16_t tag;
+		if (pktSize < 8 || pktSize > size - offs || hbinU16(pPkt + 4) != 0xF) break;
+		tag = hbinU16(pPkt + 6);
+		if (tag < BCLIP_MAX_TAG && !pHdr->pPkts[tag]) {
+			pHdr->pPkts[tag] = pPkt;
+		}
+		if (tag == 0) break; /* END */
+		offs += pktSize;
+	}
+	pVal = infopkt(pHdr, 0xA, 1);
+	infoF64 = pVal ? pVal[0] != 0 : 0;
+	pVal = infopkt(pHdr, 8, 1);
+	pHdr->dataF64 = pVal ? pVal[0] != 0 : 0;
+	pHdr->rate = infoval(pHdr, 1, infoF64);
+	pHdr->start = infoval(pHdr, 2, infoF64);
+	pVal = infopkt(pHdr, 3, 4);
+	pHdr->nfrm = pVal ? (int32_t)hbinU32(pVal) : 0;
+	pVal = infopkt(pHdr, 5, 4);
+	if (!pVal || pHdr->nfrm <= 0) return 0;
+	pHdr->ntrk = (int32_t)hbinU32(pVal);
+	pHdr->pTrk = pVal + 4;
+	pHdr->pTrkEnd = pHdr->pPkts[5] + hbinU32(pHdr->pPkts[5]);
+	return pHdr->ntrk > 0;
+}
+
+/* NAME/DATA/.../END packets of one track, returns the next track or NULL if malformed */
+static const uint8_t* trkpkts(const BCLIP_HDR* pHdr, const uint8_t* pTrk, BCLIP_TRK* pInfo) {
+	size_t dataSize = (size_t)pHdr->nfrm * (pHdr->dataF64 ? 8 : 4);
+	memset(pInfo, 0, sizeof(BCLIP_TRK));
+	while (1) {
+		uint32_t pktLen;
+		uint16_t tag;
+		if (pHdr->pTrkEnd - pTrk < 8) return NULL;
+		pktLen = hbinU32(pTrk);
+		if (pktLen < 8 || pktLen > (size_t)(pHdr->pTrkEnd - pTrk) || hbinU16(pTrk + 4) != 0x10) return NULL;
+		tag = hbinU16(pTrk + 6);
+		if (tag == 1) {
+			uint32_t len = pktLen - 8;
+			pInfo->pName = pTrk + 8;
+			if (len >= 2 && hbinU16(pTrk + 8) <= len - 2) {
+				pInfo->nameLen = hbinU16(pTrk + 8);
+				pInfo->pName += 2;
+			} else {
+				pInfo->nameLen = len;
+			}
+			while (pInfo->nameLen > 0 && pInfo->pName[pInfo->nameLen - 1] == 0) {
+				--pInfo->nameLen;
+			}
+		} else if (tag == 2) {
+			if (pktLen - 8 < dataSize) return NULL;
+			pInfo->pData = pTrk + 8;
+		}
+		pTrk += pktLen;
+		if (tag == 0) break; /* END */
+	}
+	return pInfo->pName ? pTrk : NULL;
+}
+
+static void smpdata(float* pDst, const uint8_t* pSrc, int f64, int nsmp) {
+	int i;
+	if (!pSrc) {
+		memset(pDst, 0, (size_t)nsmp * sizeof(float));
+	} else if (f64) {
+		for (i = 0; i < nsmp; ++i) {
+			pDst[i] = (float)hbinF64(pSrc + i*8);
+		}
+	} else {
+		for (i = 0; i < nsmp; ++i) {
+			pDst[i] = hbinF32(pSrc + i*4);
+		}
+	}
+}
+
+/* pLens: ntrk name lengths scratch */
+static int bclipparse(MOT_HCLIP* pHClip, const BCLIP_HDR* pHdr, uint32_t* pLens) {
+	const uint8_t* pTrk = pHdr->pTrk;
+	size_t namesSize = 0;
+	char* pName;
+	int i, f;
+	pHClip->rate = pHdr->rate;
+	pHClip->start = (int)pHdr->start;
+	pHClip->nfrm = pHdr->nfrm;
+	pHClip->ntrk = pHdr->ntrk;
+	pHClip->pTrks = (MOT_HCLIP_TRACK*)calloc((size_t)pHdr->ntrk, sizeof(MOT_HCLIP_TRACK));
+	pHClip->pData = (float*)malloc((size_t)pHdr->ntrk * pHdr->nfrm * sizeof(float));
+	if (!pHClip->pTrks || !pHClip->pData) return 0;
+	/* one walk: data decoded in place, name sizes summed, names kept in the file until pooled */
+	for (i = 0; i < pHdr->ntrk; ++i) {
+		MOT_HCLIP_TRACK* pDst = &pHClip->pTrks[i];
+		BCLIP_TRK trk;
+		float* pData = &pHClip->pData[(size_t)i * pHdr->nfrm];
+		pTrk = trkpkts(pHdr, pTrk, &trk);
+		if (!pTrk) return 0;
+		smpdata(pData, trk.pData, pHdr->dataF64, pHdr->nfrm);
+		pDst->pData = pData;
+		pDst->pName = (const char*)trk.pName;
+		pLens[i] = trk.nameLen;
+		namesSize += trk.nameLen + 1;
+	}
+	pHClip->pNames = pName = (char*)malloc(namesSize);
+	if (!pName) return 0;
+	for (i = 0; i < pHdr->ntrk; ++i) {
+		MOT_HCLIP_TRACK* pDst = &pHClip->pTrks[i];
+		size_t len = pLens[i];
+		memcpy(pName, pDst->pName, len);
+		pName[len] = 0;
+		pDst->pName = pName;
+		pName += len + 1;
+		pDst->vmin = pDst->vmax = pDst->pData[0];
+		for (f = 1; f < pHdr->nfrm; ++f) {
+			pDst->vmin = pDst->pData[f] < pDst->vmin ? pDst->pData[f] : pDst->vmin;
+			pDst->vmax = pDst->pData[f] > pDst->vmax ? pDst->pData[f] : pDst->vmax;
+		}
+	}
+	return 1;
+}
+
+int motBClipParse(MOT_HCLIP* pHClip, const void* pMem, size_t size) {
+	BCLIP_HDR hdr;
+	uint32_t* pLens;
+	int res;
+	if (!pHClip) return 0;
+	memset(pHClip, 0, sizeof(MOT_HCLIP));
+	if (!bclipheader(&hdr, (const uint8_t*)pMem, size)) return 0;
+	pLens = (uint32_t*)malloc((size_t)hdr.ntrk * sizeof(uint32_t));
+	res = pLens && bclipparse(pHClip, &hdr, pLens);
+	free(pLens);
+	if (!res) {
+		motHClipFree(pHClip);
+	}
+	return res;
+}
+
+int motBClipLoad(MOT_HCLIP* pHClip, const char* pPath) {
+	MOT_FMAP map;
+	int res;
+	if (!pHClip) return 0;
+	memset(pHClip, 0, sizeof(MOT_HCLIP));
+	if (!motFileMap(&map, pPath)) return 0;
+	res = motBClipParse(pHClip, map.pMem, map.size);
+	motFileUnmap(&map);
+	return res;
+}
+
+static uint32_t namehash(const char* pName, size_t len) {
+	uint32_t h = 2166136261U;
+	size_t i;
+	for (i = 0; i < len; ++i) {
+		h *= 16777619U;
+		h ^= (uint8_t)pName[i];
+	}
+	return h;
+}
+
+static int ordcmp(const void* p1, const void* p2) {
+	const uint32_t* pE1 = (const uint32_t*)p1;
+	const uint32_t* pE2 = (const uint32_t*)p2;
+	if (pE1[0] != pE2[0]) return pE1[0] < pE2[0] ? -1 : 1;
+	return pE1[1] < pE2[1] ? -1 : pE1[1] > pE2[1] ? 1 : 0;
+}
+
+/* pLens: ntrk * 2 scratch, name lengths, then (hash, index) pairs for sorting */
+static int tocbuild(MOT_BCLIP* pBClip, const BCLIP_HDR* pHdr, uint32_t* pLens) {
+	const uint8_t* pTop = (const uint8_t*)pBClip->map.pMem;
+	const uint8_t* pTrk = pHdr->pTrk;
+	size_t namesSize = 0;
+	char* pName;
+	int i;
+	pBClip->rate = pHdr->rate;
+	pBClip->start = (int)pHdr->start;
+	pBClip->nfrm = pHdr->nfrm;
+	pBClip->ntrk = pHdr->ntrk;
+	pBClip->pToc = (MOT_BCLIP_TOC*)calloc((size_t)pHdr->ntrk, sizeof(MOT_BCLIP_TOC));
+	pBClip->pOrd = (int32_t*)malloc((size_t)pHdr->ntrk * sizeof(int32_t));
+	if (!pBClip->pToc || !pBClip->pOrd) return 0;
+	for (i = 0; i < pHdr->ntrk; ++i) {
+		MOT_BCLIP_TOC* pEnt = &pBClip->pToc[i];
+		BCLIP_TRK trk;
+		pTrk = trkpkts(pHdr, pTrk, &trk);
+		if (!pTrk) return 0;
+		pEnt->pName = (const char*)trk.pName;
+		pEnt->hash = namehash(pEnt->pName, trk.nameLen);
+		pEnt->f64 = (uint32_t)pHdr->dataF64;
+		pEnt->offs = trk.pData ? (size_t)(trk.pData - pTop) : 0;
+		pLens[i] = trk.nameLen;
+		namesSize += trk.nameLen + 1;
+	}
+	pBClip->pNames = pName = (char*)malloc(namesSize);
+	if (!pName) return 0;
+	for (i = 0; i < pHdr->ntrk; ++i) {
+		MOT_BCLIP_TOC* pEnt = &pBClip->pToc[i];
+		memcpy(pName, pEnt->pName, pLens[i]);
+		pName[pLens[i]] = 0;
+		pEnt->pName = pName;
+		pName += pLens[i] + 1;
+	}
+	for (i = 0; i < pHdr->ntrk; ++i) {
+		pLens[i*2] = pBClip->pToc[i].hash;
+		pLens[i*2 + 1] = (uint32_t)i;
+	}
+	qsort(pLens, pHdr->ntrk, sizeof(uint32_t) * 2, ordcmp);
+	for (i = 0; i < pHdr->ntrk; ++i) {
+		pBClip->pOrd[i] = (int32_t)pLens[i*2 + 1];
+	}
+	return 1;
+}
+
+static int bclipopen(MOT_BCLIP* pBClip) {
+	BCLIP_HDR hdr;
+	uint32_t* pLens;
+	int res;
+	if (!bclipheader(&hdr, (const uint8_t*)pBClip->map.pMem, pBClip->map.size)) return 0;
+	pLens = (uint32_t*)malloc((size_t)hdr.ntrk * 2 * sizeof(uint32_t));
+	res = pLens && tocbuild(pBClip, &hdr, pLens);
+	free(pLens);
+	return res;
+}
+
+int motBClipOpenMem(MOT_BCLIP* pBClip, const void* pMem, size_t size) {
+	if (!pBClip) return 0;
+	memset(pBClip, 0, sizeof(MOT_BCLIP));
+	pBClip->map.pMem = pMem;
+	pBClip->map.size = size;
+	if (!bclipopen(pBClip)) {
+		motBClipClose(pBClip);
+		return 0;
+	}
+	return 1;
+}
+
+int motBClipOpen(MOT_BCLIP* pBClip, const char* pPath) {
+	if (!pBClip) return 0;
+	memset(pBClip, 0, sizeof(MOT_BCLIP));
+	if (!motFileMap(&pBClip->map, pPath)) return 0;
+	pBClip->own = 1;
+	if (!bclipopen(pBClip)) {
+		motBClipClose(pBClip);
+		return 0;
+	}
+	return 1;
+}
+
+void motBClipClose(MOT_BCLIP* pBClip) {
+	if (!pBClip) return;
+	if (pBClip->own) {
+		motFileUnmap(&pBClip->map);
+	}
+	free(pBClip->pToc);
+	free(pBClip->pOrd);
+	free(pBClip->pNames);
+	memset(pBClip, 0, sizeof(MOT_BCLIP));
+}
+
+int motBClipFindTrack(const MOT_BCLIP* pBClip, const char* pName) {
+	uint32_t h;
+	int lo, hi;
+	if (!pBClip || !pBClip->pToc || !pName) return -1;
+	h = namehash(pName, strlen(pName));
+	lo = 0;
+	hi = pBClip->ntrk;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (pBClip->pToc[pBClip->pOrd[mid]].hash < h) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	for (; lo < pBClip->ntrk && pBClip->pToc[pBClip->pOrd[lo]].hash == h; ++lo) {
+		int itrk = pBClip->pOrd[lo];
+		if (strcmp(pBClip->pToc[itrk].pName, pName) == 0) return itrk;
+	}
+	return -1;
+}
+
+/* frames [frm0, frm0 + nfrm) clipped to the track, returns the number of values written */
+int motBClipReadTrack(const MOT_BCLIP* pBClip, int trkIdx, int frm0, int nfrm, float* pDst) {
+	const MOT_BCLIP_TOC* pEnt;
+	const uint8_t* pSrc = NULL;
+	if (!pBClip || !pBClip->pToc || !pDst || trkIdx < 0 || trkIdx >= pBClip->ntrk) return 0;
+	if (frm0 < 0) {
+		nfrm += frm0;
+		frm0 = 0;
+	}
+	if (nfrm > pBClip->nfrm - frm0) {
+		nfrm = pBClip->nfrm - frm0;
+	}
+	if (nfrm <= 0) return 0;
+	pEnt = &pBClip->pToc[trkIdx];
+	if (pEnt->offs) {
+		pSrc = (const uint8_t*)pBClip->map.pMem + pEnt->offs + (size_t)frm0 * (pEnt->f64 ? 8 : 4);
+	}
+	smpdata(pDst, pSrc, (int)pEnt->f64, nfrm);
+	return nfrm;
+}
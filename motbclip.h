@@ -0,0 +1,52 @@
+/*
+ * Motion Clip Houdini .bclip reader
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ */
+
+#ifndef MOTBCLIP_H
+#define MOTBCLIP_H
+
+#include "mothclip.h"
+
+/*
+ * Binary channel clips: "bclp" followed by big-endian packets
+ * (u32 size, u16 class, u16 tag). Info packets give the rate, start,
+ * track length, f64/f32 info and data types; the TRACKS packet holds
+ * per-track NAME/DATA/END packets. Tracks are read into the same channel
+ * clip as the text reader, so motHClipBuild makes MCLP clips of them.
+ */
+MOT_EXTERN_FUNC int motBClipParse(MOT_HCLIP* pHClip, const void* pMem, size_t size);
+MOT_EXTERN_FUNC int motBClipLoad(MOT_HCLIP* pHClip, const char* pPath);
+
+/*
+ * Random access: one pass over the packet headers makes a table of
+ * contents, track data stays in the mapped file and is decoded per track
+ * or frame range on request. Lookups by full channel name use the tracks
+ * in name hash order.
+ */
+typedef struct _MOT_BCLIP_TOC {
+	const char* pName;
+	uint32_t    hash;
+	uint32_t    f64;  /* samples are big-endian doubles, otherwise floats */
+	size_t      offs; /* samples offset in the file, 0 if the track has no DATA packet */
+} MOT_BCLIP_TOC;
+
+typedef struct _MOT_BCLIP {
+	MOT_FMAP       map;
+	int            own; /* map is released on close */
+	float          rate;
+	int            start;
+	int            nfrm;
+	int            ntrk;
+	MOT_BCLIP_TOC* pToc;
+	int32_t*       pOrd; /* track indices in hash order */
+	char*          pNames;
+} MOT_BCLIP;
+
+MOT_EXTERN_FUNC int motBClipOpen(MOT_BCLIP* pBClip, const char* pPath);
+MOT_EXTERN_FUNC int motBClipOpenMem(MOT_BCLIP* pBClip, const void* pMem, size_t size);
+MOT_EXTERN_FUNC void motBClipClose(MOT_BCLIP* pBClip);
+MOT_EXTERN_FUNC int motBClipFindTrack(const MOT_BCLIP* pBClip, const char* pName);
+MOT_EXTERN_FUNC int motBClipReadTrack(const MOT_BCLIP* pBClip, int trkIdx, int frm0, int nfrm, float* pDst);
+
+#endif /* MOTBCLIP_H */
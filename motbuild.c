@@ -0,0 +1,388 @@
+/*
+ * Motion Clip builder
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ *
+ * motClipBuilderSize resolves the layout: node hash order, per-track value
+ * ranges and masks, then the data, EVAL and SEQ offsets; it is cached until
+ * the builder is changed. motClipBuilderWrite fills the caller's buffer in
+ * one pass from the source arrays. Rotation tracks are converted into a
+ * one-track scratch for their ranges and again when written.
+ */
+
+#include "motbuild.h"
+
+typedef struct _BLD_CHAN {
+	const float* pVals;
+	int          stride;
+} BLD_CHAN;
+
+typedef struct _BLD_NODE {
+	MOT_STRING name;
+	uint32_t   hash;
+	uint8_t    xord;
+	uint8_t    rord;
+	BLD_CHAN   chan[3][3];
+	MOT_TRACK  trk[3];
+	uint32_t   offs[3];
+} BLD_NODE;
+
+struct _MOT_CLIP_BUILDER {
+	MOT_STRING name;
+	int        nfrm;
+	float      rate;
+	int        rotMode;
+	int        nnod;
+	int        maxNod;
+	BLD_NODE*  pNodes;
+	int32_t*   pOrd;  /* clip node -> builder node */
+	MOT_VEC*   pLog;  /* rotation scratch, nfrm */
+	int        nlog;
+	size_t     size;  /* 0: layout not resolved */
+	size_t     hash;
+	size_t     eval;
+	size_t     seq;
+	uint32_t   ntrk;
+	uint32_t   nchn;
+};
+
+static int setname(MOT_STRING* pStr, const char* pName) {
+	size_t len = pName ? strlen(pName) : 0;
+	if (len >= sizeof(pStr->chr)) return 0;
+	memset(pStr, 0, sizeof(MOT_STRING));
+	pStr->len = (uint8_t)len;
+	memcpy(pStr->chr, pName, len);
+	return 1;
+}
+
+MOT_CLIP_BUILDER* motClipBuilderCreate(const char* pName, int nfrm, float rate) {
+	MOT_CLIP_BUILDER* pBld = (MOT_CLIP_BUILDER*)calloc(1, sizeof(MOT_CLIP_BUILDER));
+	if (!pBld) return NULL;
+	if (!motClipBuilderReset(pBld, pName, nfrm, rate)) {
+		free(pBld);
+		return NULL;
+	}
+	return pBld;
+}
+
+void motClipBuilderDestroy(MOT_CLIP_BUILDER* pBld) {
+	if (pBld) {
+		free(pBld->pNodes);
+		free(pBld->pOrd);
+		free(pBld->pLog);
+		free(pBld);
+	}
+}
+
+/* starts a new clip, node and scratch memory is kept for the next one */
+int motClipBuilderReset(MOT_CLIP_BUILDER* pBld, const char* pName, int nfrm, float rate) {
+	if (!pBld || nfrm < 1 || !setname(&pBld->name, pName ? pName : "")) return 0;
+	pBld->nfrm = nfrm;
+	pBld->rate = rate;
+	pBld->nnod = 0;
+	pBld->size = 0;
+	return 1;
+}
+
+/* kept across resets */
+void motClipBuilderSetRotMode(MOT_CLIP_BUILDER* pBld, E_MOT_BROT mode) {
+	if (pBld) {
+		pBld->rotMode = mode == BROT_LOG ? BROT_LOG : BROT_DEGREES;
+		pBld->size = 0;
+	}
+}
+
+int motClipBuilderAddNode(MOT_CLIP_BUILDER* pBld, const char* pName, E_MOT_XORD xord, E_MOT_RORD rord) {
+	BLD_NODE* pNode;
+	uint32_t len;
+	if (!pBld || !pName || pBld->nnod >= 0xFFFF) return -1;
+	if ((uint32_t)xord > XORD_TRS || (uint32_t)rord > RORD_ZYX) return -1;
+	if (pBld->nnod >= pBld->maxNod) {
+		int maxNod = pBld->maxNod ? pBld->maxNod * 2 : 64;
+		BLD_NODE* pNodes = (BLD_NODE*)realloc(pBld->pNodes, maxNod * sizeof(BLD_NODE));
+		if (!pNodes) return -1;
+		pBld->pNodes = pNodes;
+		pBld->maxNod = maxNod;
+	}
+	pNode = &pBld->pNodes[pBld->nnod];
+	memset(pNode, 0, sizeof(BLD_NODE));
+	if (!setname(&pNode->name, pName)) return -1;
+	pNode->hash = motNameHash(&len, pName);
+	pNode->xord = (uint8_t)xord;
+	pNode->rord = (uint8_t)rord;
+	pBld->size = 0;
+	return pBld->nnod++;
+}
+
+int motClipBuilderFindNode(const MOT_CLIP_BUILDER* pBld, const char* pName) {
+	uint32_t len, h;
+	int i;
+	if (!pBld || !pName) return -1;
+	h = motNameHash(&len, pName);
+	for (i = 0; i < pBld->nnod; ++i) {
+		const BLD_NODE* pNode = &pBld->pNodes[i];
+		if (pNode->hash == h && pNode->name.len == len && memcmp(pNode->name.chr, pName, len) == 0) return i;
+	}
+	return -1;
+}
+
+int motClipBuilderSetChan(MOT_CLIP_BUILDER* pBld, int nodeIdx, E_MOT_TRK kind, int chan, const float* pVals, int stride) {
+	BLD_CHAN* pChan;
+	if (!pBld || nodeIdx < 0 || nodeIdx >= pBld->nnod) return 0;
+	if ((uint32_t)kind > TRK_SCL || chan < 0 || chan > 2 || stride < 0) return 0;
+	pChan = &pBld->pNodes[nodeIdx].chan[kind][chan];
+	pChan->pVals = pVals;
+	pChan->stride = stride ? stride : 1;
+	pBld->size = 0;
+	return 1;
+}
+
+static float chanval(const BLD_CHAN* pChan, int f) {
+	return pChan->pVals ? pChan->pVals[(size_t)f * pChan->stride] : 0.0f;
+}
+
+/* Euler degrees -> log vectors, each quaternion in the hemisphere of the previous one (of the identity for the first) */
+static void rotlogs(MOT_VEC* pLog, const BLD_NODE* pNode, int nfrm) {
+	const BLD_CHAN* pChan = pNode->chan[TRK_ROT];
+	MOT_QUAT prev = { 0.0f, 0.0f, 0.0f, 1.0f };
+	int f;
+	for (f = 0; f < nfrm; ++f) {
+		MOT_QUAT q = motQuatFromDegrees(chanval(&pChan[0], f), chanval(&pChan[1], f), chanval(&pChan[2], f), (E_MOT_RORD)pNode->rord);
+		float cosh, hang, norm, s;
+		if (q.x*prev.x + q.y*prev.y + q.z*prev.z + q.w*prev.w < 0.0f) {
+			q.x = -q.x;
+			q.y = -q.y;
+			q.z = -q.z;
+			q.w = -q.w;
+		}
+		prev = q;
+		cosh = q.w < -1.0f ? -1.0f : q.w > 1.0f ? 1.0f : q.w;
+		hang = acosf(cosh);
+		norm = sqrtf(q.x*q.x + q.y*q.y + q.z*q.z);
+		s = norm > 0.0f ? hang / norm : 0.0f;
+		pLog[f].x = q.x * s;
+		pLog[f].y = q.y * s;
+		pLog[f].z = q.z * s;
+	}
+}
+
+/* value f of channel chan of a track, rotations from the converted scratch */
+static float trkval(const MOT_CLIP_BUILDER* pBld, const BLD_NODE* pNode, int kind, int chan, int f) {
+	if (kind == TRK_ROT && pBld->rotMode == BROT_DEGREES) return pBld->pLog[f].s[chan];
+	return chanval(&pNode->chan[kind][chan], f);
+}
+
+/* track ranges and masks; missing channels keep 0 as in cMotClipWriter */
+static void trkrange(MOT_CLIP_BUILDER* pBld, BLD_NODE* pNode, int kind) {
+	MOT_TRACK* pTrk = &pNode->trk[kind];
+	int f, chan;
+	memset(pTrk, 0, sizeof(MOT_TRACK));
+	for (chan = 0; chan < 3; ++chan) {
+		if (pNode->chan[kind][chan].pVals) {
+			pTrk->srcMask |= 1 << chan;
+		}
+	}
+	if (!pTrk->srcMask) return;
+	if (kind == TRK_ROT && pBld->rotMode == BROT_DEGREES) {
+		/* every Euler channel contributes to all log components */
+		pTrk->srcMask = 7;
+		rotlogs(pBld->pLog, pNode, pBld->nfrm);
+	}
+	for (chan = 0; chan < 3; ++chan) {
+		float vmin = trkval(pBld, pNode, kind, chan, 0);
+		float vmax = vmin;
+		for (f = 1; f < pBld->nfrm; ++f) {
+			float v = trkval(pBld, pNode, kind, chan, f);
+			vmin = v < vmin ? v : vmin;
+			vmax = v > vmax ? v : vmax;
+		}
+		pTrk->vmin.s[chan] = vmin;
+		pTrk->vmax.s[chan] = vmax;
+		if (vmax != vmin) {
+			pTrk->dataMask |= 1 << chan;
+		}
+	}
+	pTrk->stride = (uint8_t)motMaskChanCount(pTrk->dataMask);
+}
+
+static int ordcmp(const void* p1, const void* p2) {
+	const uint32_t* pE1 = (const uint32_t*)p1;
+	const uint32_t* pE2 = (const uint32_t*)p2;
+	if (pE1[0] != pE2[0]) return pE1[0] < pE2[0] ? -1 : 1;
+	return pE1[1] < pE2[1] ? -1 : pE1[1] > pE2[1] ? 1 : 0;
+}
+
+/* node order by name hash (insertion order among equal hashes) */
+static int bldorder(MOT_CLIP_BUILDER* pBld) {
+	int i, nnod = pBld->nnod;
+	uint32_t* pTmp = (uint32_t*)malloc((nnod ? nnod : 1) * 2 * sizeof(uint32_t));
+	int32_t* pOrd = (int32_t*)realloc(pBld->pOrd, (nnod ? nnod : 1) * sizeof(int32_t));
+	if (pOrd) {
+		pBld->pOrd = pOrd;
+	}
+	if (!pTmp || !pOrd) {
+		free(pTmp);
+		return 0;
+	}
+	for (i = 0; i < nnod; ++i) {
+		pTmp[i*2] = pBld->pNodes[i].hash;
+		pTmp[i*2 + 1] = (uint32_t)i;
+	}
+	qsort(pTmp, nnod, 2 * sizeof(uint32_t), ordcmp);
+	for (i = 0; i < nnod; ++i) {
+		pOrd[i] = (int32_t)pTmp[i*2 + 1];
+	}
+	free(pTmp);
+	return 1;
+}
+
+size_t motClipBuilderSize(MOT_CLIP_BUILDER* pBld) {
+	size_t offs;
+	int i, kind;
+	if (!pBld) return 0;
+	if (pBld->size) return pBld->size;
+	if (pBld->nlog < pBld->nfrm) {
+		MOT_VEC* pLog = (MOT_VEC*)realloc(pBld->pLog, pBld->nfrm * sizeof(MOT_VEC));
+		if (!pLog) return 0;
+		pBld->pLog = pLog;
+		pBld->nlog = pBld->nfrm;
+	}
+	if (!bldorder(pBld)) return 0;
+	pBld->hash = offsetof(MOT_CLIP, nodes) + pBld->nnod * sizeof(MOT_NODE);
+	offs = pBld->hash + pBld->nnod * sizeof(uint32_t);
+	pBld->ntrk = 0;
+	pBld->nchn = 0;
+	for (i = 0; i < pBld->nnod; ++i) {
+		BLD_NODE* pNode = &pBld->pNodes[pBld->pOrd[i]];
+		for (kind = 0; kind < 3; ++kind) {
+			const MOT_TRACK* pTrk = &pNode->trk[kind];
+			trkrange(pBld, pNode, kind);
+			pNode->offs[kind] = 0;
+			if (pTrk->srcMask) {
+				++pBld->ntrk;
+				pBld->nchn += motMaskChanCount(pTrk->srcMask);
+			}
+			if (pTrk->dataMask) {
+				pNode->offs[kind] = (uint32_t)offs;
+				offs += (size_t)pBld->nfrm * pTrk->stride * sizeof(float);
+			}
+		}
+	}
+	pBld->eval = offs;
+	pBld->seq = pBld->eval + offsetof(MOT_EVAL, map) + pBld->nchn * sizeof(MOT_CMAP);
+	offs = pBld->seq + pBld->ntrk * 3 * sizeof(MOT_SEQ);
+	if (offs > UINT32_MAX) return 0;
+	pBld->size = offs;
+	return offs;
+}
+
+/* EVAL: per-kind counts, curves then constants, each in kind, node, channel order */
+static void bldeval(const MOT_CLIP_BUILDER* pBld, MOT_CLIP* pClip) {
+	MOT_EVAL* pEval = (MOT_EVAL*)((uint8_t*)pClip + pBld->eval);
+	int i, kind, chan, pass;
+	int imap = 0;
+	for (pass = 0; pass < 2; ++pass) {
+		for (kind = 0; kind < 3; ++kind) {
+			for (i = 0; i < pBld->nnod; ++i) {
+				const MOT_TRACK* pTrk = &pClip->nodes[i].trk[kind];
+				if (pass == 0 && pTrk->srcMask) {
+					++pEval->ntrk[kind];
+					pEval->nchn[kind] += motMaskChanCount(pTrk->srcMask);
+					pEval->ncrv[kind] += motMaskChanCount(pTrk->dataMask);
+				}
+				for (chan = 0; chan < 3; ++chan) {
+					int crv = (pTrk->dataMask >> chan) & 1;
+					if (!(pTrk->srcMask & (1 << chan)) || crv == pass) continue;
+					pEval->map[imap].node = (uint16_t)i;
+					pEval->map[imap].kind = (uint8_t)kind;
+					pEval->map[imap].chan = (uint8_t)chan;
+					++imap;
+				}
+			}
+		}
+	}
+}
+
+/* SEQ: 3 entries per track, -> data column or the constant in vmin, 0 for missing channels */
+static void bldseq(const MOT_CLIP_BUILDER* pBld, MOT_CLIP* pClip) {
+	MOT_SEQ* pSeq = (MOT_SEQ*)((uint8_t*)pClip + pBld->seq);
+	int i, kind, chan;
+	for (kind = 0; kind < 3; ++kind) {
+		for (i = 0; i < pBld->nnod; ++i) {
+			const MOT_NODE* pNode = &pClip->nodes[i];
+			const MOT_TRACK* pTrk = &pNode->trk[kind];
+			int col = 0;
+			if (!pTrk->srcMask) continue;
+			for (chan = 0; chan < 3; ++chan) {
+				MOT_SEQ* pEnt = pSeq++;
+				pEnt->node = (uint16_t)i;
+				pEnt->chan = (uint8_t)chan;
+				if (!(pTrk->srcMask & (1 << chan))) continue;
+				if (pTrk->dataMask & (1 << chan)) {
+					pEnt->offs = pNode->offs[kind] + col * sizeof(float);
+					pEnt->stride = pTrk->stride;
+					++col;
+				} else {
+					pEnt->offs = (uint32_t)((const uint8_t*)&pTrk->vmin.s[chan] - (const uint8_t*)pClip);
+				}
+			}
+		}
+	}
+}
+
+/* pMem: memSize >= motClipBuilderSize bytes, 4-byte aligned; NULL: allocated, released with free() */
+MOT_CLIP* motClipBuilderWrite(MOT_CLIP_BUILDER* pBld, void* pMem, size_t memSize) {
+	MOT_CLIP* pClip;
+	uint8_t* pTop;
+	size_t size = motClipBuilderSize(pBld);
+	int i, kind, f, chan;
+	if (!size) return NULL;
+	if (pMem) {
+		if (memSize < size || ((uintptr_t)pMem & 3)) return NULL;
+	} else {
+		pMem = malloc(size);
+		if (!pMem) return NULL;
+	}
+	pTop = (uint8_t*)pMem;
+	pClip = (MOT_CLIP*)pMem;
+	/* track data is written in full, only the tables are cleared */
+	memset(pTop, 0, pBld->hash + pBld->nnod * sizeof(uint32_t));
+	memset(pTop + pBld->eval, 0, size - pBld->eval);
+	memcpy(pClip->fmt, g_motClipFmt, 4);
+	pClip->size = (uint32_t)size;
+	pClip->rate = pBld->rate;
+	pClip->nfrm = pBld->nfrm;
+	pClip->nnod = pBld->nnod;
+	pClip->hash = (uint32_t)pBld->hash;
+	pClip->eval = (uint32_t)pBld->eval;
+	pClip->seq = (uint32_t)pBld->seq;
+	pClip->name = pBld->name;
+	for (i = 0; i < pBld->nnod; ++i) {
+		const BLD_NODE* pSrc = &pBld->pNodes[pBld->pOrd[i]];
+		MOT_NODE* pNode = &pClip->nodes[i];
+		pNode->name = pSrc->name;
+		pNode->xord = pSrc->xord;
+		pNode->rord = pSrc->rord;
+		((uint32_t*)(pTop + pBld->hash))[i] = pSrc->hash;
+		for (kind = 0; kind < 3; ++kind) {
+			const MOT_TRACK* pTrk = &pSrc->trk[kind];
+			float* pDst;
+			pNode->trk[kind] = *pTrk;
+			pNode->offs[kind] = pSrc->offs[kind];
+			if (!pTrk->dataMask) continue;
+			if (kind == TRK_ROT && pBld->rotMode == BROT_DEGREES) {
+				rotlogs(pBld->pLog, pSrc, pBld->nfrm);
+			}
+			pDst = (float*)(pTop + pSrc->offs[kind]);
+			for (f = 0; f < pBld->nfrm; ++f) {
+				for (chan = 0; chan < 3; ++chan) {
+					if (pTrk->dataMask & (1 << chan)) {
+						*pDst++ = trkval(pBld, pSrc, kind, chan, f);
+					}
+				}
+			}
+		}
+	}
+	bldeval(pBld, pClip);
+	bldseq(pBld, pClip);
+	return pClip;
+}
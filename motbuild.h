@@ -0,0 +1,37 @@
+/*
+ * Motion Clip builder
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ */
+
+#ifndef MOTBUILD_H
+#define MOTBUILD_H
+
+#include "motclip.h"
+
+/*
+ * In-memory MCLP construction, laid out as cMotClipWriter writes it:
+ * nodes in name hash order with the hash table, track data, EVAL and SEQ.
+ * Channels are given per node as float arrays of nfrm values, read with a
+ * stride (in floats) so that interleaved sources need no repacking; the
+ * arrays are only referenced and must stay valid until motClipBuilderWrite.
+ * Rotation channels are Euler degrees in the node's rotation order, stored
+ * as hemisphere-continuous quaternion log vectors (all three components are
+ * sources then), or with BROT_LOG the log vector components themselves.
+ * Channels that do not change are kept as constants (srcMask without dataMask).
+ * Node indices are the builder's, the clip orders nodes by name hash.
+ */
+typedef struct _MOT_CLIP_BUILDER MOT_CLIP_BUILDER;
+
+typedef enum _E_MOT_BROT { BROT_DEGREES, BROT_LOG } E_MOT_BROT;
+
+MOT_EXTERN_FUNC MOT_CLIP_BUILDER* motClipBuilderCreate(const char* pName, int nfrm, float rate);
+MOT_EXTERN_FUNC void motClipBuilderDestroy(MOT_CLIP_BUILDER* pBld);
+MOT_EXTERN_FUNC int motClipBuilderReset(MOT_CLIP_BUILDER* pBld, const char* pName, int nfrm, float rate);
+MOT_EXTERN_FUNC void motClipBuilderSetRotMode(MOT_CLIP_BUILDER* pBld, E_MOT_BROT mode);
+MOT_EXTERN_FUNC int motClipBuilderAddNode(MOT_CLIP_BUILDER* pBld, const char* pName, E_MOT_XORD xord, E_MOT_RORD rord);
+MOT_EXTERN_FUNC int motClipBuilderFindNode(const MOT_CLIP_BUILDER* pBld, const char* pName);
+MOT_EXTERN_FUNC int motClipBuilderSetChan(MOT_CLIP_BUILDER* pBld, int nodeIdx, E_MOT_TRK kind, int chan, const float* pVals, int stride);
+MOT_EXTERN_FUNC size_t motClipBuilderSize(MOT_CLIP_BUILDER* pBld);
+MOT_EXTERN_FUNC MOT_CLIP* motClipBuilderWrite(MOT_CLIP_BUILDER* pBld, void* pMem, size_t memSize);
+
+#endif /* MOTBUILD_H */
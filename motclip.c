@@ -5,6 +5,36 @@
 
 #include "motclip.h"
 
+#if !defined(MOT_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#	define MOT_SIMD_X86 1
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#elif !defined(MOT_NO_SIMD) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#	define MOT_SIMD_NEON 1
+#	include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define MOT_TARGET(_t) __attribute__((target(_t)))
+#else
+#	define MOT_TARGET(_t)
+#endif
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN 1
+#	define NOMINMAX
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
 const char g_motClipFmt[4] = { 'M', 'C', 'L', 'P' };
 const char g_motLibFmt[4] = { 'M', 'L', 'I', 'B' };
 
@@ -84,51 +114,229 @@ static void qmtx(float m[3][3], const MOT_QUAT q) {
 	m[2][2] = 1.0f - 2.0f*x*x - 2.0f*y*y;
 }
 
-void motMakeTransform(MOT_MTX* pMtx, const MOT_VEC tns, const MOT_QUAT rot, const MOT_VEC scl, E_MOT_XORD xord) {
-	MOT_MTX ms[3];
-	float qm[3][3];
-	const uint8_t S = 0;
-	const uint8_t R = 1;
-	const uint8_t T = 2;
-	int i, j, k;
-	int i0, i1, i2;
-	if (!pMtx) return;
+/*
+ * Closed-form TRS composition, flags describe where S and R act
+ * relative to T in the given order:
+ * 1 - S is applied before R (row scale instead of column scale),
+ * 2 - T is scaled (T before S and R),
+ * 4 - T is rotated (T before R),
+ * 8 - T is scaled after rotation (T before R before S).
+ */
+static int xordflg(E_MOT_XORD xord) {
+	int flg = 1;
 	switch (xord) {
 		default:
-		case XORD_SRT: i0 = S; i1 = R; i2 = T; break;
-		case XORD_STR: i0 = S; i1 = T; i2 = R; break;
-		case XORD_RST: i0 = R; i1 = S; i2 = T; break;
-		case XORD_RTS: i0 = R; i1 = T; i2 = S; break;
-		case XORD_TSR: i0 = T; i1 = S; i2 = R; break;
-		case XORD_TRS: i0 = T; i1 = R; i2 = S; break;
-	};
+		case XORD_SRT: flg = 1; break;
+		case XORD_STR: flg = 1 | 4; break;
+		case XORD_RST: flg = 0; break;
+		case XORD_RTS: flg = 8; break;
+		case XORD_TSR: flg = 1 | 2 | 4; break;
+		case XORD_TRS: flg = 4 | 8; break;
+	}
+	return flg;
+}
+
+static void mkaff(MOT_AFFINE* pAff, const MOT_VEC tns, const MOT_QUAT rot, const MOT_VEC scl, int flg) {
+	float qm[3][3];
+	float t[3];
+	int i, j;
 	qmtx(qm, rot);
-	for (k = 0; k < 3; ++k) {
-		for (i = 0; i < 4; ++i) {
-			for (j = 0; j < 4; ++j) {
-				if (i == j) {
-					float s = 1.0f;
-					if (k == 0 && i < 3) {
-						s = scl.s[i];
-					}
-					ms[k][i][j] = s;
-				} else {
-					float t = 0.0f;
-					if (i == 3 && k == 2 && i < 3) {
-						t = tns.s[i];
-					}
-					ms[k][i][j] = t;
-				}
-			}
+	for (i = 0; i < 3; ++i) {
+		t[i] = tns.s[i];
+	}
+	if (flg & 2) {
+		for (i = 0; i < 3; ++i) {
+			t[i] *= scl.s[i];
 		}
 	}
 	for (i = 0; i < 3; ++i) {
+		float ti = t[i];
+		if (flg & 4) {
+			ti = t[0]*qm[0][i] + t[1]*qm[1][i] + t[2]*qm[2][i];
+		}
+		if (flg & 8) {
+			ti *= scl.s[i];
+		}
 		for (j = 0; j < 3; ++j) {
-			ms[1][i][j] = qm[i][j];
+			(*pAff)[i][j] = qm[j][i] * ((flg & 1) ? scl.s[j] : scl.s[i]);
+		}
+		(*pAff)[i][3] = ti;
+	}
+}
+
+void motMakeAffine(MOT_AFFINE* pAff, const MOT_VEC tns, const MOT_QUAT rot, const MOT_VEC scl, E_MOT_XORD xord) {
+	if (!pAff) return;
+	mkaff(pAff, tns, rot, scl, xordflg(xord));
+}
+
+void motAffineToMtx(MOT_MTX* pMtx, const MOT_AFFINE* pAff) {
+	int i, j;
+	if (!pMtx || !pAff) return;
+	for (i = 0; i < 4; ++i) {
+		for (j = 0; j < 3; ++j) {
+			(*pMtx)[i][j] = (*pAff)[j][i];
+		}
+		(*pMtx)[i][3] = i < 3 ? 0.0f : 1.0f;
+	}
+}
+
+void motAffineFromMtx(MOT_AFFINE* pAff, const MOT_MTX* pMtx) {
+	int i, j;
+	if (!pAff || !pMtx) return;
+	for (i = 0; i < 3; ++i) {
+		for (j = 0; j < 4; ++j) {
+			(*pAff)[i][j] = (*pMtx)[j][i];
+		}
+	}
+}
+
+/* same sense as motMtxMul: pAff1 is applied first */
+void motAffineMul(MOT_AFFINE* pRes, const MOT_AFFINE* pAff1, const MOT_AFFINE* pAff2) {
+	MOT_AFFINE a;
+	int i, j;
+	if (!pRes || !pAff1 || !pAff2) return;
+	for (i = 0; i < 3; ++i) {
+		const float* pB = (*pAff2)[i];
+		for (j = 0; j < 4; ++j) {
+			a[i][j] = pB[0]*(*pAff1)[0][j] + pB[1]*(*pAff1)[1][j] + pB[2]*(*pAff1)[2][j];
+		}
+		a[i][3] += pB[3];
+	}
+	memcpy(pRes, &a, sizeof(MOT_AFFINE));
+}
+
+static void affAryScalar(MOT_AFFINE* pAff, const MOT_VEC* pTns, const MOT_QUAT* pRot, const MOT_VEC* pScl, int n, int flg) {
+	MOT_VEC t = { 0.0f, 0.0f, 0.0f };
+	MOT_QUAT q = { 0.0f, 0.0f, 0.0f, 1.0f };
+	MOT_VEC s = { 1.0f, 1.0f, 1.0f };
+	int i;
+	for (i = 0; i < n; ++i) {
+		if (pTns) t = pTns[i];
+		if (pRot) q = pRot[i];
+		if (pScl) s = pScl[i];
+		mkaff(&pAff[i], t, q, s, flg);
+	}
+}
+
+#if MOT_SIMD_X86
+static MOT_TARGET("avx2") void affAryAVX2(MOT_AFFINE* pAff, const MOT_VEC* pTns, const MOT_QUAT* pRot, const MOT_VEC* pScl, int n, int flg) {
+	const __m256i iq = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+	const __m256i iv = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	float res[12][8];
+	__m256 qx = _mm256_setzero_ps();
+	__m256 qy = qx;
+	__m256 qz = qx;
+	__m256 qw = one;
+	__m256 t[3], s[3], m[3][3], tr[3];
+	int i, j, k, idx;
+	int nblk = n / 8;
+	for (i = 0; i < 3; ++i) {
+		t[i] = _mm256_setzero_ps();
+		s[i] = one;
+	}
+	for (idx = 0; idx < nblk * 8; idx += 8) {
+		if (pRot) {
+			const float* pQ = pRot[idx].s;
+			qx = _mm256_i32gather_ps(pQ, iq, 4);
+			qy = _mm256_i32gather_ps(pQ + 1, iq, 4);
+			qz = _mm256_i32gather_ps(pQ + 2, iq, 4);
+			qw = _mm256_i32gather_ps(pQ + 3, iq, 4);
+		}
+		if (pTns) {
+			for (i = 0; i < 3; ++i) {
+				t[i] = _mm256_i32gather_ps(pTns[idx].s + i, iv, 4);
+			}
+		}
+		if (pScl) {
+			for (i = 0; i < 3; ++i) {
+				s[i] = _mm256_i32gather_ps(pScl[idx].s + i, iv, 4);
+			}
+		}
+		{
+			__m256 x2 = _mm256_mul_ps(two, qx);
+			__m256 y2 = _mm256_mul_ps(two, qy);
+			__m256 z2 = _mm256_mul_ps(two, qz);
+			__m256 xx = _mm256_mul_ps(x2, qx);
+			__m256 yy = _mm256_mul_ps(y2, qy);
+			__m256 zz = _mm256_mul_ps(z2, qz);
+			__m256 xy = _mm256_mul_ps(x2, qy);
+			__m256 xz = _mm256_mul_ps(x2, qz);
+			__m256 yz = _mm256_mul_ps(y2, qz);
+			__m256 wx = _mm256_mul_ps(x2, qw);
+			__m256 wy = _mm256_mul_ps(y2, qw);
+			__m256 wz = _mm256_mul_ps(z2, qw);
+			m[0][0] = _mm256_sub_ps(_mm256_sub_ps(one, yy), zz);
+			m[0][1] = _mm256_add_ps(xy, wz);
+			m[0][2] = _mm256_sub_ps(xz, wy);
+			m[1][0] = _mm256_sub_ps(xy, wz);
+			m[1][1] = _mm256_sub_ps(_mm256_sub_ps(one, xx), zz);
+			m[1][2] = _mm256_add_ps(yz, wx);
+			m[2][0] = _mm256_add_ps(xz, wy);
+			m[2][1] = _mm256_sub_ps(yz, wx);
+			m[2][2] = _mm256_sub_ps(_mm256_sub_ps(one, xx), yy);
+		}
+		for (i = 0; i < 3; ++i) {
+			tr[i] = (flg & 2) ? _mm256_mul_ps(t[i], s[i]) : t[i];
+		}
+		for (i = 0; i < 3; ++i) {
+			__m256 ti = tr[i];
+			if (flg & 4) {
+				ti = _mm256_mul_ps(tr[0], m[0][i]);
+				ti = _mm256_add_ps(ti, _mm256_mul_ps(tr[1], m[1][i]));
+				ti = _mm256_add_ps(ti, _mm256_mul_ps(tr[2], m[2][i]));
+			}
+			if (flg & 8) {
+				ti = _mm256_mul_ps(ti, s[i]);
+			}
+			for (j = 0; j < 3; ++j) {
+				_mm256_storeu_ps(res[i*4 + j], _mm256_mul_ps(m[j][i], (flg & 1) ? s[j] : s[i]));
+			}
+			_mm256_storeu_ps(res[i*4 + 3], ti);
 		}
+		for (k = 0; k < 8; ++k) {
+			float* pDst = &pAff[idx + k][0][0];
+			for (j = 0; j < 12; ++j) {
+				pDst[j] = res[j][k];
+			}
+		}
+	}
+	if (idx < n) {
+		affAryScalar(&pAff[idx],
+		             pTns ? &pTns[idx] : NULL,
+		             pRot ? &pRot[idx] : NULL,
+		             pScl ? &pScl[idx] : NULL,
+		             n - idx, flg);
+	}
+}
+#endif
+
+void motMakeAffineAryEx(MOT_AFFINE* pAff, const MOT_VEC* pTns, const MOT_QUAT* pRot, const MOT_VEC* pScl, int n, E_MOT_XORD xord, E_MOT_SIMD simd) {
+	int flg;
+	if (!pAff || n <= 0) return;
+	flg = xordflg(xord);
+	if (!motSIMDCk(simd)) {
+		simd = motGetSIMD();
+	}
+#if MOT_SIMD_X86
+	if (simd == SIMD_AVX2) {
+		affAryAVX2(pAff, pTns, pRot, pScl, n, flg);
+		return;
 	}
-	motMtxMul(pMtx, (const MOT_MTX*)&ms[i0], (const MOT_MTX*)&ms[i1]);
-	motMtxMul(pMtx, (const MOT_MTX*)pMtx, (const MOT_MTX*)&ms[i2]);
+#endif
+	affAryScalar(pAff, pTns, pRot, pScl, n, flg);
+}
+
+void motMakeAffineAry(MOT_AFFINE* pAff, const MOT_VEC* pTns, const MOT_QUAT* pRot, const MOT_VEC* pScl, int n, E_MOT_XORD xord) {
+	motMakeAffineAryEx(pAff, pTns, pRot, pScl, n, xord, motGetSIMD());
+}
+
+void motMakeTransform(MOT_MTX* pMtx, const MOT_VEC tns, const MOT_QUAT rot, const MOT_VEC scl, E_MOT_XORD xord) {
+	MOT_AFFINE aff;
+	if (!pMtx) return;
+	mkaff(&aff, tns, rot, scl, xordflg(xord));
+	motAffineToMtx(pMtx, &aff);
 }
 
 void motMakeTransformTR(MOT_MTX* pMtx, const MOT_VEC tns, const MOT_QUAT rot, E_MOT_XORD xord) {
@@ -158,7 +366,7 @@ void motMakeTransformTR(MOT_MTX* pMtx, const MOT_VEC tns, const MOT_QUAT rot, E_
 			}
 			for (i = 0; i < 3; ++i) {
 				for (j = 0; j < 3; ++j) {
-					(*pMtx)[3][i] += tns.s[j] * qm[i][j];
+					(*pMtx)[3][i] += tns.s[j] * qm[j][i];
 				}
 			}
 			break;
@@ -357,8 +565,10 @@ MOT_VEC motQuatToRadians(const MOT_QUAT q, E_MOT_RORD rord) {
 			break;
 	}
 	if (!singleAxis) {
-		int i, i0, i1, i2;
+		int i, j, i0, i1, i2;
+		int ax[3];
 		float sgn;
+		float qm[3][3];
 		float m[3][3];
 		float s, c;
 		switch (rord) {
@@ -370,7 +580,16 @@ MOT_VEC motQuatToRadians(const MOT_QUAT q, E_MOT_RORD rord) {
 			case RORD_ZXY: i0 = 2; i1 = 0; i2 = 1; sgn =  1.0f; break;
 			case RORD_ZYX: i0 = 2; i1 = 1; i2 = 0; sgn = -1.0f; break;
 		}
-		qmtx(m, q);
+		qmtx(qm, q);
+		/* rows and columns in rotation order, so that the XYZ extraction applies */
+		ax[0] = i0;
+		ax[1] = i1;
+		ax[2] = i2;
+		for (i = 0; i < 3; ++i) {
+			for (j = 0; j < 3; ++j) {
+				m[i][j] = qm[ax[i]][ax[j]];
+			}
+		}
 		r.s[i0] = atan2f(m[1][2], m[2][2]);
 		r.s[i1] = atan2f(-m[0][2], sqrtf(m[0][0]*m[0][0] + m[0][1]*m[0][1]));
 		s = sinf(r.s[i0]);
@@ -438,10 +657,9 @@ MOT_QUAT aryqexp(const MOT_VEC v) {
 	return q;
 }
 
-#if defined(_MSC_VER)
 #define ARY_BLK_SH (3)
 #define ARY_BLK_SIZE (1<<ARY_BLK_SH)
-void motQuatExpAry(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
+static void qexpAryBlk(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
 	float x[ARY_BLK_SIZE];
 	float y[ARY_BLK_SIZE];
 	float z[ARY_BLK_SIZE];
@@ -450,7 +668,6 @@ void motQuatExpAry(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
 	float h[ARY_BLK_SIZE];
 	int blk, elem, idx;
 	int nblk = n >> ARY_BLK_SH;
-	if (!pQuats || !pVecs || n <= 0) return;
 	for (blk = 0; blk < nblk; ++blk) {
 		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) {
 			idx = (blk << ARY_BLK_SH) + elem;
@@ -485,383 +702,3986 @@ void motQuatExpAry(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
 		pQuats[idx] = aryqexp(pVecs[idx]);
 	}
 }
-#else
-void motQuatExpAry(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
+
+static void qexpAryScalar(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
 	int idx;
 	for (idx = 0; idx < n; ++idx) {
 		pQuats[idx] = aryqexp(pVecs[idx]);
 	}
 }
-#endif
 
-int motClipHeaderCk(const MOT_CLIP* pClip) {
-	if (!pClip) return 0;
-	int i;
-	for (i = 0; i < 4; ++i) {
-		if (pClip->fmt[i] != g_motClipFmt[i]) return 0;
-	}
-	return 1;
+#if MOT_SIMD_X86
+/* [x0 y0 z0 x1] [y1 z1 x2 y2] [z2 x3 y3 z3] -> [x0..x3] [y0..y3] [z0..z3] */
+static MOT_TARGET("sse4.1") void sseLoadVec4(__m128* pX, __m128* pY, __m128* pZ, const MOT_VEC* pVecs) {
+	const float* p = pVecs->s;
+	__m128 a = _mm_loadu_ps(p);
+	__m128 b = _mm_loadu_ps(p + 4);
+	__m128 c = _mm_loadu_ps(p + 8);
+	__m128 t, u;
+	t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+	*pX = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+	t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+	u = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+	*pY = _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
+	t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+	u = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+	*pZ = _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
 }
 
-int motClipNodeIdxCk(const MOT_CLIP* pClip, int nodeIdx) {
-	return !!(pClip && ((uint32_t)nodeIdx < pClip->nnod));
+static MOT_TARGET("sse4.1") __m128 sseSeries(__m128 x2, const float tbl[]) {
+	__m128 r = _mm_set1_ps(tbl[3]);
+	r = _mm_add_ps(_mm_mul_ps(r, x2), _mm_set1_ps(tbl[2]));
+	r = _mm_add_ps(_mm_mul_ps(r, x2), _mm_set1_ps(tbl[1]));
+	r = _mm_add_ps(_mm_mul_ps(r, x2), _mm_set1_ps(tbl[0]));
+	return _mm_add_ps(_mm_mul_ps(r, x2), _mm_set1_ps(1.0f));
 }
 
-int motFrameNoCk(const MOT_CLIP* pClip, int fno) {
-	return !!(pClip && ((uint32_t)fno < pClip->nfrm));
+static MOT_TARGET("sse4.1") void qexpArySSE4(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
+	int idx;
+	int nblk = n >> 2;
+	for (idx = 0; idx < nblk << 2; idx += 4) {
+		__m128 x, y, z, w, h2, t;
+		sseLoadVec4(&x, &y, &z, &pVecs[idx]);
+		h2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		t = sseSeries(h2, s_sinctbl);
+		w = sseSeries(h2, s_costbl);
+		x = _mm_mul_ps(x, t);
+		y = _mm_mul_ps(y, t);
+		z = _mm_mul_ps(z, t);
+		t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+		t = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(t));
+		x = _mm_mul_ps(x, t);
+		y = _mm_mul_ps(y, t);
+		z = _mm_mul_ps(z, t);
+		w = _mm_mul_ps(w, t);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(pQuats[idx + 0].s, x);
+		_mm_storeu_ps(pQuats[idx + 1].s, y);
+		_mm_storeu_ps(pQuats[idx + 2].s, z);
+		_mm_storeu_ps(pQuats[idx + 3].s, w);
+	}
+	qexpAryScalar(&pQuats[idx], &pVecs[idx], n - idx);
 }
 
-int motNodeTrackCk(const MOT_CLIP* pClip, int nodeIdx, E_MOT_TRK trk) {
-	int res = 0;
-	if (pClip && motClipNodeIdxCk(pClip, nodeIdx)) {
-		switch (trk) {
-			case TRK_POS:
-			case TRK_ROT:
-			case TRK_SCL:
-				res = pClip->nodes[nodeIdx].trk[trk].srcMask != 0;
-				break;
-			default:
-				break;
-		}
-	}
-	return res;
+static MOT_TARGET("avx2") __m256 avxSeries(__m256 x2, const float tbl[]) {
+	__m256 r = _mm256_set1_ps(tbl[3]);
+	r = _mm256_add_ps(_mm256_mul_ps(r, x2), _mm256_set1_ps(tbl[2]));
+	r = _mm256_add_ps(_mm256_mul_ps(r, x2), _mm256_set1_ps(tbl[1]));
+	r = _mm256_add_ps(_mm256_mul_ps(r, x2), _mm256_set1_ps(tbl[0]));
+	return _mm256_add_ps(_mm256_mul_ps(r, x2), _mm256_set1_ps(1.0f));
 }
 
-static uint32_t strhash(uint32_t* pLen, const char* pStr) {
-	uint32_t c;
-	uint32_t len = 0;
-	uint32_t h = 2166136261U;
-	while (c = *pStr++) {
-		h *= 16777619U;
-		h ^= c;
-		++len;
+static MOT_TARGET("avx2") void qexpAryAVX2(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
+	int idx;
+	int nblk = n >> 3;
+	for (idx = 0; idx < nblk << 3; idx += 8) {
+		__m128 x0, y0, z0, x1, y1, z1;
+		__m256 x, y, z, w, h2, t;
+		__m256 t0, t1, t2, t3;
+		sseLoadVec4(&x0, &y0, &z0, &pVecs[idx]);
+		sseLoadVec4(&x1, &y1, &z1, &pVecs[idx + 4]);
+		x = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+		y = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+		z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+		h2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+		t = avxSeries(h2, s_sinctbl);
+		w = avxSeries(h2, s_costbl);
+		x = _mm256_mul_ps(x, t);
+		y = _mm256_mul_ps(y, t);
+		z = _mm256_mul_ps(z, t);
+		t = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_add_ps(_mm256_mul_ps(z, z), _mm256_mul_ps(w, w)));
+		t = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(t));
+		x = _mm256_mul_ps(x, t);
+		y = _mm256_mul_ps(y, t);
+		z = _mm256_mul_ps(z, t);
+		w = _mm256_mul_ps(w, t);
+		/* per-lane 4x4 transpose: lane 0 -> quats 0..3, lane 1 -> quats 4..7 */
+		t0 = _mm256_unpacklo_ps(x, y);
+		t1 = _mm256_unpackhi_ps(x, y);
+		t2 = _mm256_unpacklo_ps(z, w);
+		t3 = _mm256_unpackhi_ps(z, w);
+		x = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		y = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		z = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		w = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		_mm256_storeu_ps(pQuats[idx + 0].s, _mm256_permute2f128_ps(x, y, 0x20));
+		_mm256_storeu_ps(pQuats[idx + 2].s, _mm256_permute2f128_ps(z, w, 0x20));
+		_mm256_storeu_ps(pQuats[idx + 4].s, _mm256_permute2f128_ps(x, y, 0x31));
+		_mm256_storeu_ps(pQuats[idx + 6].s, _mm256_permute2f128_ps(z, w, 0x31));
 	}
-	*pLen = len;
-	return h;
+	qexpArySSE4(&pQuats[idx], &pVecs[idx], n - idx);
 }
+#endif /* MOT_SIMD_X86 */
 
-static int hfind(const uint32_t* pHashes, int n, uint32_t h) {
-	const uint32_t* p = pHashes;
-	uint32_t cnt = (uint32_t)n;
-	while (cnt > 1) {
-		uint32_t mid = cnt / 2;
-		const uint32_t* pm = &p[mid];
-		uint32_t ck = *pm;
-		p = (h < ck) ? p : pm;
-		cnt -= mid;
-	}
-	return (int)(p - pHashes) + ((p != pHashes) & (*p > h));
+#if MOT_SIMD_NEON
+static float32x4_t neonSeries(float32x4_t x2, const float tbl[]) {
+	float32x4_t r = vdupq_n_f32(tbl[3]);
+	r = vmlaq_f32(vdupq_n_f32(tbl[2]), r, x2);
+	r = vmlaq_f32(vdupq_n_f32(tbl[1]), r, x2);
+	r = vmlaq_f32(vdupq_n_f32(tbl[0]), r, x2);
+	return vmlaq_f32(vdupq_n_f32(1.0f), r, x2);
 }
 
-int motFindClipNode(const MOT_CLIP* pClip, const char* pName) {
-	int idx = -1;
-	const int binSearchThreshold = 20;
-	if (pClip && pName) {
-		int i;
-		int n = pClip->nnod;
-		if (n > binSearchThreshold && pClip->hash) {
-			uint32_t len;
-			uint32_t h = strhash(&len, pName);
-			if ((size_t)len < sizeof(MOT_STRING) - 2) {
-				uint32_t* pHashes = (uint32_t*)((uint8_t*)pClip + pClip->hash);
-				int hidx = hfind(pHashes, n, h);
-				if (h == pHashes[hidx]) {
-					int nc = 1;
-					for (i = hidx; --i >= 0;) {
-						if (pHashes[i] != h) break;
-						--idx;
-						++nc;
-					}
-					for (i = 0; i < nc; ++i) {
-						int tidx = hidx + i;
-						const MOT_NODE* pNode = &pClip->nodes[tidx];
-						if (len == pNode->name.len) {
-							if (memcmp(pNode->name.chr, pName, len) == 0) {
-								idx = tidx;
-								break;
-							}
-						}
-					}
-				}
-			}
-		} else {
-			for (i = 0; i < n; ++i) {
-				if (strcmp(pClip->nodes[i].name.chr, pName) == 0) {
-					idx = i;
-					break;
-				}
-			}
-		}
+static float32x4_t neonRcpSqrt(float32x4_t x) {
+	float32x4_t r = vrsqrteq_f32(x);
+	r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+	r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+	return r;
+}
+
+static void qexpAryNEON(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
+	int idx;
+	int nblk = n >> 2;
+	for (idx = 0; idx < nblk << 2; idx += 4) {
+		float32x4x3_t v = vld3q_f32(pVecs[idx].s);
+		float32x4x4_t q;
+		float32x4_t h2, t;
+		h2 = vmulq_f32(v.val[0], v.val[0]);
+		h2 = vmlaq_f32(h2, v.val[1], v.val[1]);
+		h2 = vmlaq_f32(h2, v.val[2], v.val[2]);
+		t = neonSeries(h2, s_sinctbl);
+		q.val[3] = neonSeries(h2, s_costbl);
+		q.val[0] = vmulq_f32(v.val[0], t);
+		q.val[1] = vmulq_f32(v.val[1], t);
+		q.val[2] = vmulq_f32(v.val[2], t);
+		t = vmulq_f32(q.val[0], q.val[0]);
+		t = vmlaq_f32(t, q.val[1], q.val[1]);
+		t = vmlaq_f32(t, q.val[2], q.val[2]);
+		t = vmlaq_f32(t, q.val[3], q.val[3]);
+		t = neonRcpSqrt(t);
+		q.val[0] = vmulq_f32(q.val[0], t);
+		q.val[1] = vmulq_f32(q.val[1], t);
+		q.val[2] = vmulq_f32(q.val[2], t);
+		q.val[3] = vmulq_f32(q.val[3], t);
+		vst4q_f32(pQuats[idx].s, q);
 	}
-	return idx;
+	qexpAryScalar(&pQuats[idx], &pVecs[idx], n - idx);
 }
+#endif /* MOT_SIMD_NEON */
 
-int motClipTrackCount(const MOT_CLIP* pClip, E_MOT_TRK kind) {
-	int n = 0;
-	MOT_EVAL* pEval = motGetEvalInfo(pClip);
-	switch (kind) {
-		case TRK_POS:
-		case TRK_ROT:
-		case TRK_SCL:
-			if (pEval) {
-				n = pEval->ntrk[(int)kind];
-			} else if (pClip) {
-				int i;
-				int nnod = pClip->nnod;
-				for (i = 0; i < nnod; ++i) {
-					if (motNodeTrackCk(pClip, i, kind)) {
-						++n;
-					}
+#if MOT_SIMD_X86
+static void cpuid(uint32_t info[4], uint32_t leaf, uint32_t sub) {
+#if defined(_MSC_VER)
+	__cpuidex((int*)info, (int)leaf, (int)sub);
+#else
+	__cpuid_count(leaf, sub, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+static uint64_t xgetbv0(void) {
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t lo, hi;
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((uint64_t)hi << 32) | lo;
+#endif
+}
+#endif
+
+static E_MOT_SIMD simddetect(void) {
+	E_MOT_SIMD simd = SIMD_BLOCK;
+#if MOT_SIMD_X86
+	uint32_t info[4];
+	cpuid(info, 0, 0);
+	if (info[0] >= 1) {
+		uint32_t nleaf = info[0];
+		cpuid(info, 1, 0);
+		if (info[2] & (1 << 19)) {
+			simd = SIMD_SSE4;
+		}
+		/* AVX2 needs OSXSAVE + AVX and the OS saving YMM state */
+		if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && nleaf >= 7) {
+			if ((xgetbv0() & 6) == 6) {
+				cpuid(info, 7, 0);
+				if (info[1] & (1 << 5)) {
+					simd = SIMD_AVX2;
 				}
 			}
-			break;
+		}
 	}
-	return n;
+#elif MOT_SIMD_NEON
+	simd = SIMD_NEON;
+#endif
+	return simd;
 }
 
-MOT_EVAL* motGetEvalInfo(const MOT_CLIP* pClip) {
-	MOT_EVAL* pEval = NULL;
-	if (pClip && pClip->eval) {
-		pEval = (MOT_EVAL*)&((uint8_t*)pClip)[pClip->eval];
+static int s_simd = -1;
+
+E_MOT_SIMD motGetSIMD(void) {
+	if (s_simd < 0) {
+		s_simd = (int)simddetect();
 	}
-	return pEval;
+	return (E_MOT_SIMD)s_simd;
 }
 
-MOT_SEQ* motGetSeqInfo(const MOT_CLIP* pClip) {
-	MOT_SEQ* pSeq = NULL;
-	if (pClip && pClip->seq) {
-		pSeq = (MOT_SEQ*)&((uint8_t*)pClip)[pClip->seq];
+int motSIMDCk(E_MOT_SIMD simd) {
+	E_MOT_SIMD best = motGetSIMD();
+	int res = 0;
+	switch (simd) {
+		case SIMD_NONE:
+		case SIMD_BLOCK:
+			res = 1;
+			break;
+		case SIMD_SSE4:
+			res = best == SIMD_SSE4 || best == SIMD_AVX2;
+			break;
+		case SIMD_AVX2:
+		case SIMD_NEON:
+			res = best == simd;
+			break;
 	}
-	return pSeq;
+	return res;
 }
 
-float* motGetTrackData(const MOT_CLIP* pClip, int nodeIdx, E_MOT_TRK trk) {
-	float* p = NULL;
-	if (pClip && motClipNodeIdxCk(pClip, nodeIdx)) {
-		int itrk = (int)trk;
-		if (itrk < 3) {
-			uint32_t offs = pClip->nodes[nodeIdx].offs[itrk];
-			if (offs) {
-				char* pTop = (char*)pClip;
-				p = (float*)&pTop[offs];
-			}
-		}
+const char* motSIMDName(E_MOT_SIMD simd) {
+	const char* pName = "?";
+	switch (simd) {
+		case SIMD_NONE: pName = "none"; break;
+		case SIMD_BLOCK: pName = "block"; break;
+		case SIMD_SSE4: pName = "SSE4.1"; break;
+		case SIMD_AVX2: pName = "AVX2"; break;
+		case SIMD_NEON: pName = "NEON"; break;
 	}
-	return p;
+	return pName;
 }
 
-void motGetChanData(const MOT_CLIP* pClip, int nodeIdx, E_MOT_TRK trk, int chIdx, float** ppData, int* pStride) {
-	int stride = 0;
-	float* p = NULL;
-	if ((uint32_t)chIdx < 3) {
-		float* pTrk = motGetTrackData(pClip, nodeIdx, trk);
-		if (pTrk) {
-			int i;
-			int dataMask = pClip->nodes[nodeIdx].trk[(int)trk].dataMask;
-			for (i = 0; i < 3; ++i) {
-				if (dataMask & (1 << i)) {
-					p = pTrk + stride;
-					++stride;
-				}
-			}
-		}
+void motQuatExpAryEx(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n, E_MOT_SIMD simd) {
+	if (!pQuats || !pVecs || n <= 0) return;
+	if (!motSIMDCk(simd)) {
+		simd = motGetSIMD();
 	}
-	if (ppData) {
-		*ppData = p;
+	switch (simd) {
+		case SIMD_NONE:
+			qexpAryScalar(pQuats, pVecs, n);
+			break;
+#if MOT_SIMD_X86
+		case SIMD_SSE4:
+			qexpArySSE4(pQuats, pVecs, n);
+			break;
+		case SIMD_AVX2:
+			qexpAryAVX2(pQuats, pVecs, n);
+			break;
+#endif
+#if MOT_SIMD_NEON
+		case SIMD_NEON:
+			qexpAryNEON(pQuats, pVecs, n);
+			break;
+#endif
+		default:
+			qexpAryBlk(pQuats, pVecs, n);
+			break;
 	}
-	if (pStride) {
-		*pStride = stride;
+}
+
+void motQuatExpAry(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
+	motQuatExpAryEx(pQuats, pVecs, n, motGetSIMD());
+}
+
+/*
+ * Euler angle arrays.
+ * Quaternions are composed from the half angle sin/cos products directly
+ * instead of three axis quaternions, and angles are taken from the nine
+ * rotation matrix terms written out in the quaternion components.
+ * The axes are permuted to rotation order; odd orders extract with w
+ * negated and negate the angles, as motQuatToRadians does.
+ * The third angle uses the unnormalized sin/cos of the first one.
+ * sin/cos: quadrant reduction with a three part pi/2, Cephes sinf/cosf
+ * polynomials over [-pi/4, pi/4].
+ * atan2: octant reduction to |t| <= tan(pi/8) with one division, Cephes
+ * atanf polynomial.
+ * Single axis rotations take the angle from atan2 where motQuatToRadians
+ * uses acos(w), so they are as close to the source angles or closer.
+ * Error bounds against motQuatFromRadians/motQuatToRadians (libm):
+ * quaternion components within 1e-6 for angles up to 1e4 radians (2.4e-7
+ * measured); angles within 1e-6 + 1e-7/|cos(middle angle)| radians away
+ * from gimbal lock, where the float rounding of the matrix terms dominates
+ * and only the rotation is defined; the rotation the angles describe within
+ * 1e-6 radians everywhere (3e-7 measured).
+ */
+
+static const float s_eulsin[] = { -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f };
+static const float s_eulcos[] = { 4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f };
+static const float s_eulatan[] = { -3.33329491539e-1f, 1.99777106478e-1f, -1.38776856032e-1f, 8.05374449538e-2f };
+static const float s_eulpio2[] = { 1.5703125f, 4.837512969970703125e-4f, 7.54978995489188216e-8f };
+
+#define EUL_2OPI (0.636619772367581343f)
+#define EUL_TAN1PI8 (0.414213562373095049f)
+#define EUL_TAN3PI8 (2.41421356237309505f)
+#define EUL_EPS (1.0e-6f)
+
+/* rotation order axes, first applied axis first; -1 for odd permutations */
+static float eulaxes(int ax[3], E_MOT_RORD rord) {
+	float sgn = 1.0f;
+	switch (rord) {
+		default:
+		case RORD_XYZ: ax[0] = 0; ax[1] = 1; ax[2] = 2; break;
+		case RORD_XZY: ax[0] = 0; ax[1] = 2; ax[2] = 1; sgn = -1.0f; break;
+		case RORD_YXZ: ax[0] = 1; ax[1] = 0; ax[2] = 2; sgn = -1.0f; break;
+		case RORD_YZX: ax[0] = 1; ax[1] = 2; ax[2] = 0; break;
+		case RORD_ZXY: ax[0] = 2; ax[1] = 0; ax[2] = 1; break;
+		case RORD_ZYX: ax[0] = 2; ax[1] = 1; ax[2] = 0; sgn = -1.0f; break;
 	}
+	return sgn;
 }
 
-E_MOT_RORD motGetRotOrd(const MOT_CLIP* pClip, int nodeIdx) {
-	return motClipNodeIdxCk(pClip, nodeIdx) ? (E_MOT_RORD)pClip->nodes[nodeIdx].rord : RORD_XYZ;
+static void arysincos(float* pSin, float* pCos, float x) {
+	float k = floorf(x * EUL_2OPI + 0.5f);
+	int iq = (int)k;
+	float r = ((x - k*s_eulpio2[0]) - k*s_eulpio2[1]) - k*s_eulpio2[2];
+	float z = r * r;
+	float s = r + r*z*(s_eulsin[0] + z*(s_eulsin[1] + z*s_eulsin[2]));
+	float c = 1.0f - 0.5f*z + z*z*(s_eulcos[0] + z*(s_eulcos[1] + z*s_eulcos[2]));
+	float t = (iq & 1) ? c : s;
+	c = (iq & 1) ? s : c;
+	*pSin = (iq & 2) ? -t : t;
+	*pCos = ((iq + 1) & 2) ? -c : c;
 }
 
-E_MOT_XORD motGetXformOrd(const MOT_CLIP* pClip, int nodeIdx) {
-	return motClipNodeIdxCk(pClip, nodeIdx) ? (E_MOT_XORD)pClip->nodes[nodeIdx].xord : XORD_SRT;
+static float aryatan2(float y, float x) {
+	float ax = fabsf(x);
+	float ay = fabsf(y);
+	float num = ay;
+	float den = ax;
+	float offs = 0.0f;
+	float t, z, a;
+	if (ay > ax * EUL_TAN3PI8) {
+		num = -ax;
+		den = ay;
+		offs = c_pi * 0.5f;
+	} else if (ay > ax * EUL_TAN1PI8) {
+		num = ay - ax;
+		den = ay + ax;
+		offs = c_pi * 0.25f;
+	}
+	t = num / fmaxf(den, FLT_MIN);
+	z = t * t;
+	a = offs + t + t*z*(s_eulatan[0] + z*(s_eulatan[1] + z*(s_eulatan[2] + z*s_eulatan[3])));
+	if (signbit(x)) a = c_pi - a;
+	return copysignf(a, y);
 }
 
-MOT_VEC motGetVec(const MOT_CLIP* pClip, int nodeIdx, int fno, E_MOT_TRK trk) {
-	MOT_VEC v = {0.0f, 0.0f, 0.0f};
-	if (pClip && motClipNodeIdxCk(pClip, nodeIdx) && motFrameNoCk(pClip, fno)) {
-		int i;
-		float* p = motGetTrackData(pClip, nodeIdx, trk);
-		if (p) {
-			int itrk = (int)trk;
-			if (itrk < 3) {
-				float defVal = trk == TRK_SCL ? 1.0f : 0.0f;
-				int dataMask = pClip->nodes[nodeIdx].trk[itrk].dataMask;
-				int srcMask = pClip->nodes[nodeIdx].trk[itrk].srcMask;
-				int vsize = 0;
-				for (i = 0; i < 3; ++i) {
-					if (dataMask & (1 << i)) ++vsize;
-				}
-				p += fno * vsize;
+/* scl: angle to half angle in radians */
+static MOT_QUAT aryqeuler(const MOT_VEC v, const int ax[3], float sgn, float scl) {
+	MOT_QUAT q;
+	float s0, c0, s1, c1, s2, c2;
+	arysincos(&s0, &c0, v.s[ax[0]] * scl);
+	arysincos(&s1, &c1, v.s[ax[1]] * scl);
+	arysincos(&s2, &c2, v.s[ax[2]] * scl);
+	q.s[ax[0]] = s0*c1*c2 - sgn*c0*s1*s2;
+	q.s[ax[1]] = c0*s1*c2 + sgn*s0*c1*s2;
+	q.s[ax[2]] = c0*c1*s2 - sgn*s0*s1*c2;
+	q.w = c0*c1*c2 + sgn*s0*s1*s2;
+	return q;
+}
+
+/* single axis rotations stay in [-pi, pi] about their axis, as in motQuatToRadians */
+static int aryeulaxis(MOT_VEC* pRad, const MOT_QUAT q, float scl) {
+	int mask = 0;
+	int i;
+	for (i = 0; i < 3; ++i) {
+		if (fabsf(q.s[i]) < EUL_EPS) mask |= 1 << i;
+	}
+	if (fabsf(q.w) < EUL_EPS || (mask != 7 && mask != 6 && mask != 5 && mask != 3)) return 0;
+	for (i = 0; i < 3; ++i) {
+		pRad->s[i] = 0.0f;
+	}
+	if (mask != 7) {
+		i = mask == 6 ? 0 : mask == 5 ? 1 : 2;
+		pRad->s[i] = 2.0f * aryatan2(q.w < 0.0f ? -q.s[i] : q.s[i], fabsf(q.w)) * scl;
+	}
+	return 1;
+}
+
+/* scl: radians to output units, including the order sign */
+static MOT_VEC aryeulerq(const MOT_QUAT q, const int ax[3], float sgn, float scl) {
+	MOT_VEC r;
+	float x = q.s[ax[0]];
+	float y = q.s[ax[1]];
+	float z = q.s[ax[2]];
+	float w = q.w * sgn;
+	float m00 = 1.0f - 2.0f*(y*y + z*z);
+	float m01 = 2.0f*(x*y + w*z);
+	float m02 = 2.0f*(x*z - w*y);
+	float m10 = 2.0f*(x*y - w*z);
+	float m11 = 1.0f - 2.0f*(x*x + z*z);
+	float m12 = 2.0f*(y*z + w*x);
+	float m20 = 2.0f*(x*z + w*y);
+	float m21 = 2.0f*(y*z - w*x);
+	float m22 = 1.0f - 2.0f*(x*x + y*y);
+	float c = (m12 == 0.0f && m22 == 0.0f) ? 1.0f : m22;
+	if (aryeulaxis(&r, q, scl * sgn)) return r;
+	r.s[ax[0]] = aryatan2(m12, m22) * scl;
+	r.s[ax[1]] = aryatan2(-m02, sqrtf(m00*m00 + m01*m01)) * scl;
+	r.s[ax[2]] = aryatan2(m12*m20 - c*m10, c*m11 - m12*m21) * scl;
+	return r;
+}
+
+static void qeulerAryScalar(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n, const int ax[3], float sgn, float scl) {
+	int idx;
+	for (idx = 0; idx < n; ++idx) {
+		pQuats[idx] = aryqeuler(pVecs[idx], ax, sgn, scl);
+	}
+}
+
+static void eulerqAryScalar(MOT_VEC* pVecs, const MOT_QUAT* pQuats, int n, const int ax[3], float sgn, float scl) {
+	int idx;
+	for (idx = 0; idx < n; ++idx) {
+		pVecs[idx] = aryeulerq(pQuats[idx], ax, sgn, scl);
+	}
+}
+
+static void qeulerAryBlk(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n, const int ax[3], float sgn, float scl) {
+	float h[3][ARY_BLK_SIZE];
+	float s[3][ARY_BLK_SIZE];
+	float c[3][ARY_BLK_SIZE];
+	float q[4][ARY_BLK_SIZE];
+	int blk, elem, idx, i;
+	int nblk = n >> ARY_BLK_SH;
+	for (blk = 0; blk < nblk; ++blk) {
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) {
+			idx = (blk << ARY_BLK_SH) + elem;
+			for (i = 0; i < 3; ++i) {
+				h[i][elem] = pVecs[idx].s[ax[i]] * scl;
+			}
+		}
+
+		for (i = 0; i < 3; ++i) {
+			for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { arysincos(&s[i][elem], &c[i][elem], h[i][elem]); }
+		}
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { q[0][elem] = s[0][elem]*c[1][elem]*c[2][elem] - sgn*c[0][elem]*s[1][elem]*s[2][elem]; }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { q[1][elem] = c[0][elem]*s[1][elem]*c[2][elem] + sgn*s[0][elem]*c[1][elem]*s[2][elem]; }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { q[2][elem] = c[0][elem]*c[1][elem]*s[2][elem] - sgn*s[0][elem]*s[1][elem]*c[2][elem]; }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { q[3][elem] = c[0][elem]*c[1][elem]*c[2][elem] + sgn*s[0][elem]*s[1][elem]*s[2][elem]; }
+
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) {
+			idx = (blk << ARY_BLK_SH) + elem;
+			for (i = 0; i < 3; ++i) {
+				pQuats[idx].s[ax[i]] = q[i][elem];
+			}
+			pQuats[idx].w = q[3][elem];
+		}
+	}
+	idx = nblk << ARY_BLK_SH;
+	qeulerAryScalar(&pQuats[idx], &pVecs[idx], n - idx, ax, sgn, scl);
+}
+
+static void eulerqAryBlk(MOT_VEC* pVecs, const MOT_QUAT* pQuats, int n, const int ax[3], float sgn, float scl) {
+	float q[4][ARY_BLK_SIZE];
+	float m[9][ARY_BLK_SIZE];
+	float r[3][ARY_BLK_SIZE];
+	int blk, elem, idx, i;
+	int nblk = n >> ARY_BLK_SH;
+	for (blk = 0; blk < nblk; ++blk) {
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) {
+			idx = (blk << ARY_BLK_SH) + elem;
+			for (i = 0; i < 3; ++i) {
+				q[i][elem] = pQuats[idx].s[ax[i]];
+			}
+			q[3][elem] = pQuats[idx].w * sgn;
+		}
+
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { m[0][elem] = 1.0f - 2.0f*(sq(q[1][elem]) + sq(q[2][elem])); }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { m[1][elem] = 2.0f*(q[0][elem]*q[1][elem] + q[3][elem]*q[2][elem]); }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { m[2][elem] = 2.0f*(q[0][elem]*q[2][elem] - q[3][elem]*q[1][elem]); }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { m[3][elem] = 2.0f*(q[0][elem]*q[1][elem] - q[3][elem]*q[2][elem]); }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { m[4][elem] = 1.0f - 2.0f*(sq(q[0][elem]) + sq(q[2][elem])); }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { m[5][elem] = 2.0f*(q[1][elem]*q[2][elem] + q[3][elem]*q[0][elem]); }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { m[6][elem] = 2.0f*(q[0][elem]*q[2][elem] + q[3][elem]*q[1][elem]); }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { m[7][elem] = 2.0f*(q[1][elem]*q[2][elem] - q[3][elem]*q[0][elem]); }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { m[8][elem] = 1.0f - 2.0f*(sq(q[0][elem]) + sq(q[1][elem])); }
+
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { r[0][elem] = aryatan2(m[5][elem], m[8][elem]); }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) { r[1][elem] = aryatan2(-m[2][elem], sqrtf(sq(m[0][elem]) + sq(m[1][elem]))); }
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) {
+			float c = (m[5][elem] == 0.0f && m[8][elem] == 0.0f) ? 1.0f : m[8][elem];
+			r[2][elem] = aryatan2(m[5][elem]*m[6][elem] - c*m[3][elem], c*m[4][elem] - m[5][elem]*m[7][elem]);
+		}
+
+		for (elem = 0; elem < ARY_BLK_SIZE; ++elem) {
+			idx = (blk << ARY_BLK_SH) + elem;
+			if (!aryeulaxis(&pVecs[idx], pQuats[idx], scl * sgn)) {
 				for (i = 0; i < 3; ++i) {
-					if (dataMask & (1 << i)) {
-						v.s[i] = *p++;
-					} else if (srcMask & (1 << i)) {
-						v.s[i] = pClip->nodes[nodeIdx].trk[itrk].vmin.s[i];
-					} else {
-						v.s[i] = defVal;
-					}
+					pVecs[idx].s[ax[i]] = r[i][elem] * scl;
 				}
 			}
 		}
 	}
-	return v;
+	idx = nblk << ARY_BLK_SH;
+	eulerqAryScalar(&pVecs[idx], &pQuats[idx], n - idx, ax, sgn, scl);
 }
 
-MOT_VEC motGetPos(const MOT_CLIP* pClip, int nodeIdx, int fno) {
-	return motGetVec(pClip, nodeIdx, fno, TRK_POS);
+#if MOT_SIMD_X86
+/* [x0..x3] [y0..y3] [z0..z3] -> [x0 y0 z0 x1] [y1 z1 x2 y2] [z2 x3 y3 z3] */
+static MOT_TARGET("sse4.1") void sseStoreVec4(MOT_VEC* pVecs, __m128 x, __m128 y, __m128 z) {
+	float* p = pVecs->s;
+	__m128 t, u;
+	t = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+	_mm_storeu_ps(p, _mm_shuffle_ps(_mm_unpacklo_ps(x, y), t, _MM_SHUFFLE(2, 0, 1, 0)));
+	t = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+	u = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));
+	_mm_storeu_ps(p + 4, _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
+	t = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+	u = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+	_mm_storeu_ps(p + 8, _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0)));
 }
 
-MOT_VEC motGetScl(const MOT_CLIP* pClip, int nodeIdx, int fno) {
-	if (!motNodeTrackCk(pClip, nodeIdx, TRK_SCL)) {
-		MOT_VEC s = { 1.0f, 1.0f, 1.0f };
-		return s;
+static MOT_TARGET("sse4.1") void sseSinCos(__m128* pSin, __m128* pCos, __m128 x) {
+	__m128 k = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(EUL_2OPI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m128i iq = _mm_cvttps_epi32(k);
+	__m128 r, z, s, c, swp;
+	r = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(s_eulpio2[0])));
+	r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(s_eulpio2[1])));
+	r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(s_eulpio2[2])));
+	z = _mm_mul_ps(r, r);
+	s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s_eulsin[2]), z), _mm_set1_ps(s_eulsin[1]));
+	s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(s_eulsin[0]));
+	s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), r), r);
+	c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s_eulcos[2]), z), _mm_set1_ps(s_eulcos[1]));
+	c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(s_eulcos[0]));
+	c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+	c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+	/* quadrant bit 0 swaps, bit 1 negates sin, bit 1 of q+1 negates cos */
+	swp = _mm_castsi128_ps(_mm_slli_epi32(iq, 31));
+	*pSin = _mm_xor_ps(_mm_blendv_ps(s, c, swp), _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(iq, 1), 31)));
+	*pCos = _mm_xor_ps(_mm_blendv_ps(c, s, swp), _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(_mm_add_epi32(iq, _mm_set1_epi32(1)), 1), 31)));
+}
+
+static MOT_TARGET("sse4.1") __m128 sseAtan2(__m128 y, __m128 x) {
+	__m128 sgn = _mm_set1_ps(-0.0f);
+	__m128 ax = _mm_andnot_ps(sgn, x);
+	__m128 ay = _mm_andnot_ps(sgn, y);
+	__m128 m1 = _mm_cmpgt_ps(ay, _mm_mul_ps(ax, _mm_set1_ps(EUL_TAN1PI8)));
+	__m128 m3 = _mm_cmpgt_ps(ay, _mm_mul_ps(ax, _mm_set1_ps(EUL_TAN3PI8)));
+	__m128 num = _mm_blendv_ps(_mm_blendv_ps(ay, _mm_sub_ps(ay, ax), m1), _mm_xor_ps(ax, sgn), m3);
+	__m128 den = _mm_blendv_ps(_mm_blendv_ps(ax, _mm_add_ps(ay, ax), m1), ay, m3);
+	__m128 offs = _mm_blendv_ps(_mm_and_ps(m1, _mm_set1_ps(c_pi * 0.25f)), _mm_set1_ps(c_pi * 0.5f), m3);
+	__m128 t = _mm_div_ps(num, _mm_max_ps(den, _mm_set1_ps(FLT_MIN)));
+	__m128 z = _mm_mul_ps(t, t);
+	__m128 a = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s_eulatan[3]), z), _mm_set1_ps(s_eulatan[2]));
+	a = _mm_add_ps(_mm_mul_ps(a, z), _mm_set1_ps(s_eulatan[1]));
+	a = _mm_add_ps(_mm_mul_ps(a, z), _mm_set1_ps(s_eulatan[0]));
+	a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(a, z), t), t), offs);
+	a = _mm_blendv_ps(a, _mm_sub_ps(_mm_set1_ps(c_pi), a), x);
+	return _mm_or_ps(a, _mm_and_ps(y, sgn));
+}
+
+/* aryeulaxis lanes: the only non-zero axis angle of the single axis rotations */
+static MOT_TARGET("sse4.1") void sseEulAxis(__m128 r[3], const __m128 q[4], __m128 uscl) {
+	__m128 sgn = _mm_set1_ps(-0.0f);
+	__m128 eps = _mm_set1_ps(EUL_EPS);
+	__m128 sx = _mm_cmplt_ps(_mm_andnot_ps(sgn, q[0]), eps);
+	__m128 sy = _mm_cmplt_ps(_mm_andnot_ps(sgn, q[1]), eps);
+	__m128 sz = _mm_cmplt_ps(_mm_andnot_ps(sgn, q[2]), eps);
+	__m128 aw = _mm_andnot_ps(sgn, q[3]);
+	__m128 one = _mm_or_ps(_mm_or_ps(_mm_and_ps(sx, sy), _mm_and_ps(sx, sz)), _mm_and_ps(sy, sz));
+	one = _mm_and_ps(one, _mm_cmpge_ps(aw, eps));
+	if (_mm_movemask_ps(one)) {
+		__m128 ay = _mm_andnot_ps(sy, sx);
+		__m128 az = _mm_andnot_ps(sz, _mm_and_ps(sx, sy));
+		__m128 comp = _mm_blendv_ps(_mm_and_ps(az, q[2]), q[1], ay);
+		__m128 a;
+		comp = _mm_blendv_ps(q[0], comp, sx);
+		a = sseAtan2(_mm_xor_ps(comp, _mm_and_ps(q[3], sgn)), aw);
+		a = _mm_mul_ps(_mm_add_ps(a, a), uscl);
+		r[0] = _mm_blendv_ps(r[0], _mm_andnot_ps(sx, a), one);
+		r[1] = _mm_blendv_ps(r[1], _mm_and_ps(ay, a), one);
+		r[2] = _mm_blendv_ps(r[2], _mm_and_ps(az, a), one);
 	}
-	return motGetVec(pClip, nodeIdx, fno, TRK_SCL);
 }
 
-MOT_QUAT motGetQuat(const MOT_CLIP* pClip, int nodeIdx, int fno) {
-	return motQuatExp(motGetVec(pClip, nodeIdx, fno, TRK_ROT));
+static MOT_TARGET("sse4.1") void qeulerArySSE4(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n, const int ax[3], float sgn, float scl) {
+	__m128 vsgn = _mm_set1_ps(sgn);
+	__m128 vscl = _mm_set1_ps(scl);
+	int idx;
+	int nblk = n >> 2;
+	for (idx = 0; idx < nblk << 2; idx += 4) {
+		__m128 v[3], s[3], c[3], q[4];
+		__m128 t;
+		int i;
+		sseLoadVec4(&v[0], &v[1], &v[2], &pVecs[idx]);
+		for (i = 0; i < 3; ++i) {
+			sseSinCos(&s[i], &c[i], _mm_mul_ps(v[ax[i]], vscl));
+		}
+		t = _mm_mul_ps(vsgn, _mm_mul_ps(c[0], _mm_mul_ps(s[1], s[2])));
+		q[ax[0]] = _mm_sub_ps(_mm_mul_ps(s[0], _mm_mul_ps(c[1], c[2])), t);
+		t = _mm_mul_ps(vsgn, _mm_mul_ps(s[0], _mm_mul_ps(c[1], s[2])));
+		q[ax[1]] = _mm_add_ps(_mm_mul_ps(c[0], _mm_mul_ps(s[1], c[2])), t);
+		t = _mm_mul_ps(vsgn, _mm_mul_ps(s[0], _mm_mul_ps(s[1], c[2])));
+		q[ax[2]] = _mm_sub_ps(_mm_mul_ps(c[0], _mm_mul_ps(c[1], s[2])), t);
+		t = _mm_mul_ps(vsgn, _mm_mul_ps(s[0], _mm_mul_ps(s[1], s[2])));
+		q[3] = _mm_add_ps(_mm_mul_ps(c[0], _mm_mul_ps(c[1], c[2])), t);
+		_MM_TRANSPOSE4_PS(q[0], q[1], q[2], q[3]);
+		_mm_storeu_ps(pQuats[idx + 0].s, q[0]);
+		_mm_storeu_ps(pQuats[idx + 1].s, q[1]);
+		_mm_storeu_ps(pQuats[idx + 2].s, q[2]);
+		_mm_storeu_ps(pQuats[idx + 3].s, q[3]);
+	}
+	qeulerAryScalar(&pQuats[idx], &pVecs[idx], n - idx, ax, sgn, scl);
 }
 
-MOT_VEC motGetRadians(const MOT_CLIP* pClip, int nodeIdx, int fno) {
-	return motQuatToRadians(motGetQuat(pClip, nodeIdx, fno), motGetRotOrd(pClip, nodeIdx));
+static MOT_TARGET("sse4.1") void eulerqArySSE4(MOT_VEC* pVecs, const MOT_QUAT* pQuats, int n, const int ax[3], float sgn, float scl) {
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 two = _mm_set1_ps(2.0f);
+	__m128 vscl = _mm_set1_ps(scl);
+	int idx;
+	int nblk = n >> 2;
+	for (idx = 0; idx < nblk << 2; idx += 4) {
+		__m128 q[4], r[3];
+		__m128 x, y, z, w, c;
+		__m128 m00, m01, m02, m10, m11, m12, m20, m21, m22;
+		q[0] = _mm_loadu_ps(pQuats[idx + 0].s);
+		q[1] = _mm_loadu_ps(pQuats[idx + 1].s);
+		q[2] = _mm_loadu_ps(pQuats[idx + 2].s);
+		q[3] = _mm_loadu_ps(pQuats[idx + 3].s);
+		_MM_TRANSPOSE4_PS(q[0], q[1], q[2], q[3]);
+		x = q[ax[0]];
+		y = q[ax[1]];
+		z = q[ax[2]];
+		w = _mm_mul_ps(q[3], _mm_set1_ps(sgn));
+		m00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z))));
+		m01 = _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(x, y), _mm_mul_ps(w, z)));
+		m02 = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(x, z), _mm_mul_ps(w, y)));
+		m10 = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(x, y), _mm_mul_ps(w, z)));
+		m11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(z, z))));
+		m12 = _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(y, z), _mm_mul_ps(w, x)));
+		m20 = _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(x, z), _mm_mul_ps(w, y)));
+		m21 = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(y, z), _mm_mul_ps(w, x)));
+		m22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))));
+		c = _mm_and_ps(_mm_cmpeq_ps(m12, _mm_setzero_ps()), _mm_cmpeq_ps(m22, _mm_setzero_ps()));
+		c = _mm_blendv_ps(m22, one, c);
+		r[ax[0]] = _mm_mul_ps(sseAtan2(m12, m22), vscl);
+		r[ax[1]] = _mm_mul_ps(sseAtan2(_mm_sub_ps(_mm_setzero_ps(), m02), _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(m00, m00), _mm_mul_ps(m01, m01)))), vscl);
+		r[ax[2]] = _mm_mul_ps(sseAtan2(_mm_sub_ps(_mm_mul_ps(m12, m20), _mm_mul_ps(c, m10)), _mm_sub_ps(_mm_mul_ps(c, m11), _mm_mul_ps(m12, m21))), vscl);
+		sseEulAxis(r, q, _mm_set1_ps(scl * sgn));
+		sseStoreVec4(&pVecs[idx], r[0], r[1], r[2]);
+	}
+	eulerqAryScalar(&pVecs[idx], &pQuats[idx], n - idx, ax, sgn, scl);
 }
 
-MOT_VEC motGetDegrees(const MOT_CLIP* pClip, int nodeIdx, int fno) {
-	return motQuatToDegrees(motGetQuat(pClip, nodeIdx, fno), motGetRotOrd(pClip, nodeIdx));
+static MOT_TARGET("avx2") void avxSinCos(__m256* pSin, __m256* pCos, __m256 x) {
+	__m256 k = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(EUL_2OPI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256i iq = _mm256_cvttps_epi32(k);
+	__m256 r, z, s, c, swp;
+	r = _mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(s_eulpio2[0])));
+	r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(s_eulpio2[1])));
+	r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(s_eulpio2[2])));
+	z = _mm256_mul_ps(r, r);
+	s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(s_eulsin[2]), z), _mm256_set1_ps(s_eulsin[1]));
+	s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(s_eulsin[0]));
+	s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, z), r), r);
+	c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(s_eulcos[2]), z), _mm256_set1_ps(s_eulcos[1]));
+	c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(s_eulcos[0]));
+	c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+	c = _mm256_add_ps(_mm256_sub_ps(c, _mm256_mul_ps(z, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1.0f));
+	swp = _mm256_castsi256_ps(_mm256_slli_epi32(iq, 31));
+	*pSin = _mm256_xor_ps(_mm256_blendv_ps(s, c, swp), _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(iq, 1), 31)));
+	*pCos = _mm256_xor_ps(_mm256_blendv_ps(c, s, swp), _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(_mm256_add_epi32(iq, _mm256_set1_epi32(1)), 1), 31)));
 }
 
-typedef struct _MOT_FRAME_INFO {
-	float f;
-	float t;
-	int fno;
-	int next;
-} MOT_FRAME_INFO;
+static MOT_TARGET("avx2") __m256 avxAtan2(__m256 y, __m256 x) {
+	__m256 sgn = _mm256_set1_ps(-0.0f);
+	__m256 ax = _mm256_andnot_ps(sgn, x);
+	__m256 ay = _mm256_andnot_ps(sgn, y);
+	__m256 m1 = _mm256_cmp_ps(ay, _mm256_mul_ps(ax, _mm256_set1_ps(EUL_TAN1PI8)), _CMP_GT_OQ);
+	__m256 m3 = _mm256_cmp_ps(ay, _mm256_mul_ps(ax, _mm256_set1_ps(EUL_TAN3PI8)), _CMP_GT_OQ);
+	__m256 num = _mm256_blendv_ps(_mm256_blendv_ps(ay, _mm256_sub_ps(ay, ax), m1), _mm256_xor_ps(ax, sgn), m3);
+	__m256 den = _mm256_blendv_ps(_mm256_blendv_ps(ax, _mm256_add_ps(ay, ax), m1), ay, m3);
+	__m256 offs = _mm256_blendv_ps(_mm256_and_ps(m1, _mm256_set1_ps(c_pi * 0.25f)), _mm256_set1_ps(c_pi * 0.5f), m3);
+	__m256 t = _mm256_div_ps(num, _mm256_max_ps(den, _mm256_set1_ps(FLT_MIN)));
+	__m256 z = _mm256_mul_ps(t, t);
+	__m256 a = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(s_eulatan[3]), z), _mm256_set1_ps(s_eulatan[2]));
+	a = _mm256_add_ps(_mm256_mul_ps(a, z), _mm256_set1_ps(s_eulatan[1]));
+	a = _mm256_add_ps(_mm256_mul_ps(a, z), _mm256_set1_ps(s_eulatan[0]));
+	a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(a, z), t), t), offs);
+	a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(c_pi), a), x);
+	return _mm256_or_ps(a, _mm256_and_ps(y, sgn));
+}
 
-static MOT_FRAME_INFO finfo(const MOT_CLIP* pClip, float frm) {
-	MOT_FRAME_INFO fi;
-	int nfrm = pClip->nfrm;
-	frm = fabsf(frm);
-	fi.f = fmodf(frm, (float)nfrm);
-	fi.fno = (int)fi.f;
-	fi.t = fi.f - (float)fi.fno;
-	fi.next = fi.fno < nfrm - 1 ? fi.fno + 1 : 0;
-	return fi;
+static MOT_TARGET("avx2") void avxEulAxis(__m256 r[3], const __m256 q[4], __m256 uscl) {
+	__m256 sgn = _mm256_set1_ps(-0.0f);
+	__m256 eps = _mm256_set1_ps(EUL_EPS);
+	__m256 sx = _mm256_cmp_ps(_mm256_andnot_ps(sgn, q[0]), eps, _CMP_LT_OQ);
+	__m256 sy = _mm256_cmp_ps(_mm256_andnot_ps(sgn, q[1]), eps, _CMP_LT_OQ);
+	__m256 sz = _mm256_cmp_ps(_mm256_andnot_ps(sgn, q[2]), eps, _CMP_LT_OQ);
+	__m256 aw = _mm256_andnot_ps(sgn, q[3]);
+	__m256 one = _mm256_or_ps(_mm256_or_ps(_mm256_and_ps(sx, sy), _mm256_and_ps(sx, sz)), _mm256_and_ps(sy, sz));
+	one = _mm256_and_ps(one, _mm256_cmp_ps(aw, eps, _CMP_GE_OQ));
+	if (_mm256_movemask_ps(one)) {
+		__m256 ay = _mm256_andnot_ps(sy, sx);
+		__m256 az = _mm256_andnot_ps(sz, _mm256_and_ps(sx, sy));
+		__m256 comp = _mm256_blendv_ps(_mm256_and_ps(az, q[2]), q[1], ay);
+		__m256 a;
+		comp = _mm256_blendv_ps(q[0], comp, sx);
+		a = avxAtan2(_mm256_xor_ps(comp, _mm256_and_ps(q[3], sgn)), aw);
+		a = _mm256_mul_ps(_mm256_add_ps(a, a), uscl);
+		r[0] = _mm256_blendv_ps(r[0], _mm256_andnot_ps(sx, a), one);
+		r[1] = _mm256_blendv_ps(r[1], _mm256_and_ps(ay, a), one);
+		r[2] = _mm256_blendv_ps(r[2], _mm256_and_ps(az, a), one);
+	}
 }
 
-MOT_QUAT motEvalQuat(const MOT_CLIP* pClip, int nodeIdx, float frm) {
-	MOT_FRAME_INFO fi;
-	MOT_QUAT q = { 0.0f, 0.0f, 0.0f, 1.0f };
-	MOT_VEC v;
-	if (!pClip || !motClipNodeIdxCk(pClip, nodeIdx)) {
-		return q;
+static MOT_TARGET("avx2") void avxLoadQuat8(__m256 q[4], const MOT_QUAT* pQuats) {
+	__m128 lo[4], hi[4];
+	int i;
+	for (i = 0; i < 4; ++i) {
+		lo[i] = _mm_loadu_ps(pQuats[i].s);
+		hi[i] = _mm_loadu_ps(pQuats[i + 4].s);
 	}
-	fi = finfo(pClip, frm);
-	v = motGetVec(pClip, nodeIdx, fi.fno, TRK_ROT);
-	if (fi.t != 0.0f) {
-		MOT_VEC vnext = motGetVec(pClip, nodeIdx, fi.next, TRK_ROT);
-		v = motVecLerp(v, vnext, fi.t);
+	_MM_TRANSPOSE4_PS(lo[0], lo[1], lo[2], lo[3]);
+	_MM_TRANSPOSE4_PS(hi[0], hi[1], hi[2], hi[3]);
+	for (i = 0; i < 4; ++i) {
+		q[i] = _mm256_insertf128_ps(_mm256_castps128_ps256(lo[i]), hi[i], 1);
 	}
-	q = motQuatExp(v);
-	return q;
 }
 
-MOT_QUAT motEvalQuatSlerp(const MOT_CLIP* pClip, int nodeIdx, float frm) {
-	MOT_FRAME_INFO fi;
-	MOT_QUAT q = { 0.0f, 0.0f, 0.0f, 1.0f };
-	if (!pClip || !motClipNodeIdxCk(pClip, nodeIdx)) {
-		return q;
+static MOT_TARGET("avx2") void qeulerAryAVX2(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n, const int ax[3], float sgn, float scl) {
+	__m256 vsgn = _mm256_set1_ps(sgn);
+	__m256 vscl = _mm256_set1_ps(scl);
+	int idx;
+	int nblk = n >> 3;
+	for (idx = 0; idx < nblk << 3; idx += 8) {
+		__m128 v0[3], v1[3];
+		__m256 v[3], s[3], c[3], q[4];
+		__m256 t, t0, t1, t2, t3;
+		int i;
+		sseLoadVec4(&v0[0], &v0[1], &v0[2], &pVecs[idx]);
+		sseLoadVec4(&v1[0], &v1[1], &v1[2], &pVecs[idx + 4]);
+		for (i = 0; i < 3; ++i) {
+			v[i] = _mm256_insertf128_ps(_mm256_castps128_ps256(v0[i]), v1[i], 1);
+		}
+		for (i = 0; i < 3; ++i) {
+			avxSinCos(&s[i], &c[i], _mm256_mul_ps(v[ax[i]], vscl));
+		}
+		t = _mm256_mul_ps(vsgn, _mm256_mul_ps(c[0], _mm256_mul_ps(s[1], s[2])));
+		q[ax[0]] = _mm256_sub_ps(_mm256_mul_ps(s[0], _mm256_mul_ps(c[1], c[2])), t);
+		t = _mm256_mul_ps(vsgn, _mm256_mul_ps(s[0], _mm256_mul_ps(c[1], s[2])));
+		q[ax[1]] = _mm256_add_ps(_mm256_mul_ps(c[0], _mm256_mul_ps(s[1], c[2])), t);
+		t = _mm256_mul_ps(vsgn, _mm256_mul_ps(s[0], _mm256_mul_ps(s[1], c[2])));
+		q[ax[2]] = _mm256_sub_ps(_mm256_mul_ps(c[0], _mm256_mul_ps(c[1], s[2])), t);
+		t = _mm256_mul_ps(vsgn, _mm256_mul_ps(s[0], _mm256_mul_ps(s[1], s[2])));
+		q[3] = _mm256_add_ps(_mm256_mul_ps(c[0], _mm256_mul_ps(c[1], c[2])), t);
+		/* per-lane 4x4 transpose as in qexpAryAVX2 */
+		t0 = _mm256_unpacklo_ps(q[0], q[1]);
+		t1 = _mm256_unpackhi_ps(q[0], q[1]);
+		t2 = _mm256_unpacklo_ps(q[2], q[3]);
+		t3 = _mm256_unpackhi_ps(q[2], q[3]);
+		q[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		q[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		q[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		q[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		_mm256_storeu_ps(pQuats[idx + 0].s, _mm256_permute2f128_ps(q[0], q[1], 0x20));
+		_mm256_storeu_ps(pQuats[idx + 2].s, _mm256_permute2f128_ps(q[2], q[3], 0x20));
+		_mm256_storeu_ps(pQuats[idx + 4].s, _mm256_permute2f128_ps(q[0], q[1], 0x31));
+		_mm256_storeu_ps(pQuats[idx + 6].s, _mm256_permute2f128_ps(q[2], q[3], 0x31));
 	}
-	fi = finfo(pClip, frm);
-	q = motGetQuat(pClip, nodeIdx, fi.fno);
-	if (fi.t != 0.0f) {
-		MOT_QUAT qnext = motGetQuat(pClip, nodeIdx, fi.next);
-		q = motQuatSlerp(q, qnext, fi.t);
+	qeulerArySSE4(&pQuats[idx], &pVecs[idx], n - idx, ax, sgn, scl);
+}
+
+static MOT_TARGET("avx2") void eulerqAryAVX2(MOT_VEC* pVecs, const MOT_QUAT* pQuats, int n, const int ax[3], float sgn, float scl) {
+	__m256 one = _mm256_set1_ps(1.0f);
+	__m256 two = _mm256_set1_ps(2.0f);
+	__m256 vscl = _mm256_set1_ps(scl);
+	int idx;
+	int nblk = n >> 3;
+	for (idx = 0; idx < nblk << 3; idx += 8) {
+		__m256 q[4], r[3];
+		__m256 x, y, z, w, c;
+		__m256 m00, m01, m02, m10, m11, m12, m20, m21, m22;
+		avxLoadQuat8(q, &pQuats[idx]);
+		x = q[ax[0]];
+		y = q[ax[1]];
+		z = q[ax[2]];
+		w = _mm256_mul_ps(q[3], _mm256_set1_ps(sgn));
+		m00 = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(y, y), _mm256_mul_ps(z, z))));
+		m01 = _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(x, y), _mm256_mul_ps(w, z)));
+		m02 = _mm256_mul_ps(two, _mm256_sub_ps(_mm256_mul_ps(x, z), _mm256_mul_ps(w, y)));
+		m10 = _mm256_mul_ps(two, _mm256_sub_ps(_mm256_mul_ps(x, y), _mm256_mul_ps(w, z)));
+		m11 = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(z, z))));
+		m12 = _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(y, z), _mm256_mul_ps(w, x)));
+		m20 = _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(x, z), _mm256_mul_ps(w, y)));
+		m21 = _mm256_mul_ps(two, _mm256_sub_ps(_mm256_mul_ps(y, z), _mm256_mul_ps(w, x)));
+		m22 = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y))));
+		c = _mm256_and_ps(_mm256_cmp_ps(m12, _mm256_setzero_ps(), _CMP_EQ_OQ), _mm256_cmp_ps(m22, _mm256_setzero_ps(), _CMP_EQ_OQ));
+		c = _mm256_blendv_ps(m22, one, c);
+		r[ax[0]] = _mm256_mul_ps(avxAtan2(m12, m22), vscl);
+		r[ax[1]] = _mm256_mul_ps(avxAtan2(_mm256_sub_ps(_mm256_setzero_ps(), m02), _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(m00, m00), _mm256_mul_ps(m01, m01)))), vscl);
+		r[ax[2]] = _mm256_mul_ps(avxAtan2(_mm256_sub_ps(_mm256_mul_ps(m12, m20), _mm256_mul_ps(c, m10)), _mm256_sub_ps(_mm256_mul_ps(c, m11), _mm256_mul_ps(m12, m21))), vscl);
+		avxEulAxis(r, q, _mm256_set1_ps(scl * sgn));
+		sseStoreVec4(&pVecs[idx], _mm256_castps256_ps128(r[0]), _mm256_castps256_ps128(r[1]), _mm256_castps256_ps128(r[2]));
+		sseStoreVec4(&pVecs[idx + 4], _mm256_extractf128_ps(r[0], 1), _mm256_extractf128_ps(r[1], 1), _mm256_extractf128_ps(r[2], 1));
 	}
-	return q;
+	eulerqArySSE4(&pVecs[idx], &pQuats[idx], n - idx, ax, sgn, scl);
 }
+#endif /* MOT_SIMD_X86 */
 
-MOT_VEC motEvalRadians(const MOT_CLIP* pClip, int nodeIdx, float frm) {
-	return motQuatToRadians(motEvalQuat(pClip, nodeIdx, frm), motGetRotOrd(pClip, nodeIdx));
+#if MOT_SIMD_NEON
+static float32x4_t neonSelSign(float32x4_t v, uint32x4_t bits) {
+	return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(v), bits));
 }
 
-MOT_VEC motEvalDegrees(const MOT_CLIP* pClip, int nodeIdx, float frm) {
-	return motQuatToDegrees(motEvalQuat(pClip, nodeIdx, frm), motGetRotOrd(pClip, nodeIdx));
+static void neonSinCos(float32x4_t* pSin, float32x4_t* pCos, float32x4_t x) {
+	/* round half away from zero */
+	float32x4_t k = vmulq_f32(x, vdupq_n_f32(EUL_2OPI));
+	int32x4_t iq = vcvtq_s32_f32(vaddq_f32(k, neonSelSign(vdupq_n_f32(0.5f), vandq_u32(vreinterpretq_u32_f32(k), vdupq_n_u32(0x80000000)))));
+	uint32x4_t uq = vreinterpretq_u32_s32(iq);
+	uint32x4_t swp;
+	float32x4_t r, z, s, c;
+	k = vcvtq_f32_s32(iq);
+	r = vmlsq_f32(x, k, vdupq_n_f32(s_eulpio2[0]));
+	r = vmlsq_f32(r, k, vdupq_n_f32(s_eulpio2[1]));
+	r = vmlsq_f32(r, k, vdupq_n_f32(s_eulpio2[2]));
+	z = vmulq_f32(r, r);
+	s = vmlaq_f32(vdupq_n_f32(s_eulsin[1]), vdupq_n_f32(s_eulsin[2]), z);
+	s = vmlaq_f32(vdupq_n_f32(s_eulsin[0]), s, z);
+	s = vmlaq_f32(r, vmulq_f32(s, z), r);
+	c = vmlaq_f32(vdupq_n_f32(s_eulcos[1]), vdupq_n_f32(s_eulcos[2]), z);
+	c = vmlaq_f32(vdupq_n_f32(s_eulcos[0]), c, z);
+	c = vmulq_f32(vmulq_f32(c, z), z);
+	c = vaddq_f32(vmlsq_f32(c, z, vdupq_n_f32(0.5f)), vdupq_n_f32(1.0f));
+	swp = vtstq_u32(uq, vdupq_n_u32(1));
+	*pSin = neonSelSign(vbslq_f32(swp, c, s), vshlq_n_u32(vshrq_n_u32(uq, 1), 31));
+	*pCos = neonSelSign(vbslq_f32(swp, s, c), vshlq_n_u32(vshrq_n_u32(vaddq_u32(uq, vdupq_n_u32(1)), 1), 31));
 }
 
-MOT_VEC motEvalPos(const MOT_CLIP* pClip, int nodeIdx, float frm) {
-	MOT_FRAME_INFO fi;
-	MOT_VEC v = { 0.0f, 0.0f, 0.0f };
-	if (!pClip || !motClipNodeIdxCk(pClip, nodeIdx)) {
-		return v;
+static float32x4_t neonAtan2(float32x4_t y, float32x4_t x) {
+	uint32x4_t sgn = vdupq_n_u32(0x80000000);
+	float32x4_t ax = vabsq_f32(x);
+	float32x4_t ay = vabsq_f32(y);
+	uint32x4_t m1 = vcgtq_f32(ay, vmulq_f32(ax, vdupq_n_f32(EUL_TAN1PI8)));
+	uint32x4_t m3 = vcgtq_f32(ay, vmulq_f32(ax, vdupq_n_f32(EUL_TAN3PI8)));
+	float32x4_t num = vbslq_f32(m3, vnegq_f32(ax), vbslq_f32(m1, vsubq_f32(ay, ax), ay));
+	float32x4_t den = vbslq_f32(m3, ay, vbslq_f32(m1, vaddq_f32(ay, ax), ax));
+	float32x4_t offs = vbslq_f32(m3, vdupq_n_f32(c_pi * 0.5f), vbslq_f32(m1, vdupq_n_f32(c_pi * 0.25f), vdupq_n_f32(0.0f)));
+	float32x4_t rcp, t, z, a;
+	den = vmaxq_f32(den, vdupq_n_f32(FLT_MIN));
+	rcp = vrecpeq_f32(den);
+	rcp = vmulq_f32(rcp, vrecpsq_f32(den, rcp));
+	rcp = vmulq_f32(rcp, vrecpsq_f32(den, rcp));
+	t = vmulq_f32(num, rcp);
+	z = vmulq_f32(t, t);
+	a = vmlaq_f32(vdupq_n_f32(s_eulatan[2]), vdupq_n_f32(s_eulatan[3]), z);
+	a = vmlaq_f32(vdupq_n_f32(s_eulatan[1]), a, z);
+	a = vmlaq_f32(vdupq_n_f32(s_eulatan[0]), a, z);
+	a = vaddq_f32(vmlaq_f32(t, vmulq_f32(a, z), t), offs);
+	a = vbslq_f32(vtstq_u32(vreinterpretq_u32_f32(x), sgn), vsubq_f32(vdupq_n_f32(c_pi), a), a);
+	return neonSelSign(a, vandq_u32(vreinterpretq_u32_f32(y), sgn));
+}
+
+static void neonEulAxis(float32x4x3_t* pRad, const float32x4x4_t* pQuat, float uscl) {
+	float32x4_t eps = vdupq_n_f32(EUL_EPS);
+	uint32x4_t sx = vcltq_f32(vabsq_f32(pQuat->val[0]), eps);
+	uint32x4_t sy = vcltq_f32(vabsq_f32(pQuat->val[1]), eps);
+	uint32x4_t sz = vcltq_f32(vabsq_f32(pQuat->val[2]), eps);
+	float32x4_t aw = vabsq_f32(pQuat->val[3]);
+	uint32x4_t one = vorrq_u32(vorrq_u32(vandq_u32(sx, sy), vandq_u32(sx, sz)), vandq_u32(sy, sz));
+	uint32x2_t any;
+	one = vandq_u32(one, vcgeq_f32(aw, eps));
+	any = vorr_u32(vget_low_u32(one), vget_high_u32(one));
+	if (vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) {
+		uint32x4_t ay = vbicq_u32(sx, sy);
+		uint32x4_t az = vbicq_u32(vandq_u32(sx, sy), sz);
+		float32x4_t zero = vdupq_n_f32(0.0f);
+		float32x4_t comp = vbslq_f32(sx, vbslq_f32(ay, pQuat->val[1], vbslq_f32(az, pQuat->val[2], zero)), pQuat->val[0]);
+		float32x4_t a;
+		comp = neonSelSign(comp, vandq_u32(vreinterpretq_u32_f32(pQuat->val[3]), vdupq_n_u32(0x80000000)));
+		a = vmulq_n_f32(neonAtan2(comp, aw), 2.0f * uscl);
+		pRad->val[0] = vbslq_f32(one, vbslq_f32(sx, zero, a), pRad->val[0]);
+		pRad->val[1] = vbslq_f32(one, vbslq_f32(ay, a, zero), pRad->val[1]);
+		pRad->val[2] = vbslq_f32(one, vbslq_f32(az, a, zero), pRad->val[2]);
 	}
-	fi = finfo(pClip, frm);
-	v = motGetPos(pClip, nodeIdx, fi.fno);
-	if (fi.t != 0.0f) {
-		MOT_VEC vnext = motGetPos(pClip, nodeIdx, fi.next);
-		v = motVecLerp(v, vnext, fi.t);
+}
+
+static void qeulerAryNEON(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n, const int ax[3], float sgn, float scl) {
+	int idx;
+	int nblk = n >> 2;
+	for (idx = 0; idx < nblk << 2; idx += 4) {
+		float32x4x3_t v = vld3q_f32(pVecs[idx].s);
+		float32x4x4_t q;
+		float32x4_t s[3], c[3];
+		int i;
+		for (i = 0; i < 3; ++i) {
+			neonSinCos(&s[i], &c[i], vmulq_n_f32(v.val[ax[i]], scl));
+		}
+		q.val[ax[0]] = vmlsq_n_f32(vmulq_f32(s[0], vmulq_f32(c[1], c[2])), vmulq_f32(c[0], vmulq_f32(s[1], s[2])), sgn);
+		q.val[ax[1]] = vmlaq_n_f32(vmulq_f32(c[0], vmulq_f32(s[1], c[2])), vmulq_f32(s[0], vmulq_f32(c[1], s[2])), sgn);
+		q.val[ax[2]] = vmlsq_n_f32(vmulq_f32(c[0], vmulq_f32(c[1], s[2])), vmulq_f32(s[0], vmulq_f32(s[1], c[2])), sgn);
+		q.val[3] = vmlaq_n_f32(vmulq_f32(c[0], vmulq_f32(c[1], c[2])), vmulq_f32(s[0], vmulq_f32(s[1], s[2])), sgn);
+		vst4q_f32(pQuats[idx].s, q);
 	}
-	return v;
+	qeulerAryScalar(&pQuats[idx], &pVecs[idx], n - idx, ax, sgn, scl);
 }
 
-MOT_VEC motEvalScl(const MOT_CLIP* pClip, int nodeIdx, float frm) {
-	MOT_FRAME_INFO fi;
-	MOT_VEC v = { 1.0f, 1.0f, 1.0f };
-	if (!pClip || !motClipNodeIdxCk(pClip, nodeIdx)) {
-		return v;
+static void eulerqAryNEON(MOT_VEC* pVecs, const MOT_QUAT* pQuats, int n, const int ax[3], float sgn, float scl) {
+	float32x4_t one = vdupq_n_f32(1.0f);
+	int idx;
+	int nblk = n >> 2;
+	for (idx = 0; idx < nblk << 2; idx += 4) {
+		float32x4x4_t q = vld4q_f32(pQuats[idx].s);
+		float32x4x3_t r;
+		float32x4_t x, y, z, w, c, c1;
+		float32x4_t m00, m01, m02, m10, m11, m12, m20, m21, m22;
+		x = q.val[ax[0]];
+		y = q.val[ax[1]];
+		z = q.val[ax[2]];
+		w = vmulq_n_f32(q.val[3], sgn);
+		m00 = vmlsq_n_f32(one, vmlaq_f32(vmulq_f32(y, y), z, z), 2.0f);
+		m01 = vmulq_n_f32(vmlaq_f32(vmulq_f32(x, y), w, z), 2.0f);
+		m02 = vmulq_n_f32(vmlsq_f32(vmulq_f32(x, z), w, y), 2.0f);
+		m10 = vmulq_n_f32(vmlsq_f32(vmulq_f32(x, y), w, z), 2.0f);
+		m11 = vmlsq_n_f32(one, vmlaq_f32(vmulq_f32(x, x), z, z), 2.0f);
+		m12 = vmulq_n_f32(vmlaq_f32(vmulq_f32(y, z), w, x), 2.0f);
+		m20 = vmulq_n_f32(vmlaq_f32(vmulq_f32(x, z), w, y), 2.0f);
+		m21 = vmulq_n_f32(vmlsq_f32(vmulq_f32(y, z), w, x), 2.0f);
+		m22 = vmlsq_n_f32(one, vmlaq_f32(vmulq_f32(x, x), y, y), 2.0f);
+		c = vbslq_f32(vandq_u32(vceqq_f32(m12, vdupq_n_f32(0.0f)), vceqq_f32(m22, vdupq_n_f32(0.0f))), one, m22);
+		r.val[ax[0]] = vmulq_n_f32(neonAtan2(m12, m22), scl);
+		c1 = vmaxq_f32(vmlaq_f32(vmulq_f32(m00, m00), m01, m01), vdupq_n_f32(FLT_MIN));
+		r.val[ax[1]] = vmulq_n_f32(neonAtan2(vnegq_f32(m02), vmulq_f32(c1, neonRcpSqrt(c1))), scl);
+		r.val[ax[2]] = vmulq_n_f32(neonAtan2(vmlsq_f32(vmulq_f32(m12, m20), c, m10), vmlsq_f32(vmulq_f32(c, m11), m12, m21)), scl);
+		neonEulAxis(&r, &q, scl * sgn);
+		vst3q_f32(pVecs[idx].s, r);
 	}
-	fi = finfo(pClip, frm);
-	v = motGetScl(pClip, nodeIdx, fi.fno);
-	if (fi.t != 0.0f) {
-		MOT_VEC vnext = motGetScl(pClip, nodeIdx, fi.next);
-		v = motVecLerp(v, vnext, fi.t);
+	eulerqAryScalar(&pVecs[idx], &pQuats[idx], n - idx, ax, sgn, scl);
+}
+#endif /* MOT_SIMD_NEON */
+
+static void qeulerAry(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n, E_MOT_RORD rord, float scl, E_MOT_SIMD simd) {
+	int ax[3];
+	float sgn = eulaxes(ax, rord);
+	if (!pQuats || !pVecs || n <= 0) return;
+	if (!motSIMDCk(simd)) {
+		simd = motGetSIMD();
+	}
+	switch (simd) {
+		case SIMD_NONE:
+			qeulerAryScalar(pQuats, pVecs, n, ax, sgn, scl);
+			break;
+#if MOT_SIMD_X86
+		case SIMD_SSE4:
+			qeulerArySSE4(pQuats, pVecs, n, ax, sgn, scl);
+			break;
+		case SIMD_AVX2:
+			qeulerAryAVX2(pQuats, pVecs, n, ax, sgn, scl);
+			break;
+#endif
+#if MOT_SIMD_NEON
+		case SIMD_NEON:
+			qeulerAryNEON(pQuats, pVecs, n, ax, sgn, scl);
+			break;
+#endif
+		default:
+			qeulerAryBlk(pQuats, pVecs, n, ax, sgn, scl);
+			break;
 	}
-	return v;
 }
 
-void motEvalTransform(MOT_MTX* pMtx, const MOT_CLIP* pClip, int nodeIdx, float frm, const MOT_VEC* pDefTns) {
-	MOT_QUAT q;
-	MOT_VEC t;
-	MOT_VEC s;
-	E_MOT_XORD xord;
-	int srt = 0;
-	if (!pMtx || !pClip || !motClipNodeIdxCk(pClip, nodeIdx)) return;
-	xord = motGetXformOrd(pClip, nodeIdx);
-	if (motNodeTrackCk(pClip, nodeIdx, TRK_POS)) srt |= 1;
-	if (motNodeTrackCk(pClip, nodeIdx, TRK_ROT)) srt |= 2;
-	if (motNodeTrackCk(pClip, nodeIdx, TRK_SCL)) srt |= 4;
-	if (srt & 1) {
-		t = motEvalPos(pClip, nodeIdx, frm);
-	} else {
-		if (pDefTns) {
-			t = *pDefTns;
-			srt |= 1;
-		}
+static void eulerqAry(MOT_VEC* pVecs, const MOT_QUAT* pQuats, int n, E_MOT_RORD rord, float scl, E_MOT_SIMD simd) {
+	int ax[3];
+	float sgn = eulaxes(ax, rord);
+	if (!pVecs || !pQuats || n <= 0) return;
+	if (!motSIMDCk(simd)) {
+		simd = motGetSIMD();
 	}
-	switch (srt) {
-		case 0:
+	scl *= sgn;
+	switch (simd) {
+		case SIMD_NONE:
+			eulerqAryScalar(pVecs, pQuats, n, ax, sgn, scl);
 			break;
-		case 1:
-			motMakeTransformT(pMtx, t);
+#if MOT_SIMD_X86
+		case SIMD_SSE4:
+			eulerqArySSE4(pVecs, pQuats, n, ax, sgn, scl);
 			break;
-		case 2:
-			q = motEvalQuat(pClip, nodeIdx, frm);
-			motMakeTransformR(pMtx, q);
+		case SIMD_AVX2:
+			eulerqAryAVX2(pVecs, pQuats, n, ax, sgn, scl);
 			break;
-		case (1 | 2):
-			q = motEvalQuat(pClip, nodeIdx, frm);
-			motMakeTransformTR(pMtx, t, q, xord);
+#endif
+#if MOT_SIMD_NEON
+		case SIMD_NEON:
+			eulerqAryNEON(pVecs, pQuats, n, ax, sgn, scl);
 			break;
+#endif
 		default:
-			q = motEvalQuat(pClip, nodeIdx, frm);
-			s = motEvalScl(pClip, nodeIdx, frm);
-			motMakeTransform(pMtx, t, q, s, xord);
+			eulerqAryBlk(pVecs, pQuats, n, ax, sgn, scl);
 			break;
 	}
 }
+
+void motQuatFromRadiansAryEx(MOT_QUAT* pQuats, const MOT_VEC* pRads, int n, E_MOT_RORD rord, E_MOT_SIMD simd) {
+	qeulerAry(pQuats, pRads, n, rord, 0.5f, simd);
+}
+
+void motQuatFromRadiansAry(MOT_QUAT* pQuats, const MOT_VEC* pRads, int n, E_MOT_RORD rord) {
+	motQuatFromRadiansAryEx(pQuats, pRads, n, rord, motGetSIMD());
+}
+
+void motQuatFromDegreesAryEx(MOT_QUAT* pQuats, const MOT_VEC* pDegs, int n, E_MOT_RORD rord, E_MOT_SIMD simd) {
+	qeulerAry(pQuats, pDegs, n, rord, c_pi / 360.0f, simd);
+}
+
+void motQuatFromDegreesAry(MOT_QUAT* pQuats, const MOT_VEC* pDegs, int n, E_MOT_RORD rord) {
+	motQuatFromDegreesAryEx(pQuats, pDegs, n, rord, motGetSIMD());
+}
+
+void motQuatToRadiansAryEx(MOT_VEC* pRads, const MOT_QUAT* pQuats, int n, E_MOT_RORD rord, E_MOT_SIMD simd) {
+	eulerqAry(pRads, pQuats, n, rord, 1.0f, simd);
+}
+
+void motQuatToRadiansAry(MOT_VEC* pRads, const MOT_QUAT* pQuats, int n, E_MOT_RORD rord) {
+	motQuatToRadiansAryEx(pRads, pQuats, n, rord, motGetSIMD());
+}
+
+void motQuatToDegreesAryEx(MOT_VEC* pDegs, const MOT_QUAT* pQuats, int n, E_MOT_RORD rord, E_MOT_SIMD simd) {
+	eulerqAry(pDegs, pQuats, n, rord, 180.0f / c_pi, simd);
+}
+
+void motQuatToDegreesAry(MOT_VEC* pDegs, const MOT_QUAT* pQuats, int n, E_MOT_RORD rord) {
+	motQuatToDegreesAryEx(pDegs, pQuats, n, rord, motGetSIMD());
+}
+
+int motClipHeaderCk(const MOT_CLIP* pClip) {
+	if (!pClip) return 0;
+	int i;
+	for (i = 0; i < 4; ++i) {
+		if (pClip->fmt[i] != g_motClipFmt[i]) return 0;
+	}
+	return 1;
+}
+
+int motClipNodeIdxCk(const MOT_CLIP* pClip, int nodeIdx) {
+	return !!(pClip && ((uint32_t)nodeIdx < pClip->nnod));
+}
+
+int motFrameNoCk(const MOT_CLIP* pClip, int fno) {
+	return !!(pClip && ((uint32_t)fno < pClip->nfrm));
+}
+
+int motNodeTrackCk(const MOT_CLIP* pClip, int nodeIdx, E_MOT_TRK trk) {
+	int res = 0;
+	if (pClip && motClipNodeIdxCk(pClip, nodeIdx)) {
+		switch (trk) {
+			case TRK_POS:
+			case TRK_ROT:
+			case TRK_SCL:
+				res = pClip->nodes[nodeIdx].trk[trk].srcMask != 0;
+				break;
+			default:
+				break;
+		}
+	}
+	return res;
+}
+
+static uint32_t strhash(uint32_t* pLen, const char* pStr) {
+	uint32_t c;
+	uint32_t len = 0;
+	uint32_t h = 2166136261U;
+	while ((c = *pStr++)) {
+		h *= 16777619U;
+		h ^= c;
+		++len;
+	}
+	*pLen = len;
+	return h;
+}
+
+uint32_t motNameHash(uint32_t* pLen, const char* pName) {
+	return strhash(pLen, pName);
+}
+
+static int hfind(const uint32_t* pHashes, int n, uint32_t h) {
+	const uint32_t* p = pHashes;
+	uint32_t cnt = (uint32_t)n;
+	while (cnt > 1) {
+		uint32_t mid = cnt / 2;
+		const uint32_t* pm = &p[mid];
+		uint32_t ck = *pm;
+		p = (h < ck) ? p : pm;
+		cnt -= mid;
+	}
+	return (int)(p - pHashes) + ((p != pHashes) & (*p > h));
+}
+
+int motFindClipNode(const MOT_CLIP* pClip, const char* pName) {
+	int idx = -1;
+	const int binSearchThreshold = 20;
+	if (pClip && pName) {
+		int i;
+		int n = pClip->nnod;
+		if (n > binSearchThreshold && pClip->hash) {
+			uint32_t len;
+			uint32_t h = strhash(&len, pName);
+			if ((size_t)len < sizeof(MOT_STRING) - 2) {
+				uint32_t* pHashes = (uint32_t*)((uint8_t*)pClip + pClip->hash);
+				int hidx = hfind(pHashes, n, h);
+				if (h == pHashes[hidx]) {
+					int nc = 1;
+					for (i = hidx; --i >= 0;) {
+						if (pHashes[i] != h) break;
+						--hidx;
+						++nc;
+					}
+					for (i = 0; i < nc; ++i) {
+						int tidx = hidx + i;
+						const MOT_NODE* pNode = &pClip->nodes[tidx];
+						if (len == pNode->name.len) {
+							if (memcmp(pNode->name.chr, pName, len) == 0) {
+								idx = tidx;
+								break;
+							}
+						}
+					}
+				}
+			}
+		} else {
+			for (i = 0; i < n; ++i) {
+				if (strcmp(pClip->nodes[i].name.chr, pName) == 0) {
+					idx = i;
+					break;
+				}
+			}
+		}
+	}
+	return idx;
+}
+
+int motClipTrackCount(const MOT_CLIP* pClip, E_MOT_TRK kind) {
+	int n = 0;
+	MOT_EVAL* pEval = motGetEvalInfo(pClip);
+	switch (kind) {
+		case TRK_POS:
+		case TRK_ROT:
+		case TRK_SCL:
+			if (pEval) {
+				n = pEval->ntrk[(int)kind];
+			} else if (pClip) {
+				int i;
+				int nnod = pClip->nnod;
+				for (i = 0; i < nnod; ++i) {
+					if (motNodeTrackCk(pClip, i, kind)) {
+						++n;
+					}
+				}
+			}
+			break;
+	}
+	return n;
+}
+
+MOT_EVAL* motGetEvalInfo(const MOT_CLIP* pClip) {
+	MOT_EVAL* pEval = NULL;
+	if (pClip && pClip->eval) {
+		pEval = (MOT_EVAL*)&((uint8_t*)pClip)[pClip->eval];
+	}
+	return pEval;
+}
+
+MOT_SEQ* motGetSeqInfo(const MOT_CLIP* pClip) {
+	MOT_SEQ* pSeq = NULL;
+	if (pClip && pClip->seq) {
+		pSeq = (MOT_SEQ*)&((uint8_t*)pClip)[pClip->seq];
+	}
+	return pSeq;
+}
+
+/* floats per frame of a frame-major clip: its animated channels, counted by EVAL */
+int motClipRowWidth(const MOT_CLIP* pClip) {
+	const MOT_EVAL* pEval = motGetEvalInfo(pClip);
+	if (!pEval) return 0;
+	return (int)(pEval->ncrv[0] + pEval->ncrv[1] + pEval->ncrv[2]);
+}
+
+float* motGetTrackData(const MOT_CLIP* pClip, int nodeIdx, E_MOT_TRK trk) {
+	float* p = NULL;
+	if (pClip && motClipNodeIdxCk(pClip, nodeIdx)) {
+		int itrk = (int)trk;
+		if (itrk < 3) {
+			uint32_t offs = pClip->nodes[nodeIdx].offs[itrk];
+			if (offs) {
+				char* pTop = (char*)pClip;
+				p = (float*)&pTop[offs];
+			}
+		}
+	}
+	return p;
+}
+
+void motGetChanData(const MOT_CLIP* pClip, int nodeIdx, E_MOT_TRK trk, int chIdx, float** ppData, int* pStride) {
+	int stride = 0;
+	float* p = NULL;
+	if ((uint32_t)chIdx < 3) {
+		float* pTrk = motGetTrackData(pClip, nodeIdx, trk);
+		const MOT_TRACK* pTrkInfo = pTrk ? &pClip->nodes[nodeIdx].trk[(int)trk] : NULL;
+		if (pTrk && !pTrkInfo->qbits && !pTrkInfo->spline && !pTrkInfo->rdft) {
+			int i;
+			int dataMask = pClip->nodes[nodeIdx].trk[(int)trk].dataMask;
+			for (i = 0; i < 3; ++i) {
+				if (dataMask & (1 << i)) {
+					p = pTrk + stride;
+					++stride;
+				}
+			}
+			if (pTrkInfo->fmaj) {
+				stride = motClipRowWidth(pClip);
+			}
+		}
+	}
+	if (ppData) {
+		*ppData = p;
+	}
+	if (pStride) {
+		*pStride = stride;
+	}
+}
+
+E_MOT_RORD motGetRotOrd(const MOT_CLIP* pClip, int nodeIdx) {
+	return motClipNodeIdxCk(pClip, nodeIdx) ? (E_MOT_RORD)pClip->nodes[nodeIdx].rord : RORD_XYZ;
+}
+
+E_MOT_XORD motGetXformOrd(const MOT_CLIP* pClip, int nodeIdx) {
+	return motClipNodeIdxCk(pClip, nodeIdx) ? (E_MOT_XORD)pClip->nodes[nodeIdx].xord : XORD_SRT;
+}
+
+static uint32_t qmax(int qbits) {
+	return (1U << qbits) - 1;
+}
+
+static float qscale(const MOT_TRACK* pTrk, int chan) {
+	return (pTrk->vmax.s[chan] - pTrk->vmin.s[chan]) / (float)qmax(pTrk->qbits);
+}
+
+/* quantized data: qbits <= 8 are stored as uint8, up to 16 as uint16 */
+static float dequant(const MOT_TRACK* pTrk, int chan, const void* pData, int idx) {
+	uint32_t q;
+	if (pTrk->qbits <= 8) {
+		q = ((const uint8_t*)pData)[idx];
+	} else {
+		q = ((const uint16_t*)pData)[idx];
+	}
+	return pTrk->vmin.s[chan] + (float)q * qscale(pTrk, chan);
+}
+
+/*
+ * Spline channel block: uint32 nkey, uint16 frames[nkey] (padded to 4 bytes), float values[nkey].
+ * Keys are non-uniform Catmull-Rom (one-sided tangents at the ends), the first and last
+ * frames are always keys. Frames between keys are sampled from the curve, so the usual
+ * lerp between integer frames applies on top as with dense data.
+ */
+static size_t keyblksize(uint32_t nkey) {
+	return sizeof(uint32_t) + ((nkey * sizeof(uint16_t) + 3) & ~3) + nkey * sizeof(float);
+}
+
+static const uint8_t* keynext(const uint8_t* pBlk) {
+	return pBlk + keyblksize(*(const uint32_t*)pBlk);
+}
+
+/* slope per frame at key i */
+static float keytan(const uint16_t* pFrm, const float* pVal, int nkey, int i) {
+	int i0 = i > 0 ? i - 1 : i;
+	int i1 = i < nkey - 1 ? i + 1 : i;
+	return (pVal[i1] - pVal[i0]) / (float)(pFrm[i1] - pFrm[i0]);
+}
+
+/* Hermite segment as a cubic in frames from the segment start */
+static void keycoef(float c[4], const uint16_t* pFrm, const float* pVal, int nkey, int seg) {
+	float h = (float)(pFrm[seg + 1] - pFrm[seg]);
+	float ih = 1.0f / h;
+	float v0 = pVal[seg];
+	float v1 = pVal[seg + 1];
+	float m0 = keytan(pFrm, pVal, nkey, seg) * h;
+	float m1 = keytan(pFrm, pVal, nkey, seg + 1) * h;
+	c[0] = v0;
+	c[1] = m0 * ih;
+	c[2] = (3.0f*(v1 - v0) - 2.0f*m0 - m1) * ih * ih;
+	c[3] = (2.0f*(v0 - v1) + m0 + m1) * ih * ih * ih;
+}
+
+static float keypoly(const float c[4], float u) {
+	return c[0] + u*(c[1] + u*(c[2] + u*c[3]));
+}
+
+static float keyeval(const uint16_t* pFrm, const float* pVal, int nkey, int seg, int fno) {
+	float c[4];
+	keycoef(c, pFrm, pVal, nkey, seg);
+	return keypoly(c, (float)(fno - pFrm[seg]));
+}
+
+/* segment with frm[seg] <= fno < frm[seg+1] (the last one includes its end): cur or the one after it, otherwise binary search */
+static int keyseg(const uint16_t* pFrm, int nkey, int fno, int cur) {
+	int lo, hi;
+	if (cur >= 0 && cur < nkey - 1 && fno >= pFrm[cur]) {
+		if (fno < pFrm[cur + 1] || cur == nkey - 2) return cur;
+		if (fno < pFrm[cur + 2] || cur + 1 == nkey - 2) return cur + 1;
+	}
+	lo = 0;
+	hi = nkey - 2;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) >> 1;
+		if (pFrm[mid] <= fno) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return lo;
+}
+
+static float keysmp(const uint8_t* pBlk, int fno) {
+	int nkey = (int)*(const uint32_t*)pBlk;
+	const uint16_t* pFrm = (const uint16_t*)(pBlk + sizeof(uint32_t));
+	const float* pVal = (const float*)(pBlk + keyblksize(nkey) - nkey * sizeof(float));
+	return keyeval(pFrm, pVal, nkey, keyseg(pFrm, nkey, fno, -1), fno);
+}
+
+/*
+ * Fourier channel block: uint32 cut, float a[cut], float b[cut-1] (b[0] = 0 is not stored):
+ * v(frm) = a[0] + sum(k = 1 .. cut-1) a[k]*cos(k*w) + b[k]*sin(k*w), w = 2*pi*frm/nfrm.
+ */
+static size_t dftblksize(uint32_t cut) {
+	return sizeof(uint32_t) + (cut * 2 - 1) * sizeof(float);
+}
+
+static const uint8_t* dftnext(const uint8_t* pBlk) {
+	return pBlk + dftblksize(*(const uint32_t*)pBlk);
+}
+
+static float dftparam(const MOT_CLIP* pClip, float frm) {
+	return frm * (2.0f * c_pi) / (float)pClip->nfrm;
+}
+
+/* cos/sin(k*w) for k < n with the NR ed3 (5.4.6) recurrence */
+static void dfttrig(float* pCos, float* pSin, int n, float w) {
+	float a = sinf(w * 0.5f);
+	float b = sinf(w);
+	float c = 1.0f;
+	float s = 0.0f;
+	int i;
+	a = 2.0f * a * a;
+	for (i = 0; i < n; ++i) {
+		float ci = c - (a*c + b*s);
+		float si = s - (a*s - b*c);
+		pCos[i] = c;
+		pSin[i] = s;
+		c = ci;
+		s = si;
+	}
+}
+
+static float dftdot(const uint8_t* pBlk, const float* pCos, const float* pSin) {
+	int cut = (int)*(const uint32_t*)pBlk;
+	const float* pA = (const float*)(pBlk + sizeof(uint32_t));
+	const float* pB = pA + cut - 1;
+	float res = pA[0];
+	int k;
+	for (k = 1; k < cut; ++k) {
+		res += pA[k]*pCos[k] + pB[k]*pSin[k];
+	}
+	return res;
+}
+
+static float dfteval(const uint8_t* pBlk, float w) {
+	int cut = (int)*(const uint32_t*)pBlk;
+	const float* pA = (const float*)(pBlk + sizeof(uint32_t));
+	const float* pB = pA + cut - 1;
+	float a = sinf(w * 0.5f);
+	float b = sinf(w);
+	float c = cosf(w);
+	float s = b;
+	float res = pA[0];
+	int k;
+	a = 2.0f * a * a;
+	for (k = 1; k < cut; ++k) {
+		float ck, sk;
+		res += pA[k]*c + pB[k]*s;
+		ck = c - (a*c + b*s);
+		sk = s - (a*s - b*c);
+		c = ck;
+		s = sk;
+	}
+	return res;
+}
+
+static MOT_VEC dftvec(const MOT_CLIP* pClip, int nodeIdx, E_MOT_TRK trk, float frm) {
+	const MOT_TRACK* pTrk = &pClip->nodes[nodeIdx].trk[(int)trk];
+	const uint8_t* pBlk = (const uint8_t*)motGetTrackData(pClip, nodeIdx, trk);
+	float defVal = trk == TRK_SCL ? 1.0f : 0.0f;
+	float w = dftparam(pClip, frm);
+	MOT_VEC v;
+	int i;
+	for (i = 0; i < 3; ++i) {
+		if (pTrk->dataMask & (1 << i)) {
+			v.s[i] = dfteval(pBlk, w);
+			pBlk = dftnext(pBlk);
+		} else if (pTrk->srcMask & (1 << i)) {
+			v.s[i] = pTrk->vmin.s[i];
+		} else {
+			v.s[i] = defVal;
+		}
+	}
+	return v;
+}
+
+MOT_VEC motGetVec(const MOT_CLIP* pClip, int nodeIdx, int fno, E_MOT_TRK trk) {
+	MOT_VEC v = {0.0f, 0.0f, 0.0f};
+	if (pClip && motClipNodeIdxCk(pClip, nodeIdx) && motFrameNoCk(pClip, fno)) {
+		int i;
+		int itrk = (int)trk;
+		if (itrk < 3 && pClip->nodes[nodeIdx].trk[itrk].srcMask) {
+			const MOT_TRACK* pTrk = &pClip->nodes[nodeIdx].trk[itrk];
+			float* p = motGetTrackData(pClip, nodeIdx, trk);
+			float defVal = trk == TRK_SCL ? 1.0f : 0.0f;
+			int dataMask = pTrk->dataMask;
+			int srcMask = pTrk->srcMask;
+			int vsize = 0;
+			if (!p) {
+				/* constant channels only: no curve data is stored */
+				dataMask = 0;
+			}
+			for (i = 0; i < 3; ++i) {
+				if (dataMask & (1 << i)) ++vsize;
+			}
+			if (p && pTrk->qbits) {
+				int idx = fno * vsize;
+				for (i = 0; i < 3; ++i) {
+					if (dataMask & (1 << i)) {
+						v.s[i] = dequant(pTrk, i, p, idx++);
+					} else if (srcMask & (1 << i)) {
+						v.s[i] = pTrk->vmin.s[i];
+					} else {
+						v.s[i] = defVal;
+					}
+				}
+				return v;
+			}
+			if (p && pTrk->rdft) {
+				return dftvec(pClip, nodeIdx, trk, (float)fno);
+			}
+			if (p && pTrk->spline) {
+				const uint8_t* pBlk = (const uint8_t*)p;
+				for (i = 0; i < 3; ++i) {
+					if (dataMask & (1 << i)) {
+						v.s[i] = keysmp(pBlk, fno);
+						pBlk = keynext(pBlk);
+					} else if (srcMask & (1 << i)) {
+						v.s[i] = pTrk->vmin.s[i];
+					} else {
+						v.s[i] = defVal;
+					}
+				}
+				return v;
+			}
+			if (p) {
+				p += fno * (pTrk->fmaj ? motClipRowWidth(pClip) : vsize);
+			}
+			for (i = 0; i < 3; ++i) {
+				if (dataMask & (1 << i)) {
+					v.s[i] = *p++;
+				} else if (srcMask & (1 << i)) {
+					v.s[i] = pTrk->vmin.s[i];
+				} else {
+					v.s[i] = defVal;
+				}
+			}
+		}
+	}
+	return v;
+}
+
+MOT_VEC motGetPos(const MOT_CLIP* pClip, int nodeIdx, int fno) {
+	return motGetVec(pClip, nodeIdx, fno, TRK_POS);
+}
+
+MOT_VEC motGetScl(const MOT_CLIP* pClip, int nodeIdx, int fno) {
+	if (!motNodeTrackCk(pClip, nodeIdx, TRK_SCL)) {
+		MOT_VEC s = { 1.0f, 1.0f, 1.0f };
+		return s;
+	}
+	return motGetVec(pClip, nodeIdx, fno, TRK_SCL);
+}
+
+MOT_QUAT motGetQuat(const MOT_CLIP* pClip, int nodeIdx, int fno) {
+	return motQuatExp(motGetVec(pClip, nodeIdx, fno, TRK_ROT));
+}
+
+MOT_VEC motGetRadians(const MOT_CLIP* pClip, int nodeIdx, int fno) {
+	return motQuatToRadians(motGetQuat(pClip, nodeIdx, fno), motGetRotOrd(pClip, nodeIdx));
+}
+
+MOT_VEC motGetDegrees(const MOT_CLIP* pClip, int nodeIdx, int fno) {
+	return motQuatToDegrees(motGetQuat(pClip, nodeIdx, fno), motGetRotOrd(pClip, nodeIdx));
+}
+
+typedef struct _MOT_FRAME_INFO {
+	float f;
+	float t;
+	int fno;
+	int next;
+} MOT_FRAME_INFO;
+
+static MOT_FRAME_INFO finfo(const MOT_CLIP* pClip, float frm) {
+	MOT_FRAME_INFO fi;
+	int nfrm = pClip->nfrm;
+	frm = fabsf(frm);
+	fi.f = fmodf(frm, (float)nfrm);
+	fi.fno = (int)fi.f;
+	fi.t = fi.f - (float)fi.fno;
+	fi.next = fi.fno < nfrm - 1 ? fi.fno + 1 : 0;
+	return fi;
+}
+
+/* track value at frm: Fourier tracks are evaluated at frm itself, others lerp between frames */
+static MOT_VEC evalvec(const MOT_CLIP* pClip, int nodeIdx, E_MOT_TRK trk, float frm) {
+	MOT_FRAME_INFO fi = finfo(pClip, frm);
+	MOT_VEC v;
+	if (pClip->nodes[nodeIdx].trk[(int)trk].rdft && motGetTrackData(pClip, nodeIdx, trk)) {
+		return dftvec(pClip, nodeIdx, trk, fi.f);
+	}
+	v = motGetVec(pClip, nodeIdx, fi.fno, trk);
+	if (fi.t != 0.0f) {
+		v = motVecLerp(v, motGetVec(pClip, nodeIdx, fi.next, trk), fi.t);
+	}
+	return v;
+}
+
+MOT_QUAT motEvalQuat(const MOT_CLIP* pClip, int nodeIdx, float frm) {
+	MOT_QUAT q = { 0.0f, 0.0f, 0.0f, 1.0f };
+	if (!pClip || !motClipNodeIdxCk(pClip, nodeIdx)) {
+		return q;
+	}
+	q = motQuatExp(evalvec(pClip, nodeIdx, TRK_ROT, frm));
+	return q;
+}
+
+MOT_QUAT motEvalQuatSlerp(const MOT_CLIP* pClip, int nodeIdx, float frm) {
+	MOT_FRAME_INFO fi;
+	MOT_QUAT q = { 0.0f, 0.0f, 0.0f, 1.0f };
+	if (!pClip || !motClipNodeIdxCk(pClip, nodeIdx)) {
+		return q;
+	}
+	fi = finfo(pClip, frm);
+	q = motGetQuat(pClip, nodeIdx, fi.fno);
+	if (fi.t != 0.0f) {
+		MOT_QUAT qnext = motGetQuat(pClip, nodeIdx, fi.next);
+		q = motQuatSlerp(q, qnext, fi.t);
+	}
+	return q;
+}
+
+MOT_VEC motEvalRadians(const MOT_CLIP* pClip, int nodeIdx, float frm) {
+	return motQuatToRadians(motEvalQuat(pClip, nodeIdx, frm), motGetRotOrd(pClip, nodeIdx));
+}
+
+MOT_VEC motEvalDegrees(const MOT_CLIP* pClip, int nodeIdx, float frm) {
+	return motQuatToDegrees(motEvalQuat(pClip, nodeIdx, frm), motGetRotOrd(pClip, nodeIdx));
+}
+
+MOT_VEC motEvalPos(const MOT_CLIP* pClip, int nodeIdx, float frm) {
+	MOT_VEC v = { 0.0f, 0.0f, 0.0f };
+	if (!pClip || !motClipNodeIdxCk(pClip, nodeIdx)) {
+		return v;
+	}
+	v = evalvec(pClip, nodeIdx, TRK_POS, frm);
+	return v;
+}
+
+MOT_VEC motEvalScl(const MOT_CLIP* pClip, int nodeIdx, float frm) {
+	MOT_VEC v = { 1.0f, 1.0f, 1.0f };
+	if (!pClip || !motClipNodeIdxCk(pClip, nodeIdx) || !motNodeTrackCk(pClip, nodeIdx, TRK_SCL)) {
+		return v;
+	}
+	v = evalvec(pClip, nodeIdx, TRK_SCL, frm);
+	return v;
+}
+
+static void mkxform(MOT_MTX* pMtx, int srt, const MOT_VEC t, const MOT_QUAT q, const MOT_VEC s, E_MOT_XORD xord) {
+	switch (srt) {
+		case 0:
+			break;
+		case 1:
+			motMakeTransformT(pMtx, t);
+			break;
+		case 2:
+			motMakeTransformR(pMtx, q);
+			break;
+		case (1 | 2):
+			motMakeTransformTR(pMtx, t, q, xord);
+			break;
+		default:
+			motMakeTransform(pMtx, t, q, s, xord);
+			break;
+	}
+}
+
+void motEvalTransform(MOT_MTX* pMtx, const MOT_CLIP* pClip, int nodeIdx, float frm, const MOT_VEC* pDefTns) {
+	MOT_QUAT q = { 0.0f, 0.0f, 0.0f, 1.0f };
+	MOT_VEC t = { 0.0f, 0.0f, 0.0f };
+	MOT_VEC s = { 1.0f, 1.0f, 1.0f };
+	E_MOT_XORD xord;
+	int srt = 0;
+	if (!pMtx || !pClip || !motClipNodeIdxCk(pClip, nodeIdx)) return;
+	xord = motGetXformOrd(pClip, nodeIdx);
+	if (motNodeTrackCk(pClip, nodeIdx, TRK_POS)) srt |= 1;
+	if (motNodeTrackCk(pClip, nodeIdx, TRK_ROT)) srt |= 2;
+	if (motNodeTrackCk(pClip, nodeIdx, TRK_SCL)) srt |= 4;
+	if (srt & 1) {
+		t = motEvalPos(pClip, nodeIdx, frm);
+	} else {
+		if (pDefTns) {
+			t = *pDefTns;
+			srt |= 1;
+		}
+	}
+	if (srt & 2) {
+		q = motEvalQuat(pClip, nodeIdx, frm);
+	}
+	if (srt & 4) {
+		s = motEvalScl(pClip, nodeIdx, frm);
+	}
+	mkxform(pMtx, srt, t, q, s, xord);
+}
+
+void motEvalPose(const MOT_CLIP* pClip, float frm, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	MOT_FRAME_INFO fi;
+	const MOT_EVAL* pEval;
+	const MOT_SEQ* pSeq;
+	const uint8_t* pTop;
+	int i, nnod, kind;
+	int fofs[4];
+	int nofs[4];
+	if (!pClip) return;
+	nnod = pClip->nnod;
+	for (i = 0; i < nnod; ++i) {
+		if (pPos) {
+			pPos[i].x = 0.0f;
+			pPos[i].y = 0.0f;
+			pPos[i].z = 0.0f;
+		}
+		if (pRot) {
+			pRot[i].x = 0.0f;
+			pRot[i].y = 0.0f;
+			pRot[i].z = 0.0f;
+			pRot[i].w = 1.0f;
+		}
+		if (pScl) {
+			pScl[i].x = 1.0f;
+			pScl[i].y = 1.0f;
+			pScl[i].z = 1.0f;
+		}
+	}
+	pEval = motGetEvalInfo(pClip);
+	pSeq = motGetSeqInfo(pClip);
+	if (!pEval || !pSeq) {
+		for (i = 0; i < nnod; ++i) {
+			if (pPos) pPos[i] = motEvalPos(pClip, i, frm);
+			if (pRot) pRot[i] = motEvalQuat(pClip, i, frm);
+			if (pScl) pScl[i] = motEvalScl(pClip, i, frm);
+		}
+		return;
+	}
+	fi = finfo(pClip, frm);
+	for (i = 0; i < 4; ++i) {
+		fofs[i] = fi.fno * i;
+		nofs[i] = fi.next * i;
+	}
+	pTop = (const uint8_t*)pClip;
+	for (kind = 0; kind < 3; ++kind) {
+		int nseq = (int)pEval->ntrk[kind] * 3;
+		float* pDst = NULL;
+		int dstStride = 3;
+		float defVal = kind == TRK_SCL ? 1.0f : 0.0f;
+		switch (kind) {
+			case TRK_POS: pDst = pPos ? pPos->s : NULL; break;
+			case TRK_ROT: pDst = pRot ? pRot->s : NULL; dstStride = 4; break;
+			case TRK_SCL: pDst = pScl ? pScl->s : NULL; break;
+		}
+		if (!pDst) {
+			pSeq += nseq;
+			continue;
+		}
+		if (fi.t != 0.0f) {
+			for (i = 0; i < nseq; ++i) {
+				float* pVal = &pDst[pSeq[i].node*dstStride + pSeq[i].chan];
+				if (pSeq[i].offs) {
+					const float* pSrc = (const float*)&pTop[pSeq[i].offs];
+					int stride = pSeq[i].stride;
+					*pVal = lerp(pSrc[fofs[stride]], pSrc[nofs[stride]], fi.t);
+				} else {
+					*pVal = defVal;
+				}
+			}
+		} else {
+			for (i = 0; i < nseq; ++i) {
+				float* pVal = &pDst[pSeq[i].node*dstStride + pSeq[i].chan];
+				if (pSeq[i].offs) {
+					const float* pSrc = (const float*)&pTop[pSeq[i].offs];
+					*pVal = pSrc[fofs[pSeq[i].stride]];
+				} else {
+					*pVal = defVal;
+				}
+			}
+		}
+		if (kind == TRK_ROT) {
+			for (i = 0; i < nseq; i += 3) {
+				MOT_QUAT* pQuat = &pRot[pSeq[i].node];
+				MOT_VEC v;
+				v.x = pQuat->x;
+				v.y = pQuat->y;
+				v.z = pQuat->z;
+				*pQuat = motQuatExp(v);
+			}
+		}
+		pSeq += nseq;
+	}
+}
+
+static const float s_acostbl[] = {
+	1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f,
+	0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f
+};
+
+/* acos(x) for 0 <= x <= 1, |err| <= 2e-8 (A&S 4.4.46) */
+static float aryacos(float x) {
+	const float* c = s_acostbl;
+	float p = c[7];
+	int i;
+	for (i = 6; i >= 0; --i) {
+		p = p*x + c[i];
+	}
+	return sqrtf(1.0f - x) * p;
+}
+
+/* t correction for nlerp approximating slerp, see zeux.io/2015/07/23/approximating-slerp */
+static float nlfix(float d, float t) {
+	float a = 1.0904f + d*(-3.2452f + d*(3.55645f - d*1.43519f));
+	float b = 0.848013f + d*(-1.06021f + d*0.215638f);
+	float u = t - 0.5f;
+	float k = a*u*u + b;
+	return t + t*u*(t - 1.0f)*k;
+}
+
+static void* alignptr(void* p, size_t algn) {
+	return (void*)(((uintptr_t)p + algn - 1) & ~(uintptr_t)(algn - 1));
+}
+
+int motPoseAlloc(MOT_POSE* pPose, int njnt) {
+	int i, nlane;
+	float* pLane;
+	if (!pPose || njnt <= 0) return 0;
+	memset(pPose, 0, sizeof(MOT_POSE));
+	nlane = (njnt + MOT_POSE_PAD - 1) & ~(MOT_POSE_PAD - 1);
+	pPose->pMem = malloc(10 * nlane * sizeof(float) + MOT_POSE_PAD * sizeof(float));
+	if (!pPose->pMem) return 0;
+	pPose->njnt = njnt;
+	pPose->nlane = nlane;
+	pLane = (float*)alignptr(pPose->pMem, MOT_POSE_PAD * sizeof(float));
+	for (i = 0; i < 3; ++i) {
+		pPose->pPos[i] = pLane;
+		pLane += nlane;
+	}
+	for (i = 0; i < 4; ++i) {
+		pPose->pRot[i] = pLane;
+		pLane += nlane;
+	}
+	for (i = 0; i < 3; ++i) {
+		pPose->pScl[i] = pLane;
+		pLane += nlane;
+	}
+	motPoseIdentity(pPose);
+	return 1;
+}
+
+void motPoseFree(MOT_POSE* pPose) {
+	if (pPose) {
+		if (pPose->pMem) {
+			free(pPose->pMem);
+		}
+		memset(pPose, 0, sizeof(MOT_POSE));
+	}
+}
+
+void motPoseIdentity(MOT_POSE* pPose) {
+	int i, j, n;
+	if (!pPose || !pPose->pMem) return;
+	n = pPose->nlane;
+	for (i = 0; i < n; ++i) {
+		for (j = 0; j < 3; ++j) {
+			pPose->pPos[j][i] = 0.0f;
+			pPose->pRot[j][i] = 0.0f;
+			pPose->pScl[j][i] = 1.0f;
+		}
+		pPose->pRot[3][i] = 1.0f;
+	}
+}
+
+void motPoseFromAry(MOT_POSE* pPose, const MOT_VEC* pPos, const MOT_QUAT* pRot, const MOT_VEC* pScl) {
+	int i, j, n;
+	if (!pPose || !pPose->pMem) return;
+	n = pPose->njnt;
+	if (pPos) {
+		for (i = 0; i < n; ++i) {
+			for (j = 0; j < 3; ++j) {
+				pPose->pPos[j][i] = pPos[i].s[j];
+			}
+		}
+	}
+	if (pRot) {
+		for (i = 0; i < n; ++i) {
+			for (j = 0; j < 4; ++j) {
+				pPose->pRot[j][i] = pRot[i].s[j];
+			}
+		}
+	}
+	if (pScl) {
+		for (i = 0; i < n; ++i) {
+			for (j = 0; j < 3; ++j) {
+				pPose->pScl[j][i] = pScl[i].s[j];
+			}
+		}
+	}
+}
+
+void motPoseToAry(const MOT_POSE* pPose, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	int i, j, n;
+	if (!pPose || !pPose->pMem) return;
+	n = pPose->njnt;
+	if (pPos) {
+		for (i = 0; i < n; ++i) {
+			for (j = 0; j < 3; ++j) {
+				pPos[i].s[j] = pPose->pPos[j][i];
+			}
+		}
+	}
+	if (pRot) {
+		for (i = 0; i < n; ++i) {
+			for (j = 0; j < 4; ++j) {
+				pRot[i].s[j] = pPose->pRot[j][i];
+			}
+		}
+	}
+	if (pScl) {
+		for (i = 0; i < n; ++i) {
+			for (j = 0; j < 3; ++j) {
+				pScl[i].s[j] = pPose->pScl[j][i];
+			}
+		}
+	}
+}
+
+static void lerpLanes(float* pDst, const float* pSrc1, const float* pSrc2, float t, int n) {
+	int i;
+	for (i = 0; i < n; ++i) {
+		pDst[i] = lerp(pSrc1[i], pSrc2[i], t);
+	}
+}
+
+static void qblendLanes(float* const pDst[4], float* const pSrc1[4], float* const pSrc2[4], float t, int n, E_MOT_QBLEND mode) {
+	int i, j;
+	for (i = 0; i < n; ++i) {
+		float q1[4], q2[4];
+		float d = 0.0f;
+		float w1, w2, s;
+		for (j = 0; j < 4; ++j) {
+			q1[j] = pSrc1[j][i];
+			q2[j] = pSrc2[j][i];
+			d += q1[j] * q2[j];
+		}
+		s = d < 0.0f ? -1.0f : 1.0f;
+		d = fabsf(d);
+		switch (mode) {
+			default:
+			case QBLEND_NLERP:
+				w1 = 1.0f - t;
+				w2 = t;
+				break;
+			case QBLEND_NLERP_FIX:
+				w2 = nlfix(d, t);
+				w1 = 1.0f - w2;
+				break;
+			case QBLEND_SLERP: {
+				float ang = aryacos(d < 1.0f ? d : 1.0f);
+				float r = 1.0f / arysinc(ang);
+				w1 = (1.0f - t) * arysinc(ang*(1.0f - t)) * r;
+				w2 = t * arysinc(ang*t) * r;
+				break;
+			}
+		}
+		w2 *= s;
+		for (j = 0; j < 4; ++j) {
+			q1[j] = q1[j]*w1 + q2[j]*w2;
+		}
+		s = 1.0f / sqrtf(sq(q1[0]) + sq(q1[1]) + sq(q1[2]) + sq(q1[3]));
+		for (j = 0; j < 4; ++j) {
+			pDst[j][i] = q1[j] * s;
+		}
+	}
+}
+
+#if MOT_SIMD_X86
+static MOT_TARGET("avx2") void lerpLanesAVX2(float* pDst, const float* pSrc1, const float* pSrc2, float t, int n) {
+	int i;
+	__m256 vt = _mm256_set1_ps(t);
+	for (i = 0; i < n; i += 8) {
+		__m256 a = _mm256_load_ps(&pSrc1[i]);
+		__m256 b = _mm256_load_ps(&pSrc2[i]);
+		_mm256_store_ps(&pDst[i], _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), vt)));
+	}
+}
+
+static MOT_TARGET("avx2") __m256 avxPoly(__m256 x, const float tbl[], int n) {
+	__m256 r = _mm256_set1_ps(tbl[n - 1]);
+	int i;
+	for (i = n - 2; i >= 0; --i) {
+		r = _mm256_add_ps(_mm256_mul_ps(r, x), _mm256_set1_ps(tbl[i]));
+	}
+	return r;
+}
+
+static MOT_TARGET("avx2") __m256 avxSinc(__m256 x) {
+	return avxSeries(_mm256_mul_ps(x, x), s_sinctbl);
+}
+
+static MOT_TARGET("avx2") void qblendLanesAVX2(float* const pDst[4], float* const pSrc1[4], float* const pSrc2[4], float t, int n, E_MOT_QBLEND mode) {
+	int i, j;
+	__m256 one = _mm256_set1_ps(1.0f);
+	__m256 vt = _mm256_set1_ps(t);
+	__m256 vt1 = _mm256_set1_ps(1.0f - t);
+	__m256 sgnMask = _mm256_set1_ps(-0.0f);
+	for (i = 0; i < n; i += 8) {
+		__m256 q1[4], q2[4];
+		__m256 d, s, w1, w2;
+		for (j = 0; j < 4; ++j) {
+			q1[j] = _mm256_load_ps(&pSrc1[j][i]);
+			q2[j] = _mm256_load_ps(&pSrc2[j][i]);
+		}
+		d = _mm256_mul_ps(q1[0], q2[0]);
+		for (j = 1; j < 4; ++j) {
+			d = _mm256_add_ps(d, _mm256_mul_ps(q1[j], q2[j]));
+		}
+		s = _mm256_and_ps(d, sgnMask);
+		d = _mm256_andnot_ps(sgnMask, d);
+		switch (mode) {
+			default:
+			case QBLEND_NLERP:
+				w1 = vt1;
+				w2 = vt;
+				break;
+			case QBLEND_NLERP_FIX: {
+				__m256 u = _mm256_set1_ps(t - 0.5f);
+				__m256 a = _mm256_set1_ps(-1.43519f);
+				__m256 b = _mm256_set1_ps(0.215638f);
+				__m256 k;
+				a = _mm256_add_ps(_mm256_mul_ps(a, d), _mm256_set1_ps(3.55645f));
+				a = _mm256_add_ps(_mm256_mul_ps(a, d), _mm256_set1_ps(-3.2452f));
+				a = _mm256_add_ps(_mm256_mul_ps(a, d), _mm256_set1_ps(1.0904f));
+				b = _mm256_add_ps(_mm256_mul_ps(b, d), _mm256_set1_ps(-1.06021f));
+				b = _mm256_add_ps(_mm256_mul_ps(b, d), _mm256_set1_ps(0.848013f));
+				k = _mm256_add_ps(_mm256_mul_ps(a, _mm256_mul_ps(u, u)), b);
+				w2 = _mm256_mul_ps(_mm256_mul_ps(vt, u), _mm256_mul_ps(_mm256_set1_ps(t - 1.0f), k));
+				w2 = _mm256_add_ps(vt, w2);
+				w1 = _mm256_sub_ps(one, w2);
+				break;
+			}
+			case QBLEND_SLERP: {
+				__m256 ang, r;
+				d = _mm256_min_ps(d, one);
+				ang = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sub_ps(one, d)), avxPoly(d, s_acostbl, 8));
+				r = _mm256_div_ps(one, avxSinc(ang));
+				w1 = _mm256_mul_ps(_mm256_mul_ps(vt1, avxSinc(_mm256_mul_ps(ang, vt1))), r);
+				w2 = _mm256_mul_ps(_mm256_mul_ps(vt, avxSinc(_mm256_mul_ps(ang, vt))), r);
+				break;
+			}
+		}
+		w2 = _mm256_xor_ps(w2, s);
+		for (j = 0; j < 4; ++j) {
+			q1[j] = _mm256_add_ps(_mm256_mul_ps(q1[j], w1), _mm256_mul_ps(q2[j], w2));
+		}
+		d = _mm256_mul_ps(q1[0], q1[0]);
+		for (j = 1; j < 4; ++j) {
+			d = _mm256_add_ps(d, _mm256_mul_ps(q1[j], q1[j]));
+		}
+		d = _mm256_div_ps(one, _mm256_sqrt_ps(d));
+		for (j = 0; j < 4; ++j) {
+			_mm256_store_ps(&pDst[j][i], _mm256_mul_ps(q1[j], d));
+		}
+	}
+}
+#endif /* MOT_SIMD_X86 */
+
+void motPoseBlendEx(MOT_POSE* pDst, const MOT_POSE* pSrc1, const MOT_POSE* pSrc2, float t, E_MOT_QBLEND mode, E_MOT_SIMD simd) {
+	int j, n;
+	if (!pDst || !pSrc1 || !pSrc2) return;
+	if (!pDst->pMem || !pSrc1->pMem || !pSrc2->pMem) return;
+	n = pDst->nlane;
+	if (pSrc1->nlane < n || pSrc2->nlane < n) return;
+	if (!motSIMDCk(simd)) {
+		simd = motGetSIMD();
+	}
+#if MOT_SIMD_X86
+	if (simd == SIMD_AVX2) {
+		for (j = 0; j < 3; ++j) {
+			lerpLanesAVX2(pDst->pPos[j], pSrc1->pPos[j], pSrc2->pPos[j], t, n);
+			lerpLanesAVX2(pDst->pScl[j], pSrc1->pScl[j], pSrc2->pScl[j], t, n);
+		}
+		qblendLanesAVX2(pDst->pRot, pSrc1->pRot, pSrc2->pRot, t, n, mode);
+		return;
+	}
+#endif
+	for (j = 0; j < 3; ++j) {
+		lerpLanes(pDst->pPos[j], pSrc1->pPos[j], pSrc2->pPos[j], t, n);
+		lerpLanes(pDst->pScl[j], pSrc1->pScl[j], pSrc2->pScl[j], t, n);
+	}
+	qblendLanes(pDst->pRot, pSrc1->pRot, pSrc2->pRot, t, n, mode);
+}
+
+void motPoseBlend(MOT_POSE* pDst, const MOT_POSE* pSrc1, const MOT_POSE* pSrc2, float t, E_MOT_QBLEND mode) {
+	motPoseBlendEx(pDst, pSrc1, pSrc2, t, mode, motGetSIMD());
+}
+
+static void seqsmp(float v[3], const uint8_t* pTop, const MOT_SEQ* pSeq, const MOT_FRAME_INFO* pFi, float defVal) {
+	int i;
+	for (i = 0; i < 3; ++i) {
+		if (pSeq[i].offs) {
+			const float* pSrc = (const float*)&pTop[pSeq[i].offs];
+			int stride = pSeq[i].stride;
+			float v0 = pSrc[pFi->fno * stride];
+			v[i] = pFi->t != 0.0f ? lerp(v0, pSrc[pFi->next * stride], pFi->t) : v0;
+		} else {
+			v[i] = defVal;
+		}
+	}
+}
+
+static void qnlerp(float q[4], const float q1[4], const float q2[4], float t) {
+	int i;
+	float d = 0.0f;
+	float s = 0.0f;
+	for (i = 0; i < 4; ++i) {
+		d += q1[i] * q2[i];
+	}
+	d = d < 0.0f ? -t : t;
+	for (i = 0; i < 4; ++i) {
+		q[i] = q1[i]*(1.0f - t) + q2[i]*d;
+		s += sq(q[i]);
+	}
+	s = 1.0f / sqrtf(s);
+	for (i = 0; i < 4; ++i) {
+		q[i] *= s;
+	}
+}
+
+static void blendQuat(MOT_POSE* pPose, int jnt, const MOT_QUAT* pQuat, const MOT_QUAT* pRef, float w) {
+	float q[4];
+	int i;
+	for (i = 0; i < 4; ++i) {
+		q[i] = pPose->pRot[i][jnt];
+	}
+	if (pRef) {
+		static const float qid[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		MOT_QUAT qref = *pRef;
+		MOT_QUAT dq;
+		for (i = 0; i < 3; ++i) {
+			qref.s[i] = -qref.s[i];
+		}
+		dq = motQuatMul(qref, *pQuat);
+		qnlerp(dq.s, qid, dq.s, w);
+		for (i = 0; i < 4; ++i) {
+			qref.s[i] = q[i];
+		}
+		dq = motQuatMul(qref, dq);
+		for (i = 0; i < 4; ++i) {
+			q[i] = dq.s[i];
+		}
+	} else {
+		qnlerp(q, q, pQuat->s, w);
+	}
+	for (i = 0; i < 4; ++i) {
+		pPose->pRot[i][jnt] = q[i];
+	}
+}
+
+static void blendVec(MOT_POSE* pPose, int jnt, int kind, const float v[3], const float vref[3], float w, int additive) {
+	float* const* pDst = kind == TRK_POS ? pPose->pPos : pPose->pScl;
+	int i;
+	for (i = 0; i < 3; ++i) {
+		float* pVal = &pDst[i][jnt];
+		if (!additive) {
+			*pVal = lerp(*pVal, v[i], w);
+		} else if (kind == TRK_POS) {
+			*pVal += (v[i] - vref[i]) * w;
+		} else if (vref[i] != 0.0f) {
+			*pVal *= lerp(1.0f, v[i] / vref[i], w);
+		}
+	}
+}
+
+static void blendLayerNodes(MOT_POSE* pPose, const MOT_LAYER* pLayer) {
+	const MOT_CLIP* pClip = pLayer->pClip;
+	int inod, kind;
+	int nnod = pClip->nnod;
+	int additive = pLayer->mode == LAYER_ADDITIVE;
+	for (inod = 0; inod < nnod; ++inod) {
+		int jnt = pLayer->pMap ? pLayer->pMap[inod] : inod;
+		float w;
+		if ((uint32_t)jnt >= (uint32_t)pPose->njnt) continue;
+		w = pLayer->weight * (pLayer->pMask ? pLayer->pMask[jnt] : 1.0f);
+		if (w <= 0.0f) continue;
+		for (kind = 0; kind < 3; ++kind) {
+			MOT_VEC v, vref;
+			if (!motNodeTrackCk(pClip, inod, (E_MOT_TRK)kind)) continue;
+			switch (kind) {
+				case TRK_POS:
+					v = motEvalPos(pClip, inod, pLayer->frm);
+					vref = motEvalPos(pClip, inod, pLayer->refFrm);
+					break;
+				case TRK_SCL:
+					v = motEvalScl(pClip, inod, pLayer->frm);
+					vref = motEvalScl(pClip, inod, pLayer->refFrm);
+					break;
+				default:
+					v = evalvec(pClip, inod, TRK_ROT, pLayer->frm);
+					vref = evalvec(pClip, inod, TRK_ROT, pLayer->refFrm);
+					break;
+			}
+			if (kind == TRK_ROT) {
+				MOT_QUAT q = motQuatExp(v);
+				MOT_QUAT qref = motQuatExp(vref);
+				blendQuat(pPose, jnt, &q, additive ? &qref : NULL, w);
+			} else {
+				blendVec(pPose, jnt, kind, v.s, vref.s, w, additive);
+			}
+		}
+	}
+}
+
+#define BLEND_BLK_SIZE (64)
+
+static void blendQuatBlk(MOT_POSE* pPose, const int* pJnt, const float* pWgt, const MOT_VEC* pVecs, MOT_QUAT* pQuats, int n, int additive) {
+	int i;
+	motQuatExpAry(pQuats, pVecs, n);
+	if (additive) {
+		motQuatExpAry(pQuats + BLEND_BLK_SIZE, pVecs + BLEND_BLK_SIZE, n);
+	}
+	for (i = 0; i < n; ++i) {
+		blendQuat(pPose, pJnt[i], &pQuats[i], additive ? &pQuats[BLEND_BLK_SIZE + i] : NULL, pWgt[i]);
+	}
+}
+
+void motEvalBlend(MOT_POSE* pPose, const MOT_LAYER* pLayers, int nlayers) {
+	int ilyr;
+	if (!pPose || !pPose->pMem) return;
+	motPoseIdentity(pPose);
+	if (!pLayers) return;
+	for (ilyr = 0; ilyr < nlayers; ++ilyr) {
+		const MOT_LAYER* pLayer = &pLayers[ilyr];
+		const MOT_CLIP* pClip = pLayer->pClip;
+		const MOT_EVAL* pEval;
+		const MOT_SEQ* pSeq;
+		const uint8_t* pTop;
+		MOT_FRAME_INFO fi, fref;
+		MOT_VEC blkVec[BLEND_BLK_SIZE * 2];
+		MOT_QUAT blkQuat[BLEND_BLK_SIZE * 2];
+		int blkJnt[BLEND_BLK_SIZE];
+		float blkWgt[BLEND_BLK_SIZE];
+		int kind, i;
+		int additive = pLayer->mode == LAYER_ADDITIVE;
+		if (!pClip || pClip->nfrm == 0 || pLayer->weight <= 0.0f) continue;
+		pEval = motGetEvalInfo(pClip);
+		pSeq = motGetSeqInfo(pClip);
+		if (!pEval || !pSeq) {
+			blendLayerNodes(pPose, pLayer);
+			continue;
+		}
+		pTop = (const uint8_t*)pClip;
+		fi = finfo(pClip, pLayer->frm);
+		fref = additive ? finfo(pClip, pLayer->refFrm) : fi;
+		for (kind = 0; kind < 3; ++kind) {
+			int nseq = (int)pEval->ntrk[kind] * 3;
+			float defVal = kind == TRK_SCL ? 1.0f : 0.0f;
+			int nblk = 0;
+			for (i = 0; i < nseq; i += 3) {
+				const MOT_SEQ* pTrk = &pSeq[i];
+				int jnt = pLayer->pMap ? pLayer->pMap[pTrk->node] : pTrk->node;
+				float v[3];
+				float vref[3] = { 0.0f, 0.0f, 0.0f };
+				float w;
+				if ((uint32_t)jnt >= (uint32_t)pPose->njnt) continue;
+				w = pLayer->weight * (pLayer->pMask ? pLayer->pMask[jnt] : 1.0f);
+				if (w <= 0.0f) continue;
+				if (kind == TRK_ROT) {
+					/* collect log vectors, convert them in batches */
+					seqsmp(blkVec[nblk].s, pTop, pTrk, &fi, 0.0f);
+					if (additive) {
+						seqsmp(blkVec[BLEND_BLK_SIZE + nblk].s, pTop, pTrk, &fref, 0.0f);
+					}
+					blkJnt[nblk] = jnt;
+					blkWgt[nblk] = w;
+					if (++nblk == BLEND_BLK_SIZE) {
+						blendQuatBlk(pPose, blkJnt, blkWgt, blkVec, blkQuat, nblk, additive);
+						nblk = 0;
+					}
+					continue;
+				}
+				seqsmp(v, pTop, pTrk, &fi, defVal);
+				if (additive) {
+					seqsmp(vref, pTop, pTrk, &fref, defVal);
+				}
+				blendVec(pPose, jnt, kind, v, vref, w, additive);
+			}
+			if (nblk > 0) {
+				blendQuatBlk(pPose, blkJnt, blkWgt, blkVec, blkQuat, nblk, additive);
+			}
+			pSeq += nseq;
+		}
+	}
+}
+
+int motSkelAlloc(MOT_SKEL* pSkel, int njnt, const int* pParents, const MOT_VEC* pRestTns) {
+	int i, lvl, nlvl;
+	size_t memSize;
+	uint8_t* pMem;
+	int* pDepth;
+	if (!pSkel) return 0;
+	memset(pSkel, 0, sizeof(MOT_SKEL));
+	if (njnt <= 0 || njnt > 0x7FFF || !pParents) return 0;
+	memSize = njnt * (sizeof(MOT_VEC) + sizeof(int) + 3 * sizeof(int16_t)) + (njnt + 1) * sizeof(int);
+	pMem = (uint8_t*)malloc(memSize);
+	if (!pMem) return 0;
+	pSkel->pMem = pMem;
+	pSkel->pRestTns = (MOT_VEC*)pMem;
+	pMem += njnt * sizeof(MOT_VEC);
+	pSkel->pLvl = (int*)pMem;
+	pMem += (njnt + 1) * sizeof(int);
+	pDepth = (int*)pMem;
+	pMem += njnt * sizeof(int);
+	pSkel->pParent = (int16_t*)pMem;
+	pMem += njnt * sizeof(int16_t);
+	pSkel->pOrder = (int16_t*)pMem;
+	pMem += njnt * sizeof(int16_t);
+	pSkel->pNode = (int16_t*)pMem;
+	pSkel->njnt = njnt;
+
+	/* depth of each source joint, in any joint order: walk up to the first joint of known depth,
+	   marking the path (-2), then fill the path back in; every joint is walked once
+	   and reaching a marked joint means a cycle */
+	for (i = 0; i < njnt; ++i) {
+		pDepth[i] = -1;
+	}
+	nlvl = 0;
+	for (i = 0; i < njnt; ++i) {
+		int d, n = 0;
+		int p = i;
+		while (p >= 0 && pDepth[p] == -1) {
+			pDepth[p] = -2;
+			p = pParents[p];
+			if (p >= njnt || (p >= 0 && pDepth[p] == -2)) {
+				motSkelFree(pSkel);
+				return 0;
+			}
+			++n;
+		}
+		d = (p < 0 ? -1 : pDepth[p]) + n;
+		if (d + 1 > nlvl) nlvl = d + 1;
+		for (p = i; n > 0; --n, --d) {
+			pDepth[p] = d;
+			p = pParents[p];
+		}
+	}
+	pSkel->nlvl = nlvl;
+
+	/* stable counting sort by depth: parents come before children, levels are contiguous */
+	for (lvl = 0; lvl <= nlvl; ++lvl) {
+		pSkel->pLvl[lvl] = 0;
+	}
+	for (i = 0; i < njnt; ++i) {
+		++pSkel->pLvl[pDepth[i] + 1];
+	}
+	for (lvl = 0; lvl < nlvl; ++lvl) {
+		pSkel->pLvl[lvl + 1] += pSkel->pLvl[lvl];
+	}
+	/* pLvl[d] serves as the insertion cursor of level d and ends up at the start of d + 1 */
+	for (i = 0; i < njnt; ++i) {
+		pSkel->pOrder[pSkel->pLvl[pDepth[i]]++] = (int16_t)i;
+	}
+	for (lvl = nlvl; lvl > 0; --lvl) {
+		pSkel->pLvl[lvl] = pSkel->pLvl[lvl - 1];
+	}
+	pSkel->pLvl[0] = 0;
+	/* pDepth is reused as the source -> sorted map */
+	for (i = 0; i < njnt; ++i) {
+		pDepth[pSkel->pOrder[i]] = i;
+	}
+	for (i = 0; i < njnt; ++i) {
+		int src = pSkel->pOrder[i];
+		int p = pParents[src];
+		pSkel->pParent[i] = (int16_t)(p < 0 ? -1 : pDepth[p]);
+		pSkel->pNode[i] = -1;
+		if (pRestTns) {
+			pSkel->pRestTns[i] = pRestTns[src];
+		} else {
+			pSkel->pRestTns[i].x = 0.0f;
+			pSkel->pRestTns[i].y = 0.0f;
+			pSkel->pRestTns[i].z = 0.0f;
+		}
+	}
+	return 1;
+}
+
+void motSkelFree(MOT_SKEL* pSkel) {
+	if (pSkel) {
+		if (pSkel->pMem) {
+			free(pSkel->pMem);
+		}
+		memset(pSkel, 0, sizeof(MOT_SKEL));
+	}
+}
+
+int motSkelBind(MOT_SKEL* pSkel, const MOT_CLIP* pClip, const char* const* ppNames) {
+	int i, nbound = 0;
+	if (!pSkel || !pSkel->pMem) return 0;
+	for (i = 0; i < pSkel->njnt; ++i) {
+		int idx = -1;
+		if (pClip && ppNames) {
+			idx = motFindClipNode(pClip, ppNames[pSkel->pOrder[i]]);
+		}
+		pSkel->pNode[i] = (int16_t)idx;
+		if (idx >= 0) ++nbound;
+	}
+	return nbound;
+}
+
+void motSkelLocalXforms(const MOT_SKEL* pSkel, const MOT_CLIP* pClip, const MOT_VEC* pPos, const MOT_QUAT* pRot, const MOT_VEC* pScl, MOT_MTX* pLocal) {
+	int i;
+	if (!pSkel || !pSkel->pMem || !pLocal) return;
+	for (i = 0; i < pSkel->njnt; ++i) {
+		int inod = pSkel->pNode[i];
+		MOT_QUAT q = { 0.0f, 0.0f, 0.0f, 1.0f };
+		MOT_VEC s = { 1.0f, 1.0f, 1.0f };
+		MOT_VEC t = pSkel->pRestTns[i];
+		int srt = 1;
+		if (pClip && motClipNodeIdxCk(pClip, inod)) {
+			const MOT_NODE* pNode = &pClip->nodes[inod];
+			if (pNode->trk[TRK_POS].srcMask && pPos) {
+				t = pPos[inod];
+			}
+			if (pNode->trk[TRK_ROT].srcMask && pRot) {
+				q = pRot[inod];
+				srt |= 2;
+			}
+			if (pNode->trk[TRK_SCL].srcMask && pScl) {
+				s = pScl[inod];
+				srt |= 4;
+			}
+			mkxform(&pLocal[i], srt, t, q, s, (E_MOT_XORD)pNode->xord);
+		} else {
+			motMakeTransformT(&pLocal[i], t);
+		}
+	}
+}
+
+/* row-vector affine product: res = local * parent, column 3 is assumed to be (0, 0, 0, 1) */
+static void xformmul(MOT_MTX* pRes, const MOT_MTX* pLocal, const MOT_MTX* pParent) {
+	int i, j;
+	MOT_MTX m;
+	for (i = 0; i < 4; ++i) {
+		for (j = 0; j < 3; ++j) {
+			m[i][j] = (*pLocal)[i][0]*(*pParent)[0][j] + (*pLocal)[i][1]*(*pParent)[1][j] + (*pLocal)[i][2]*(*pParent)[2][j];
+		}
+		m[i][3] = 0.0f;
+	}
+	for (j = 0; j < 3; ++j) {
+		m[3][j] += (*pParent)[3][j];
+	}
+	m[3][3] = 1.0f;
+	memcpy(pRes, &m, sizeof(MOT_MTX));
+}
+
+#if MOT_SIMD_X86
+static MOT_TARGET("sse4.1") void worldLvlSSE(MOT_MTX* pWorld, const MOT_MTX* pLocal, const int16_t* pParent, int org, int end) {
+	int i, k;
+	for (i = org; i < end; ++i) {
+		const float* pL = &pLocal[i][0][0];
+		const float* pP = &pWorld[pParent[i]][0][0];
+		float* pW = &pWorld[i][0][0];
+		__m128 p0 = _mm_loadu_ps(pP);
+		__m128 p1 = _mm_loadu_ps(pP + 4);
+		__m128 p2 = _mm_loadu_ps(pP + 8);
+		__m128 p3 = _mm_loadu_ps(pP + 12);
+		for (k = 0; k < 4; ++k) {
+			const float* pRow = pL + k*4;
+			__m128 r = _mm_mul_ps(_mm_set1_ps(pRow[0]), p0);
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pRow[1]), p1));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pRow[2]), p2));
+			if (k == 3) {
+				r = _mm_add_ps(r, p3);
+			}
+			_mm_storeu_ps(pW + k*4, r);
+		}
+	}
+}
+#endif
+
+#if MOT_SIMD_NEON
+static void worldLvlNEON(MOT_MTX* pWorld, const MOT_MTX* pLocal, const int16_t* pParent, int org, int end) {
+	int i, k;
+	for (i = org; i < end; ++i) {
+		const float* pL = &pLocal[i][0][0];
+		const float* pP = &pWorld[pParent[i]][0][0];
+		float* pW = &pWorld[i][0][0];
+		float32x4_t p0 = vld1q_f32(pP);
+		float32x4_t p1 = vld1q_f32(pP + 4);
+		float32x4_t p2 = vld1q_f32(pP + 8);
+		float32x4_t p3 = vld1q_f32(pP + 12);
+		for (k = 0; k < 4; ++k) {
+			const float* pRow = pL + k*4;
+			float32x4_t r = vmulq_n_f32(p0, pRow[0]);
+			r = vmlaq_n_f32(r, p1, pRow[1]);
+			r = vmlaq_n_f32(r, p2, pRow[2]);
+			if (k == 3) {
+				r = vaddq_f32(r, p3);
+			}
+			vst1q_f32(pW + k*4, r);
+		}
+	}
+}
+#endif
+
+void motSkelWorldXforms(const MOT_SKEL* pSkel, const MOT_MTX* pLocal, MOT_MTX* pWorld, const MOT_MTX* pRoot) {
+	int i, lvl;
+	E_MOT_SIMD simd;
+	if (!pSkel || !pSkel->pMem || !pLocal || !pWorld) return;
+	simd = motGetSIMD();
+	/* level 0: roots */
+	for (i = 0; i < pSkel->pLvl[1]; ++i) {
+		if (pRoot) {
+			xformmul(&pWorld[i], &pLocal[i], pRoot);
+		} else {
+			memcpy(&pWorld[i], &pLocal[i], sizeof(MOT_MTX));
+		}
+	}
+	/* joints within a level are independent, parents are complete from the previous level */
+	for (lvl = 1; lvl < pSkel->nlvl; ++lvl) {
+		int org = pSkel->pLvl[lvl];
+		int end = pSkel->pLvl[lvl + 1];
+#if MOT_SIMD_X86
+		if (simd >= SIMD_SSE4) {
+			worldLvlSSE(pWorld, pLocal, pSkel->pParent, org, end);
+			continue;
+		}
+#elif MOT_SIMD_NEON
+		if (simd == SIMD_NEON) {
+			worldLvlNEON(pWorld, pLocal, pSkel->pParent, org, end);
+			continue;
+		}
+#endif
+		for (i = org; i < end; ++i) {
+			xformmul(&pWorld[i], &pLocal[i], &pWorld[pSkel->pParent[i]]);
+		}
+	}
+	(void)simd;
+}
+
+static int bitcnt(int mask) {
+	int n = 0;
+	while (mask) {
+		n += mask & 1;
+		mask >>= 1;
+	}
+	return n;
+}
+
+int motMaskChanCount(int mask) {
+	return bitcnt(mask);
+}
+
+int motSamplerInit(MOT_SAMPLER* pSmp, const MOT_CLIP* pClip) {
+	int i, kind, chan, nnod, nanim, nqanim, nkanim, nfanim, maxCut;
+	int nq[3] = { 0, 0, 0 };
+	int nk[3] = { 0, 0, 0 };
+	int nf[3] = { 0, 0, 0 };
+	int width, col;
+	size_t memSize;
+	uint8_t* pMem;
+	MOT_SMP_CHAN* pAnim;
+	if (!pSmp) return 0;
+	memset(pSmp, 0, sizeof(MOT_SAMPLER));
+	if (!pClip || pClip->nnod <= 0 || pClip->nfrm <= 0) return 0;
+	nnod = pClip->nnod;
+	nanim = 0;
+	nqanim = 0;
+	maxCut = 0;
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			const MOT_TRACK* pTrk = &pClip->nodes[i].trk[kind];
+			if (pTrk->srcMask && motGetTrackData(pClip, i, (E_MOT_TRK)kind)) {
+				if (pTrk->qbits) {
+					nq[kind] += bitcnt(pTrk->dataMask);
+				} else if (pTrk->spline) {
+					nk[kind] += bitcnt(pTrk->dataMask);
+				} else if (pTrk->rdft) {
+					const uint8_t* pBlk = (const uint8_t*)motGetTrackData(pClip, i, (E_MOT_TRK)kind);
+					for (chan = 0; chan < bitcnt(pTrk->dataMask); ++chan) {
+						int cut = (int)*(const uint32_t*)pBlk;
+						maxCut = cut > maxCut ? cut : maxCut;
+						pBlk = dftnext(pBlk);
+						++nf[kind];
+					}
+				} else {
+					nanim += bitcnt(pTrk->dataMask);
+				}
+			}
+		}
+	}
+	nqanim = nq[0] + nq[1] + nq[2];
+	nkanim = nk[0] + nk[1] + nk[2];
+	nfanim = nf[0] + nf[1] + nf[2];
+	width = motClipFrameMajorCk(pClip) ? motClipRowWidth(pClip) : 0;
+	if (width) {
+		/* frame-major columns are read from the rows, not listed as channels */
+		nanim = 0;
+	}
+	memSize = (nnod * 9 + nanim) * sizeof(MOT_SMP_CHAN) + nnod * 4 * sizeof(MOT_VEC) + (nqanim * 6 + nkanim * 9 + nfanim * 2 + width) * sizeof(int32_t);
+	memSize += maxCut * 2 * sizeof(float);
+	pMem = (uint8_t*)malloc(memSize);
+	if (!pMem) return 0;
+	pSmp->pMem = pMem;
+	pSmp->pNodeChan = (MOT_SMP_CHAN*)pMem;
+	pMem += nnod * 9 * sizeof(MOT_SMP_CHAN);
+	pAnim = (MOT_SMP_CHAN*)pMem;
+	pMem += nanim * sizeof(MOT_SMP_CHAN);
+	for (kind = 0; kind < 3; ++kind) {
+		pSmp->pBase[kind] = (MOT_VEC*)pMem;
+		pMem += nnod * sizeof(MOT_VEC);
+	}
+	pSmp->pLog = (MOT_VEC*)pMem;
+	pMem += nnod * sizeof(MOT_VEC);
+	pSmp->pClip = pClip;
+	pSmp->nnod = nnod;
+	pSmp->nfrm = pClip->nfrm;
+	pSmp->rows.width = width;
+	pSmp->rows.pDst = (int32_t*)pMem;
+	pMem += width * sizeof(int32_t);
+	col = 0;
+
+	/* animated channels are grouped by kind so that each kind is one flat loop */
+	for (kind = 0; kind < 3; ++kind) {
+		float defVal = kind == TRK_SCL ? 1.0f : 0.0f;
+		MOT_SMP_QCHN* pQ = &pSmp->qanim[kind];
+		MOT_SMP_KCHN* pK = &pSmp->kanim[kind];
+		MOT_SMP_FCHN* pF = &pSmp->fanim[kind];
+		pSmp->pAnim[kind] = pAnim;
+		pSmp->nanim[kind] = 0;
+		/* quantized channels: lane arrays for the gather decoder */
+		pQ->n = 0;
+		pQ->pOffs = (int32_t*)pMem;
+		pQ->pStride = pQ->pOffs + nq[kind];
+		pQ->pDst = pQ->pStride + nq[kind];
+		pQ->pMask = (uint32_t*)(pQ->pDst + nq[kind]);
+		pQ->pBase = (float*)(pQ->pMask + nq[kind]);
+		pQ->pScale = pQ->pBase + nq[kind];
+		pK->n = 0;
+		pK->pOffs = (int32_t*)(pQ->pScale + nq[kind]);
+		pK->pDst = pK->pOffs + nk[kind];
+		pK->pCur = pK->pDst + nk[kind];
+		pK->pSpan = pK->pCur + nk[kind];
+		pK->pCoef = (float*)(pK->pSpan + nk[kind] * 2);
+		pF->n = 0;
+		pF->pOffs = (int32_t*)(pK->pCoef + nk[kind] * 4);
+		pF->pDst = pF->pOffs + nf[kind];
+		pSmp->rows.col[kind] = col;
+		for (i = 0; i < nnod; ++i) {
+			const MOT_TRACK* pTrk = &pClip->nodes[i].trk[kind];
+			const uint8_t* pData = NULL;
+			MOT_SMP_CHAN* pChan = &pSmp->pNodeChan[i*9 + kind*3];
+			int dataMask = 0;
+			int vsize = 0;
+			int esize = pTrk->qbits ? (pTrk->qbits <= 8 ? 1 : 2) : (int)sizeof(float);
+			if (pTrk->srcMask) {
+				pData = (const uint8_t*)motGetTrackData(pClip, i, (E_MOT_TRK)kind);
+				dataMask = pData ? pTrk->dataMask : 0;
+				vsize = bitcnt(dataMask);
+			}
+			for (chan = 0; chan < 3; ++chan) {
+				float* pBase = &pSmp->pBase[kind][i].s[chan];
+				*pBase = defVal;
+				pChan[chan].dst = i*3 + chan;
+				if (dataMask & (1 << chan)) {
+					pChan[chan].pSrc = (const float*)pData;
+					pChan[chan].stride = vsize;
+					if (pTrk->fmaj) {
+						/* columns come in kind, node, channel order */
+						if (!col) {
+							pSmp->rows.pRow0 = (const float*)pData;
+						}
+						pChan[chan].stride = width;
+						pSmp->rows.pDst[col++] = i*3 + chan;
+					} else if (pTrk->rdft) {
+						int jf = pF->n++;
+						pF->pOffs[jf] = (int32_t)(pData - (const uint8_t*)pClip);
+						pF->pDst[jf] = i*3 + chan;
+						pData = dftnext(pData);
+						continue;
+					} else if (pTrk->spline) {
+						int ik = pK->n++;
+						pK->pOffs[ik] = (int32_t)(pData - (const uint8_t*)pClip);
+						pK->pDst[ik] = i*3 + chan;
+						pK->pCur[ik] = -1;
+						pK->pSpan[ik*2] = 0;
+						pK->pSpan[ik*2 + 1] = 0;
+						pData = keynext(pData);
+						continue;
+					} else if (pTrk->qbits) {
+						int iq = pQ->n++;
+						pQ->pOffs[iq] = (int32_t)(pData - (const uint8_t*)pClip);
+						pQ->pStride[iq] = vsize * esize;
+						pQ->pDst[iq] = i*3 + chan;
+						pQ->pMask[iq] = qmax(esize * 8);
+						pQ->pBase[iq] = pTrk->vmin.s[chan];
+						pQ->pScale[iq] = qscale(pTrk, chan);
+					} else {
+						pAnim[pSmp->nanim[kind]++] = pChan[chan];
+					}
+					pData += esize;
+				} else {
+					if (pTrk->srcMask & (1 << chan)) {
+						*pBase = pTrk->vmin.s[chan];
+					}
+					pChan[chan].pSrc = pBase;
+					pChan[chan].stride = 0;
+				}
+			}
+		}
+		pAnim += pSmp->nanim[kind];
+		pMem += (nq[kind] * 6 + nk[kind] * 9 + nf[kind] * 2) * sizeof(int32_t);
+	}
+	pSmp->rows.col[3] = col;
+	pSmp->maxCut = maxCut;
+	pSmp->pTrig = maxCut ? (float*)pMem : NULL;
+	motSamplerSeek(pSmp, 0.0f);
+	return 1;
+}
+
+void motSamplerFree(MOT_SAMPLER* pSmp) {
+	if (pSmp) {
+		if (pSmp->pMem) {
+			free(pSmp->pMem);
+		}
+		memset(pSmp, 0, sizeof(MOT_SAMPLER));
+	}
+}
+
+void motSamplerSeek(MOT_SAMPLER* pSmp, float frm) {
+	MOT_FRAME_INFO fi;
+	if (!pSmp || !pSmp->pClip) return;
+	fi = finfo(pSmp->pClip, frm);
+	pSmp->frm = fi.f;
+	pSmp->t = fi.t;
+	pSmp->fno = fi.fno;
+	pSmp->next = fi.next;
+}
+
+void motSamplerAdvance(MOT_SAMPLER* pSmp, float dfrm) {
+	float f;
+	int nfrm;
+	if (!pSmp || !pSmp->pClip) return;
+	nfrm = pSmp->nfrm;
+	if (!(dfrm >= 0.0f && dfrm < (float)nfrm)) {
+		/* backwards or more than one loop: take the general path */
+		motSamplerSeek(pSmp, pSmp->frm + dfrm);
+		return;
+	}
+	f = pSmp->frm + dfrm;
+	if (f >= (float)nfrm) {
+		f -= (float)nfrm;
+	}
+	if (!(f >= (float)pSmp->fno && f < (float)(pSmp->fno + 1))) {
+		/* crossed into the next frame or wrapped around */
+		pSmp->fno = (int)f;
+	}
+	pSmp->frm = f;
+	pSmp->t = f - (float)pSmp->fno;
+	pSmp->next = pSmp->fno < nfrm - 1 ? pSmp->fno + 1 : 0;
+}
+
+static void smpchans(float* pDst, const MOT_SMP_CHAN* pChan, int n, int fno, int next, float t) {
+	int i;
+	int fofs[4];
+	int nofs[4];
+	for (i = 0; i < 4; ++i) {
+		fofs[i] = fno * i;
+		nofs[i] = next * i;
+	}
+	if (t != 0.0f) {
+		for (i = 0; i < n; ++i) {
+			const float* pSrc = pChan[i].pSrc;
+			int stride = pChan[i].stride;
+			pDst[pChan[i].dst] = lerp(pSrc[fofs[stride]], pSrc[nofs[stride]], t);
+		}
+	} else {
+		for (i = 0; i < n; ++i) {
+			pDst[pChan[i].dst] = pChan[i].pSrc[fofs[pChan[i].stride]];
+		}
+	}
+}
+
+/* one kind's columns of two frame-major rows */
+static void rsmpchans(float* pDst, const MOT_SMP_ROWS* pRows, int kind, int fno, int next, float t) {
+	const float* pRow = pRows->pRow0 + (size_t)fno * pRows->width;
+	const float* pNext = pRows->pRow0 + (size_t)next * pRows->width;
+	int i;
+	int i0 = pRows->col[kind];
+	int i1 = pRows->col[kind + 1];
+	if (t != 0.0f) {
+		for (i = i0; i < i1; ++i) {
+			pDst[pRows->pDst[i]] = lerp(pRow[i], pNext[i], t);
+		}
+	} else {
+		for (i = i0; i < i1; ++i) {
+			pDst[pRows->pDst[i]] = pRow[i];
+		}
+	}
+}
+
+static void qsmpchans(float* pDst, const uint8_t* pTop, const MOT_SMP_QCHN* pQ, int i0, int fno, int next, float t) {
+	int i;
+	for (i = i0; i < pQ->n; ++i) {
+		const uint8_t* pSrc = pTop + pQ->pOffs[i];
+		int stride = pQ->pStride[i];
+		float q0, q1;
+		if (pQ->pMask[i] == 0xFF) {
+			q0 = (float)pSrc[fno * stride];
+			q1 = (float)pSrc[next * stride];
+		} else {
+			q0 = (float)*(const uint16_t*)&pSrc[fno * stride];
+			q1 = (float)*(const uint16_t*)&pSrc[next * stride];
+		}
+		pDst[pQ->pDst[i]] = pQ->pBase[i] + lerp(q0, q1, t) * pQ->pScale[i];
+	}
+}
+
+/*
+ * Each channel keeps the cubic of its current segment, so forward playback
+ * is a span check and two polynomial evaluations per channel; the segment is
+ * looked up again only when fno leaves the span.
+ */
+static void ksmpchans(float* pDst, const uint8_t* pTop, const MOT_SMP_KCHN* pK, int fno, int next, float t) {
+	int i;
+	for (i = 0; i < pK->n; ++i) {
+		int32_t* pSpan = &pK->pSpan[i*2];
+		float* pCoef = &pK->pCoef[i*4];
+		float u, v;
+		if (fno < pSpan[0] || fno >= pSpan[1]) {
+			const uint8_t* pBlk = pTop + pK->pOffs[i];
+			int nkey = (int)*(const uint32_t*)pBlk;
+			const uint16_t* pFrm = (const uint16_t*)(pBlk + sizeof(uint32_t));
+			const float* pVal = (const float*)(pBlk + keyblksize(nkey) - nkey * sizeof(float));
+			int seg = keyseg(pFrm, nkey, fno, pK->pCur[i]);
+			pK->pCur[i] = seg;
+			pSpan[0] = pFrm[seg];
+			/* the last segment owns its end frame */
+			pSpan[1] = seg == nkey - 2 ? pFrm[seg + 1] + 1 : pFrm[seg + 1];
+			keycoef(pCoef, pFrm, pVal, nkey, seg);
+		}
+		u = (float)(fno - pSpan[0]);
+		v = keypoly(pCoef, u);
+		if (t != 0.0f) {
+			/* next is either in the same span or wraps to frame 0, which is always a key */
+			float vnext = next > fno ? keypoly(pCoef, u + 1.0f) : keysmp(pTop + pK->pOffs[i], next);
+			v = lerp(v, vnext, t);
+		}
+		pDst[pK->pDst[i]] = v;
+	}
+}
+
+static void fsmpchans(float* pDst, const uint8_t* pTop, const MOT_SMP_FCHN* pF, const float* pCos, const float* pSin) {
+	int i;
+	for (i = 0; i < pF->n; ++i) {
+		pDst[pF->pDst[i]] = dftdot(pTop + pF->pOffs[i], pCos, pSin);
+	}
+}
+
+#if MOT_SIMD_X86
+static MOT_TARGET("avx2") void qsmpchansAVX2(float* pDst, const uint8_t* pTop, const MOT_SMP_QCHN* pQ, int fno, int next, float t) {
+	__m256i vfno = _mm256_set1_epi32(fno);
+	__m256i vnext = _mm256_set1_epi32(next);
+	__m256 vt = _mm256_set1_ps(t);
+	float res[8];
+	int i, k;
+	for (i = 0; i + 8 <= pQ->n; i += 8) {
+		__m256i offs = _mm256_loadu_si256((const __m256i*)&pQ->pOffs[i]);
+		__m256i stride = _mm256_loadu_si256((const __m256i*)&pQ->pStride[i]);
+		__m256i mask = _mm256_loadu_si256((const __m256i*)&pQ->pMask[i]);
+		__m256i o0 = _mm256_add_epi32(offs, _mm256_mullo_epi32(stride, vfno));
+		__m256i o1 = _mm256_add_epi32(offs, _mm256_mullo_epi32(stride, vnext));
+		/* 32-bit loads at byte offsets, the clip data section is padded for the tail */
+		__m256i q0 = _mm256_and_si256(_mm256_i32gather_epi32((const int*)pTop, o0, 1), mask);
+		__m256i q1 = _mm256_and_si256(_mm256_i32gather_epi32((const int*)pTop, o1, 1), mask);
+		__m256 f0 = _mm256_cvtepi32_ps(q0);
+		__m256 f1 = _mm256_cvtepi32_ps(q1);
+		__m256 f = _mm256_add_ps(f0, _mm256_mul_ps(_mm256_sub_ps(f1, f0), vt));
+		__m256 v = _mm256_add_ps(_mm256_loadu_ps(&pQ->pBase[i]), _mm256_mul_ps(f, _mm256_loadu_ps(&pQ->pScale[i])));
+		_mm256_storeu_ps(res, v);
+		for (k = 0; k < 8; ++k) {
+			pDst[pQ->pDst[i + k]] = res[k];
+		}
+	}
+	qsmpchans(pDst, pTop, pQ, i, fno, next, t);
+}
+#endif
+
+void motSamplerEval(MOT_SAMPLER* pSmp, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	const uint8_t* pTop;
+	E_MOT_SIMD simd;
+	int kind, nnod;
+	if (!pSmp || !pSmp->pMem) return;
+	nnod = pSmp->nnod;
+	pTop = (const uint8_t*)pSmp->pClip;
+	simd = motGetSIMD();
+	(void)simd;
+	if (pSmp->pTrig) {
+		/* one set of cos/sin rows serves every Fourier channel of the frame */
+		dfttrig(pSmp->pTrig, pSmp->pTrig + pSmp->maxCut, pSmp->maxCut, dftparam(pSmp->pClip, pSmp->frm));
+	}
+	for (kind = 0; kind < 3; ++kind) {
+		MOT_VEC* pDst = NULL;
+		switch (kind) {
+			case TRK_POS: pDst = pPos; break;
+			case TRK_ROT: pDst = pRot ? pSmp->pLog : NULL; break;
+			case TRK_SCL: pDst = pScl; break;
+		}
+		if (!pDst) continue;
+		memcpy(pDst, pSmp->pBase[kind], nnod * sizeof(MOT_VEC));
+		smpchans(pDst->s, pSmp->pAnim[kind], pSmp->nanim[kind], pSmp->fno, pSmp->next, pSmp->t);
+		if (pSmp->rows.width) {
+			rsmpchans(pDst->s, &pSmp->rows, kind, pSmp->fno, pSmp->next, pSmp->t);
+		}
+		if (pSmp->kanim[kind].n) {
+			ksmpchans(pDst->s, pTop, &pSmp->kanim[kind], pSmp->fno, pSmp->next, pSmp->t);
+		}
+		if (pSmp->fanim[kind].n) {
+			fsmpchans(pDst->s, pTop, &pSmp->fanim[kind], pSmp->pTrig, pSmp->pTrig + pSmp->maxCut);
+		}
+		if (pSmp->qanim[kind].n) {
+#if MOT_SIMD_X86
+			if (simd == SIMD_AVX2) {
+				qsmpchansAVX2(pDst->s, pTop, &pSmp->qanim[kind], pSmp->fno, pSmp->next, pSmp->t);
+				continue;
+			}
+#endif
+			qsmpchans(pDst->s, pTop, &pSmp->qanim[kind], 0, pSmp->fno, pSmp->next, pSmp->t);
+		}
+	}
+	if (pRot) {
+		motQuatExpAry(pRot, pSmp->pLog, nnod);
+	}
+}
+
+void motSamplerEvalNode(const MOT_SAMPLER* pSmp, int nodeIdx, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	const MOT_SMP_CHAN* pChan;
+	MOT_VEC v[3];
+	int kind, chan;
+	if (!pSmp || !pSmp->pMem || (uint32_t)nodeIdx >= (uint32_t)pSmp->nnod) return;
+	pChan = &pSmp->pNodeChan[nodeIdx * 9];
+	for (kind = 0; kind < 3; ++kind) {
+		const MOT_TRACK* pTrk = &pSmp->pClip->nodes[nodeIdx].trk[kind];
+		for (chan = 0; chan < 3; ++chan) {
+			const float* pSrc = pChan[chan].pSrc;
+			int stride = pChan[chan].stride;
+			float v0, v1;
+			if (stride && pTrk->rdft) {
+				v[kind].s[chan] = dfteval((const uint8_t*)pSrc, dftparam(pSmp->pClip, pSmp->frm));
+				continue;
+			}
+			if (stride && pTrk->spline) {
+				v0 = keysmp((const uint8_t*)pSrc, pSmp->fno);
+				v1 = keysmp((const uint8_t*)pSrc, pSmp->next);
+			} else if (stride && pTrk->qbits) {
+				v0 = dequant(pTrk, chan, pSrc, pSmp->fno * stride);
+				v1 = dequant(pTrk, chan, pSrc, pSmp->next * stride);
+			} else {
+				v0 = pSrc[pSmp->fno * stride];
+				v1 = pSrc[pSmp->next * stride];
+			}
+			v[kind].s[chan] = pSmp->t != 0.0f ? lerp(v0, v1, pSmp->t) : v0;
+		}
+		pChan += 3;
+	}
+	if (pPos) *pPos = v[TRK_POS];
+	if (pRot) *pRot = motQuatExp(v[TRK_ROT]);
+	if (pScl) *pScl = v[TRK_SCL];
+}
+
+static size_t alignsz(size_t size, size_t align) {
+	return (size + align - 1) & ~(align - 1);
+}
+
+static size_t trkdatasize(const MOT_CLIP* pClip, int nodeIdx, int kind, int qbits) {
+	const MOT_TRACK* pTrk = &pClip->nodes[nodeIdx].trk[kind];
+	size_t esize = qbits ? (qbits <= 8 ? 1 : 2) : sizeof(float);
+	if (!pTrk->srcMask || !motGetTrackData(pClip, nodeIdx, (E_MOT_TRK)kind)) return 0;
+	return pClip->nfrm * bitcnt(pTrk->dataMask) * esize;
+}
+
+MOT_CLIP* motClipQuantize(const MOT_CLIP* pClip, int qbits, float* pMaxErr) {
+	MOT_CLIP* pQClip;
+	uint8_t* pTop;
+	size_t hdrSize, evalSize, dataSize, memSize, offs;
+	int i, kind, nnod, nfrm;
+	if (pMaxErr) {
+		for (kind = 0; kind < 3; ++kind) {
+			pMaxErr[kind] = 0.0f;
+		}
+	}
+	if (!motClipHeaderCk(pClip) || qbits < 1 || qbits > 16 || motClipKeyCk(pClip) || motClipRdftCk(pClip) || motClipFrameMajorCk(pClip)) return NULL;
+	nnod = pClip->nnod;
+	nfrm = pClip->nfrm;
+	hdrSize = offsetof(MOT_CLIP, nodes) + nnod * sizeof(MOT_NODE);
+	if (pClip->hash) {
+		hdrSize = pClip->hash + nnod * sizeof(uint32_t);
+	}
+	hdrSize = alignsz(hdrSize, 0x10);
+	dataSize = 0;
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			dataSize += alignsz(trkdatasize(pClip, i, kind, qbits), 4);
+		}
+	}
+	/* padding: SIMD decoders read 32 bits around each element */
+	dataSize += 4;
+	evalSize = 0;
+	if (pClip->eval) {
+		evalSize = (pClip->seq > pClip->eval ? pClip->seq : pClip->size) - pClip->eval;
+	}
+	memSize = hdrSize + dataSize + evalSize;
+	pQClip = (MOT_CLIP*)malloc(memSize);
+	if (!pQClip) return NULL;
+	pTop = (uint8_t*)pQClip;
+	memset(pTop, 0, memSize);
+	memcpy(pTop, pClip, hdrSize < pClip->size ? hdrSize : pClip->size);
+	offs = hdrSize;
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			const float* pSrc = motGetTrackData(pClip, i, (E_MOT_TRK)kind);
+			MOT_NODE* pNode = &pQClip->nodes[i];
+			MOT_TRACK* pTrk = &pNode->trk[kind];
+			size_t trkSize = trkdatasize(pClip, i, kind, qbits);
+			int vsize, ifrm, chan;
+			pNode->offs[kind] = 0;
+			pTrk->qbits = 0;
+			if (!trkSize) continue;
+			pNode->offs[kind] = (uint32_t)offs;
+			pTrk->qbits = (uint8_t)qbits;
+			vsize = bitcnt(pTrk->dataMask);
+			for (ifrm = 0; ifrm < nfrm; ++ifrm) {
+				int idx = ifrm * vsize;
+				for (chan = 0; chan < 3; ++chan) {
+					float v, range, err;
+					uint32_t q;
+					if (!(pTrk->dataMask & (1 << chan))) continue;
+					v = pSrc[idx];
+					range = pTrk->vmax.s[chan] - pTrk->vmin.s[chan];
+					q = 0;
+					if (range > 0.0f) {
+						float fq = (v - pTrk->vmin.s[chan]) / range * (float)qmax(qbits) + 0.5f;
+						fq = fq < 0.0f ? 0.0f : fq;
+						q = (uint32_t)fq;
+						q = q > qmax(qbits) ? qmax(qbits) : q;
+					}
+					if (qbits <= 8) {
+						pTop[offs + idx] = (uint8_t)q;
+					} else {
+						((uint16_t*)&pTop[offs])[idx] = (uint16_t)q;
+					}
+					err = fabsf(dequant(pTrk, chan, &pTop[offs], idx) - v);
+					if (pMaxErr && err > pMaxErr[kind]) {
+						pMaxErr[kind] = err;
+					}
+					++idx;
+				}
+			}
+			offs += alignsz(trkSize, 4);
+		}
+	}
+	offs += 4;
+	pQClip->eval = 0;
+	if (evalSize) {
+		memcpy(&pTop[offs], (const uint8_t*)pClip + pClip->eval, evalSize);
+		pQClip->eval = (uint32_t)offs;
+	}
+	/* SEQ addresses float data directly, quantized clips are evaluated through the tracks */
+	pQClip->seq = 0;
+	pQClip->size = (uint32_t)memSize;
+	return pQClip;
+}
+
+int motClipQuantCk(const MOT_CLIP* pClip) {
+	int i, kind;
+	if (!pClip) return 0;
+	for (i = 0; i < (int)pClip->nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			if (pClip->nodes[i].trk[kind].qbits) return 1;
+		}
+	}
+	return 0;
+}
+
+static void keyerr(float* pErr, const uint16_t* pFrm, const float* pVal, int nkey, const float* pSrc, int stride, int seg0, int seg1) {
+	int seg, f;
+	for (seg = seg0; seg <= seg1; ++seg) {
+		for (f = pFrm[seg] + 1; f < pFrm[seg + 1]; ++f) {
+			pErr[f] = fabsf(keyeval(pFrm, pVal, nkey, seg, f) - pSrc[f * stride]);
+		}
+		/* keys hold the source values; never picked again, so no zero-length segments */
+		pErr[pFrm[seg]] = 0.0f;
+		pErr[pFrm[seg + 1]] = 0.0f;
+	}
+}
+
+/*
+ * Greedy refinement: start from the end frames and insert a key at the worst frame
+ * until every frame is within tol. An insertion only changes the tangents of its
+ * neighbours, so errors are updated for the two segments on either side.
+ */
+static int keyfit(uint16_t* pFrm, float* pVal, float* pErr, const float* pSrc, int stride, int nfrm, float tol, float* pMaxErr) {
+	int nkey = 2;
+	int f, fmax, seg;
+	pFrm[0] = 0;
+	pFrm[1] = (uint16_t)(nfrm - 1);
+	pVal[0] = pSrc[0];
+	pVal[1] = pSrc[(nfrm - 1) * stride];
+	keyerr(pErr, pFrm, pVal, nkey, pSrc, stride, 0, 0);
+	while (1) {
+		fmax = 0;
+		for (f = 1; f < nfrm; ++f) {
+			if (pErr[f] > pErr[fmax]) fmax = f;
+		}
+		if (pErr[fmax] <= tol || pErr[fmax] <= 0.0f) break;
+		seg = keyseg(pFrm, nkey, fmax, -1);
+		memmove(&pFrm[seg + 2], &pFrm[seg + 1], (nkey - seg - 1) * sizeof(uint16_t));
+		memmove(&pVal[seg + 2], &pVal[seg + 1], (nkey - seg - 1) * sizeof(float));
+		pFrm[seg + 1] = (uint16_t)fmax;
+		pVal[seg + 1] = pSrc[fmax * stride];
+		++nkey;
+		keyerr(pErr, pFrm, pVal, nkey, pSrc, stride, seg > 0 ? seg - 1 : 0, seg + 2 < nkey - 1 ? seg + 2 : nkey - 2);
+	}
+	if (pMaxErr) {
+		*pMaxErr = pErr[fmax];
+	}
+	return nkey;
+}
+
+/* pKeys: nfrm frames per channel slot, pVal/pErr: nfrm each, pNKey: 9 per node, pSpline: 3 per node */
+static MOT_CLIP* keyclip(const MOT_CLIP* pClip, const float* pTol, float* pMaxErr, uint16_t* pKeys, float* pVal, float* pErr, uint32_t* pNKey, uint8_t* pSpline) {
+	MOT_CLIP* pKClip;
+	uint8_t* pTop;
+	uint16_t* pFrm;
+	size_t hdrSize, evalSize, dataSize, memSize, offs;
+	int i, kind, chan;
+	int nnod = pClip->nnod;
+	int nfrm = pClip->nfrm;
+	hdrSize = offsetof(MOT_CLIP, nodes) + nnod * sizeof(MOT_NODE);
+	if (pClip->hash) {
+		hdrSize = pClip->hash + nnod * sizeof(uint32_t);
+	}
+	hdrSize = alignsz(hdrSize, 0x10);
+	dataSize = 0;
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			const MOT_TRACK* pTrk = &pClip->nodes[i].trk[kind];
+			const float* pSrc = motGetTrackData(pClip, i, (E_MOT_TRK)kind);
+			size_t denseSize = trkdatasize(pClip, i, kind, 0);
+			size_t keySize = 0;
+			float trkErr = 0.0f;
+			int vsize = bitcnt(pTrk->dataMask);
+			pSpline[i*3 + kind] = 0;
+			if (!denseSize) continue;
+			for (chan = 0; chan < 3; ++chan) {
+				int ich = i*9 + kind*3 + chan;
+				float err = 0.0f;
+				if (!(pTrk->dataMask & (1 << chan))) continue;
+				pFrm = &pKeys[(size_t)ich * nfrm];
+				pNKey[ich] = keyfit(pFrm, pVal, pErr, pSrc++, vsize, nfrm, pTol[kind], &err);
+				keySize += keyblksize(pNKey[ich]);
+				trkErr = fmaxf(trkErr, err);
+			}
+			/* tracks that do not get smaller stay dense */
+			if (keySize < denseSize) {
+				pSpline[i*3 + kind] = 1;
+				dataSize += keySize;
+				if (pMaxErr && trkErr > pMaxErr[kind]) {
+					pMaxErr[kind] = trkErr;
+				}
+			} else {
+				dataSize += alignsz(denseSize, 4);
+			}
+		}
+	}
+	evalSize = 0;
+	if (pClip->eval) {
+		evalSize = (pClip->seq > pClip->eval ? pClip->seq : pClip->size) - pClip->eval;
+	}
+	memSize = hdrSize + dataSize + evalSize;
+	pKClip = (MOT_CLIP*)malloc(memSize);
+	if (!pKClip) return NULL;
+	pTop = (uint8_t*)pKClip;
+	memset(pTop, 0, memSize);
+	memcpy(pTop, pClip, hdrSize < pClip->size ? hdrSize : pClip->size);
+	offs = hdrSize;
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			const float* pSrc = motGetTrackData(pClip, i, (E_MOT_TRK)kind);
+			MOT_NODE* pNode = &pKClip->nodes[i];
+			MOT_TRACK* pTrk = &pNode->trk[kind];
+			size_t denseSize = trkdatasize(pClip, i, kind, 0);
+			int vsize = bitcnt(pTrk->dataMask);
+			pNode->offs[kind] = 0;
+			pTrk->spline = pSpline[i*3 + kind];
+			if (!denseSize) continue;
+			pNode->offs[kind] = (uint32_t)offs;
+			if (!pTrk->spline) {
+				memcpy(&pTop[offs], pSrc, denseSize);
+				offs += alignsz(denseSize, 4);
+				continue;
+			}
+			for (chan = 0; chan < 3; ++chan) {
+				int ich = i*9 + kind*3 + chan;
+				uint32_t k, nkey;
+				uint8_t* pBlk = &pTop[offs];
+				float* pDst;
+				if (!(pTrk->dataMask & (1 << chan))) continue;
+				nkey = pNKey[ich];
+				pFrm = &pKeys[(size_t)ich * nfrm];
+				*(uint32_t*)pBlk = nkey;
+				memcpy(pBlk + sizeof(uint32_t), pFrm, nkey * sizeof(uint16_t));
+				pDst = (float*)(pBlk + keyblksize(nkey) - nkey * sizeof(float));
+				for (k = 0; k < nkey; ++k) {
+					pDst[k] = pSrc[pFrm[k] * vsize];
+				}
+				offs += keyblksize(nkey);
+				++pSrc;
+			}
+		}
+	}
+	pKClip->eval = 0;
+	if (evalSize) {
+		memcpy(&pTop[offs], (const uint8_t*)pClip + pClip->eval, evalSize);
+		pKClip->eval = (uint32_t)offs;
+	}
+	/* as with quantized clips, spline tracks are evaluated through the tracks */
+	pKClip->seq = 0;
+	pKClip->size = (uint32_t)memSize;
+	return pKClip;
+}
+
+MOT_CLIP* motClipKeyReduce(const MOT_CLIP* pClip, const float* pTol, float* pMaxErr) {
+	MOT_CLIP* pKClip = NULL;
+	uint16_t* pKeys;
+	float* pVal;
+	uint32_t* pNKey;
+	uint8_t* pSpline;
+	int kind, nnod, nfrm;
+	if (pMaxErr) {
+		for (kind = 0; kind < 3; ++kind) {
+			pMaxErr[kind] = 0.0f;
+		}
+	}
+	if (!motClipHeaderCk(pClip) || !pTol || motClipQuantCk(pClip) || motClipKeyCk(pClip) || motClipRdftCk(pClip) || motClipFrameMajorCk(pClip)) return NULL;
+	nnod = pClip->nnod;
+	nfrm = pClip->nfrm;
+	if (nfrm < 2 || nfrm > 0x10000) return NULL;
+	/* fitted keys of every channel are kept until the output size is known */
+	pKeys = (uint16_t*)malloc((size_t)nnod * 9 * nfrm * sizeof(uint16_t));
+	pVal = (float*)malloc(nfrm * 2 * sizeof(float));
+	pNKey = (uint32_t*)malloc(nnod * 9 * sizeof(uint32_t));
+	pSpline = (uint8_t*)malloc(nnod * 3);
+	if (pKeys && pVal && pNKey && pSpline) {
+		pKClip = keyclip(pClip, pTol, pMaxErr, pKeys, pVal, pVal + nfrm, pNKey, pSpline);
+	}
+	free(pKeys);
+	free(pVal);
+	free(pNKey);
+	free(pSpline);
+	return pKClip;
+}
+
+int motClipKeyCk(const MOT_CLIP* pClip) {
+	int i, kind;
+	if (!pClip) return 0;
+	for (i = 0; i < (int)pClip->nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			if (pClip->nodes[i].trk[kind].spline) return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Real DFT of one looped channel, a[k] and b[k] for k = 0 .. nfrm/2 (b[0] = 0):
+ * the inverse is the series in the Fourier block comment with cut = nfrm/2 + 1.
+ * Per term the angle is stepped by a double precision rotation, O(nfrm^2).
+ */
+void motRdftFwd(float* pA, float* pB, const float* pSmp, int stride, int nfrm) {
+	int k, j;
+	int nh = nfrm / 2;
+	if (!pA || !pB || !pSmp || nfrm < 1) return;
+	for (k = 0; k <= nh; ++k) {
+		double th = 2.0 * MOT_PI * (double)k / (double)nfrm;
+		double cs = cos(th);
+		double sn = sin(th);
+		double c = 1.0;
+		double s = 0.0;
+		double sa = 0.0;
+		double sb = 0.0;
+		double nrm = (k == 0 || k * 2 == nfrm) ? 1.0 / nfrm : 2.0 / nfrm;
+		for (j = 0; j < nfrm; ++j) {
+			double x = pSmp[j * stride];
+			double cj = c*cs - s*sn;
+			sa += x * c;
+			sb += x * s;
+			s = s*cs + c*sn;
+			c = cj;
+		}
+		pA[k] = (float)(sa * nrm);
+		pB[k] = (float)(sb * nrm);
+	}
+}
+
+/*
+ * Shortest series whose dropped terms stay within tol: |v - series| <= sum of the
+ * dropped amplitudes sqrt(a^2 + b^2) at any frm, in-betweens included.
+ */
+static int dftcut(const float* pA, const float* pB, int nh, float tol) {
+	double tail = 0.0;
+	int k;
+	for (k = nh; k >= 1; --k) {
+		tail += sqrt((double)pA[k]*pA[k] + (double)pB[k]*pB[k]);
+		if (tail > tol) return k + 1;
+	}
+	return 1;
+}
+
+/* pSpec: (nfrm/2 + 1) * 2 per channel slot, pCut: 9 per node, pRdft: 3 per node */
+static MOT_CLIP* rdftclip(const MOT_CLIP* pClip, const float* pTol, float* pMaxErr, float* pSpec, int32_t* pCut, uint8_t* pRdft) {
+	MOT_CLIP* pFClip;
+	uint8_t* pTop;
+	size_t hdrSize, evalSize, dataSize, memSize, offs;
+	int i, kind, chan, f;
+	int nnod = pClip->nnod;
+	int nfrm = pClip->nfrm;
+	int nh = nfrm / 2;
+	size_t nspec = (size_t)(nh + 1) * 2;
+	hdrSize = offsetof(MOT_CLIP, nodes) + nnod * sizeof(MOT_NODE);
+	if (pClip->hash) {
+		hdrSize = pClip->hash + nnod * sizeof(uint32_t);
+	}
+	hdrSize = alignsz(hdrSize, 0x10);
+	dataSize = 0;
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			const MOT_TRACK* pTrk = &pClip->nodes[i].trk[kind];
+			const float* pSrc = motGetTrackData(pClip, i, (E_MOT_TRK)kind);
+			size_t denseSize = trkdatasize(pClip, i, kind, 0);
+			size_t dftSize = 0;
+			int vsize = bitcnt(pTrk->dataMask);
+			pRdft[i*3 + kind] = 0;
+			if (!denseSize) continue;
+			if (pTol[kind] < 0.0f) {
+				dataSize += alignsz(denseSize, 4);
+				continue;
+			}
+			for (chan = 0; chan < 3; ++chan) {
+				int ich = i*9 + kind*3 + chan;
+				float* pA = &pSpec[ich * nspec];
+				if (!(pTrk->dataMask & (1 << chan))) continue;
+				motRdftFwd(pA, pA + nh + 1, pSrc++, vsize, nfrm);
+				pCut[ich] = dftcut(pA, pA + nh + 1, nh, pTol[kind]);
+				dftSize += dftblksize(pCut[ich]);
+			}
+			/* tracks that do not get smaller stay dense */
+			if (dftSize < denseSize) {
+				pRdft[i*3 + kind] = 1;
+				dataSize += dftSize;
+			} else {
+				dataSize += alignsz(denseSize, 4);
+			}
+		}
+	}
+	evalSize = 0;
+	if (pClip->eval) {
+		evalSize = (pClip->seq > pClip->eval ? pClip->seq : pClip->size) - pClip->eval;
+	}
+	memSize = hdrSize + dataSize + evalSize;
+	pFClip = (MOT_CLIP*)malloc(memSize);
+	if (!pFClip) return NULL;
+	pTop = (uint8_t*)pFClip;
+	memset(pTop, 0, memSize);
+	memcpy(pTop, pClip, hdrSize < pClip->size ? hdrSize : pClip->size);
+	offs = hdrSize;
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			const float* pSrc = motGetTrackData(pClip, i, (E_MOT_TRK)kind);
+			MOT_NODE* pNode = &pFClip->nodes[i];
+			MOT_TRACK* pTrk = &pNode->trk[kind];
+			size_t denseSize = trkdatasize(pClip, i, kind, 0);
+			int vsize = bitcnt(pTrk->dataMask);
+			pNode->offs[kind] = 0;
+			pTrk->rdft = pRdft[i*3 + kind];
+			if (!denseSize) continue;
+			pNode->offs[kind] = (uint32_t)offs;
+			if (!pTrk->rdft) {
+				memcpy(&pTop[offs], pSrc, denseSize);
+				offs += alignsz(denseSize, 4);
+				continue;
+			}
+			for (chan = 0; chan < 3; ++chan) {
+				int ich = i*9 + kind*3 + chan;
+				const float* pA = &pSpec[ich * nspec];
+				uint8_t* pBlk = &pTop[offs];
+				int cut;
+				if (!(pTrk->dataMask & (1 << chan))) continue;
+				cut = pCut[ich];
+				*(uint32_t*)pBlk = (uint32_t)cut;
+				memcpy(pBlk + sizeof(uint32_t), pA, cut * sizeof(float));
+				memcpy(pBlk + sizeof(uint32_t) + cut * sizeof(float), pA + nh + 2, (cut - 1) * sizeof(float));
+				if (pMaxErr) {
+					for (f = 0; f < nfrm; ++f) {
+						float err = fabsf(dfteval(pBlk, dftparam(pClip, (float)f)) - pSrc[f * vsize]);
+						if (err > pMaxErr[kind]) {
+							pMaxErr[kind] = err;
+						}
+					}
+				}
+				offs += dftblksize(cut);
+				++pSrc;
+			}
+		}
+	}
+	pFClip->eval = 0;
+	if (evalSize) {
+		memcpy(&pTop[offs], (const uint8_t*)pClip + pClip->eval, evalSize);
+		pFClip->eval = (uint32_t)offs;
+	}
+	/* as with quantized clips, Fourier tracks are evaluated through the tracks */
+	pFClip->seq = 0;
+	pFClip->size = (uint32_t)memSize;
+	return pFClip;
+}
+
+MOT_CLIP* motClipRdft(const MOT_CLIP* pClip, const float* pTol, float* pMaxErr) {
+	MOT_CLIP* pFClip = NULL;
+	float* pSpec;
+	int32_t* pCut;
+	uint8_t* pRdft;
+	int kind, nnod, nfrm;
+	if (pMaxErr) {
+		for (kind = 0; kind < 3; ++kind) {
+			pMaxErr[kind] = 0.0f;
+		}
+	}
+	if (!motClipHeaderCk(pClip) || !pTol || motClipQuantCk(pClip) || motClipKeyCk(pClip) || motClipRdftCk(pClip) || motClipFrameMajorCk(pClip)) return NULL;
+	nnod = pClip->nnod;
+	nfrm = pClip->nfrm;
+	if (nfrm < 2) return NULL;
+	/* full spectra of every channel are kept until the output size is known */
+	pSpec = (float*)malloc((size_t)nnod * 9 * (nfrm / 2 + 1) * 2 * sizeof(float));
+	pCut = (int32_t*)malloc(nnod * 9 * sizeof(int32_t));
+	pRdft = (uint8_t*)malloc(nnod * 3);
+	if (pSpec && pCut && pRdft) {
+		pFClip = rdftclip(pClip, pTol, pMaxErr, pSpec, pCut, pRdft);
+	}
+	free(pSpec);
+	free(pCut);
+	free(pRdft);
+	return pFClip;
+}
+
+int motClipRdftCk(const MOT_CLIP* pClip) {
+	int i, kind;
+	if (!pClip) return 0;
+	for (i = 0; i < (int)pClip->nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			if (pClip->nodes[i].trk[kind].rdft) return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Frame-major layout: the animated channels of all tracks are interleaved into
+ * one table of nfrm rows, a row being one frame of every channel, so evaluating
+ * a pose reads two adjacent rows instead of one cache line per track.
+ * Columns follow the EVAL curve order (kind, node, channel), the row width is
+ * the EVAL curve count; node offsets point to the track's first column in row 0.
+ */
+MOT_CLIP* motClipFrameMajor(const MOT_CLIP* pClip) {
+	MOT_CLIP* pRClip;
+	const MOT_EVAL* pEval;
+	uint8_t* pTop;
+	float* pRows;
+	size_t hdrSize, evalSize, dataSize, memSize, offs;
+	int i, kind, f, nnod, nfrm, width, col;
+	if (!motClipHeaderCk(pClip) || motClipQuantCk(pClip) || motClipKeyCk(pClip) || motClipRdftCk(pClip) || motClipFrameMajorCk(pClip)) return NULL;
+	pEval = motGetEvalInfo(pClip);
+	/* the row width is read back from EVAL, so it has to be there and agree with the tracks */
+	if (!pEval) return NULL;
+	nnod = pClip->nnod;
+	nfrm = pClip->nfrm;
+	width = 0;
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			if (trkdatasize(pClip, i, kind, 0)) {
+				width += bitcnt(pClip->nodes[i].trk[kind].dataMask);
+			}
+		}
+	}
+	if (width != motClipRowWidth(pClip)) return NULL;
+	hdrSize = offsetof(MOT_CLIP, nodes) + nnod * sizeof(MOT_NODE);
+	if (pClip->hash) {
+		hdrSize = pClip->hash + nnod * sizeof(uint32_t);
+	}
+	hdrSize = alignsz(hdrSize, 0x10);
+	dataSize = alignsz((size_t)nfrm * width * sizeof(float), 0x10);
+	evalSize = (pClip->seq > pClip->eval ? pClip->seq : pClip->size) - pClip->eval;
+	memSize = hdrSize + dataSize + evalSize;
+	pRClip = (MOT_CLIP*)malloc(memSize);
+	if (!pRClip) return NULL;
+	pTop = (uint8_t*)pRClip;
+	memset(pTop, 0, memSize);
+	memcpy(pTop, pClip, hdrSize < pClip->size ? hdrSize : pClip->size);
+	offs = hdrSize;
+	pRows = (float*)&pTop[offs];
+	col = 0;
+	for (kind = 0; kind < 3; ++kind) {
+		for (i = 0; i < nnod; ++i) {
+			const float* pSrc = motGetTrackData(pClip, i, (E_MOT_TRK)kind);
+			MOT_NODE* pNode = &pRClip->nodes[i];
+			MOT_TRACK* pTrk = &pNode->trk[kind];
+			int vsize = bitcnt(pTrk->dataMask);
+			int chan;
+			pNode->offs[kind] = 0;
+			if (!trkdatasize(pClip, i, kind, 0)) continue;
+			pNode->offs[kind] = (uint32_t)(offs + col * sizeof(float));
+			pTrk->fmaj = 1;
+			for (chan = 0; chan < vsize; ++chan) {
+				for (f = 0; f < nfrm; ++f) {
+					pRows[(size_t)f * width + col] = pSrc[f * vsize + chan];
+				}
+				++col;
+			}
+		}
+	}
+	offs += dataSize;
+	memcpy(&pTop[offs], (const uint8_t*)pClip + pClip->eval, evalSize);
+	pRClip->eval = (uint32_t)offs;
+	/* SEQ strides are 8-bit and cannot span a row, frame-major clips are evaluated through the tracks */
+	pRClip->seq = 0;
+	pRClip->size = (uint32_t)memSize;
+	return pRClip;
+}
+
+int motClipFrameMajorCk(const MOT_CLIP* pClip) {
+	int i, kind;
+	if (!pClip) return 0;
+	for (i = 0; i < (int)pClip->nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			if (pClip->nodes[i].trk[kind].fmaj) return 1;
+		}
+	}
+	return 0;
+}
+
+int motLibHeaderCk(const MOT_LIB* pLib) {
+	int i;
+	if (!pLib) return 0;
+	for (i = 0; i < 4; ++i) {
+		if (pLib->fmt[i] != g_motLibFmt[i]) return 0;
+	}
+	return 1;
+}
+
+static int libtblck(uint32_t offs, size_t n, size_t elemSize, size_t size) {
+	return !(offs & 3) && offs <= size && n <= (size - offs) / elemSize;
+}
+
+/* directory and every clip of a library blob (loaded or mapped) against its size */
+int motLibMemCk(const void* pMem, size_t size) {
+	const MOT_LIB* pLib = (const MOT_LIB*)pMem;
+	const uint32_t* pOffs;
+	uint32_t i;
+	if (!pLib || size < sizeof(MOT_LIB) || !motLibHeaderCk(pLib)) return 0;
+	if (pLib->size > size) return 0;
+	size = pLib->size;
+	if (!libtblck(pLib->clips, pLib->nclip, sizeof(uint32_t), size)) return 0;
+	if (!libtblck(pLib->hash, pLib->nclip, sizeof(uint32_t), size)) return 0;
+	if (!libtblck(pLib->nodes, pLib->nnod, sizeof(MOT_STRING), size)) return 0;
+	if (!libtblck(pLib->nodeHash, pLib->nnod, sizeof(uint32_t), size)) return 0;
+	pOffs = (const uint32_t*)((const uint8_t*)pLib + pLib->clips);
+	for (i = 0; i < pLib->nclip; ++i) {
+		if ((pOffs[i] & 3) || pOffs[i] > size) return 0;
+		if (!motClipMemCk((const uint8_t*)pLib + pOffs[i], size - pOffs[i])) return 0;
+	}
+	return 1;
+}
+
+/* the whole library with one open and one allocation, free with motLibFree */
+MOT_LIB* motLibLoad(const char* pPath) {
+	MOT_LIB* pLib = NULL;
+	FILE* f;
+	if (!pPath) return NULL;
+	f = fopen(pPath, "rb");
+	if (f) {
+		long len = 0;
+		if (0 == fseek(f, 0, SEEK_END)) {
+			len = ftell(f);
+		}
+		fseek(f, 0, SEEK_SET);
+		if (len > (long)sizeof(MOT_LIB)) {
+			pLib = (MOT_LIB*)malloc(len);
+			if (pLib) {
+				if (fread(pLib, len, 1, f) != 1 || !motLibMemCk(pLib, (size_t)len)) {
+					free(pLib);
+					pLib = NULL;
+				}
+			}
+		}
+		fclose(f);
+	}
+	return pLib;
+}
+
+void motLibFree(MOT_LIB* pLib) {
+	free(pLib);
+}
+
+int motLibClipCount(const MOT_LIB* pLib) {
+	return pLib ? (int)pLib->nclip : 0;
+}
+
+const MOT_CLIP* motLibGetClip(const MOT_LIB* pLib, int clipIdx) {
+	const uint32_t* pOffs;
+	if (!pLib || (uint32_t)clipIdx >= pLib->nclip) return NULL;
+	pOffs = (const uint32_t*)((const uint8_t*)pLib + pLib->clips);
+	return (const MOT_CLIP*)((const uint8_t*)pLib + pOffs[clipIdx]);
+}
+
+/* first of the entries with hash h, -1: none */
+static int hfirst(const uint32_t* pHashes, int n, uint32_t h) {
+	int idx;
+	if (n <= 0) return -1;
+	idx = hfind(pHashes, n, h);
+	if (pHashes[idx] != h) return -1;
+	while (idx > 0 && pHashes[idx - 1] == h) {
+		--idx;
+	}
+	return idx;
+}
+
+static int strck(const MOT_STRING* pStr, const char* pName, uint32_t len) {
+	return len == pStr->len && memcmp(pStr->chr, pName, len) == 0;
+}
+
+int motLibFindClip(const MOT_LIB* pLib, const char* pName) {
+	uint32_t len, h;
+	const uint32_t* pHashes;
+	int i, n;
+	if (!pLib || !pName) return -1;
+	h = strhash(&len, pName);
+	if ((size_t)len >= sizeof(MOT_STRING) - 2) return -1;
+	n = (int)pLib->nclip;
+	pHashes = (const uint32_t*)((const uint8_t*)pLib + pLib->hash);
+	i = hfirst(pHashes, n, h);
+	if (i < 0) return -1;
+	for (; i < n && pHashes[i] == h; ++i) {
+		if (strck(&motLibGetClip(pLib, i)->name, pName, len)) return i;
+	}
+	return -1;
+}
+
+const MOT_CLIP* motLibFindClipPtr(const MOT_LIB* pLib, const char* pName) {
+	return motLibGetClip(pLib, motLibFindClip(pLib, pName));
+}
+
+const char* motLibGetNodeName(const MOT_LIB* pLib, int nodeIdx) {
+	const MOT_STRING* pNames;
+	if (!pLib || (uint32_t)nodeIdx >= pLib->nnod) return NULL;
+	pNames = (const MOT_STRING*)((const uint8_t*)pLib + pLib->nodes);
+	return pNames[nodeIdx].chr;
+}
+
+int motLibFindNode(const MOT_LIB* pLib, const char* pName) {
+	uint32_t len, h;
+	const uint32_t* pHashes;
+	const MOT_STRING* pNames;
+	int i, n;
+	if (!pLib || !pName) return -1;
+	h = strhash(&len, pName);
+	if ((size_t)len >= sizeof(MOT_STRING) - 2) return -1;
+	n = (int)pLib->nnod;
+	pHashes = (const uint32_t*)((const uint8_t*)pLib + pLib->nodeHash);
+	pNames = (const MOT_STRING*)((const uint8_t*)pLib + pLib->nodes);
+	i = hfirst(pHashes, n, h);
+	if (i < 0) return -1;
+	for (; i < n && pHashes[i] == h; ++i) {
+		if (strck(&pNames[i], pName, len)) return i;
+	}
+	return -1;
+}
+
+static int bindcmp(const void* p1, const void* p2) {
+	const uint32_t* pE1 = (const uint32_t*)p1;
+	const uint32_t* pE2 = (const uint32_t*)p2;
+	if (pE1[0] != pE2[0]) return pE1[0] < pE2[0] ? -1 : 1;
+	return pE1[1] < pE2[1] ? -1 : pE1[1] > pE2[1] ? 1 : 0;
+}
+
+/* pOrd: (hash, joint) pairs, sorted so that duplicate names bind their first joint */
+static void bindsort(MOT_BIND* pBind, const char* const* ppNames, uint32_t* pOrd) {
+	int i, n;
+	n = 0;
+	for (i = 0; i < pBind->njnt; ++i) {
+		uint32_t len;
+		uint32_t h = ppNames[i] ? strhash(&len, ppNames[i]) : 0;
+		if (!ppNames[i] || (size_t)len >= sizeof(MOT_STRING) - 2) continue;
+		pOrd[n*2] = h;
+		pOrd[n*2 + 1] = (uint32_t)i;
+		++n;
+	}
+	qsort(pOrd, n, 2 * sizeof(uint32_t), bindcmp);
+	for (i = 0; i < n; ++i) {
+		int jnt = (int)pOrd[i*2 + 1];
+		MOT_STRING* pName = &pBind->pName[i];
+		pBind->pHash[i] = pOrd[i*2];
+		pBind->pJnt[i] = (int16_t)jnt;
+		pName->len = (uint8_t)strlen(ppNames[jnt]);
+		memcpy(pName->chr, ppNames[jnt], pName->len);
+	}
+	pBind->nent = n;
+}
+
+int motBindInit(MOT_BIND* pBind, const char* const* ppNames, int njnt) {
+	uint8_t* pMem;
+	uint32_t* pOrd;
+	size_t memSize;
+	if (!pBind) return 0;
+	memset(pBind, 0, sizeof(MOT_BIND));
+	if (!ppNames || njnt < 0 || njnt > 0x7FFF) return 0;
+	memSize = njnt * (sizeof(MOT_STRING) + sizeof(uint32_t) + sizeof(int16_t));
+	pMem = (uint8_t*)malloc(memSize ? memSize : 1);
+	pOrd = (uint32_t*)malloc((njnt ? njnt : 1) * 2 * sizeof(uint32_t));
+	if (!pMem || !pOrd) {
+		free(pMem);
+		free(pOrd);
+		return 0;
+	}
+	pBind->njnt = njnt;
+	pBind->pMem = pMem;
+	pBind->pName = (MOT_STRING*)pMem;
+	pMem += njnt * sizeof(MOT_STRING);
+	pBind->pHash = (uint32_t*)pMem;
+	pMem += njnt * sizeof(uint32_t);
+	pBind->pJnt = (int16_t*)pMem;
+	bindsort(pBind, ppNames, pOrd);
+	free(pOrd);
+	return 1;
+}
+
+void motBindFree(MOT_BIND* pBind) {
+	if (pBind) {
+		if (pBind->pMem) {
+			free(pBind->pMem);
+		}
+		memset(pBind, 0, sizeof(MOT_BIND));
+	}
+}
+
+/* end of the run of entries with the hash of entry i */
+static int hrunend(const uint32_t* pHashes, int n, int i) {
+	uint32_t h = pHashes[i];
+	do {
+		++i;
+	} while (i < n && pHashes[i] == h);
+	return i;
+}
+
+/* node inod against the joint entries [i0, i1) sharing its hash */
+static int bindnode(const MOT_BIND* pBind, const MOT_CLIP* pClip, int inod, int i0, int i1, int16_t* pNodeJnt, int16_t* pJntNode) {
+	const MOT_STRING* pNodeName = &pClip->nodes[inod].name;
+	int i;
+	for (i = i0; i < i1; ++i) {
+		if (strck(&pBind->pName[i], pNodeName->chr, pNodeName->len)) {
+			int jnt = pBind->pJnt[i];
+			if (pNodeJnt) {
+				pNodeJnt[inod] = (int16_t)jnt;
+			}
+			if (pJntNode && pJntNode[jnt] < 0) {
+				pJntNode[jnt] = (int16_t)inod;
+			}
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Clip node -> joint (pNodeJnt[nnod], as MOT_LAYER.pMap) and/or
+ * joint -> clip node (pJntNode[njnt], as MOT_SKEL.pNode), -1 = unbound.
+ * Clips with a hash table are merged with the joint hashes in O(nnod + njnt),
+ * others hash each node name once and search the joints.
+ */
+int motBindClip(const MOT_BIND* pBind, const MOT_CLIP* pClip, int16_t* pNodeJnt, int16_t* pJntNode) {
+	int i, j, nnod, nent;
+	int nbound = 0;
+	if (!pBind || !pClip || !pBind->pMem) return 0;
+	nnod = pClip->nnod;
+	nent = pBind->nent;
+	if (pNodeJnt) {
+		for (i = 0; i < nnod; ++i) {
+			pNodeJnt[i] = -1;
+		}
+	}
+	if (pJntNode) {
+		for (i = 0; i < pBind->njnt; ++i) {
+			pJntNode[i] = -1;
+		}
+	}
+	if (pClip->hash) {
+		const uint32_t* pHashes = (const uint32_t*)((const uint8_t*)pClip + pClip->hash);
+		i = 0;
+		j = 0;
+		while (i < nnod && j < nent) {
+			uint32_t h = pHashes[i];
+			if (h < pBind->pHash[j]) {
+				++i;
+			} else if (h > pBind->pHash[j]) {
+				++j;
+			} else {
+				int j1 = hrunend(pBind->pHash, nent, j);
+				for (; i < nnod && pHashes[i] == h; ++i) {
+					nbound += bindnode(pBind, pClip, i, j, j1, pNodeJnt, pJntNode);
+				}
+				j = j1;
+			}
+		}
+	} else {
+		for (i = 0; i < nnod; ++i) {
+			uint32_t len;
+			uint32_t h = strhash(&len, pClip->nodes[i].name.chr);
+			j = hfirst(pBind->pHash, nent, h);
+			if (j < 0) continue;
+			nbound += bindnode(pBind, pClip, i, j, hrunend(pBind->pHash, nent, j), pNodeJnt, pJntNode);
+		}
+	}
+	return nbound;
+}
+
+/* int16 entries for the node maps of every clip in a library */
+size_t motBindLibSize(const MOT_LIB* pLib) {
+	size_t n = 0;
+	int i;
+	if (!pLib) return 0;
+	for (i = 0; i < (int)pLib->nclip; ++i) {
+		n += motLibGetClip(pLib, i)->nnod;
+	}
+	return n;
+}
+
+/* clip node -> joint maps of all library clips back to back, clip i's at pMaps + pOffs[i] */
+int motBindLib(const MOT_BIND* pBind, const MOT_LIB* pLib, int16_t* pMaps, uint32_t* pOffs) {
+	size_t offs = 0;
+	int i;
+	int nbound = 0;
+	if (!pBind || !pLib || !pMaps) return 0;
+	for (i = 0; i < (int)pLib->nclip; ++i) {
+		const MOT_CLIP* pClip = motLibGetClip(pLib, i);
+		if (pOffs) {
+			pOffs[i] = (uint32_t)offs;
+		}
+		nbound += motBindClip(pBind, pClip, &pMaps[offs], NULL);
+		offs += pClip->nnod;
+	}
+	return nbound;
+}
+
+static int memrangeck(size_t offs, size_t len, size_t size) {
+	return offs <= size && len <= size - offs;
+}
+
+/* a spline or Fourier block chain of one track, block by block */
+static int blkchainck(const uint8_t* pTop, size_t offs, int nchan, int spline, size_t size) {
+	int i;
+	for (i = 0; i < nchan; ++i) {
+		uint32_t n;
+		size_t blkSize;
+		if ((offs & 3) || !memrangeck(offs, sizeof(uint32_t), size)) return 0;
+		n = *(const uint32_t*)&pTop[offs];
+		if (n < 1 || n > 0xFFFF) return 0;
+		blkSize = spline ? keyblksize(n) : dftblksize(n);
+		if (!memrangeck(offs, blkSize, size)) return 0;
+		offs += blkSize;
+	}
+	return 1;
+}
+
+/*
+ * Structural validation of a clip image against the bytes available:
+ * header, name strings, node track data, hash, eval and seq tables,
+ * every offset checked once, O(nnod) (spline and Fourier blocks are walked per channel).
+ */
+int motClipMemCk(const void* pMem, size_t size) {
+	const MOT_CLIP* pClip = (const MOT_CLIP*)pMem;
+	const uint8_t* pTop = (const uint8_t*)pMem;
+	size_t nodesEnd;
+	uint32_t ntrk = 0;
+	size_t width = 0;
+	int i, kind;
+	if (!pClip || size < offsetof(MOT_CLIP, nodes) || !motClipHeaderCk(pClip)) return 0;
+	if (pClip->size > size || pClip->size < offsetof(MOT_CLIP, nodes)) return 0;
+	size = pClip->size;
+	if (pClip->nnod > 0xFFFF || pClip->nnod > (size - offsetof(MOT_CLIP, nodes)) / sizeof(MOT_NODE)) return 0;
+	/* evaluation wraps frames with fmodf(t, nfrm) */
+	if (pClip->nfrm < 1) return 0;
+	nodesEnd = offsetof(MOT_CLIP, nodes) + pClip->nnod * sizeof(MOT_NODE);
+	if (pClip->name.chr[sizeof(pClip->name.chr) - 1]) return 0;
+	if (pClip->hash && ((pClip->hash & 3) || pClip->hash < nodesEnd || !memrangeck(pClip->hash, pClip->nnod * sizeof(uint32_t), size))) return 0;
+	if (pClip->eval && !(pClip->eval & 3) && memrangeck(pClip->eval, offsetof(MOT_EVAL, map), size)) {
+		/* frame-major row width, the counts themselves are checked with the rest of eval */
+		const MOT_EVAL* pEval = (const MOT_EVAL*)&pTop[pClip->eval];
+		for (kind = 0; kind < 3; ++kind) {
+			if (pEval->ncrv[kind] > pClip->nnod * 3) return 0;
+			width += pEval->ncrv[kind];
+		}
+	}
+	for (i = 0; i < (int)pClip->nnod; ++i) {
+		const MOT_NODE* pNode = &pClip->nodes[i];
+		if (pNode->name.chr[sizeof(pNode->name.chr) - 1]) return 0;
+		if (pNode->xord > XORD_TRS || pNode->rord > RORD_ZYX) return 0;
+		for (kind = 0; kind < 3; ++kind) {
+			const MOT_TRACK* pTrk = &pNode->trk[kind];
+			uint32_t offs = pNode->offs[kind];
+			int nchan = bitcnt(pTrk->dataMask);
+			if ((pTrk->srcMask | pTrk->dataMask) > 7 || (pTrk->dataMask & ~pTrk->srcMask)) return 0;
+			if (pTrk->qbits > 16 || (!!pTrk->qbits + !!pTrk->spline + !!pTrk->rdft + !!pTrk->fmaj) > 1) return 0;
+			if (!offs) continue;
+			if (offs < nodesEnd || !nchan) return 0;
+			if (pTrk->fmaj) {
+				size_t span = pClip->nfrm ? ((size_t)(pClip->nfrm - 1) * width + nchan) * sizeof(float) : 0;
+				if ((offs & 3) || (size_t)nchan > width || !memrangeck(offs, span, size)) return 0;
+			} else if (pTrk->spline || pTrk->rdft) {
+				if (!blkchainck(pTop, offs, nchan, pTrk->spline, size)) return 0;
+			} else {
+				size_t esize = pTrk->qbits ? (pTrk->qbits <= 8 ? 1 : 2) : sizeof(float);
+				/* quantized data is read with 32-bit gathers, 4 bytes past the track must be there */
+				size_t pad = pTrk->qbits ? 4 : 0;
+				if ((offs % esize) || !memrangeck(offs, (size_t)pClip->nfrm * nchan * esize + pad, size)) return 0;
+			}
+		}
+	}
+	if (pClip->eval) {
+		const MOT_EVAL* pEval;
+		size_t nmap = 0;
+		if ((pClip->eval & 3) || pClip->eval < nodesEnd || !memrangeck(pClip->eval, offsetof(MOT_EVAL, map), size)) return 0;
+		pEval = (const MOT_EVAL*)&pTop[pClip->eval];
+		for (kind = 0; kind < 3; ++kind) {
+			if (pEval->ntrk[kind] > pClip->nnod || pEval->nchn[kind] > pClip->nnod * 3 || pEval->ncrv[kind] > pEval->nchn[kind]) return 0;
+			ntrk += pEval->ntrk[kind];
+			nmap += pEval->nchn[kind];
+		}
+		if (!memrangeck(pClip->eval + offsetof(MOT_EVAL, map), nmap * sizeof(MOT_CMAP), size)) return 0;
+		for (i = 0; i < (int)nmap; ++i) {
+			const MOT_CMAP* pMap = &pEval->map[i];
+			if (pMap->node >= pClip->nnod || pMap->kind > 2 || pMap->chan > 2) return 0;
+		}
+	}
+	if (pClip->seq) {
+		const MOT_SEQ* pSeq;
+		/* seq is only walked along with eval's track counts */
+		if (!pClip->eval) return 0;
+		if ((pClip->seq & 3) || pClip->seq < nodesEnd || !memrangeck(pClip->seq, ntrk * 3 * sizeof(MOT_SEQ), size)) return 0;
+		pSeq = (const MOT_SEQ*)&pTop[pClip->seq];
+		for (kind = 0; kind < 3; ++kind) {
+			const MOT_EVAL* pEval = (const MOT_EVAL*)&pTop[pClip->eval];
+			int nseq = (int)pEval->ntrk[kind] * 3;
+			for (i = 0; i < nseq; ++i) {
+				size_t span = ((size_t)(pClip->nfrm - 1) * pSeq[i].stride + 1) * sizeof(float);
+				if (pSeq[i].node >= pClip->nnod || pSeq[i].chan > 2) return 0;
+				if (!pSeq[i].offs) continue;
+				/* motEvalPose indexes its per-stride frame offsets with it */
+				if (pSeq[i].stride && pSeq[i].stride != bitcnt(pClip->nodes[pSeq[i].node].trk[kind].dataMask)) return 0;
+				if ((pSeq[i].offs & 3) || !memrangeck(pSeq[i].offs, span, size)) return 0;
+			}
+			pSeq += nseq;
+		}
+	}
+	return 1;
+}
+
+/* read-only shared mapping of a whole file, released with motFileUnmap */
+int motFileMap(MOT_FMAP* pMap, const char* pPath) {
+	if (!pMap) return 0;
+	memset(pMap, 0, sizeof(MOT_FMAP));
+	if (!pPath) return 0;
+#if defined(_WIN32)
+	{
+		HANDLE hFile = CreateFileA(pPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		LARGE_INTEGER len;
+		HANDLE hMap = NULL;
+		if (hFile == INVALID_HANDLE_VALUE) return 0;
+		if (GetFileSizeEx(hFile, &len) && len.QuadPart > 0 && (uint64_t)len.QuadPart <= (uint64_t)SIZE_MAX) {
+			hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		}
+		CloseHandle(hFile);
+		if (!hMap) return 0;
+		pMap->pMem = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+		if (!pMap->pMem) {
+			CloseHandle(hMap);
+			return 0;
+		}
+		pMap->size = (size_t)len.QuadPart;
+		pMap->hMap = hMap;
+	}
+#else
+	{
+		struct stat st;
+		void* pMem = MAP_FAILED;
+		int fd = open(pPath, O_RDONLY);
+		if (fd < 0) return 0;
+		if (fstat(fd, &st) == 0 && st.st_size > 0 && (uint64_t)st.st_size <= (uint64_t)SIZE_MAX) {
+			pMem = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		}
+		close(fd);
+		if (pMem == MAP_FAILED) return 0;
+		pMap->pMem = pMem;
+		pMap->size = (size_t)st.st_size;
+	}
+#endif
+	return 1;
+}
+
+void motFileUnmap(MOT_FMAP* pMap) {
+	if (!pMap || !pMap->pMem) return;
+#if defined(_WIN32)
+	UnmapViewOfFile(pMap->pMem);
+	CloseHandle((HANDLE)pMap->hMap);
+#else
+	munmap((void*)pMap->pMem, pMap->size);
+#endif
+	memset(pMap, 0, sizeof(MOT_FMAP));
+}
+
+/* clip used in place from the page cache, NULL if the file fails validation */
+const MOT_CLIP* motClipMap(MOT_FMAP* pMap, const char* pPath) {
+	if (!motFileMap(pMap, pPath)) return NULL;
+	if (!motClipMemCk(pMap->pMem, pMap->size)) {
+		motFileUnmap(pMap);
+		return NULL;
+	}
+	return (const MOT_CLIP*)pMap->pMem;
+}
+
+const MOT_LIB* motLibMap(MOT_FMAP* pMap, const char* pPath) {
+	if (!motFileMap(pMap, pPath)) return NULL;
+	if (!motLibMemCk(pMap->pMem, pMap->size)) {
+		motFileUnmap(pMap);
+		return NULL;
+	}
+	return (const MOT_LIB*)pMap->pMem;
+}
@@ -3,7 +3,11 @@
  * Author: Sergey Chaban <sergey.chaban@gmail.com>
  */
 
+#ifndef MOTCLIP_H
+#define MOTCLIP_H
+
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -18,9 +22,15 @@
 #	define MOT_EXTERN_DATA extern
 #endif
 
+/* M_PI is not in C99 nor in MSVC's math.h by default */
+#define MOT_PI (3.14159265358979323846)
+
 typedef enum _E_MOT_TRK { TRK_POS, TRK_ROT, TRK_SCL } E_MOT_TRK;
 typedef enum _E_MOT_RORD { RORD_XYZ, RORD_XZY, RORD_YXZ, RORD_YZX, RORD_ZXY, RORD_ZYX } E_MOT_RORD;
 typedef enum _E_MOT_XORD { XORD_SRT, XORD_STR, XORD_RST, XORD_RTS, XORD_TSR, XORD_TRS } E_MOT_XORD;
+typedef enum _E_MOT_SIMD { SIMD_NONE, SIMD_BLOCK, SIMD_SSE4, SIMD_AVX2, SIMD_NEON } E_MOT_SIMD;
+typedef enum _E_MOT_QBLEND { QBLEND_NLERP, QBLEND_NLERP_FIX, QBLEND_SLERP } E_MOT_QBLEND;
+typedef enum _E_MOT_LAYER { LAYER_OVERRIDE, LAYER_ADDITIVE } E_MOT_LAYER;
 
 typedef struct _MOT_STRING {
 	uint8_t len;
@@ -29,6 +39,12 @@ typedef struct _MOT_STRING {
 
 typedef float MOT_MTX[4][4];
 
+/*
+ * Affine 3x4: row i is column i of the equivalent MOT_MTX,
+ * element 3 is the translation (x' = dot(row0.xyz, p) + row0.w).
+ */
+typedef float MOT_AFFINE[3][4];
+
 typedef union _MOT_VEC {
 	struct { float x, y, z; };
 	float s[3];
@@ -45,7 +61,11 @@ typedef struct _MOT_TRACK {
 	uint8_t srcMask;
 	uint8_t dataMask;
 	uint8_t stride;
-	uint8_t reserved[5];
+	uint8_t qbits; /* 0: float data, 1..16: normalized ints in [vmin, vmax] */
+	uint8_t spline; /* 1: sparse Catmull-Rom keys per channel, see motClipKeyReduce */
+	uint8_t rdft;   /* 1: truncated Fourier series per channel, see motClipRdft */
+	uint8_t fmaj;   /* 1: columns of the clip's frame-major rows, see motClipFrameMajor */
+	uint8_t reserved;
 } MOT_TRACK;
 
 typedef struct _MOT_NODE {
@@ -90,6 +110,163 @@ typedef struct _MOT_CLIP {
 	MOT_NODE   nodes[1];
 } MOT_CLIP;
 
+/*
+ * Motion library: clips back to back in one blob, each clip 16-byte aligned
+ * and self-relative, so clips are used in place as MOT_CLIP views.
+ * Clips and the union of their node names are listed in name hash order,
+ * as clip nodes (see motFindClipNode). Offsets are from the library top.
+ */
+typedef struct _MOT_LIB {
+	char     fmt[4];
+	uint32_t nclip;
+	uint32_t nnod;
+	uint32_t size;
+	uint32_t clips;    /* -> uint32 clip offsets [nclip] */
+	uint32_t hash;     /* -> uint32 clip name hashes [nclip] */
+	uint32_t nodes;    /* -> MOT_STRING node names [nnod] */
+	uint32_t nodeHash; /* -> uint32 node name hashes [nnod] */
+} MOT_LIB;
+
+/* read-only file mapping, the pages are shared by all processes mapping the file */
+typedef struct _MOT_FMAP {
+	const void* pMem;
+	size_t      size;
+	void*       hMap; /* Win32 mapping object */
+} MOT_FMAP;
+
+/* Structure-of-arrays pose: one lane per component, lanes padded to MOT_POSE_PAD joints. */
+#define MOT_POSE_PAD (8)
+
+typedef struct _MOT_POSE {
+	int    njnt;
+	int    nlane;
+	float* pPos[3];
+	float* pRot[4];
+	float* pScl[3];
+	void*  pMem;
+} MOT_POSE;
+
+/*
+ * Blend layer: tracks present in pClip are blended into the pose in layer order.
+ * LAYER_OVERRIDE lerps towards the clip values by weight*mask,
+ * LAYER_ADDITIVE applies the clip's delta between refFrm and frm.
+ * pMap remaps clip nodes to pose joints (-1 = skip), NULL = same order.
+ * pMask holds per-joint weights in pose order, NULL = 1.
+ */
+typedef struct _MOT_LAYER {
+	const MOT_CLIP* pClip;
+	const int16_t*  pMap;
+	const float*    pMask;
+	float           frm;
+	float           refFrm;
+	float           weight;
+	uint8_t         mode;
+	uint8_t         reserved[3];
+} MOT_LAYER;
+
+/*
+ * Skeleton: joints are sorted by hierarchy level (parents before children,
+ * each level contiguous in [pLvl[l], pLvl[l+1])), pOrder maps sorted joints
+ * back to the caller's order, pNode to clip nodes (-1 = not animated).
+ */
+typedef struct _MOT_SKEL {
+	int       njnt;
+	int       nlvl;
+	int*      pLvl;
+	int16_t*  pParent;
+	int16_t*  pOrder;
+	int16_t*  pNode;
+	MOT_VEC*  pRestTns;
+	void*     pMem;
+} MOT_SKEL;
+
+/*
+ * Name binding: a skeleton's joint names hashed once and kept in hash order
+ * (njnt entries, names too long for MOT_STRING dropped), so each clip is bound
+ * by one merge pass over its node hash table instead of a search per joint.
+ */
+typedef struct _MOT_BIND {
+	int         njnt;
+	int         nent;
+	uint32_t*   pHash;
+	int16_t*    pJnt;
+	MOT_STRING* pName;
+	void*       pMem;
+} MOT_BIND;
+
+typedef struct _MOT_SMP_CHAN {
+	const float* pSrc;
+	int32_t      stride;
+	int32_t      dst;
+} MOT_SMP_CHAN;
+
+/* quantized animated channels of one kind, as lanes for the SIMD decoder */
+typedef struct _MOT_SMP_QCHN {
+	int       n;
+	int32_t*  pOffs;   /* frame 0 element, bytes from clip top */
+	int32_t*  pStride; /* bytes per frame */
+	int32_t*  pDst;
+	uint32_t* pMask;
+	float*    pBase;
+	float*    pScale;
+} MOT_SMP_QCHN;
+
+/* spline channels of one kind, with the cursor segment cached as a cubic */
+typedef struct _MOT_SMP_KCHN {
+	int       n;
+	int32_t*  pOffs; /* key block, bytes from clip top */
+	int32_t*  pDst;
+	int32_t*  pCur;  /* key segment of the last frame, -1: none */
+	int32_t*  pSpan; /* [first, end) frames of the segment */
+	float*    pCoef; /* 4 per channel: cubic in frames from the span start */
+} MOT_SMP_KCHN;
+
+/* Fourier channels of one kind, evaluated against the sampler's shared cos/sin rows */
+typedef struct _MOT_SMP_FCHN {
+	int       n;
+	int32_t*  pOffs; /* series block, bytes from clip top */
+	int32_t*  pDst;
+} MOT_SMP_FCHN;
+
+/* frame-major rows: animated channels are the row columns, kind by kind */
+typedef struct _MOT_SMP_ROWS {
+	const float* pRow0;  /* frame 0 */
+	int          width;  /* floats per frame */
+	int          col[4]; /* first column of each kind, col[3] = width */
+	int32_t*     pDst;   /* per column */
+} MOT_SMP_ROWS;
+
+/*
+ * Clip sampler: channel sources resolved once per clip, constant channels
+ * point at their value with stride 0. Animated channels are also listed
+ * per kind for whole-pose evaluation (rotations as log vectors in pLog),
+ * float channels in pAnim, quantized ones in qanim, spline keys in kanim,
+ * Fourier series in fanim (evaluated at the exact frame, cos/sin rows in pTrig),
+ * frame-major columns in rows (two contiguous rows per pose).
+ * The cursor is advanced without fmodf while playback moves forward.
+ */
+typedef struct _MOT_SAMPLER {
+	const MOT_CLIP* pClip;
+	int             nnod;
+	int             nfrm;
+	float           frm;
+	float           t;
+	int             fno;
+	int             next;
+	int             nanim[3];
+	MOT_SMP_CHAN*   pAnim[3];
+	MOT_SMP_QCHN    qanim[3];
+	MOT_SMP_KCHN    kanim[3];
+	MOT_SMP_FCHN    fanim[3];
+	int             maxCut;
+	float*          pTrig;
+	MOT_SMP_ROWS    rows;
+	MOT_SMP_CHAN*   pNodeChan;
+	MOT_VEC*        pBase[3];
+	MOT_VEC*        pLog;
+	void*           pMem;
+} MOT_SAMPLER;
+
 MOT_EXTERN_DATA const char g_motClipFmt[4];
 MOT_EXTERN_DATA const char g_motLibFmt[4];
 
@@ -105,6 +282,12 @@ MOT_EXTERN_FUNC void motMakeTransformTR(MOT_MTX* pMtx, const MOT_VEC tns, const
 MOT_EXTERN_FUNC void motMakeTransformR(MOT_MTX* pMtx, const MOT_QUAT rot);
 MOT_EXTERN_FUNC void motMakeTransformT(MOT_MTX* pMtx, const MOT_VEC tns);
 
+MOT_EXTERN_FUNC void motMakeAffine(MOT_AFFINE* pAff, const MOT_VEC tns, const MOT_QUAT rot, const MOT_VEC scl, E_MOT_XORD xord);
+MOT_EXTERN_FUNC void motMakeAffineAry(MOT_AFFINE* pAff, const MOT_VEC* pTns, const MOT_QUAT* pRot, const MOT_VEC* pScl, int n, E_MOT_XORD xord);
+MOT_EXTERN_FUNC void motAffineMul(MOT_AFFINE* pRes, const MOT_AFFINE* pAff1, const MOT_AFFINE* pAff2);
+MOT_EXTERN_FUNC void motAffineToMtx(MOT_MTX* pMtx, const MOT_AFFINE* pAff);
+MOT_EXTERN_FUNC void motAffineFromMtx(MOT_AFFINE* pAff, const MOT_MTX* pMtx);
+
 MOT_EXTERN_FUNC MOT_QUAT motQuatFromRadians(float rx, float ry, float rz, E_MOT_RORD rord);
 MOT_EXTERN_FUNC MOT_QUAT motQuatFromDegrees(float dx, float dy, float dz, E_MOT_RORD rord);
 MOT_EXTERN_FUNC MOT_QUAT motQuatMul(const MOT_QUAT q1, const MOT_QUAT q2);
@@ -114,6 +297,33 @@ MOT_EXTERN_FUNC MOT_QUAT motQuatSlerp(const MOT_QUAT q1, const MOT_QUAT q2, floa
 MOT_EXTERN_FUNC MOT_VEC motQuatToRadians(const MOT_QUAT q, E_MOT_RORD rord);
 MOT_EXTERN_FUNC MOT_VEC motQuatToDegrees(const MOT_QUAT q, E_MOT_RORD rord);
 MOT_EXTERN_FUNC void motQuatExpAry(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n);
+MOT_EXTERN_FUNC void motQuatExpAryEx(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n, E_MOT_SIMD simd);
+
+/*
+ * Euler angle arrays in one rotation order, with vectorized sin/cos/atan2
+ * approximations. Against motQuatFromRadians/motQuatToRadians: quaternion
+ * components within 1e-6 for angles up to 1e4 radians; angles within
+ * 1e-6 + 1e-7/|cos(middle angle)| radians away from gimbal lock, the
+ * rotation they describe within 1e-6 radians everywhere.
+ */
+MOT_EXTERN_FUNC void motQuatFromRadiansAry(MOT_QUAT* pQuats, const MOT_VEC* pRads, int n, E_MOT_RORD rord);
+MOT_EXTERN_FUNC void motQuatFromRadiansAryEx(MOT_QUAT* pQuats, const MOT_VEC* pRads, int n, E_MOT_RORD rord, E_MOT_SIMD simd);
+MOT_EXTERN_FUNC void motQuatFromDegreesAry(MOT_QUAT* pQuats, const MOT_VEC* pDegs, int n, E_MOT_RORD rord);
+MOT_EXTERN_FUNC void motQuatFromDegreesAryEx(MOT_QUAT* pQuats, const MOT_VEC* pDegs, int n, E_MOT_RORD rord, E_MOT_SIMD simd);
+MOT_EXTERN_FUNC void motQuatToRadiansAry(MOT_VEC* pRads, const MOT_QUAT* pQuats, int n, E_MOT_RORD rord);
+MOT_EXTERN_FUNC void motQuatToRadiansAryEx(MOT_VEC* pRads, const MOT_QUAT* pQuats, int n, E_MOT_RORD rord, E_MOT_SIMD simd);
+MOT_EXTERN_FUNC void motQuatToDegreesAry(MOT_VEC* pDegs, const MOT_QUAT* pQuats, int n, E_MOT_RORD rord);
+MOT_EXTERN_FUNC void motQuatToDegreesAryEx(MOT_VEC* pDegs, const MOT_QUAT* pQuats, int n, E_MOT_RORD rord, E_MOT_SIMD simd);
+
+MOT_EXTERN_FUNC E_MOT_SIMD motGetSIMD(void);
+MOT_EXTERN_FUNC int motSIMDCk(E_MOT_SIMD simd);
+MOT_EXTERN_FUNC const char* motSIMDName(E_MOT_SIMD simd);
+MOT_EXTERN_FUNC void motMakeAffineAryEx(MOT_AFFINE* pAff, const MOT_VEC* pTns, const MOT_QUAT* pRot, const MOT_VEC* pScl, int n, E_MOT_XORD xord, E_MOT_SIMD simd);
+
+/* name hash as stored in MOT_CLIP nodeHash; *pLen receives the name length */
+MOT_EXTERN_FUNC uint32_t motNameHash(uint32_t* pLen, const char* pName);
+/* number of channels in a track data/source mask */
+MOT_EXTERN_FUNC int motMaskChanCount(int mask);
 
 MOT_EXTERN_FUNC int motClipHeaderCk(const MOT_CLIP* pClip);
 MOT_EXTERN_FUNC int motClipNodeIdxCk(const MOT_CLIP* pClip, int nodeIdx);
@@ -140,3 +350,65 @@ MOT_EXTERN_FUNC MOT_VEC motEvalDegrees(const MOT_CLIP* pClip, int nodeIdx, float
 MOT_EXTERN_FUNC MOT_VEC motEvalPos(const MOT_CLIP* pClip, int nodeIdx, float frm);
 MOT_EXTERN_FUNC MOT_VEC motEvalScl(const MOT_CLIP* pClip, int nodeIdx, float frm);
 MOT_EXTERN_FUNC void motEvalTransform(MOT_MTX* pMtx, const MOT_CLIP* pClip, int nodeIdx, float frm, const MOT_VEC* pDefTns);
+MOT_EXTERN_FUNC void motEvalPose(const MOT_CLIP* pClip, float frm, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl);
+
+MOT_EXTERN_FUNC int motPoseAlloc(MOT_POSE* pPose, int njnt);
+MOT_EXTERN_FUNC void motPoseFree(MOT_POSE* pPose);
+MOT_EXTERN_FUNC void motPoseIdentity(MOT_POSE* pPose);
+MOT_EXTERN_FUNC void motPoseFromAry(MOT_POSE* pPose, const MOT_VEC* pPos, const MOT_QUAT* pRot, const MOT_VEC* pScl);
+MOT_EXTERN_FUNC void motPoseToAry(const MOT_POSE* pPose, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl);
+MOT_EXTERN_FUNC void motPoseBlend(MOT_POSE* pDst, const MOT_POSE* pSrc1, const MOT_POSE* pSrc2, float t, E_MOT_QBLEND mode);
+MOT_EXTERN_FUNC void motPoseBlendEx(MOT_POSE* pDst, const MOT_POSE* pSrc1, const MOT_POSE* pSrc2, float t, E_MOT_QBLEND mode, E_MOT_SIMD simd);
+
+MOT_EXTERN_FUNC void motEvalBlend(MOT_POSE* pPose, const MOT_LAYER* pLayers, int nlayers);
+
+MOT_EXTERN_FUNC int motSkelAlloc(MOT_SKEL* pSkel, int njnt, const int* pParents, const MOT_VEC* pRestTns);
+MOT_EXTERN_FUNC void motSkelFree(MOT_SKEL* pSkel);
+MOT_EXTERN_FUNC int motSkelBind(MOT_SKEL* pSkel, const MOT_CLIP* pClip, const char* const* ppNames);
+MOT_EXTERN_FUNC int motBindInit(MOT_BIND* pBind, const char* const* ppNames, int njnt);
+MOT_EXTERN_FUNC void motBindFree(MOT_BIND* pBind);
+MOT_EXTERN_FUNC int motBindClip(const MOT_BIND* pBind, const MOT_CLIP* pClip, int16_t* pNodeJnt, int16_t* pJntNode);
+MOT_EXTERN_FUNC size_t motBindLibSize(const MOT_LIB* pLib);
+MOT_EXTERN_FUNC int motBindLib(const MOT_BIND* pBind, const MOT_LIB* pLib, int16_t* pMaps, uint32_t* pOffs);
+MOT_EXTERN_FUNC void motSkelLocalXforms(const MOT_SKEL* pSkel, const MOT_CLIP* pClip, const MOT_VEC* pPos, const MOT_QUAT* pRot, const MOT_VEC* pScl, MOT_MTX* pLocal);
+MOT_EXTERN_FUNC void motSkelWorldXforms(const MOT_SKEL* pSkel, const MOT_MTX* pLocal, MOT_MTX* pWorld, const MOT_MTX* pRoot);
+
+MOT_EXTERN_FUNC MOT_CLIP* motClipQuantize(const MOT_CLIP* pClip, int qbits, float* pMaxErr);
+MOT_EXTERN_FUNC int motClipQuantCk(const MOT_CLIP* pClip);
+
+MOT_EXTERN_FUNC MOT_CLIP* motClipKeyReduce(const MOT_CLIP* pClip, const float* pTol, float* pMaxErr);
+MOT_EXTERN_FUNC int motClipKeyCk(const MOT_CLIP* pClip);
+
+MOT_EXTERN_FUNC void motRdftFwd(float* pA, float* pB, const float* pSmp, int stride, int nfrm);
+MOT_EXTERN_FUNC MOT_CLIP* motClipRdft(const MOT_CLIP* pClip, const float* pTol, float* pMaxErr);
+MOT_EXTERN_FUNC int motClipRdftCk(const MOT_CLIP* pClip);
+
+MOT_EXTERN_FUNC MOT_CLIP* motClipFrameMajor(const MOT_CLIP* pClip);
+MOT_EXTERN_FUNC int motClipFrameMajorCk(const MOT_CLIP* pClip);
+MOT_EXTERN_FUNC int motClipRowWidth(const MOT_CLIP* pClip);
+
+MOT_EXTERN_FUNC int motLibHeaderCk(const MOT_LIB* pLib);
+MOT_EXTERN_FUNC int motLibMemCk(const void* pMem, size_t size);
+MOT_EXTERN_FUNC MOT_LIB* motLibLoad(const char* pPath);
+MOT_EXTERN_FUNC void motLibFree(MOT_LIB* pLib);
+MOT_EXTERN_FUNC int motLibClipCount(const MOT_LIB* pLib);
+MOT_EXTERN_FUNC const MOT_CLIP* motLibGetClip(const MOT_LIB* pLib, int clipIdx);
+MOT_EXTERN_FUNC int motLibFindClip(const MOT_LIB* pLib, const char* pName);
+MOT_EXTERN_FUNC const MOT_CLIP* motLibFindClipPtr(const MOT_LIB* pLib, const char* pName);
+MOT_EXTERN_FUNC const char* motLibGetNodeName(const MOT_LIB* pLib, int nodeIdx);
+MOT_EXTERN_FUNC int motLibFindNode(const MOT_LIB* pLib, const char* pName);
+
+MOT_EXTERN_FUNC int motClipMemCk(const void* pMem, size_t size);
+MOT_EXTERN_FUNC int motFileMap(MOT_FMAP* pMap, const char* pPath);
+MOT_EXTERN_FUNC void motFileUnmap(MOT_FMAP* pMap);
+MOT_EXTERN_FUNC const MOT_CLIP* motClipMap(MOT_FMAP* pMap, const char* pPath);
+MOT_EXTERN_FUNC const MOT_LIB* motLibMap(MOT_FMAP* pMap, const char* pPath);
+
+MOT_EXTERN_FUNC int motSamplerInit(MOT_SAMPLER* pSmp, const MOT_CLIP* pClip);
+MOT_EXTERN_FUNC void motSamplerFree(MOT_SAMPLER* pSmp);
+MOT_EXTERN_FUNC void motSamplerSeek(MOT_SAMPLER* pSmp, float frm);
+MOT_EXTERN_FUNC void motSamplerAdvance(MOT_SAMPLER* pSmp, float dfrm);
+MOT_EXTERN_FUNC void motSamplerEval(MOT_SAMPLER* pSmp, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl);
+MOT_EXTERN_FUNC void motSamplerEvalNode(const MOT_SAMPLER* pSmp, int nodeIdx, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl);
+
+#endif /* MOTCLIP_H */
@@ -0,0 +1,668 @@
+/*
+ * Motion Clip benchmarks
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ */
+
+/*
+ * Self-contained: clips are generated in memory (no data files), every public
+ * evaluation path is timed over batches, and per-op p50/p99 times and
+ * throughput are written as JSON.
+ *
+ *   motclip_bench [-nodes:200] [-frames:120] [-masks:7,7,7] [-const:4] [-smp:200] [-out:res.json] [-dump:synth.mclp]
+ *
+ * masks are the srcMask of pos, rot and scl tracks, every const-th source
+ * channel is constant (0: all animated).
+ */
+
+#ifdef _MSC_VER
+#	define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN 1
+#	define NOMINMAX
+#	include <Windows.h>
+#endif
+
+#include <time.h>
+
+#include "motclip.h"
+
+typedef struct _BENCH_CFG {
+	int nnod;
+	int nfrm;
+	int masks[3];
+	int constStep;
+	int nsmp;
+	const char* pOutPath;
+	const char* pDumpPath;
+} BENCH_CFG;
+
+typedef struct _BENCH_CTX {
+	const MOT_CLIP* pClip;
+	int             nnod;
+	int             nfrm;
+	MOT_SAMPLER     smp;
+	MOT_SKEL        skel;
+	MOT_POSE        pose[3];
+	MOT_VEC*        pPos;
+	MOT_QUAT*       pRot;
+	MOT_VEC*        pScl;
+	MOT_QUAT*       pRot2;
+	MOT_VEC*        pVec;
+	MOT_MTX*        pMtx;
+	MOT_MTX*        pWorld;
+	MOT_AFFINE*     pAff;
+	const char**    ppNames;
+	int*            pParents;
+	uint32_t        seed;
+	double          sink;
+} BENCH_CTX;
+
+/* one batch of ops, returns their count */
+typedef int (*BENCH_FUNC)(BENCH_CTX* pCtx);
+
+typedef struct _BENCH {
+	const char* pName;
+	const char* pUnit;
+	BENCH_FUNC  func;
+} BENCH;
+
+static double timestamp() {
+	double us = 0.0;
+#if defined(_WIN32)
+	LARGE_INTEGER frq;
+	if (QueryPerformanceFrequency(&frq)) {
+		LARGE_INTEGER ctr;
+		QueryPerformanceCounter(&ctr);
+		us = ((double)ctr.QuadPart / (double)frq.QuadPart) * 1.0e6;
+	}
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec t;
+	if (clock_gettime(CLOCK_MONOTONIC, &t) != 0) {
+		clock_gettime(CLOCK_REALTIME, &t);
+	}
+	us = (double)t.tv_nsec*1.0e-3 + (double)t.tv_sec*1.0e6;
+#endif
+	return us;
+}
+
+static uint32_t benchRand(uint32_t* pSeed) {
+	*pSeed = *pSeed * 1664525U + 1013904223U;
+	return *pSeed >> 8;
+}
+
+static float benchFrm(BENCH_CTX* pCtx) {
+	return (float)benchRand(&pCtx->seed) * (float)pCtx->nfrm / 16777216.0f;
+}
+
+static int hashCmp(const void* p1, const void* p2) {
+	uint32_t h1 = *(const uint32_t*)p1;
+	uint32_t h2 = *(const uint32_t*)p2;
+	return h1 < h2 ? -1 : h1 > h2 ? 1 : 0;
+}
+
+/* smooth looping curves, rotations as log vectors well inside the half turn */
+static float synthVal(int inod, int kind, int chan, int f, int nfrm) {
+	float w = 6.2831853f * (float)f / (float)nfrm;
+	float ph = (float)(inod * 9 + kind * 3 + chan) * 0.7f;
+	switch (kind) {
+		case TRK_POS: return (float)(chan + 1) * sinf(w * (float)(1 + chan) + ph);
+		case TRK_ROT: return 0.5f * sinf(w * (float)(1 + (inod + chan) % 3) + ph);
+		default: break;
+	}
+	return 1.0f + 0.25f * sinf(w + ph);
+}
+
+/*
+ * Synthetic clip laid out as cMotClipWriter writes it:
+ * header, nodes in name hash order, hash table, track data, EVAL, SEQ.
+ */
+static MOT_CLIP* synthClip(const BENCH_CFG* pCfg) {
+	MOT_CLIP* pClip;
+	MOT_EVAL* pEval;
+	MOT_SEQ* pSeq;
+	uint8_t* pTop;
+	uint32_t* pOrd;
+	size_t nodesEnd, offs, size;
+	int i, f, kind, chan, pass, imap, iseq, ntrk, nchn;
+	int nnod = pCfg->nnod;
+	int nfrm = pCfg->nfrm;
+	int ich = 0;
+
+	/* masks first: the data size depends on them */
+	pClip = (MOT_CLIP*)calloc(1, offsetof(MOT_CLIP, nodes) + nnod * sizeof(MOT_NODE));
+	pOrd = (uint32_t*)malloc(nnod * 2 * sizeof(uint32_t));
+	if (!pClip || !pOrd) {
+		free(pClip);
+		free(pOrd);
+		return NULL;
+	}
+	for (i = 0; i < nnod; ++i) {
+		char name[32];
+		uint32_t len;
+		sprintf(name, "jnt%04d", i);
+		pOrd[i*2] = motNameHash(&len, name);
+		pOrd[i*2 + 1] = i;
+	}
+	qsort(pOrd, nnod, 2 * sizeof(uint32_t), hashCmp);
+	nodesEnd = offsetof(MOT_CLIP, nodes) + nnod * sizeof(MOT_NODE);
+	offs = nodesEnd + nnod * sizeof(uint32_t);
+	ntrk = 0;
+	nchn = 0;
+	for (i = 0; i < nnod; ++i) {
+		MOT_NODE* pNode = &pClip->nodes[i];
+		sprintf(pNode->name.chr, "jnt%04d", pOrd[i*2 + 1]);
+		pNode->name.len = (uint8_t)strlen(pNode->name.chr);
+		pNode->xord = (uint8_t)(pOrd[i*2 + 1] % 6);
+		pNode->rord = (uint8_t)((pOrd[i*2 + 1] / 6) % 6);
+		for (kind = 0; kind < 3; ++kind) {
+			MOT_TRACK* pTrk = &pNode->trk[kind];
+			pTrk->srcMask = (uint8_t)(pCfg->masks[kind] & 7);
+			for (chan = 0; chan < 3; ++chan) {
+				if (!(pTrk->srcMask & (1 << chan))) continue;
+				++ich;
+				if (pCfg->constStep <= 0 || ich % pCfg->constStep) {
+					pTrk->dataMask |= 1 << chan;
+				}
+			}
+			pTrk->stride = (uint8_t)motMaskChanCount(pTrk->dataMask);
+			if (pTrk->srcMask) {
+				++ntrk;
+				nchn += motMaskChanCount(pTrk->srcMask);
+			}
+			if (pTrk->dataMask) {
+				offs += (size_t)nfrm * pTrk->stride * sizeof(float);
+			}
+		}
+	}
+	size = offs + offsetof(MOT_EVAL, map) + nchn * sizeof(MOT_CMAP) + ntrk * 3 * sizeof(MOT_SEQ);
+	pTop = (uint8_t*)realloc(pClip, size);
+	if (!pTop) {
+		free(pClip);
+		free(pOrd);
+		return NULL;
+	}
+	pClip = (MOT_CLIP*)pTop;
+	memset(pTop + nodesEnd, 0, size - nodesEnd);
+	memcpy(pClip->fmt, "MCLP", 4);
+	pClip->size = (uint32_t)size;
+	pClip->rate = 30.0f;
+	pClip->nfrm = nfrm;
+	pClip->nnod = nnod;
+	sprintf(pClip->name.chr, "synth_%d_%d", nnod, nfrm);
+	pClip->name.len = (uint8_t)strlen(pClip->name.chr);
+	pClip->hash = (uint32_t)nodesEnd;
+	for (i = 0; i < nnod; ++i) {
+		((uint32_t*)(pTop + pClip->hash))[i] = pOrd[i*2];
+	}
+
+	/* track data, vmin/vmax over the constant channels too */
+	offs = nodesEnd + nnod * sizeof(uint32_t);
+	for (i = 0; i < nnod; ++i) {
+		MOT_NODE* pNode = &pClip->nodes[i];
+		int inod = (int)pOrd[i*2 + 1];
+		for (kind = 0; kind < 3; ++kind) {
+			MOT_TRACK* pTrk = &pNode->trk[kind];
+			float* pDst = (float*)(pTop + offs);
+			for (chan = 0; chan < 3; ++chan) {
+				float v = synthVal(inod, kind, chan, 0, nfrm);
+				if (!(pTrk->srcMask & (1 << chan))) {
+					v = kind == TRK_SCL ? 1.0f : 0.0f;
+				}
+				pTrk->vmin.s[chan] = v;
+				pTrk->vmax.s[chan] = v;
+			}
+			if (!pTrk->dataMask) continue;
+			pNode->offs[kind] = (uint32_t)offs;
+			for (f = 0; f < nfrm; ++f) {
+				for (chan = 0; chan < 3; ++chan) {
+					float v;
+					if (!(pTrk->dataMask & (1 << chan))) continue;
+					v = synthVal(inod, kind, chan, f, nfrm);
+					pTrk->vmin.s[chan] = fminf(pTrk->vmin.s[chan], v);
+					pTrk->vmax.s[chan] = fmaxf(pTrk->vmax.s[chan], v);
+					*pDst++ = v;
+				}
+			}
+			offs += (size_t)nfrm * pTrk->stride * sizeof(float);
+		}
+	}
+
+	/* EVAL: counts, then curves followed by constants, each in kind, node, channel order */
+	pClip->eval = (uint32_t)offs;
+	pEval = (MOT_EVAL*)(pTop + offs);
+	imap = 0;
+	for (pass = 0; pass < 2; ++pass) {
+		for (kind = 0; kind < 3; ++kind) {
+			for (i = 0; i < nnod; ++i) {
+				const MOT_TRACK* pTrk = &pClip->nodes[i].trk[kind];
+				if (pass == 0 && pTrk->srcMask) {
+					++pEval->ntrk[kind];
+					pEval->nchn[kind] += motMaskChanCount(pTrk->srcMask);
+					pEval->ncrv[kind] += motMaskChanCount(pTrk->dataMask);
+				}
+				for (chan = 0; chan < 3; ++chan) {
+					int crv = (pTrk->dataMask >> chan) & 1;
+					if (!(pTrk->srcMask & (1 << chan)) || crv == pass) continue;
+					pEval->map[imap].node = (uint16_t)i;
+					pEval->map[imap].kind = (uint8_t)kind;
+					pEval->map[imap].chan = (uint8_t)chan;
+					++imap;
+				}
+			}
+		}
+	}
+
+	/* SEQ: 3 entries per track, data channel or its vmin, 0 for missing channels */
+	pClip->seq = (uint32_t)(offs + offsetof(MOT_EVAL, map) + nchn * sizeof(MOT_CMAP));
+	pSeq = (MOT_SEQ*)(pTop + pClip->seq);
+	iseq = 0;
+	for (kind = 0; kind < 3; ++kind) {
+		for (i = 0; i < nnod; ++i) {
+			const MOT_NODE* pNode = &pClip->nodes[i];
+			const MOT_TRACK* pTrk = &pNode->trk[kind];
+			int col = 0;
+			if (!pTrk->srcMask) continue;
+			for (chan = 0; chan < 3; ++chan) {
+				MOT_SEQ* pEnt = &pSeq[iseq++];
+				pEnt->node = (uint16_t)i;
+				pEnt->chan = (uint8_t)chan;
+				if (!(pTrk->srcMask & (1 << chan))) continue;
+				if (pTrk->dataMask & (1 << chan)) {
+					pEnt->offs = pNode->offs[kind] + col * sizeof(float);
+					pEnt->stride = pTrk->stride;
+					++col;
+				} else {
+					pEnt->offs = (uint32_t)((const uint8_t*)&pTrk->vmin.s[chan] - pTop);
+				}
+			}
+		}
+	}
+	free(pOrd);
+	return pClip;
+}
+
+static int benchEvalPose(BENCH_CTX* pCtx) {
+	int i;
+	for (i = 0; i < 4; ++i) {
+		motEvalPose(pCtx->pClip, benchFrm(pCtx), pCtx->pPos, pCtx->pRot, pCtx->pScl);
+	}
+	pCtx->sink += pCtx->pRot[0].w;
+	return 4;
+}
+
+static int benchSampler(BENCH_CTX* pCtx) {
+	int i;
+	for (i = 0; i < 4; ++i) {
+		motSamplerAdvance(&pCtx->smp, 0.25f);
+		motSamplerEval(&pCtx->smp, pCtx->pPos, pCtx->pRot, pCtx->pScl);
+	}
+	pCtx->sink += pCtx->pRot[0].w;
+	return 4;
+}
+
+static int benchSamplerNode(BENCH_CTX* pCtx) {
+	int i;
+	motSamplerSeek(&pCtx->smp, benchFrm(pCtx));
+	for (i = 0; i < pCtx->nnod; ++i) {
+		motSamplerEvalNode(&pCtx->smp, i, &pCtx->pPos[i], &pCtx->pRot[i], &pCtx->pScl[i]);
+	}
+	pCtx->sink += pCtx->pRot[0].w;
+	return pCtx->nnod;
+}
+
+static int benchEvalPos(BENCH_CTX* pCtx) {
+	float frm = benchFrm(pCtx);
+	int i;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		pCtx->pPos[i] = motEvalPos(pCtx->pClip, i, frm);
+	}
+	pCtx->sink += pCtx->pPos[0].x;
+	return pCtx->nnod;
+}
+
+static int benchEvalQuat(BENCH_CTX* pCtx) {
+	float frm = benchFrm(pCtx);
+	int i;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		pCtx->pRot[i] = motEvalQuat(pCtx->pClip, i, frm);
+	}
+	pCtx->sink += pCtx->pRot[0].w;
+	return pCtx->nnod;
+}
+
+static int benchEvalQuatSlerp(BENCH_CTX* pCtx) {
+	float frm = benchFrm(pCtx);
+	int i;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		pCtx->pRot[i] = motEvalQuatSlerp(pCtx->pClip, i, frm);
+	}
+	pCtx->sink += pCtx->pRot[0].w;
+	return pCtx->nnod;
+}
+
+static int benchEvalDegrees(BENCH_CTX* pCtx) {
+	float frm = benchFrm(pCtx);
+	int i;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		pCtx->pVec[i] = motEvalDegrees(pCtx->pClip, i, frm);
+	}
+	pCtx->sink += pCtx->pVec[0].x;
+	return pCtx->nnod;
+}
+
+static int benchEvalScl(BENCH_CTX* pCtx) {
+	float frm = benchFrm(pCtx);
+	int i;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		pCtx->pScl[i] = motEvalScl(pCtx->pClip, i, frm);
+	}
+	pCtx->sink += pCtx->pScl[0].x;
+	return pCtx->nnod;
+}
+
+static int benchEvalTransform(BENCH_CTX* pCtx) {
+	float frm = benchFrm(pCtx);
+	int i;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		motEvalTransform(&pCtx->pMtx[i], pCtx->pClip, i, frm, NULL);
+	}
+	pCtx->sink += pCtx->pMtx[0][3][0];
+	return pCtx->nnod;
+}
+
+static int benchMakeTransform(BENCH_CTX* pCtx) {
+	int i;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		motMakeTransform(&pCtx->pMtx[i], pCtx->pPos[i], pCtx->pRot[i], pCtx->pScl[i], (E_MOT_XORD)(i % 6));
+	}
+	pCtx->sink += pCtx->pMtx[0][3][0];
+	return pCtx->nnod;
+}
+
+static int benchMakeAffineAry(BENCH_CTX* pCtx) {
+	motMakeAffineAry(pCtx->pAff, pCtx->pPos, pCtx->pRot, pCtx->pScl, pCtx->nnod, XORD_SRT);
+	pCtx->sink += pCtx->pAff[0][0][3];
+	return pCtx->nnod;
+}
+
+static int benchSkelXforms(BENCH_CTX* pCtx) {
+	motSkelLocalXforms(&pCtx->skel, pCtx->pClip, pCtx->pPos, pCtx->pRot, pCtx->pScl, pCtx->pMtx);
+	motSkelWorldXforms(&pCtx->skel, pCtx->pMtx, pCtx->pWorld, NULL);
+	pCtx->sink += pCtx->pWorld[0][3][0];
+	return pCtx->nnod;
+}
+
+static int benchQuatSlerp(BENCH_CTX* pCtx) {
+	int i;
+	float t = (float)benchRand(&pCtx->seed) / 16777216.0f;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		pCtx->pRot[i] = motQuatSlerp(pCtx->pRot[i], pCtx->pRot2[i], t);
+	}
+	pCtx->sink += pCtx->pRot[0].w;
+	return pCtx->nnod;
+}
+
+static int benchQuatExpAry(BENCH_CTX* pCtx) {
+	motQuatExpAry(pCtx->pRot, pCtx->pVec, pCtx->nnod);
+	pCtx->sink += pCtx->pRot[0].w;
+	return pCtx->nnod;
+}
+
+static int benchQuatFromDegrees(BENCH_CTX* pCtx) {
+	int i;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		const MOT_VEC* pDeg = &pCtx->pVec[i];
+		pCtx->pRot[i] = motQuatFromDegrees(pDeg->x, pDeg->y, pDeg->z, (E_MOT_RORD)(i % 6));
+	}
+	pCtx->sink += pCtx->pRot[0].w;
+	return pCtx->nnod;
+}
+
+static int benchQuatToDegrees(BENCH_CTX* pCtx) {
+	int i;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		pCtx->pScl[i] = motQuatToDegrees(pCtx->pRot2[i], (E_MOT_RORD)(i % 6));
+	}
+	pCtx->sink += pCtx->pScl[0].x;
+	return pCtx->nnod;
+}
+
+static int benchPoseBlend(BENCH_CTX* pCtx) {
+	float t = (float)benchRand(&pCtx->seed) / 16777216.0f;
+	motPoseBlend(&pCtx->pose[2], &pCtx->pose[0], &pCtx->pose[1], t, QBLEND_NLERP_FIX);
+	pCtx->sink += pCtx->pose[2].pRot[3][0];
+	return pCtx->nnod;
+}
+
+static int benchFindClipNode(BENCH_CTX* pCtx) {
+	int i;
+	int n = 0;
+	for (i = 0; i < pCtx->nnod; ++i) {
+		n += motFindClipNode(pCtx->pClip, pCtx->ppNames[i]);
+	}
+	pCtx->sink += (double)n;
+	return pCtx->nnod;
+}
+
+static const BENCH s_benchs[] = {
+	{ "EvalPose", "pose", benchEvalPose },
+	{ "SamplerEval", "pose", benchSampler },
+	{ "SamplerEvalNode", "node", benchSamplerNode },
+	{ "EvalPos", "node", benchEvalPos },
+	{ "EvalQuat", "node", benchEvalQuat },
+	{ "EvalQuatSlerp", "node", benchEvalQuatSlerp },
+	{ "EvalDegrees", "node", benchEvalDegrees },
+	{ "EvalScl", "node", benchEvalScl },
+	{ "EvalTransform", "node", benchEvalTransform },
+	{ "MakeTransform", "node", benchMakeTransform },
+	{ "MakeAffineAry", "node", benchMakeAffineAry },
+	{ "SkelXforms", "joint", benchSkelXforms },
+	{ "QuatSlerp", "quat", benchQuatSlerp },
+	{ "QuatExpAry", "quat", benchQuatExpAry },
+	{ "QuatFromDegrees", "quat", benchQuatFromDegrees },
+	{ "QuatToDegrees", "quat", benchQuatToDegrees },
+	{ "PoseBlend", "joint", benchPoseBlend },
+	{ "FindClipNode", "name", benchFindClipNode }
+};
+
+static int ctxInit(BENCH_CTX* pCtx, const MOT_CLIP* pClip) {
+	int i, nnod;
+	memset(pCtx, 0, sizeof(BENCH_CTX));
+	pCtx->pClip = pClip;
+	nnod = pClip->nnod;
+	pCtx->nnod = nnod;
+	pCtx->nfrm = pClip->nfrm;
+	pCtx->seed = 1;
+	pCtx->pPos = (MOT_VEC*)malloc(nnod * sizeof(MOT_VEC));
+	pCtx->pRot = (MOT_QUAT*)malloc(nnod * sizeof(MOT_QUAT));
+	pCtx->pScl = (MOT_VEC*)malloc(nnod * sizeof(MOT_VEC));
+	pCtx->pRot2 = (MOT_QUAT*)malloc(nnod * sizeof(MOT_QUAT));
+	pCtx->pVec = (MOT_VEC*)malloc(nnod * sizeof(MOT_VEC));
+	pCtx->pMtx = (MOT_MTX*)malloc(nnod * sizeof(MOT_MTX));
+	pCtx->pWorld = (MOT_MTX*)malloc(nnod * sizeof(MOT_MTX));
+	pCtx->pAff = (MOT_AFFINE*)malloc(nnod * sizeof(MOT_AFFINE));
+	pCtx->ppNames = (const char**)malloc(nnod * sizeof(char*));
+	pCtx->pParents = (int*)malloc(nnod * sizeof(int));
+	if (!pCtx->pPos || !pCtx->pRot || !pCtx->pScl || !pCtx->pRot2 || !pCtx->pVec || !pCtx->pMtx
+	    || !pCtx->pWorld || !pCtx->pAff || !pCtx->ppNames || !pCtx->pParents) return 0;
+	if (!motSamplerInit(&pCtx->smp, pClip)) return 0;
+	for (i = 0; i < 3; ++i) {
+		if (!motPoseAlloc(&pCtx->pose[i], nnod)) return 0;
+	}
+	/* binary tree hierarchy over the nodes */
+	for (i = 0; i < nnod; ++i) {
+		pCtx->ppNames[i] = pClip->nodes[i].name.chr;
+		pCtx->pParents[i] = i > 0 ? (i - 1) / 2 : -1;
+	}
+	if (!motSkelAlloc(&pCtx->skel, nnod, pCtx->pParents, NULL)) return 0;
+	motSkelBind(&pCtx->skel, pClip, pCtx->ppNames);
+	motEvalPose(pClip, 0.0f, pCtx->pPos, pCtx->pRot, pCtx->pScl);
+	motPoseFromAry(&pCtx->pose[0], pCtx->pPos, pCtx->pRot, pCtx->pScl);
+	motEvalPose(pClip, (float)pClip->nfrm * 0.5f, pCtx->pPos, pCtx->pRot2, pCtx->pScl);
+	motPoseFromAry(&pCtx->pose[1], pCtx->pPos, pCtx->pRot2, pCtx->pScl);
+	for (i = 0; i < nnod; ++i) {
+		pCtx->pVec[i] = motQuatToDegrees(pCtx->pRot2[i], RORD_XYZ);
+	}
+	return 1;
+}
+
+static void ctxFree(BENCH_CTX* pCtx) {
+	int i;
+	motSamplerFree(&pCtx->smp);
+	motSkelFree(&pCtx->skel);
+	for (i = 0; i < 3; ++i) {
+		motPoseFree(&pCtx->pose[i]);
+	}
+	free(pCtx->pPos);
+	free(pCtx->pRot);
+	free(pCtx->pScl);
+	free(pCtx->pRot2);
+	free(pCtx->pVec);
+	free(pCtx->pMtx);
+	free(pCtx->pWorld);
+	free(pCtx->pAff);
+	free((void*)pCtx->ppNames);
+	free(pCtx->pParents);
+}
+
+static int smpCmp(const void* pA, const void* pB) {
+	double a = *(const double*)pA;
+	double b = *(const double*)pB;
+	return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static double pctl(const double* pSorted, int n, double p) {
+	int i = (int)(p * (double)(n - 1) + 0.5);
+	return pSorted[i < n ? i : n - 1];
+}
+
+/* nsmp timed batches of at least ~20us each after a warm-up, ns per op */
+static void benchRun(BENCH_CTX* pCtx, const BENCH* pBench, int nsmp, FILE* pOut, int last) {
+	double* pSmps = (double*)malloc(nsmp * sizeof(double));
+	double t0, t1, dt, total;
+	long long nops = 0;
+	int ismp, k, nrep, nop;
+	if (!pSmps) return;
+	nrep = 1;
+	t0 = timestamp();
+	nop = pBench->func(pCtx);
+	dt = timestamp() - t0;
+	if (dt < 20.0) {
+		nrep = (int)(20.0 / (dt > 0.05 ? dt : 0.05)) + 1;
+	}
+	total = 0.0;
+	for (ismp = 0; ismp < nsmp; ++ismp) {
+		nop = 0;
+		t0 = timestamp();
+		for (k = 0; k < nrep; ++k) {
+			nop += pBench->func(pCtx);
+		}
+		t1 = timestamp();
+		pSmps[ismp] = (t1 - t0) * 1.0e3 / (double)nop;
+		total += t1 - t0;
+		nops += nop;
+	}
+	qsort(pSmps, nsmp, sizeof(double), smpCmp);
+	fprintf(pOut, "    { \"name\": \"%s\", \"unit\": \"%s\", \"ops\": %lld, \"p50_ns\": %.2f, \"p99_ns\": %.2f, \"ops_per_sec\": %.0f }%s\n",
+	        pBench->pName, pBench->pUnit, nops, pctl(pSmps, nsmp, 0.5), pctl(pSmps, nsmp, 0.99),
+	        total > 0.0 ? (double)nops * 1.0e6 / total : 0.0, last ? "" : ",");
+	free(pSmps);
+}
+
+static int optInt(const char* pArg, const char* pName, int* pVal) {
+	size_t len = strlen(pName);
+	if (strncmp(pArg, pName, len) != 0) return 0;
+	*pVal = atoi(pArg + len);
+	return 1;
+}
+
+static void parseArgs(BENCH_CFG* pCfg, int argc, char* argv[]) {
+	int i;
+	pCfg->nnod = 200;
+	pCfg->nfrm = 120;
+	pCfg->masks[0] = 7;
+	pCfg->masks[1] = 7;
+	pCfg->masks[2] = 7;
+	pCfg->constStep = 4;
+	pCfg->nsmp = 200;
+	pCfg->pOutPath = NULL;
+	pCfg->pDumpPath = NULL;
+	for (i = 1; i < argc; ++i) {
+		const char* pArg = argv[i];
+		if (optInt(pArg, "-nodes:", &pCfg->nnod)) continue;
+		if (optInt(pArg, "-frames:", &pCfg->nfrm)) continue;
+		if (optInt(pArg, "-const:", &pCfg->constStep)) continue;
+		if (optInt(pArg, "-smp:", &pCfg->nsmp)) continue;
+		if (strncmp(pArg, "-masks:", 7) == 0) {
+			sscanf(pArg + 7, "%d,%d,%d", &pCfg->masks[0], &pCfg->masks[1], &pCfg->masks[2]);
+		} else if (strncmp(pArg, "-out:", 5) == 0) {
+			pCfg->pOutPath = pArg + 5;
+		} else if (strncmp(pArg, "-dump:", 6) == 0) {
+			pCfg->pDumpPath = pArg + 6;
+		} else {
+			fprintf(stderr, "unknown option: %s\n", pArg);
+		}
+	}
+	pCfg->nnod = pCfg->nnod < 1 ? 1 : pCfg->nnod > 0x7FFF ? 0x7FFF : pCfg->nnod;
+	pCfg->nfrm = pCfg->nfrm < 2 ? 2 : pCfg->nfrm;
+	pCfg->nsmp = pCfg->nsmp < 1 ? 1 : pCfg->nsmp;
+}
+
+int main(int argc, char* argv[]) {
+	BENCH_CFG cfg;
+	BENCH_CTX ctx;
+	MOT_CLIP* pClip;
+	const MOT_EVAL* pEval;
+	FILE* pOut = stdout;
+	int i, nbench, ncrv;
+	parseArgs(&cfg, argc, argv);
+	pClip = synthClip(&cfg);
+	if (!pClip || !motClipMemCk(pClip, pClip->size)) {
+		fprintf(stderr, "bad synthetic clip\n");
+		free(pClip);
+		return 1;
+	}
+	if (cfg.pDumpPath) {
+		FILE* pDump = fopen(cfg.pDumpPath, "wb");
+		if (pDump) {
+			fwrite(pClip, pClip->size, 1, pDump);
+			fclose(pDump);
+		}
+	}
+	if (!ctxInit(&ctx, pClip)) {
+		fprintf(stderr, "out of memory\n");
+		ctxFree(&ctx);
+		free(pClip);
+		return 1;
+	}
+	if (cfg.pOutPath) {
+		pOut = fopen(cfg.pOutPath, "w");
+		if (!pOut) {
+			fprintf(stderr, "can't open %s\n", cfg.pOutPath);
+			pOut = stdout;
+		}
+	}
+	nbench = (int)(sizeof(s_benchs) / sizeof(s_benchs[0]));
+	pEval = motGetEvalInfo(pClip);
+	ncrv = pEval ? (int)(pEval->ncrv[0] + pEval->ncrv[1] + pEval->ncrv[2]) : 0;
+	fprintf(pOut, "{\n");
+	fprintf(pOut, "  \"simd\": \"%s\",\n", motSIMDName(motGetSIMD()));
+	fprintf(pOut, "  \"clip\": { \"nodes\": %d, \"frames\": %d, \"masks\": [%d, %d, %d], \"const\": %d, \"curves\": %d, \"bytes\": %d },\n",
+	        cfg.nnod, cfg.nfrm, cfg.masks[0], cfg.masks[1], cfg.masks[2], cfg.constStep, ncrv, (int)pClip->size);
+	fprintf(pOut, "  \"samples\": %d,\n", cfg.nsmp);
+	fprintf(pOut, "  \"benchmarks\": [\n");
+	for (i = 0; i < nbench; ++i) {
+		benchRun(&ctx, &s_benchs[i], cfg.nsmp, pOut, i == nbench - 1);
+	}
+	fprintf(pOut, "  ],\n");
+	fprintf(pOut, "  \"sink\": %g\n", ctx.sink);
+	fprintf(pOut, "}\n");
+	if (pOut != stdout) {
+		fclose(pOut);
+	}
+	ctxFree(&ctx);
+	free(pClip);
+	return 0;
+}
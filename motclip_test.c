@@ -9,8 +9,23 @@
 #endif
 
 #include <time.h>
+#include <stdarg.h>
+
+#if defined(__linux__)
+#	include <linux/perf_event.h>
+#	include <sys/ioctl.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
 
 #include "motclip.h"
+#include "motcrowd.h"
+#include "motpsq.h"
+#include "motrdft.h"
+#include "motstream.h"
+#include "motbuild.h"
+#include "mothclip.h"
+#include "motbclip.h"
 
 #if defined(_MSC_VER)
 #	define D_INLINE __forceinline
@@ -187,6 +202,7 @@ static void perfFindClipNode(MOT_CLIP* pClip) {
 typedef struct _PERF_RES {
 	double dt;
 	double sum;
+	float err;
 } PERF_RES;
 
 float qmag(MOT_QUAT q) {
@@ -201,15 +217,17 @@ void qexpAryLoop(MOT_QUAT* pQuats, const MOT_VEC* pVecs, int n) {
 	}
 }
 
-static D_NOINLINE PERF_RES perfQuatArySub(MOT_CLIP* pClip, int aryFlg) {
+static D_NOINLINE PERF_RES perfQuatArySub(MOT_CLIP* pClip, int simd) {
 	PERF_RES perf;
 	double smps[N_PERF_SMP];
 	int ismp;
 	double t0, t1;
 	double qsum = 0;
+	float maxErr = 0.0f;
 	int nfrm = pClip->nfrm;
 	int nrot = motClipTrackCount(pClip, TRK_ROT);
 	MOT_QUAT* pQuats = allocQuats(nrot);
+	MOT_QUAT* pRefQuats = allocQuats(nrot);
 	MOT_VEC* pVecs = allocVecs(nrot);
 	double* pSubSmps = (double*)malloc(nfrm * sizeof(double));
 	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
@@ -226,8 +244,8 @@ static D_NOINLINE PERF_RES perfQuatArySub(MOT_CLIP* pClip, int aryFlg) {
 				fprintf(stderr, "rot count mismatch\n");
 			}
 			t0 = timestamp();
-			if (aryFlg) {
-				motQuatExpAry(pQuats, pVecs, nrot);
+			if (simd >= 0) {
+				motQuatExpAryEx(pQuats, pVecs, nrot, (E_MOT_SIMD)simd);
 			} else {
 				qexpAryLoop(pQuats, pVecs, nrot);
 			}
@@ -236,166 +254,3570 @@ static D_NOINLINE PERF_RES perfQuatArySub(MOT_CLIP* pClip, int aryFlg) {
 			for (i = 0; i < nrot; ++i) {
 				qsum += qmag(pQuats[i]);
 			}
+			if (ismp == 0) {
+				qexpAryLoop(pRefQuats, pVecs, nrot);
+				for (i = 0; i < nrot; ++i) {
+					int j;
+					for (j = 0; j < 4; ++j) {
+						maxErr = fmaxf(maxErr, fabsf(pQuats[i].s[j] - pRefQuats[i].s[j]));
+					}
+				}
+			}
 		}
 		smps[ismp] = perfsmp(pSubSmps, nfrm);
 	}
 	free(pSubSmps);
 	free(pQuats);
+	free(pRefQuats);
 	free(pVecs);
 	perf.sum = qsum;
 	perf.dt = perfsmp(smps, N_PERF_SMP);
+	perf.err = maxErr;
 	return perf;
 }
 
 static void perfQuatAry(MOT_CLIP* pClip) {
 	if (pClip) {
-		PERF_RES resLoop = perfQuatArySub(pClip, 0);
-		PERF_RES resVect = perfQuatArySub(pClip, 1);
+		static const E_MOT_SIMD simds[] = { SIMD_NONE, SIMD_BLOCK, SIMD_SSE4, SIMD_AVX2, SIMD_NEON };
+		int i;
+		PERF_RES resLoop = perfQuatArySub(pClip, -1);
 		printf("Loop: sum = %f, dt = %f\n", resLoop.sum, resLoop.dt);
-		printf("Vect: sum = %f, dt = %f\n", resVect.sum, resVect.dt);
-		printf("ratio: %f\n", resLoop.dt / resVect.dt);
+		for (i = 0; i < (int)(sizeof(simds) / sizeof(simds[0])); ++i) {
+			E_MOT_SIMD simd = simds[i];
+			if (motSIMDCk(simd)) {
+				PERF_RES resVect = perfQuatArySub(pClip, (int)simd);
+				printf("Vect[%s]%s: sum = %f, dt = %f, ratio = %f, max err = %e\n",
+				       motSIMDName(simd), simd == motGetSIMD() ? "*" : "",
+				       resVect.sum, resVect.dt, resLoop.dt / resVect.dt, resVect.err);
+			}
+		}
 	}
 }
 
-static void printSeqEntry(MOT_CLIP* pClip, MOT_SEQ* pSeq, const char* pTrkName) {
-	int inod = pSeq->node;
-	char* pNodeName = pClip->nodes[inod].name.chr;
-	printf("  %s:%s[%d]: ", pNodeName, pTrkName, pSeq->chan);
-	if (pSeq->offs) {
-		if (pSeq->stride) {
-			printf("data @ 0x%X, stride = %d", pSeq->offs, pSeq->stride);
-		} else {
-			printf("const @ 0x%X", pSeq->offs);
+#define N_EULER_RND (4093) /* with tails for the vector widths */
+#define N_EULER_SUB (4)
+
+static float eulerRnd(uint32_t* pSeed, float lim) {
+	*pSeed = *pSeed * 1664525U + 1013904223U;
+	return ((float)(*pSeed >> 8) / 16777216.0f * 2.0f - 1.0f) * lim;
+}
+
+/* angle between the rotations */
+static float quatAngErr(const MOT_QUAT q1, const MOT_QUAT q2) {
+	double d = 0.0;
+	double u = 0.0;
+	double v = 0.0;
+	int i;
+	for (i = 0; i < 4; ++i) {
+		d += (double)q1.s[i] * q2.s[i];
+	}
+	d = d < 0.0 ? -1.0 : 1.0;
+	for (i = 0; i < 4; ++i) {
+		double a = q1.s[i] - q2.s[i]*d;
+		double b = q1.s[i] + q2.s[i]*d;
+		u += a * a;
+		v += b * b;
+	}
+	return (float)(2.0 * atan2(sqrt(u), sqrt(v)));
+}
+
+static float angDiff(float a, float b) {
+	return (float)fabs(remainder((double)a - b, 2.0 * MOT_PI));
+}
+
+static void verifyEulerAry(void) {
+	static const E_MOT_SIMD simds[] = { SIMD_NONE, SIMD_BLOCK, SIMD_SSE4, SIMD_AVX2, SIMD_NEON };
+	/* middle axis of each rotation order */
+	static const int midAx[] = { 1, 2, 0, 2, 0, 1 };
+	const float pi = (float)MOT_PI;
+	MOT_VEC* pRads = allocVecs(N_EULER_RND);
+	MOT_VEC* pRes = allocVecs(N_EULER_RND);
+	MOT_QUAT* pRefQuats = allocQuats(N_EULER_RND);
+	MOT_QUAT* pQuats = allocQuats(N_EULER_RND);
+	int rord, isimd, i, j;
+	for (isimd = 0; isimd < (int)(sizeof(simds) / sizeof(simds[0])); ++isimd) {
+		E_MOT_SIMD simd = simds[isimd];
+		float qErr = 0.0f;
+		float bigErr = 0.0f;
+		float angErr = 0.0f;
+		float rotErr = 0.0f;
+		int nover = 0;
+		if (!motSIMDCk(simd)) continue;
+		for (rord = RORD_XYZ; rord <= RORD_ZYX; ++rord) {
+			uint32_t seed = 1 + rord;
+			/* general angles, then gimbal lock, single axis and identity cases */
+			for (i = 0; i < N_EULER_RND; ++i) {
+				for (j = 0; j < 3; ++j) {
+					pRads[i].s[j] = eulerRnd(&seed, pi);
+				}
+				if (i % 8 == 1) {
+					pRads[i].s[midAx[rord]] = pi * 0.5f * (i & 8 ? -1.0f : 1.0f);
+				} else if (i % 8 == 2) {
+					pRads[i].s[(i >> 3) % 3] = 0.0f;
+					pRads[i].s[((i >> 3) + 1) % 3] = 0.0f;
+				} else if (i % 64 == 3) {
+					pRads[i].x = pRads[i].y = pRads[i].z = 0.0f;
+				}
+				pRefQuats[i] = motQuatFromRadians(pRads[i].x, pRads[i].y, pRads[i].z, (E_MOT_RORD)rord);
+			}
+			motQuatFromRadiansAryEx(pQuats, pRads, N_EULER_RND, (E_MOT_RORD)rord, simd);
+			for (i = 0; i < N_EULER_RND; ++i) {
+				for (j = 0; j < 4; ++j) {
+					qErr = fmaxf(qErr, fabsf(pQuats[i].s[j] - pRefQuats[i].s[j]));
+				}
+			}
+			motQuatToRadiansAryEx(pRes, pRefQuats, N_EULER_RND, (E_MOT_RORD)rord, simd);
+			for (i = 0; i < N_EULER_RND; ++i) {
+				/* single axis angles are the source ones, motQuatToRadians takes them from acos(w) */
+				int single = i % 8 == 2 || i % 64 == 3;
+				MOT_VEC ref = single ? pRads[i] : motQuatToRadians(pRefQuats[i], (E_MOT_RORD)rord);
+				MOT_QUAT q = motQuatFromRadians(pRes[i].x, pRes[i].y, pRes[i].z, (E_MOT_RORD)rord);
+				float c = fabsf(cosf(ref.s[midAx[rord]]));
+				for (j = 0; j < 3; ++j) {
+					float d = angDiff(pRes[i].s[j], ref.s[j]);
+					/* only the rotation is defined at gimbal lock */
+					if (c > 0.1f) angErr = fmaxf(angErr, d);
+					if (c > 1.0e-3f) nover += d > 1.0e-6f + 1.0e-7f / c;
+				}
+				rotErr = fmaxf(rotErr, quatAngErr(q, pRefQuats[i]));
+			}
+			/* large angles */
+			for (i = 0; i < N_EULER_RND; ++i) {
+				for (j = 0; j < 3; ++j) {
+					pRads[i].s[j] = eulerRnd(&seed, 1.0e4f);
+				}
+				pRefQuats[i] = motQuatFromRadians(pRads[i].x, pRads[i].y, pRads[i].z, (E_MOT_RORD)rord);
+			}
+			motQuatFromRadiansAryEx(pQuats, pRads, N_EULER_RND, (E_MOT_RORD)rord, simd);
+			for (i = 0; i < N_EULER_RND; ++i) {
+				for (j = 0; j < 4; ++j) {
+					bigErr = fmaxf(bigErr, fabsf(pQuats[i].s[j] - pRefQuats[i].s[j]));
+				}
+			}
 		}
-	} else {
-		printf("--");
+		if (qErr > 1.0e-6f || bigErr > 1.0e-6f || nover || rotErr > 1.0e-6f) {
+			fprintf(stderr, "[ERR] EulerAry[%s]: quat err = %e (%e large), %d angles over bound, rotation err = %e\n",
+			        motSIMDName(simd), qErr, bigErr, nover, rotErr);
+		}
+		printf("EulerAry[%s]: max quat err = %e (%e large), angle err = %e (|cos| > 0.1), rotation err = %e\n",
+		       motSIMDName(simd), qErr, bigErr, angErr, rotErr);
 	}
-	printf("\n");
+	free(pRads);
+	free(pRes);
+	free(pRefQuats);
+	free(pQuats);
 }
 
-static void printSeqInfo(MOT_CLIP* pClip) {
-	MOT_SEQ* pSeq;
-	int i, npos, nrot, nscl;
-	if (!pClip) return;
-	pSeq = motGetSeqInfo(pClip);
-	if (!pSeq) return;
-	npos = motClipTrackCount(pClip, TRK_POS);
-	nrot = motClipTrackCount(pClip, TRK_ROT);
-	nscl = motClipTrackCount(pClip, TRK_SCL);
-	for (i = 0; i < npos * 3; ++i) {
-		printSeqEntry(pClip, pSeq, "pos");
-		++pSeq;
+/* degrees -> quaternion -> degrees per node, as the .clip export in test() does */
+static D_NOINLINE PERF_RES perfEulerArySub(MOT_CLIP* pClip, const MOT_VEC* pDegs, int n, int simd) {
+	PERF_RES perf;
+	double smps[N_PERF_SMP];
+	int ismp, i, k;
+	double t0, t1;
+	double sum = 0.0;
+	float maxErr = 0.0f;
+	int nnod = pClip->nnod;
+	MOT_QUAT* pQuats = allocQuats(n);
+	MOT_VEC* pRes = allocVecs(n * nnod);
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		const MOT_VEC* pSrc = pDegs;
+		MOT_VEC* pDst = pRes;
+		t0 = timestamp();
+		for (i = 0; i < nnod; ++i) {
+			E_MOT_RORD rord = motGetRotOrd(pClip, i);
+			if (!motNodeTrackCk(pClip, i, TRK_ROT)) continue;
+			if (simd >= 0) {
+				motQuatFromDegreesAryEx(pQuats, pSrc, n, rord, (E_MOT_SIMD)simd);
+				motQuatToDegreesAryEx(pDst, pQuats, n, rord, (E_MOT_SIMD)simd);
+			} else {
+				for (k = 0; k < n; ++k) {
+					MOT_QUAT q = motQuatFromDegrees(pSrc[k].x, pSrc[k].y, pSrc[k].z, rord);
+					pDst[k] = motQuatToDegrees(q, rord);
+				}
+			}
+			pSrc += n;
+			pDst += n;
+		}
+		t1 = timestamp();
+		smps[ismp] = t1 - t0;
 	}
-	for (i = 0; i < nrot * 3; ++i) {
-		printSeqEntry(pClip, pSeq, "rot");
-		++pSeq;
+	for (i = 0; i < nnod; ++i) {
+		if (!motNodeTrackCk(pClip, i, TRK_ROT)) continue;
+		for (k = 0; k < n; ++k) {
+			const MOT_VEC* pSrc = &pDegs[i * n + k];
+			const MOT_VEC* pDst = &pRes[i * n + k];
+			E_MOT_RORD rord = motGetRotOrd(pClip, i);
+			MOT_VEC ref = motQuatToDegrees(motQuatFromDegrees(pSrc->x, pSrc->y, pSrc->z, rord), rord);
+			int j;
+			for (j = 0; j < 3; ++j) {
+				sum += pDst->s[j];
+				maxErr = fmaxf(maxErr, fabsf(fmodf(pDst->s[j] - ref.s[j] + 540.0f, 360.0f) - 180.0f));
+			}
+		}
 	}
-	for (i = 0; i < nscl * 3; ++i) {
-		printSeqEntry(pClip, pSeq, "rot");
-		++pSeq;
+	free(pQuats);
+	free(pRes);
+	perf.sum = sum;
+	perf.dt = perfsmp(smps, N_PERF_SMP);
+	perf.err = maxErr;
+	return perf;
+}
+
+static void perfEulerAry(MOT_CLIP* pClip) {
+	if (pClip) {
+		static const E_MOT_SIMD simds[] = { SIMD_NONE, SIMD_BLOCK, SIMD_SSE4, SIMD_AVX2, SIMD_NEON };
+		int nnod = pClip->nnod;
+		int n = pClip->nfrm * N_EULER_SUB;
+		MOT_VEC* pDegs = allocVecs(n * nnod);
+		PERF_RES resLoop;
+		int i, k;
+		for (i = 0; i < nnod; ++i) {
+			for (k = 0; k < n; ++k) {
+				pDegs[i * n + k] = motEvalDegrees(pClip, i, (float)k / (float)N_EULER_SUB);
+			}
+		}
+		resLoop = perfEulerArySub(pClip, pDegs, n, -1);
+		printf("Euler loop: sum = %f, dt = %f\n", resLoop.sum, resLoop.dt);
+		for (i = 0; i < (int)(sizeof(simds) / sizeof(simds[0])); ++i) {
+			E_MOT_SIMD simd = simds[i];
+			if (motSIMDCk(simd)) {
+				PERF_RES resVect = perfEulerArySub(pClip, pDegs, n, (int)simd);
+				printf("Euler vect[%s]%s: sum = %f, dt = %f, ratio = %f, max err = %e deg\n",
+				       motSIMDName(simd), simd == motGetSIMD() ? "*" : "",
+				       resVect.sum, resVect.dt, resLoop.dt / resVect.dt, resVect.err);
+			}
+		}
+		free(pDegs);
 	}
 }
 
-void init() {
-	const char* pClipName = "../data/walk.mclp";
-	MOT_CLIP* pClip = clipLoad(pClipName);
-	if (!pClip) return;
-	s_pClip = pClip;
-	verifyFindClipNode(pClip);
-	perfFindClipNode(pClip);
-	perfQuatAry(pClip);
-	//printSeqInfo(pClip);
+static void evalPoseLoop(MOT_CLIP* pClip, float frm, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	int i;
+	int nnod = pClip->nnod;
+	for (i = 0; i < nnod; ++i) {
+		pPos[i] = motEvalPos(pClip, i, frm);
+		pRot[i] = motEvalQuat(pClip, i, frm);
+		pScl[i] = motEvalScl(pClip, i, frm);
+	}
 }
 
-void test() {
-	MOT_CLIP* pClip = s_pClip;
+static double poseSum(int n, const MOT_VEC* pPos, const MOT_QUAT* pRot, const MOT_VEC* pScl) {
+	double sum = 0;
+	int i, j;
+	for (i = 0; i < n; ++i) {
+		for (j = 0; j < 3; ++j) {
+			sum += pPos[i].s[j] + pScl[i].s[j];
+		}
+		sum += qmag(pRot[i]);
+	}
+	return sum;
+}
+
+static void verifyEvalPose(MOT_CLIP* pClip) {
 	int i, j, k;
-	int nfrm;
-	int nnod;
-	int npos;
-	int nrot;
-	int nscl;
-	float frm;
-	int nsub = 4;
-	FILE* pOut = NULL;
-	MOT_VEC* pRot = NULL;
-	MOT_MTX* pMtx = NULL;
-	int midx;
+	int nnod, nsub;
+	float maxErr = 0.0f;
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
 	if (!pClip) return;
-
-	nfrm = pClip->nfrm;
 	nnod = pClip->nnod;
-	npos = 0;
-	nrot = 0;
-	nscl = 0;
-	for (i = 0; i < nnod; ++i) {
-		if (motNodeTrackCk(pClip, i, TRK_POS)) {
-			++npos;
-		}
-		if (motNodeTrackCk(pClip, i, TRK_ROT)) {
-			++nrot;
+	nsub = 4;
+	for (i = 0; i < 2; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+	}
+	for (k = 0; k < (int)pClip->nfrm * nsub; ++k) {
+		float frm = (float)k / (float)nsub;
+		evalPoseLoop(pClip, frm, pPos[0], pRot[0], pScl[0]);
+		motEvalPose(pClip, frm, pPos[1], pRot[1], pScl[1]);
+		for (i = 0; i < nnod; ++i) {
+			for (j = 0; j < 3; ++j) {
+				maxErr = fmaxf(maxErr, fabsf(pPos[0][i].s[j] - pPos[1][i].s[j]));
+				maxErr = fmaxf(maxErr, fabsf(pScl[0][i].s[j] - pScl[1][i].s[j]));
+			}
+			for (j = 0; j < 4; ++j) {
+				maxErr = fmaxf(maxErr, fabsf(pRot[0][i].s[j] - pRot[1][i].s[j]));
+			}
 		}
-		if (motNodeTrackCk(pClip, i, TRK_SCL)) {
-			++nscl;
+	}
+	if (maxErr > 1.0e-5f) {
+		fprintf(stderr, "[ERR] EvalPose: max err = %e\n", maxErr);
+	}
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+	}
+}
+
+static D_NOINLINE PERF_RES perfEvalPoseSub(MOT_CLIP* pClip, int poseFlg) {
+	PERF_RES perf;
+	double smps[N_PERF_SMP];
+	int ismp, k;
+	double t0, t1;
+	double sum = 0;
+	int nsub = 4;
+	int nnod = pClip->nnod;
+	int nevl = pClip->nfrm * nsub;
+	MOT_VEC* pPos = allocVecs(nnod);
+	MOT_QUAT* pRot = allocQuats(nnod);
+	MOT_VEC* pScl = allocVecs(nnod);
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			float frm = (float)k / (float)nsub;
+			if (poseFlg) {
+				motEvalPose(pClip, frm, pPos, pRot, pScl);
+			} else {
+				evalPoseLoop(pClip, frm, pPos, pRot, pScl);
+			}
 		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / (double)nevl;
+		sum += poseSum(nnod, pPos, pRot, pScl);
 	}
-	printf("motion clip: %s\n", pClip->name.chr);
-	printf("#nod: %d\n", nnod);
-	printf("#frm: %d\n", nfrm);
-	printf("#pos tracks: %d (%d)\n", npos, motClipTrackCount(pClip, TRK_POS));
-	printf("#rot tracks: %d (%d)\n", nrot, motClipTrackCount(pClip, TRK_ROT));
-	printf("#scl tracks: %d (%d)\n", nscl, motClipTrackCount(pClip, TRK_SCL));
+	free(pPos);
+	free(pRot);
+	free(pScl);
+	perf.sum = sum;
+	perf.dt = perfsmp(smps, N_PERF_SMP);
+	perf.err = 0.0f;
+	return perf;
+}
 
-	pOut = fopen("../dump.clip", "w");
+static void perfEvalPose(MOT_CLIP* pClip) {
+	if (pClip) {
+		PERF_RES resLoop = perfEvalPoseSub(pClip, 0);
+		PERF_RES resPose = perfEvalPoseSub(pClip, 1);
+		printf("NodeLoop: sum = %f, dt = %f\n", resLoop.sum, resLoop.dt);
+		printf("EvalPose: sum = %f, dt = %f\n", resPose.sum, resPose.dt);
+		printf("ratio: %f\n", resLoop.dt / resPose.dt);
+	}
+}
 
-	fprintf(pOut, "{\n");
-	fprintf(pOut, "  rate = %.1f\n", pClip->rate);
-	fprintf(pOut, "  start = -1\n");
-	fprintf(pOut, "  tracklength = %d\n", nfrm * nsub);
-	fprintf(pOut, "  tracks = %d\n", nrot * 3);
+static void blendAryLoop(int n, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl,
+                         const MOT_VEC* pPos1, const MOT_QUAT* pRot1, const MOT_VEC* pScl1,
+                         const MOT_VEC* pPos2, const MOT_QUAT* pRot2, const MOT_VEC* pScl2, float t) {
+	int i;
+	for (i = 0; i < n; ++i) {
+		pPos[i] = motVecLerp(pPos1[i], pPos2[i], t);
+		pRot[i] = motQuatSlerp(pRot1[i], pRot2[i], t);
+		pScl[i] = motVecLerp(pScl1[i], pScl2[i], t);
+	}
+}
 
-	pRot = (MOT_VEC*)malloc(nfrm * nsub * sizeof(MOT_VEC));
-	pMtx = (MOT_MTX*)malloc(nnod * nfrm * nsub * sizeof(MOT_MTX));
-	midx = 0;
-	for (i = 0; i < nnod; ++i) {
-		frm = 0.0f;
-		for (k = 0; k < nfrm * nsub; ++k) {
-			motEvalTransform(&pMtx[midx], pClip, i, frm, NULL);
-			frm += 1.0f / (float)nsub;
-			++midx;
+#define N_BLEND_STEPS (64)
+
+static void perfPoseBlend(MOT_CLIP* pClip) {
+	static const E_MOT_SIMD simds[] = { SIMD_NONE, SIMD_AVX2 };
+	static const char* pModeNames[] = { "nlerp", "nlerp_fix", "slerp" };
+	double smps[N_PERF_SMP];
+	double t0, t1, dtLoop;
+	double sum;
+	int i, j, k, ismp, imode, isimd;
+	int nnod;
+	MOT_VEC* pPos[3];
+	MOT_QUAT* pRot[3];
+	MOT_VEC* pScl[3];
+	MOT_QUAT* pRefRot;
+	MOT_POSE pose[3];
+	if (!pClip) return;
+	nnod = pClip->nnod;
+	for (i = 0; i < 3; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+		motPoseAlloc(&pose[i], nnod);
+	}
+	pRefRot = allocQuats(nnod * N_BLEND_STEPS);
+	motEvalPose(pClip, 0.0f, pPos[0], pRot[0], pScl[0]);
+	motEvalPose(pClip, (float)pClip->nfrm * 0.5f, pPos[1], pRot[1], pScl[1]);
+	motPoseFromAry(&pose[0], pPos[0], pRot[0], pScl[0]);
+	motPoseFromAry(&pose[1], pPos[1], pRot[1], pScl[1]);
+
+	sum = 0;
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < N_BLEND_STEPS; ++k) {
+			float t = (float)k / (float)(N_BLEND_STEPS - 1);
+			blendAryLoop(nnod, pPos[2], &pRefRot[k * nnod], pScl[2], pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1], t);
 		}
-		if (motNodeTrackCk(pClip, i, TRK_ROT)) {
-			frm = 0.0f;
-			for (k = 0; k < nfrm * nsub; ++k) {
-				pRot[k] = motEvalDegrees(pClip, i, frm);
-				frm += 1.0f / (float)nsub;
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / N_BLEND_STEPS;
+		sum += pRefRot[0].w;
+	}
+	dtLoop = perfsmp(smps, N_PERF_SMP);
+	printf("BlendLoop: sum = %f, dt = %f\n", sum, dtLoop);
+
+	for (isimd = 0; isimd < (int)(sizeof(simds) / sizeof(simds[0])); ++isimd) {
+		E_MOT_SIMD simd = simds[isimd];
+		if (!motSIMDCk(simd)) continue;
+		for (imode = QBLEND_NLERP; imode <= QBLEND_SLERP; ++imode) {
+			float maxErr = 0.0f;
+			sum = 0;
+			for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+				t0 = timestamp();
+				for (k = 0; k < N_BLEND_STEPS; ++k) {
+					float t = (float)k / (float)(N_BLEND_STEPS - 1);
+					motPoseBlendEx(&pose[2], &pose[0], &pose[1], t, (E_MOT_QBLEND)imode, simd);
+				}
+				t1 = timestamp();
+				smps[ismp] = (t1 - t0) / N_BLEND_STEPS;
+				sum += pose[2].pRot[3][0];
 			}
-			for (k = 0; k < nfrm * nsub; ++k) {
-				E_MOT_RORD rord = motGetRotOrd(pClip, i);
-				MOT_QUAT q = motQuatFromDegrees(pRot[k].x, pRot[k].y, pRot[k].z, rord);
-				pRot[k] = motQuatToDegrees(q, rord);
+			for (k = 0; k < N_BLEND_STEPS; ++k) {
+				float t = (float)k / (float)(N_BLEND_STEPS - 1);
+				motPoseBlendEx(&pose[2], &pose[0], &pose[1], t, (E_MOT_QBLEND)imode, simd);
+				motPoseToAry(&pose[2], NULL, pRot[2], NULL);
+				for (i = 0; i < nnod; ++i) {
+					float d = 0.0f;
+					for (j = 0; j < 4; ++j) {
+						d += pRot[2][i].s[j] * pRefRot[k * nnod + i].s[j];
+					}
+					d = d < 0.0f ? -1.0f : 1.0f;
+					for (j = 0; j < 4; ++j) {
+						maxErr = fmaxf(maxErr, fabsf(pRot[2][i].s[j]*d - pRefRot[k * nnod + i].s[j]));
+					}
+				}
+			}
+			{
+				double dt = perfsmp(smps, N_PERF_SMP);
+				printf("PoseBlend[%s, %s]: sum = %f, dt = %f, ratio = %f, max err = %e\n",
+				       motSIMDName(simd), pModeNames[imode], sum, dt, dtLoop / dt, maxErr);
 			}
+		}
+	}
+
+	for (i = 0; i < 3; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+		motPoseFree(&pose[i]);
+	}
+	free(pRefRot);
+}
+
+#define N_BLEND_LAYERS (4)
+
+static void verifyEvalBlend(MOT_CLIP* pClip) {
+	MOT_LAYER layers[2];
+	MOT_POSE pose, ref;
+	MOT_VEC* pPos;
+	MOT_QUAT* pRot;
+	MOT_VEC* pScl;
+	float maxErr = 0.0f;
+	int i, j, k;
+	int nnod;
+	if (!pClip) return;
+	nnod = pClip->nnod;
+	pPos = allocVecs(nnod);
+	pRot = allocQuats(nnod);
+	pScl = allocVecs(nnod);
+	motPoseAlloc(&pose, nnod);
+	motPoseAlloc(&ref, nnod);
+	memset(layers, 0, sizeof(layers));
+	layers[0].pClip = pClip;
+	layers[0].weight = 1.0f;
+	layers[0].mode = LAYER_OVERRIDE;
+	layers[1].pClip = pClip;
+	layers[1].weight = 0.5f;
+	layers[1].mode = LAYER_ADDITIVE;
+	for (k = 0; k < (int)pClip->nfrm * 2; ++k) {
+		float frm = (float)k * 0.5f;
+		layers[0].frm = frm;
+		/* zero delta: the additive layer must leave the pose unchanged */
+		layers[1].frm = frm * 0.5f;
+		layers[1].refFrm = frm * 0.5f;
+		motEvalBlend(&pose, layers, 2);
+		motEvalPose(pClip, frm, pPos, pRot, pScl);
+		motPoseFromAry(&ref, pPos, pRot, pScl);
+		for (i = 0; i < nnod; ++i) {
 			for (j = 0; j < 3; ++j) {
-				if (pOut) {
-					fprintf(pOut, "  {\n");
-					fprintf(pOut, "    name = %s:r%c\n", pClip->nodes[i].name.chr, "xyz"[j]);
-					fprintf(pOut, "    data =");
-					for (k = 0; k < nfrm * nsub; ++k) {
-						fprintf(pOut, " %f", pRot[k].s[j]);
+				maxErr = fmaxf(maxErr, fabsf(pose.pPos[j][i] - ref.pPos[j][i]));
+				maxErr = fmaxf(maxErr, fabsf(pose.pScl[j][i] - ref.pScl[j][i]));
+			}
+			for (j = 0; j < 4; ++j) {
+				maxErr = fmaxf(maxErr, fabsf(pose.pRot[j][i] - ref.pRot[j][i]));
+			}
+		}
+	}
+	if (maxErr > 1.0e-5f) {
+		fprintf(stderr, "[ERR] EvalBlend: max err = %e\n", maxErr);
+	}
+	motPoseFree(&pose);
+	motPoseFree(&ref);
+	free(pPos);
+	free(pRot);
+	free(pScl);
+}
+
+static void perfEvalBlend(MOT_CLIP* pClip) {
+	MOT_LAYER layers[N_BLEND_LAYERS];
+	MOT_POSE pose;
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
+	double smps[N_PERF_SMP];
+	double t0, t1, dtLoop, dtBlend;
+	double sumLoop = 0;
+	double sumBlend = 0;
+	int i, k, ismp, ilyr;
+	int nnod, nevl;
+	if (!pClip) return;
+	nnod = pClip->nnod;
+	nevl = pClip->nfrm;
+	for (i = 0; i < 2; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+	}
+	motPoseAlloc(&pose, nnod);
+	memset(layers, 0, sizeof(layers));
+	for (ilyr = 0; ilyr < N_BLEND_LAYERS; ++ilyr) {
+		layers[ilyr].pClip = pClip;
+		layers[ilyr].weight = ilyr == 0 ? 1.0f : 1.0f / (float)(ilyr + 1);
+		layers[ilyr].mode = LAYER_OVERRIDE;
+	}
+
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			for (ilyr = 0; ilyr < N_BLEND_LAYERS; ++ilyr) {
+				float frm = (float)k + (float)ilyr * 0.25f;
+				float w = layers[ilyr].weight;
+				motEvalPose(pClip, frm, pPos[1], pRot[1], pScl[1]);
+				for (i = 0; i < nnod; ++i) {
+					if (ilyr == 0) {
+						pPos[0][i] = pPos[1][i];
+						pRot[0][i] = pRot[1][i];
+						pScl[0][i] = pScl[1][i];
+					} else {
+						pPos[0][i] = motVecLerp(pPos[0][i], pPos[1][i], w);
+						pRot[0][i] = motQuatSlerp(pRot[0][i], pRot[1][i], w);
+						pScl[0][i] = motVecLerp(pScl[0][i], pScl[1][i], w);
 					}
-					fprintf(pOut, "\n");
-					fprintf(pOut, "  }\n");
 				}
 			}
 		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / nevl;
+		sumLoop += pRot[0][0].w;
 	}
-	fprintf(pOut, "}\n");
-	if (pOut) {
-		fclose(pOut);
-		pOut = NULL;
+	dtLoop = perfsmp(smps, N_PERF_SMP);
+
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			for (ilyr = 0; ilyr < N_BLEND_LAYERS; ++ilyr) {
+				layers[ilyr].frm = (float)k + (float)ilyr * 0.25f;
+			}
+			motEvalBlend(&pose, layers, N_BLEND_LAYERS);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / nevl;
+		sumBlend += pose.pRot[3][0];
+	}
+	dtBlend = perfsmp(smps, N_PERF_SMP);
+
+	printf("LayerLoop[%d]: sum = %f, dt = %f\n", N_BLEND_LAYERS, sumLoop, dtLoop);
+	printf("EvalBlend[%d]: sum = %f, dt = %f\n", N_BLEND_LAYERS, sumBlend, dtBlend);
+	printf("ratio: %f\n", dtLoop / dtBlend);
+
+	motPoseFree(&pose);
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
 	}
 }
 
+#define N_CROWD_INST (5000)
+#define N_CROWD_TICKS (10)
+
+static void perfCrowd(MOT_CLIP* pClip) {
+	MOT_CROWD_INST* pInsts;
+	MOT_VEC* pPos;
+	MOT_QUAT* pRot;
+	MOT_VEC* pScl;
+	MOT_VEC refPos;
+	double dt1 = 0.0;
+	int i, itick, nthr, ncpu, nnod;
+	if (!pClip) return;
+	nnod = pClip->nnod;
+	ncpu = motCrowdCPUCount();
+	pInsts = (MOT_CROWD_INST*)malloc(N_CROWD_INST * sizeof(MOT_CROWD_INST));
+	pPos = allocVecs(N_CROWD_INST * nnod);
+	pRot = allocQuats(N_CROWD_INST * nnod);
+	pScl = allocVecs(N_CROWD_INST * nnod);
+	for (i = 0; i < N_CROWD_INST; ++i) {
+		pInsts[i].pClip = pClip;
+		pInsts[i].frm = (float)(i % 97) * 0.37f;
+		pInsts[i].pPos = &pPos[i * nnod];
+		pInsts[i].pRot = &pRot[i * nnod];
+		pInsts[i].pScl = &pScl[i * nnod];
+	}
+	printf("crowd: %d instances x %d nodes, %d CPUs\n", N_CROWD_INST, nnod, ncpu);
+	for (nthr = 1; nthr <= ncpu; nthr = nthr < ncpu && nthr * 2 > ncpu ? ncpu : nthr * 2) {
+		double smps[N_CROWD_TICKS];
+		double dt;
+		int err = 0;
+		MOT_CROWD* pCrowd = motCrowdCreate(nthr, MOT_CROWD_PIN);
+		if (!pCrowd) break;
+		for (itick = 0; itick < N_CROWD_TICKS; ++itick) {
+			double t0 = timestamp();
+			motCrowdEval(pCrowd, pInsts, N_CROWD_INST);
+			smps[itick] = timestamp() - t0;
+		}
+		dt = perfsmp(smps, N_CROWD_TICKS);
+		if (nthr == 1) {
+			dt1 = dt;
+		}
+		for (i = 0; i < N_CROWD_INST; i += 101) {
+			refPos = motEvalPos(pClip, nnod - 1, pInsts[i].frm);
+			if (memcmp(&refPos, &pInsts[i].pPos[nnod - 1], sizeof(MOT_VEC)) != 0) {
+				++err;
+			}
+		}
+		if (err) {
+			fprintf(stderr, "[ERR] Crowd: %d mismatches\n", err);
+		}
+		printf("Crowd[%d thr]: dt = %f, %.1f inst/ms, speedup = %f, steals = %d\n",
+		       nthr, dt, (double)N_CROWD_INST * 1.0e3 / dt, dt1 / dt, motCrowdStealCount(pCrowd));
+		motCrowdDestroy(pCrowd);
+		if (nthr == ncpu) break;
+	}
+	free(pInsts);
+	free(pPos);
+	free(pRot);
+	free(pScl);
+}
+
+static void skelTestInit(MOT_CLIP* pClip, MOT_SKEL* pSkel, int* pParents, MOT_VEC* pRest, const char** ppNames) {
+	int i, nnod = pClip->nnod;
+	/* joints are listed in reverse node order so that the sort has work to do */
+	for (i = 0; i < nnod; ++i) {
+		int jnt = nnod - 1 - i;
+		pParents[jnt] = i > 0 ? nnod - 1 - (i - 1) / 3 : -1;
+		pRest[jnt].x = (float)(i % 5) * 0.1f;
+		pRest[jnt].y = 0.25f;
+		pRest[jnt].z = -(float)(i % 3) * 0.05f;
+		ppNames[jnt] = pClip->nodes[i].name.chr;
+	}
+	motSkelAlloc(pSkel, nnod, pParents, pRest);
+	motSkelBind(pSkel, pClip, ppNames);
+}
+
+static void skelWorldLoop(MOT_CLIP* pClip, const int* pParents, const MOT_VEC* pRest, float frm, MOT_MTX* pLocal, MOT_MTX* pWorld) {
+	int i, nnod = pClip->nnod;
+	/* node i's parent is (i-1)/3, so walking nodes in order has parents ready */
+	for (i = 0; i < nnod; ++i) {
+		int jnt = nnod - 1 - i;
+		motEvalTransform(&pLocal[i], pClip, i, frm, &pRest[jnt]);
+		if (pParents[jnt] < 0) {
+			memcpy(&pWorld[i], &pLocal[i], sizeof(MOT_MTX));
+		} else {
+			motMtxMul(&pWorld[i], &pLocal[i], &pWorld[(i - 1) / 3]);
+		}
+	}
+}
+
+static void skelWorldBatch(MOT_CLIP* pClip, const MOT_SKEL* pSkel, float frm, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl, MOT_MTX* pLocal, MOT_MTX* pWorld) {
+	motEvalPose(pClip, frm, pPos, pRot, pScl);
+	motSkelLocalXforms(pSkel, pClip, pPos, pRot, pScl, pLocal);
+	motSkelWorldXforms(pSkel, pLocal, pWorld, NULL);
+}
+
+/* malformed hierarchies are rejected, a chain listed leaf first gets one level per joint */
+static void skelHierCk(int* pParents, int njnt) {
+	MOT_SKEL skel;
+	int i, nerr = 0;
+	for (i = 0; i < njnt; ++i) {
+		pParents[i] = i < njnt - 1 ? i + 1 : -1;
+	}
+	if (!motSkelAlloc(&skel, njnt, pParents, NULL) || skel.nlvl != njnt || skel.pOrder[0] != njnt - 1 || skel.pParent[njnt - 1] != njnt - 2) ++nerr;
+	motSkelFree(&skel);
+	pParents[njnt - 1] = 0;
+	if (motSkelAlloc(&skel, njnt, pParents, NULL)) ++nerr;
+	motSkelFree(&skel);
+	pParents[njnt - 1] = njnt;
+	if (motSkelAlloc(&skel, njnt, pParents, NULL)) ++nerr;
+	motSkelFree(&skel);
+	pParents[0] = 0;
+	pParents[njnt - 1] = -1;
+	if (motSkelAlloc(&skel, njnt, pParents, NULL)) ++nerr;
+	motSkelFree(&skel);
+	if (nerr) {
+		fprintf(stderr, "[ERR] SkelHier: %d bad hierarchies\n", nerr);
+	}
+}
+
+static void perfSkel(MOT_CLIP* pClip) {
+	MOT_SKEL skel;
+	int* pParents;
+	MOT_VEC* pRest;
+	const char** ppNames;
+	MOT_VEC* pPos;
+	MOT_QUAT* pRot;
+	MOT_VEC* pScl;
+	MOT_MTX* pLocal;
+	MOT_MTX* pWorld;
+	MOT_MTX* pRefWorld;
+	double smps[N_PERF_SMP];
+	double t0, t1, dtLoop, dtBatch;
+	double sumLoop = 0;
+	double sumBatch = 0;
+	float maxErr = 0.0f;
+	int i, j, k, ismp, nnod, nevl;
+	if (!pClip) return;
+	nnod = pClip->nnod;
+	nevl = pClip->nfrm;
+	pParents = (int*)malloc(nnod * sizeof(int));
+	pRest = allocVecs(nnod);
+	ppNames = (const char**)malloc(nnod * sizeof(char*));
+	pPos = allocVecs(nnod);
+	pRot = allocQuats(nnod);
+	pScl = allocVecs(nnod);
+	pLocal = (MOT_MTX*)malloc(nnod * sizeof(MOT_MTX));
+	pWorld = (MOT_MTX*)malloc(nnod * sizeof(MOT_MTX));
+	pRefWorld = (MOT_MTX*)malloc(nnod * sizeof(MOT_MTX));
+	skelHierCk(pParents, nnod);
+	skelTestInit(pClip, &skel, pParents, pRest, ppNames);
+	printf("skel: %d joints, %d levels\n", skel.njnt, skel.nlvl);
+
+	for (k = 0; k < nevl; ++k) {
+		float frm = (float)k + 0.5f;
+		skelWorldLoop(pClip, pParents, pRest, frm, pLocal, pRefWorld);
+		skelWorldBatch(pClip, &skel, frm, pPos, pRot, pScl, pLocal, pWorld);
+		for (i = 0; i < skel.njnt; ++i) {
+			const float* pA = &pWorld[i][0][0];
+			const float* pB = &pRefWorld[nnod - 1 - skel.pOrder[i]][0][0];
+			for (j = 0; j < 16; ++j) {
+				float e = fabsf(pA[j] - pB[j]);
+				if (e > maxErr) maxErr = e;
+			}
+		}
+	}
+	if (maxErr > 1.0e-4f) {
+		fprintf(stderr, "[ERR] SkelWorld: max err = %g\n", maxErr);
+	}
+
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			skelWorldLoop(pClip, pParents, pRest, (float)k, pLocal, pRefWorld);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / nevl;
+		sumLoop += pRefWorld[nnod - 1][3][1];
+	}
+	dtLoop = perfsmp(smps, N_PERF_SMP);
+
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			skelWorldBatch(pClip, &skel, (float)k, pPos, pRot, pScl, pLocal, pWorld);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / nevl;
+		sumBatch += pWorld[0][3][1];
+	}
+	dtBatch = perfsmp(smps, N_PERF_SMP);
+
+	printf("SkelLoop: sum = %f, dt = %f\n", sumLoop, dtLoop);
+	printf("SkelWorld: sum = %f, dt = %f, max err = %g\n", sumBatch, dtBatch, maxErr);
+	printf("ratio: %f\n", dtLoop / dtBatch);
+
+	motSkelFree(&skel);
+	free(pParents);
+	free(pRest);
+	free((void*)ppNames);
+	free(pPos);
+	free(pRot);
+	free(pScl);
+	free(pLocal);
+	free(pWorld);
+	free(pRefWorld);
+}
+
+/* reference composition: separate S, R, T matrices multiplied in xord order */
+static void refTransform(MOT_MTX* pMtx, const MOT_VEC tns, const MOT_QUAT rot, const MOT_VEC scl, E_MOT_XORD xord) {
+	MOT_MTX ms[3];
+	int i, i0, i1, i2;
+	const int S = 0;
+	const int R = 1;
+	const int T = 2;
+	switch (xord) {
+		default:
+		case XORD_SRT: i0 = S; i1 = R; i2 = T; break;
+		case XORD_STR: i0 = S; i1 = T; i2 = R; break;
+		case XORD_RST: i0 = R; i1 = S; i2 = T; break;
+		case XORD_RTS: i0 = R; i1 = T; i2 = S; break;
+		case XORD_TSR: i0 = T; i1 = S; i2 = R; break;
+		case XORD_TRS: i0 = T; i1 = R; i2 = S; break;
+	}
+	memset(&ms[S], 0, sizeof(MOT_MTX));
+	for (i = 0; i < 3; ++i) {
+		ms[S][i][i] = scl.s[i];
+	}
+	ms[S][3][3] = 1.0f;
+	motMakeTransformR(&ms[R], rot);
+	motMakeTransformT(&ms[T], tns);
+	motMtxMul(pMtx, (const MOT_MTX*)&ms[i0], (const MOT_MTX*)&ms[i1]);
+	motMtxMul(pMtx, (const MOT_MTX*)pMtx, (const MOT_MTX*)&ms[i2]);
+}
+
+static float mtxErr(const MOT_MTX* pA, const MOT_MTX* pB) {
+	const float* pa = &(*pA)[0][0];
+	const float* pb = &(*pB)[0][0];
+	float err = 0.0f;
+	int i;
+	for (i = 0; i < 16; ++i) {
+		float e = fabsf(pa[i] - pb[i]);
+		if (e > err) err = e;
+	}
+	return err;
+}
+
+static void affineTestData(MOT_CLIP* pClip, MOT_VEC* pTns, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	int i, nnod = pClip->nnod;
+	motEvalPose(pClip, 0.5f, pTns, pRot, pScl);
+	for (i = 0; i < nnod; ++i) {
+		/* non-uniform scale on every node so that all orders differ */
+		pScl[i].x *= 1.0f + (float)(i % 7) * 0.1f;
+		pScl[i].y *= 1.0f - (float)(i % 5) * 0.1f;
+		pScl[i].z *= 0.5f + (float)(i % 3) * 0.25f;
+		pTns[i].y += 1.0f;
+	}
+}
+
+static void verifyAffine(MOT_CLIP* pClip) {
+	MOT_VEC* pTns;
+	MOT_QUAT* pRot;
+	MOT_VEC* pScl;
+	MOT_AFFINE* pAff;
+	MOT_VEC one = { { 1.0f, 1.0f, 1.0f } };
+	MOT_MTX ref, mtx;
+	float maxErr = 0.0f;
+	int i, xord, simd, nnod;
+	if (!pClip) return;
+	nnod = pClip->nnod;
+	pTns = allocVecs(nnod);
+	pRot = allocQuats(nnod);
+	pScl = allocVecs(nnod);
+	pAff = (MOT_AFFINE*)malloc(nnod * sizeof(MOT_AFFINE));
+	affineTestData(pClip, pTns, pRot, pScl);
+	for (xord = XORD_SRT; xord <= XORD_TRS; ++xord) {
+		for (i = 0; i < nnod; ++i) {
+			float e;
+			refTransform(&ref, pTns[i], pRot[i], pScl[i], (E_MOT_XORD)xord);
+			motMakeTransform(&mtx, pTns[i], pRot[i], pScl[i], (E_MOT_XORD)xord);
+			e = mtxErr(&ref, &mtx);
+			if (e > maxErr) maxErr = e;
+			refTransform(&ref, pTns[i], pRot[i], one, (E_MOT_XORD)xord);
+			motMakeTransformTR(&mtx, pTns[i], pRot[i], (E_MOT_XORD)xord);
+			e = mtxErr(&ref, &mtx);
+			if (e > maxErr) maxErr = e;
+		}
+		for (simd = SIMD_NONE; simd <= SIMD_NEON; ++simd) {
+			if (!motSIMDCk((E_MOT_SIMD)simd)) continue;
+			motMakeAffineAryEx(pAff, pTns, pRot, pScl, nnod, (E_MOT_XORD)xord, (E_MOT_SIMD)simd);
+			for (i = 0; i < nnod; ++i) {
+				float e;
+				refTransform(&ref, pTns[i], pRot[i], pScl[i], (E_MOT_XORD)xord);
+				motAffineToMtx(&mtx, &pAff[i]);
+				e = mtxErr(&ref, &mtx);
+				if (e > maxErr) maxErr = e;
+			}
+		}
+	}
+	/* composition */
+	for (i = 1; i < nnod; ++i) {
+		MOT_AFFINE aff;
+		MOT_MTX m0, m1;
+		float e;
+		motAffineToMtx(&m0, &pAff[i - 1]);
+		motAffineToMtx(&m1, &pAff[i]);
+		motMtxMul(&ref, (const MOT_MTX*)&m0, (const MOT_MTX*)&m1);
+		motAffineMul(&aff, &pAff[i - 1], &pAff[i]);
+		motAffineToMtx(&mtx, &aff);
+		e = mtxErr(&ref, &mtx);
+		if (e > maxErr) maxErr = e;
+	}
+	if (maxErr > 1.0e-5f) {
+		fprintf(stderr, "[ERR] Affine: max err = %g\n", maxErr);
+	}
+	printf("Affine: max err = %g\n", maxErr);
+	free(pTns);
+	free(pRot);
+	free(pScl);
+	free(pAff);
+}
+
+static void perfAffine(MOT_CLIP* pClip) {
+	MOT_VEC* pTns;
+	MOT_QUAT* pRot;
+	MOT_VEC* pScl;
+	MOT_AFFINE* pAff;
+	MOT_MTX* pMtx;
+	double smps[N_PERF_SMP];
+	double t0, t1, dtRef, dt;
+	double sum;
+	int i, k, ismp, simd, nnod;
+	const int nrep = 100;
+	if (!pClip) return;
+	nnod = pClip->nnod;
+	pTns = allocVecs(nnod);
+	pRot = allocQuats(nnod);
+	pScl = allocVecs(nnod);
+	pAff = (MOT_AFFINE*)malloc(nnod * sizeof(MOT_AFFINE));
+	pMtx = (MOT_MTX*)malloc(nnod * sizeof(MOT_MTX));
+	affineTestData(pClip, pTns, pRot, pScl);
+
+	sum = 0;
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nrep; ++k) {
+			for (i = 0; i < nnod; ++i) {
+				refTransform(&pMtx[i], pTns[i], pRot[i], pScl[i], XORD_SRT);
+			}
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / nrep;
+		sum += pMtx[nnod - 1][3][1];
+	}
+	dtRef = perfsmp(smps, N_PERF_SMP);
+	printf("TransformMul: sum = %f, dt = %f\n", sum, dtRef);
+
+	sum = 0;
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nrep; ++k) {
+			for (i = 0; i < nnod; ++i) {
+				motMakeTransform(&pMtx[i], pTns[i], pRot[i], pScl[i], XORD_SRT);
+			}
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / nrep;
+		sum += pMtx[nnod - 1][3][1];
+	}
+	dt = perfsmp(smps, N_PERF_SMP);
+	printf("MakeTransform: sum = %f, dt = %f, ratio = %f\n", sum, dt, dtRef / dt);
+
+	for (simd = SIMD_NONE; simd <= SIMD_NEON; ++simd) {
+		if (!motSIMDCk((E_MOT_SIMD)simd)) continue;
+		sum = 0;
+		for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+			t0 = timestamp();
+			for (k = 0; k < nrep; ++k) {
+				motMakeAffineAryEx(pAff, pTns, pRot, pScl, nnod, XORD_SRT, (E_MOT_SIMD)simd);
+			}
+			t1 = timestamp();
+			smps[ismp] = (t1 - t0) / nrep;
+			sum += pAff[nnod - 1][1][3];
+		}
+		dt = perfsmp(smps, N_PERF_SMP);
+		printf("AffineAry[%s]%s: sum = %f, dt = %f, ratio = %f\n",
+		       motSIMDName((E_MOT_SIMD)simd), simd == (int)motGetSIMD() ? "*" : "", sum, dt, dtRef / dt);
+	}
+
+	free(pTns);
+	free(pRot);
+	free(pScl);
+	free(pAff);
+	free(pMtx);
+}
+
+static float poseErr(int n, const MOT_VEC* pPos0, const MOT_QUAT* pRot0, const MOT_VEC* pScl0,
+                     const MOT_VEC* pPos1, const MOT_QUAT* pRot1, const MOT_VEC* pScl1) {
+	float err = 0.0f;
+	int i, j;
+	for (i = 0; i < n; ++i) {
+		for (j = 0; j < 3; ++j) {
+			err = fmaxf(err, fabsf(pPos0[i].s[j] - pPos1[i].s[j]));
+			err = fmaxf(err, fabsf(pScl0[i].s[j] - pScl1[i].s[j]));
+		}
+		for (j = 0; j < 4; ++j) {
+			err = fmaxf(err, fabsf(pRot0[i].s[j] - pRot1[i].s[j]));
+		}
+	}
+	return err;
+}
+
+static void verifySampler(MOT_CLIP* pClip) {
+	MOT_SAMPLER smp;
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
+	float seekErr = 0.0f;
+	float advErr = 0.0f;
+	float nodeErr = 0.0f;
+	double frm = 0.0;
+	int i, k, nnod;
+	if (!pClip) return;
+	if (!motSamplerInit(&smp, pClip)) {
+		fprintf(stderr, "[ERR] Sampler: init failed\n");
+		return;
+	}
+	nnod = pClip->nnod;
+	for (i = 0; i < 2; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+	}
+	for (k = 0; k < (int)pClip->nfrm * 4; ++k) {
+		float f = (float)k * 0.25f;
+		motEvalPose(pClip, f, pPos[0], pRot[0], pScl[0]);
+		motSamplerSeek(&smp, f);
+		motSamplerEval(&smp, pPos[1], pRot[1], pScl[1]);
+		seekErr = fmaxf(seekErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+		for (i = 0; i < nnod; ++i) {
+			motSamplerEvalNode(&smp, i, &pPos[1][i], &pRot[1][i], &pScl[1][i]);
+		}
+		nodeErr = fmaxf(nodeErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+	}
+	/* forward playback at an irregular step, several loops */
+	motSamplerSeek(&smp, 0.0f);
+	for (k = 0; k < (int)pClip->nfrm * 8; ++k) {
+		float dt = 0.3f + (float)(k % 5) * 0.1f;
+		frm += dt;
+		motSamplerAdvance(&smp, dt);
+		motEvalPose(pClip, (float)fmod(frm, (double)pClip->nfrm), pPos[0], pRot[0], pScl[0]);
+		motSamplerEval(&smp, pPos[1], pRot[1], pScl[1]);
+		advErr = fmaxf(advErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+	}
+	if (seekErr > 1.0e-5f || nodeErr > 1.0e-5f || advErr > 1.0e-3f) {
+		fprintf(stderr, "[ERR] Sampler: seek err = %e, node err = %e, advance err = %e\n", seekErr, nodeErr, advErr);
+	}
+	printf("Sampler: %d+%d+%d animated channels, seek err = %e, node err = %e, advance err = %e\n",
+	       smp.nanim[0], smp.nanim[1], smp.nanim[2], seekErr, nodeErr, advErr);
+	motSamplerFree(&smp);
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+	}
+}
+
+static void perfSampler(MOT_CLIP* pClip) {
+	MOT_SAMPLER smp;
+	double smps[N_PERF_SMP];
+	double t0, t1, dtPose, dtSmp;
+	double sumPose = 0;
+	double sumSmp = 0;
+	int ismp, k, nnod, nevl;
+	MOT_VEC* pPos;
+	MOT_QUAT* pRot;
+	MOT_VEC* pScl;
+	const float dt = 0.25f;
+	if (!pClip) return;
+	if (!motSamplerInit(&smp, pClip)) return;
+	nnod = pClip->nnod;
+	nevl = pClip->nfrm * 4;
+	pPos = allocVecs(nnod);
+	pRot = allocQuats(nnod);
+	pScl = allocVecs(nnod);
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			motEvalPose(pClip, (float)k * dt, pPos, pRot, pScl);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / (double)nevl;
+		sumPose += poseSum(nnod, pPos, pRot, pScl);
+	}
+	dtPose = perfsmp(smps, N_PERF_SMP);
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		motSamplerSeek(&smp, 0.0f);
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			motSamplerEval(&smp, pPos, pRot, pScl);
+			motSamplerAdvance(&smp, dt);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / (double)nevl;
+		sumSmp += poseSum(nnod, pPos, pRot, pScl);
+	}
+	dtSmp = perfsmp(smps, N_PERF_SMP);
+	printf("EvalPose: sum = %f, dt = %f\n", sumPose, dtPose);
+	printf("Sampler: sum = %f, dt = %f\n", sumSmp, dtSmp);
+	printf("ratio: %f\n", dtPose / dtSmp);
+	motSamplerFree(&smp);
+	free(pPos);
+	free(pRot);
+	free(pScl);
+}
+
+static void perfQuantSub(MOT_CLIP* pClip, int qbits) {
+	MOT_CLIP* pQClip;
+	MOT_SAMPLER smp;
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
+	double smps[N_PERF_SMP];
+	double t0, t1, dt;
+	double sum = 0;
+	float encErr[3];
+	float poseErrMax = 0.0f;
+	float smpErr = 0.0f;
+	int i, k, ismp, nnod, nevl;
+	pQClip = motClipQuantize(pClip, qbits, encErr);
+	if (!pQClip) {
+		fprintf(stderr, "[ERR] Quantize(%d): failed\n", qbits);
+		return;
+	}
+	nnod = pClip->nnod;
+	nevl = pClip->nfrm * 4;
+	for (i = 0; i < 2; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+	}
+	motSamplerInit(&smp, pQClip);
+	for (k = 0; k < nevl; ++k) {
+		float frm = (float)k * 0.25f;
+		motEvalPose(pClip, frm, pPos[0], pRot[0], pScl[0]);
+		motEvalPose(pQClip, frm, pPos[1], pRot[1], pScl[1]);
+		poseErrMax = fmaxf(poseErrMax, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+		motSamplerSeek(&smp, frm);
+		motSamplerEval(&smp, pPos[0], pRot[0], pScl[0]);
+		smpErr = fmaxf(smpErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+	}
+	if (smpErr > 1.0e-5f) {
+		fprintf(stderr, "[ERR] Quantize(%d): sampler vs track decode err = %e\n", qbits, smpErr);
+	}
+	if (poseErrMax > 2.0f * fmaxf(encErr[0], fmaxf(encErr[1], encErr[2])) + 1.0e-5f) {
+		fprintf(stderr, "[ERR] Quantize(%d): pose err = %e\n", qbits, poseErrMax);
+	}
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		motSamplerSeek(&smp, 0.0f);
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			motSamplerEval(&smp, pPos[0], pRot[0], pScl[0]);
+			motSamplerAdvance(&smp, 0.25f);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / (double)nevl;
+		sum += poseSum(nnod, pPos[0], pRot[0], pScl[0]);
+	}
+	dt = perfsmp(smps, N_PERF_SMP);
+	printf("Quant%d: size = %d (%.1f%%), max err = %e/%e/%e, pose err = %e\n",
+	       qbits, pQClip->size, 100.0 * (double)pQClip->size / (double)pClip->size,
+	       encErr[0], encErr[1], encErr[2], poseErrMax);
+	printf("Quant%d Sampler: sum = %f, dt = %f\n", qbits, sum, dt);
+	motSamplerFree(&smp);
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+	}
+	free(pQClip);
+}
+
+static void perfQuant(MOT_CLIP* pClip) {
+	if (!pClip) return;
+	perfQuantSub(pClip, 16);
+	perfQuantSub(pClip, 12);
+	perfQuantSub(pClip, 8);
+}
+
+static void perfKeys(MOT_CLIP* pClip) {
+	static const float tol[3] = { 1.0e-2f, 1.0e-3f, 1.0e-3f };
+	static const float zeroTol[3] = { 0.0f, 0.0f, 0.0f };
+	MOT_CLIP* pKClip;
+	MOT_SAMPLER smp;
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
+	double smps[N_PERF_SMP];
+	double t0, t1, dt;
+	double sum;
+	float encErr[3];
+	float poseErrMax = 0.0f;
+	float smpErr = 0.0f;
+	int i, k, ismp, nnod, nevl, ntrk, nkey;
+	if (!pClip) return;
+	t0 = timestamp();
+	pKClip = motClipKeyReduce(pClip, tol, encErr);
+	t1 = timestamp();
+	if (!pKClip) {
+		fprintf(stderr, "[ERR] KeyReduce: failed\n");
+		return;
+	}
+	nnod = pClip->nnod;
+	nevl = pClip->nfrm * 4;
+	ntrk = 0;
+	nkey = 0;
+	for (i = 0; i < nnod; ++i) {
+		for (k = 0; k < 3; ++k) {
+			const MOT_TRACK* pTrk = &pKClip->nodes[i].trk[k];
+			if (pTrk->spline) {
+				const uint8_t* pBlk = (const uint8_t*)motGetTrackData(pKClip, i, (E_MOT_TRK)k);
+				int chan;
+				for (chan = 0; chan < 3; ++chan) {
+					if (pTrk->dataMask & (1 << chan)) {
+						uint32_t n = *(const uint32_t*)pBlk;
+						nkey += n;
+						++ntrk;
+						pBlk += sizeof(uint32_t) + ((n * sizeof(uint16_t) + 3) & ~3) + n * sizeof(float);
+					}
+				}
+			}
+		}
+	}
+	for (i = 0; i < 2; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+	}
+	motSamplerInit(&smp, pKClip);
+	for (k = 0; k < nevl; ++k) {
+		float frm = (float)k * 0.25f;
+		motEvalPose(pClip, frm, pPos[0], pRot[0], pScl[0]);
+		motEvalPose(pKClip, frm, pPos[1], pRot[1], pScl[1]);
+		poseErrMax = fmaxf(poseErrMax, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+		motSamplerAdvance(&smp, k ? 0.25f : 0.0f);
+		motSamplerEval(&smp, pPos[0], pRot[0], pScl[0]);
+		smpErr = fmaxf(smpErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+	}
+	for (k = 0; k < 3; ++k) {
+		if (encErr[k] > tol[k]) {
+			fprintf(stderr, "[ERR] KeyReduce: track kind %d err = %e\n", k, encErr[k]);
+		}
+	}
+	if (smpErr > 1.0e-5f) {
+		fprintf(stderr, "[ERR] KeyReduce: sampler vs track decode err = %e\n", smpErr);
+	}
+	if (poseErrMax > 2.0f * fmaxf(tol[0], fmaxf(tol[1], tol[2]))) {
+		fprintf(stderr, "[ERR] KeyReduce: pose err = %e\n", poseErrMax);
+	}
+	printf("KeyReduce: %.2f ms, size = %d (%.1f%%), %d spline channels, %.1f%% keys, max err = %e/%e/%e, pose err = %e\n",
+	       (t1 - t0) / 1000.0, pKClip->size, 100.0 * (double)pKClip->size / (double)pClip->size,
+	       ntrk, ntrk ? 100.0 * (double)nkey / ((double)ntrk * pClip->nfrm) : 0.0,
+	       encErr[0], encErr[1], encErr[2], poseErrMax);
+
+	sum = 0;
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		motSamplerSeek(&smp, 0.0f);
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			motSamplerEval(&smp, pPos[0], pRot[0], pScl[0]);
+			motSamplerAdvance(&smp, 0.25f);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / (double)nevl;
+		sum += poseSum(nnod, pPos[0], pRot[0], pScl[0]);
+	}
+	dt = perfsmp(smps, N_PERF_SMP);
+	printf("Keys Sampler (forward): sum = %f, dt = %f\n", sum, dt);
+	sum = 0;
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			/* jumps around the clip: cursors fall back to binary search */
+			motSamplerSeek(&smp, (float)((k * 37) % nevl) * 0.25f);
+			motSamplerEval(&smp, pPos[0], pRot[0], pScl[0]);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / (double)nevl;
+		sum += poseSum(nnod, pPos[0], pRot[0], pScl[0]);
+	}
+	dt = perfsmp(smps, N_PERF_SMP);
+	printf("Keys Sampler (random): sum = %f, dt = %f\n", sum, dt);
+	motSamplerFree(&smp);
+	free(pKClip);
+
+	/* zero tolerance: fitting must stop at exact keys instead of re-picking them */
+	pKClip = motClipKeyReduce(pClip, zeroTol, encErr);
+	if (pKClip) {
+		poseErrMax = 0.0f;
+		for (k = 0; k < (int)pClip->nfrm; ++k) {
+			motEvalPose(pClip, (float)k, pPos[0], pRot[0], pScl[0]);
+			motEvalPose(pKClip, (float)k, pPos[1], pRot[1], pScl[1]);
+			poseErrMax = fmaxf(poseErrMax, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+		}
+		if (!(poseErrMax <= 1.0e-5f) || encErr[0] != 0.0f || encErr[1] != 0.0f || encErr[2] != 0.0f) {
+			fprintf(stderr, "[ERR] KeyReduce (tol = 0): err = %e/%e/%e, pose err = %e\n", encErr[0], encErr[1], encErr[2], poseErrMax);
+		}
+		free(pKClip);
+	} else {
+		fprintf(stderr, "[ERR] KeyReduce (tol = 0): failed\n");
+	}
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+	}
+}
+
+/* per-channel recurrence, as eval_sub/eval_cpu in CUDA_mot_eval.cu */
+static void rdftRefEval(const MOT_RDFT* pRdft, float frm, float* pRes) {
+	float w = fmodf(fabsf(frm), (float)pRdft->nfrm) * (float)(2.0 * MOT_PI) / (float)pRdft->nfrm;
+	int i, k;
+	for (i = 0; i < pRdft->nchn; ++i) {
+		int cut = pRdft->pCut[i];
+		const float* pRe = &pRdft->pCoefs[pRdft->pOffs[i] + i % MOT_RDFT_LANES];
+		const float* pIm = pRe + MOT_RDFT_LANES;
+		float res = pRe[0];
+		float c = cosf(w);
+		float s = sinf(w);
+		float a = sinf(w * 0.5f);
+		float b = s;
+		a = 2.0f * a * a;
+		for (k = 1; k < cut; ++k) {
+			float ci, si;
+			res += pRe[k * 2 * MOT_RDFT_LANES]*c + pIm[k * 2 * MOT_RDFT_LANES]*s;
+			ci = c - (a*c + b*s);
+			si = s - (a*s - b*c);
+			c = ci;
+			s = si;
+		}
+		pRes[i] = res;
+	}
+}
+
+static void perfRdftSub(MOT_CLIP* pClip, float tol) {
+	MOT_RDFT rdft;
+	float* pRes;
+	float* pRef;
+	double smps[N_PERF_SMP];
+	double t0, t1, dt, dtRef;
+	double sum, l2, l2Sum;
+	float maxErr = 0.0f;
+	float refErr = 0.0f;
+	int i, k, ismp, simd, nchn, nfrm, nevl, minCut;
+	if (!pClip) return;
+	t0 = timestamp();
+	if (!motRdftInit(&rdft, pClip, tol)) {
+		fprintf(stderr, "[ERR] RDFT(%g): init failed\n", tol);
+		return;
+	}
+	t1 = timestamp();
+	nchn = rdft.nchn;
+	nfrm = rdft.nfrm;
+	nevl = nfrm * 4;
+	pRes = (float*)malloc(nchn * sizeof(float));
+	pRef = (float*)malloc(nchn * sizeof(float));
+	minCut = rdft.maxCut;
+	for (i = 0; i < nchn; ++i) {
+		if (rdft.pCut[i] < minCut) minCut = rdft.pCut[i];
+	}
+
+	/* res_l2: L2 norm of (series - track data) over all channels, averaged over frames */
+	l2Sum = 0.0;
+	for (k = 0; k < nfrm; ++k) {
+		motRdftEval(&rdft, (float)k, pRes);
+		l2 = 0.0;
+		for (i = 0; i < nchn; ++i) {
+			const MOT_CMAP* pMap = &rdft.pMap[i];
+			float d = pRes[i] - motGetVec(pClip, pMap->node, k, (E_MOT_TRK)pMap->kind).s[pMap->chan];
+			l2 += d * d;
+			maxErr = fmaxf(maxErr, fabsf(d));
+		}
+		l2Sum += sqrt(l2);
+	}
+	for (k = 0; k < nevl; ++k) {
+		float frm = (float)k * 0.25f;
+		motRdftEval(&rdft, frm, pRes);
+		rdftRefEval(&rdft, frm, pRef);
+		for (i = 0; i < nchn; ++i) {
+			refErr = fmaxf(refErr, fabsf(pRes[i] - pRef[i]));
+		}
+	}
+	if (refErr > 1.0e-4f) {
+		fprintf(stderr, "[ERR] RDFT(%g): recurrence mismatch = %e\n", tol, refErr);
+	}
+	if (tol <= 0.0f && maxErr > 1.0e-4f) {
+		fprintf(stderr, "[ERR] RDFT: full series err = %e\n", maxErr);
+	}
+	printf("RDFT(%g): %.2f ms, %d chans, cut %d..%d, coefs = %d bytes (%.1f%% of samples), res_l2 = %e, max err = %e\n",
+	       tol, (t1 - t0) / 1000.0, nchn, minCut, rdft.maxCut, (int)motRdftCoefSize(&rdft),
+	       100.0 * (double)motRdftCoefSize(&rdft) / ((double)nchn * nfrm * sizeof(float)),
+	       l2Sum / nfrm, maxErr);
+
+	sum = 0;
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			rdftRefEval(&rdft, (float)k * 0.25f, pRef);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / nevl;
+		for (i = 0; i < nchn; ++i) sum += pRef[i];
+	}
+	dtRef = perfsmp(smps, N_PERF_SMP);
+	printf("RDFT loop: sum = %f, dt = %f, %.1f Mchan/s\n", sum, dtRef, (double)nchn / dtRef);
+	for (simd = SIMD_NONE; simd <= SIMD_NEON; ++simd) {
+		if (!motSIMDCk((E_MOT_SIMD)simd)) continue;
+		motRdftSetSIMD(&rdft, (E_MOT_SIMD)simd);
+		sum = 0;
+		for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+			t0 = timestamp();
+			for (k = 0; k < nevl; ++k) {
+				motRdftEval(&rdft, (float)k * 0.25f, pRes);
+			}
+			t1 = timestamp();
+			smps[ismp] = (t1 - t0) / nevl;
+			for (i = 0; i < nchn; ++i) sum += pRes[i];
+		}
+		dt = perfsmp(smps, N_PERF_SMP);
+		printf("RDFT[%s]: sum = %f, dt = %f, %.1f Mchan/s, ratio = %f\n",
+		       motSIMDName((E_MOT_SIMD)simd), sum, dt, (double)nchn / dt, dtRef / dt);
+	}
+	motRdftFree(&rdft);
+	free(pRes);
+	free(pRef);
+}
+
+static MOT_CLIP* synthClip(int nnod, int nfrm);
+
+static void perfRdft(MOT_CLIP* pClip) {
+	MOT_CLIP* pSynth;
+	perfRdftSub(pClip, 0.0f);
+	perfRdftSub(pClip, 5.0e-4f);
+	/* truncated: the synthetic curves are harmonics 1..3, cut 2..4 */
+	pSynth = synthClip(200, 120);
+	perfRdftSub(pSynth, 5.0e-4f);
+	free(pSynth);
+}
+
+static void perfRdftClipSub(MOT_CLIP* pClip, const float* pTol) {
+	MOT_CLIP* pFClip;
+	MOT_SAMPLER smp;
+	MOT_RDFT rdft;
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
+	double smps[N_PERF_SMP];
+	double t0, t1, dt, dtInit, dtFwd;
+	double sum;
+	float encErr[3];
+	float keyErr = 0.0f;
+	float smpErr = 0.0f;
+	float rdftErr = 0.0f;
+	int i, k, ismp, nnod, nevl;
+	if (!pClip) return;
+	pFClip = motClipRdft(pClip, pTol, encErr);
+	if (!pFClip) {
+		fprintf(stderr, "[ERR] ClipRdft: failed\n");
+		return;
+	}
+	nnod = pClip->nnod;
+	nevl = pClip->nfrm * 4;
+	for (i = 0; i < 2; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+	}
+
+	/* startup: series taken from the clip vs transformed from the raw tracks */
+	t0 = timestamp();
+	motRdftInit(&rdft, pClip, 5.0e-4f);
+	t1 = timestamp();
+	dtFwd = t1 - t0;
+	motRdftFree(&rdft);
+	t0 = timestamp();
+	motRdftInit(&rdft, pFClip, 0.0f);
+	motSamplerInit(&smp, pFClip);
+	t1 = timestamp();
+	dtInit = t1 - t0;
+
+	for (k = 0; k < (int)pClip->nfrm; ++k) {
+		motEvalPose(pClip, (float)k, pPos[0], pRot[0], pScl[0]);
+		motEvalPose(pFClip, (float)k, pPos[1], pRot[1], pScl[1]);
+		keyErr = fmaxf(keyErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+	}
+	for (k = 0; k < nevl; ++k) {
+		float frm = (float)k * 0.25f;
+		motEvalPose(pFClip, frm, pPos[1], pRot[1], pScl[1]);
+		motSamplerAdvance(&smp, k ? 0.25f : 0.0f);
+		motSamplerEval(&smp, pPos[0], pRot[0], pScl[0]);
+		smpErr = fmaxf(smpErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+		/* tracks left dense are transformed at init: their in-betweens are not lerped */
+		if (k % 4 == 0) {
+			motRdftEvalPose(&rdft, frm, pPos[0], pRot[0], pScl[0]);
+			rdftErr = fmaxf(rdftErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+		}
+	}
+	for (k = 0; k < 3; ++k) {
+		if (pTol[k] >= 0.0f && encErr[k] > pTol[k]) {
+			fprintf(stderr, "[ERR] ClipRdft: track kind %d err = %e\n", k, encErr[k]);
+		}
+	}
+	if (keyErr > 2.0f * fmaxf(pTol[0], fmaxf(pTol[1], pTol[2]))) {
+		fprintf(stderr, "[ERR] ClipRdft: pose err = %e\n", keyErr);
+	}
+	if (smpErr > 1.0e-4f || rdftErr > 1.0e-4f) {
+		fprintf(stderr, "[ERR] ClipRdft: sampler err = %e, RDFT eval err = %e\n", smpErr, rdftErr);
+	}
+	printf("ClipRdft(%g/%g/%g): size = %d (%.1f%%), max err = %e/%e/%e, pose err = %e\n",
+	       pTol[0], pTol[1], pTol[2], pFClip->size, 100.0 * (double)pFClip->size / (double)pClip->size,
+	       encErr[0], encErr[1], encErr[2], keyErr);
+	printf("ClipRdft init: %f (transform at load: %f)\n", dtInit, dtFwd);
+
+	sum = 0;
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		motSamplerSeek(&smp, 0.0f);
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			motSamplerEval(&smp, pPos[0], pRot[0], pScl[0]);
+			motSamplerAdvance(&smp, 0.25f);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / (double)nevl;
+		sum += poseSum(nnod, pPos[0], pRot[0], pScl[0]);
+	}
+	dt = perfsmp(smps, N_PERF_SMP);
+	printf("ClipRdft Sampler: sum = %f, dt = %f\n", sum, dt);
+	motSamplerFree(&smp);
+	motRdftFree(&rdft);
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+	}
+	free(pFClip);
+}
+
+static void perfRdftClip(MOT_CLIP* pClip) {
+	static const float rotTol[3] = { -1.0f, 1.0e-3f, -1.0f };
+	static const float allTol[3] = { 1.0e-2f, 1.0e-3f, 1.0e-3f };
+	perfRdftClipSub(pClip, rotTol);
+	perfRdftClipSub(pClip, allTol);
+}
+
+static void perfStream(MOT_CLIP* pClip) {
+	const char* pStmPath = "../dump.mstm";
+	const int blkFrms = 16;
+	const int nwin = 3;
+	MOT_STM* pStm;
+	MOT_STREAM* pStrm;
+	MOT_STREAM_STATS stats;
+	FILE* pOut;
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
+	double t0, t1, dtStrm, dtEval;
+	float err = 0.0f;
+	float seekErr = 0.0f;
+	int i, k, nnod, nevl, nfail, nstall, maxStall;
+	if (!pClip) return;
+	pStm = motStmBuild(pClip, blkFrms);
+	if (!pStm) {
+		fprintf(stderr, "[ERR] Stream: build failed\n");
+		return;
+	}
+	pOut = fopen(pStmPath, "wb");
+	if (pOut) {
+		fwrite(pStm, pStm->size, 1, pOut);
+		fclose(pOut);
+	}
+	pStrm = motStreamOpen(pStmPath, nwin);
+	if (!pStrm) {
+		fprintf(stderr, "[ERR] Stream: open failed\n");
+		free(pStm);
+		return;
+	}
+	nnod = pClip->nnod;
+	for (i = 0; i < 2; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+	}
+
+	/* forward playback over two loops: only the very first block is waited for, see motstream.h for one CPU */
+	nevl = pClip->nfrm * 4 * 2;
+	maxStall = motCrowdCPUCount() > 1 ? 1 : (int)pStm->nblk * 2;
+	nfail = 0;
+	dtStrm = 0;
+	dtEval = 0;
+	for (k = 0; k < nevl; ++k) {
+		float frm = (float)k * 0.25f;
+		t0 = timestamp();
+		nfail += !motStreamEval(pStrm, frm, pPos[0], pRot[0], pScl[0]);
+		t1 = timestamp();
+		dtStrm += t1 - t0;
+		t0 = timestamp();
+		motEvalPose(pClip, frm, pPos[1], pRot[1], pScl[1]);
+		t1 = timestamp();
+		dtEval += t1 - t0;
+		err = fmaxf(err, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+	}
+	motStreamGetStats(pStrm, &stats);
+	nstall = stats.nstall;
+
+	/* random seeks are read synchronously */
+	for (k = 0; k < 64; ++k) {
+		float frm = (float)((k * 37) % pClip->nfrm) + 0.5f;
+		nfail += !motStreamEval(pStrm, frm, pPos[0], pRot[0], pScl[0]);
+		motEvalPose(pClip, frm, pPos[1], pRot[1], pScl[1]);
+		seekErr = fmaxf(seekErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+	}
+	if (nfail || err > 1.0e-5f || seekErr > 1.0e-5f) {
+		fprintf(stderr, "[ERR] Stream: %d failed, err = %e, seek err = %e\n", nfail, err, seekErr);
+	}
+	if (nstall > maxStall) {
+		fprintf(stderr, "[ERR] Stream: %d stalls in forward playback (max %d)\n", nstall, maxStall);
+	}
+	printf("Stream: %d blocks of %d frames, file = %d bytes, resident = %d bytes (window %d)\n",
+	       pStm->nblk, blkFrms, pStm->size, (int)stats.resident, nwin);
+	printf("Stream playback: loads = %d (%d prefetched), stalls = %d, err = %e, dt = %f (EvalPose: %f)\n",
+	       stats.nload, stats.nprefetch, nstall, err, dtStrm / nevl, dtEval / nevl);
+	motStreamClose(pStrm);
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+	}
+	free(pStm);
+}
+
+static int clipCorruptCk(const MOT_CLIP* pClip, size_t fieldOffs, uint32_t val) {
+	MOT_CLIP* pBad = (MOT_CLIP*)malloc(pClip->size);
+	int res;
+	if (!pBad) return 0;
+	memcpy(pBad, pClip, pClip->size);
+	*(uint32_t*)((uint8_t*)pBad + fieldOffs) = val;
+	res = motClipMemCk(pBad, pBad->size);
+	free(pBad);
+	return res;
+}
+
+/* quantized clip cut right after its last track: valid only with the 4 gather padding bytes */
+static int clipQuantTailCk(const MOT_CLIP* pQClip, size_t pad) {
+	MOT_CLIP* pBad;
+	size_t end = 0;
+	int i, kind, res;
+	for (i = 0; i < (int)pQClip->nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			const MOT_TRACK* pTrk = &pQClip->nodes[i].trk[kind];
+			uint32_t offs = pQClip->nodes[i].offs[kind];
+			size_t trkEnd = offs + (size_t)pQClip->nfrm * motMaskChanCount(pTrk->dataMask) * (pTrk->qbits <= 8 ? 1 : 2);
+			if (offs && trkEnd > end) end = trkEnd;
+		}
+	}
+	pBad = (MOT_CLIP*)malloc(pQClip->size);
+	if (!pBad) return 0;
+	memcpy(pBad, pQClip, pQClip->size);
+	pBad->eval = 0;
+	pBad->seq = 0;
+	pBad->size = (uint32_t)(end + pad);
+	res = motClipMemCk(pBad, pBad->size);
+	free(pBad);
+	return res;
+}
+
+static void verifyClipMap(MOT_CLIP* pClip, const char* pPath) {
+	static const float tol[3] = { 1.0e-2f, 1.0e-3f, 1.0e-3f };
+	MOT_FMAP fmap;
+	const MOT_CLIP* pMapped;
+	MOT_CLIP* pEnc[3];
+	MOT_SEQ* pSeq;
+	double t0, t1, dtMap, dtCk, dtLoad;
+	int i, nerr;
+	size_t nodeOffs;
+	if (!pClip) return;
+	nerr = 0;
+	t0 = timestamp();
+	pMapped = motClipMap(&fmap, pPath);
+	t1 = timestamp();
+	dtMap = t1 - t0;
+	if (!pMapped) {
+		fprintf(stderr, "[ERR] ClipMap: %s rejected\n", pPath);
+		return;
+	}
+	if (memcmp(pMapped, pClip, pClip->size) != 0) ++nerr;
+	if (motEvalQuat(pMapped, 3, 7.5f).w != motEvalQuat(pClip, 3, 7.5f).w) ++nerr;
+	t0 = timestamp();
+	for (i = 0; i < 100; ++i) {
+		nerr += !motClipMemCk(pMapped, fmap.size);
+	}
+	t1 = timestamp();
+	dtCk = (t1 - t0) / 100.0;
+	motFileUnmap(&fmap);
+	t0 = timestamp();
+	clipUnload(clipLoad(pPath));
+	t1 = timestamp();
+	dtLoad = t1 - t0;
+
+	/* encoded variants are valid images too */
+	pEnc[0] = motClipQuantize(pClip, 12, NULL);
+	pEnc[1] = motClipKeyReduce(pClip, tol, NULL);
+	pEnc[2] = motClipRdft(pClip, tol, NULL);
+	if (pEnc[0] && (clipQuantTailCk(pEnc[0], 0) || !clipQuantTailCk(pEnc[0], 4))) ++nerr;
+	for (i = 0; i < 3; ++i) {
+		if (!pEnc[i] || !motClipMemCk(pEnc[i], pEnc[i]->size)) ++nerr;
+		if (pEnc[i] && motClipMemCk(pEnc[i], pEnc[i]->size - 1)) ++nerr;
+		free(pEnc[i]);
+	}
+
+	/* truncation and stray offsets */
+	if (motClipMemCk(pClip, pClip->size - 1)) ++nerr;
+	if (motClipMemCk(pClip, offsetof(MOT_CLIP, nodes))) ++nerr;
+	nodeOffs = offsetof(MOT_CLIP, nodes) + (pClip->nnod - 1) * sizeof(MOT_NODE);
+	if (clipCorruptCk(pClip, offsetof(MOT_CLIP, nnod), pClip->nnod * 1000)) ++nerr;
+	if (clipCorruptCk(pClip, offsetof(MOT_CLIP, nfrm), 0)) ++nerr;
+	if (clipCorruptCk(pClip, offsetof(MOT_CLIP, hash), pClip->size - 4)) ++nerr;
+	if (clipCorruptCk(pClip, offsetof(MOT_CLIP, eval), pClip->size)) ++nerr;
+	if (clipCorruptCk(pClip, nodeOffs + offsetof(MOT_NODE, offs[TRK_ROT]), pClip->size - 16)) ++nerr;
+	pSeq = motGetSeqInfo(pClip);
+	if (pSeq && clipCorruptCk(pClip, pClip->seq + offsetof(MOT_SEQ, offs), pClip->size - 4)) ++nerr;
+	if (pSeq) {
+		/* stride past the 3 channels a track can have: node, chan and stride share one word */
+		i = 0;
+		while (!pSeq[i].offs) ++i;
+		if (clipCorruptCk(pClip, pClip->seq + i * sizeof(MOT_SEQ) + offsetof(MOT_SEQ, node), pSeq[i].node | (pSeq[i].chan << 16) | (4U << 24))) ++nerr;
+	}
+	if (nerr) {
+		fprintf(stderr, "[ERR] ClipMap: %d validation errors\n", nerr);
+	}
+	printf("ClipMap: map = %f, validate = %f, fread load = %f\n", dtMap, dtCk, dtLoad);
+}
+
+#define N_LIB_CLIPS (64)
+
+static uint32_t libStrHash(const char* pStr) {
+	uint32_t h = 2166136261U;
+	uint32_t c;
+	while ((c = (uint8_t)*pStr++)) {
+		h *= 16777619U;
+		h ^= c;
+	}
+	return h;
+}
+
+static int libHashCmp(const void* p1, const void* p2) {
+	uint32_t h1 = *(const uint32_t*)p1;
+	uint32_t h2 = *(const uint32_t*)p2;
+	return h1 < h2 ? -1 : h1 > h2 ? 1 : 0;
+}
+
+/* what cMotLibWriter writes, with nclip renamed copies of one clip */
+static MOT_LIB* libMake(const MOT_CLIP* pClip, int nclip) {
+	MOT_LIB* pLib;
+	uint8_t* pTop;
+	uint32_t* pOrd;
+	uint32_t* pOffs;
+	MOT_STRING* pNames;
+	size_t clipSize = (pClip->size + 0xF) & ~(size_t)0xF;
+	size_t dirSize, offs;
+	int i, nnod;
+	nnod = pClip->nnod;
+	dirSize = sizeof(MOT_LIB) + nclip * 2 * sizeof(uint32_t) + nnod * (sizeof(MOT_STRING) + sizeof(uint32_t));
+	dirSize = (dirSize + 0xF) & ~(size_t)0xF;
+	pLib = (MOT_LIB*)calloc(1, dirSize + clipSize * nclip);
+	pOrd = (uint32_t*)malloc(nclip * 2 * sizeof(uint32_t));
+	if (!pLib || !pOrd) {
+		free(pLib);
+		free(pOrd);
+		return NULL;
+	}
+	pTop = (uint8_t*)pLib;
+	memcpy(pLib->fmt, g_motLibFmt, 4);
+	pLib->nclip = nclip;
+	pLib->nnod = nnod;
+	pLib->size = (uint32_t)(dirSize + clipSize * nclip);
+	pLib->clips = sizeof(MOT_LIB);
+	pLib->hash = pLib->clips + nclip * sizeof(uint32_t);
+	pLib->nodes = pLib->hash + nclip * sizeof(uint32_t);
+	pLib->nodeHash = pLib->nodes + nnod * sizeof(MOT_STRING);
+	for (i = 0; i < nclip; ++i) {
+		char name[sizeof(MOT_STRING)];
+		sprintf(name, "%.40s_%04d", pClip->name.chr, i);
+		pOrd[i*2] = libStrHash(name);
+		pOrd[i*2 + 1] = i;
+	}
+	qsort(pOrd, nclip, 2 * sizeof(uint32_t), libHashCmp);
+	pOffs = (uint32_t*)(pTop + pLib->clips);
+	offs = dirSize;
+	for (i = 0; i < nclip; ++i) {
+		MOT_CLIP* pDst = (MOT_CLIP*)(pTop + offs);
+		memcpy(pDst, pClip, pClip->size);
+		sprintf(pDst->name.chr, "%.40s_%04d", pClip->name.chr, pOrd[i*2 + 1]);
+		pDst->name.len = (uint8_t)strlen(pDst->name.chr);
+		pOffs[i] = (uint32_t)offs;
+		((uint32_t*)(pTop + pLib->hash))[i] = pOrd[i*2];
+		offs += clipSize;
+	}
+	/* clip nodes are already in name hash order */
+	pNames = (MOT_STRING*)(pTop + pLib->nodes);
+	for (i = 0; i < nnod; ++i) {
+		pNames[i] = pClip->nodes[i].name;
+		((uint32_t*)(pTop + pLib->nodeHash))[i] = libStrHash(pClip->nodes[i].name.chr);
+	}
+	free(pOrd);
+	return pLib;
+}
+
+static void perfLib(MOT_CLIP* pClip) {
+	const char* pLibPath = "../dump.mlib";
+	const int nclip = N_LIB_CLIPS;
+	MOT_LIB* pLib;
+	MOT_LIB* pLoaded;
+	MOT_CLIP** ppLoose;
+	const MOT_LIB* pMapped;
+	MOT_FMAP fmap;
+	FILE* pOut;
+	char names[N_LIB_CLIPS][sizeof(MOT_STRING)];
+	double smps[N_PERF_SMP];
+	double t0, t1, dtLoose, dtLib, dtMap, dtFind;
+	int i, ismp, nerr, idx, sum;
+	if (!pClip) return;
+	pLib = libMake(pClip, nclip);
+	if (!pLib) return;
+	pOut = fopen(pLibPath, "wb");
+	if (pOut) {
+		fwrite(pLib, pLib->size, 1, pOut);
+		fclose(pOut);
+	}
+
+	/* one open + allocation per loose clip vs one per library, all kept resident */
+	ppLoose = (MOT_CLIP**)malloc(nclip * sizeof(MOT_CLIP*));
+	if (!ppLoose) {
+		free(pLib);
+		return;
+	}
+	t0 = timestamp();
+	for (i = 0; i < nclip; ++i) {
+		ppLoose[i] = clipLoad("../data/walk.mclp");
+	}
+	t1 = timestamp();
+	dtLoose = t1 - t0;
+	for (i = 0; i < nclip; ++i) {
+		clipUnload(ppLoose[i]);
+	}
+	free(ppLoose);
+	t0 = timestamp();
+	pLoaded = motLibLoad(pLibPath);
+	t1 = timestamp();
+	dtLib = t1 - t0;
+	if (!pLoaded) {
+		fprintf(stderr, "[ERR] Lib: load failed\n");
+		free(pLib);
+		return;
+	}
+
+	nerr = 0;
+	for (i = 0; i < nclip; ++i) {
+		const MOT_CLIP* pLibClip;
+		sprintf(names[i], "%.40s_%04d", pClip->name.chr, i);
+		idx = motLibFindClip(pLoaded, names[i]);
+		pLibClip = motLibGetClip(pLoaded, idx);
+		if (!pLibClip || strcmp(pLibClip->name.chr, names[i]) != 0) {
+			++nerr;
+		} else if (motEvalPos(pLibClip, 1, 1.5f).x != motEvalPos(pClip, 1, 1.5f).x) {
+			++nerr;
+		}
+	}
+	if (motLibFindClip(pLoaded, "no_such_clip") >= 0) ++nerr;
+	for (i = 0; i < (int)pClip->nnod; ++i) {
+		if (motLibFindNode(pLoaded, pClip->nodes[i].name.chr) != i) ++nerr;
+	}
+	if (motLibMemCk(pLoaded, pLoaded->size - 1)) ++nerr;
+	t0 = timestamp();
+	pMapped = motLibMap(&fmap, pLibPath);
+	t1 = timestamp();
+	dtMap = t1 - t0;
+	if (!pMapped || motLibFindClipPtr(pMapped, names[nclip - 1]) == NULL) ++nerr;
+	motFileUnmap(&fmap);
+	if (nerr) {
+		fprintf(stderr, "[ERR] Lib: %d lookup errors\n", nerr);
+	}
+
+	sum = 0;
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (i = 0; i < nclip; ++i) {
+			sum += motLibFindClip(pLoaded, names[i]);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / (double)nclip;
+	}
+	dtFind = perfsmp(smps, N_PERF_SMP);
+	printf("Lib: %d clips, %d bytes, load = %f (loose clips: %f), map = %f, find = %f (%d)\n", nclip, pLoaded->size, dtLib, dtLoose, dtMap, dtFind, sum);
+	motLibFree(pLoaded);
+	free(pLib);
+}
+
+/* library written by hclip.cs (hclip -lib:<motion.mlib> <motion1.clip> ...) */
+static void verifyLibFile(const char* pLibPath) {
+	MOT_LIB* pLib;
+	int i, j, nclip;
+	int nerr = 0;
+	pLib = motLibLoad(pLibPath);
+	if (!pLib) return;
+	if (!motLibMemCk(pLib, pLib->size)) ++nerr;
+	nclip = motLibClipCount(pLib);
+	for (i = 0; i < nclip; ++i) {
+		const MOT_CLIP* pLibClip = motLibGetClip(pLib, i);
+		if (!pLibClip || !motClipHeaderCk(pLibClip)) {
+			++nerr;
+			continue;
+		}
+		if (motLibFindClip(pLib, pLibClip->name.chr) != i) ++nerr;
+		if (!motClipMemCk(pLibClip, pLibClip->size)) ++nerr;
+		for (j = 0; j < (int)pLibClip->nnod; ++j) {
+			int inod = motLibFindNode(pLib, pLibClip->nodes[j].name.chr);
+			if (inod < 0 || strcmp(motLibGetNodeName(pLib, inod), pLibClip->nodes[j].name.chr) != 0) ++nerr;
+		}
+	}
+	if (nerr) {
+		fprintf(stderr, "[ERR] LibFile: %d errors in %s\n", nerr, pLibPath);
+	}
+	printf("LibFile: %s, %d clips, %d nodes, %d bytes\n", pLibPath, nclip, (int)pLib->nnod, (int)pLib->size);
+	motLibFree(pLib);
+}
+
+/* skeleton: clip nodes in reverse order, one joint per 8 not in the clip, plus a name too long for MOT_STRING */
+static const char** bindTestNames(const MOT_CLIP* pClip, int* pNjnt, char* pExtra) {
+	int i, nnod, njnt;
+	const char** ppNames;
+	nnod = pClip->nnod;
+	njnt = nnod + nnod / 8 + 1;
+	ppNames = (const char**)malloc(njnt * sizeof(char*));
+	if (!ppNames) return NULL;
+	for (i = 0; i < nnod; ++i) {
+		ppNames[i] = pClip->nodes[nnod - 1 - i].name.chr;
+	}
+	for (i = 0; i < nnod / 8; ++i) {
+		char* pName = &pExtra[i * 16];
+		sprintf(pName, "extra%d", i);
+		ppNames[nnod + i] = pName;
+	}
+	memset(&pExtra[(nnod / 8) * 16], 'x', sizeof(MOT_STRING) + 8);
+	pExtra[(nnod / 8) * 16 + sizeof(MOT_STRING) + 8] = 0;
+	ppNames[njnt - 1] = &pExtra[(nnod / 8) * 16];
+	*pNjnt = njnt;
+	return ppNames;
+}
+
+static int bindCk(const MOT_BIND* pBind, const MOT_CLIP* pClip, const char* const* ppNames, int16_t* pNodeJnt, int16_t* pJntNode) {
+	int i;
+	int nerr = 0;
+	motBindClip(pBind, pClip, pNodeJnt, pJntNode);
+	for (i = 0; i < pBind->njnt; ++i) {
+		int inod = motFindClipNode(pClip, ppNames[i]);
+		if (pJntNode[i] != inod) ++nerr;
+		if (inod >= 0 && pNodeJnt[inod] != i) ++nerr;
+	}
+	for (i = 0; i < (int)pClip->nnod; ++i) {
+		if (pNodeJnt[i] >= 0 && strcmp(ppNames[pNodeJnt[i]], pClip->nodes[i].name.chr) != 0) ++nerr;
+	}
+	return nerr;
+}
+
+static void perfBind(MOT_CLIP* pClip) {
+	MOT_BIND bind;
+	MOT_LIB* pLib;
+	MOT_CLIP* pNoHash;
+	const char** ppNames;
+	char* pExtra;
+	int16_t* pNodeJnt;
+	int16_t* pJntNode;
+	int16_t* pMaps;
+	uint32_t* pOffs;
+	double smps[N_PERF_SMP];
+	double t0, t1, dtFind, dtBind;
+	int i, j, ismp, njnt, nclip, nerr, nfind, nbound;
+	if (!pClip) return;
+	pExtra = (char*)malloc(pClip->nnod * 2 + sizeof(MOT_STRING) * 2);
+	ppNames = pExtra ? bindTestNames(pClip, &njnt, pExtra) : NULL;
+	if (!ppNames || !motBindInit(&bind, ppNames, njnt)) {
+		fprintf(stderr, "[ERR] Bind: init failed\n");
+		free(pExtra);
+		free((void*)ppNames);
+		return;
+	}
+	pNodeJnt = (int16_t*)malloc(pClip->nnod * sizeof(int16_t));
+	pJntNode = (int16_t*)malloc(njnt * sizeof(int16_t));
+	nerr = bindCk(&bind, pClip, ppNames, pNodeJnt, pJntNode);
+
+	/* same names without the clip's hash table */
+	pNoHash = (MOT_CLIP*)malloc(pClip->size);
+	if (pNoHash) {
+		memcpy(pNoHash, pClip, pClip->size);
+		pNoHash->hash = 0;
+		nerr += bindCk(&bind, pNoHash, ppNames, pNodeJnt, pJntNode);
+		free(pNoHash);
+	}
+
+	/* whole library: one map per clip, against per-joint lookups */
+	nclip = 64;
+	pLib = libMake(pClip, nclip);
+	if (!pLib) {
+		fprintf(stderr, "[ERR] Bind: no library\n");
+		motBindFree(&bind);
+		free(pNodeJnt);
+		free(pJntNode);
+		free((void*)ppNames);
+		free(pExtra);
+		return;
+	}
+	pMaps = (int16_t*)malloc(motBindLibSize(pLib) * sizeof(int16_t));
+	pOffs = (uint32_t*)malloc(nclip * sizeof(uint32_t));
+	nbound = motBindLib(&bind, pLib, pMaps, pOffs);
+	for (i = 0; i < nclip; ++i) {
+		const MOT_CLIP* pLibClip = motLibGetClip(pLib, i);
+		for (j = 0; j < (int)pLibClip->nnod; ++j) {
+			if (pMaps[pOffs[i] + j] != pNodeJnt[j]) ++nerr;
+		}
+	}
+	if (nbound != nclip * (int)pClip->nnod) ++nerr;
+	nfind = 0;
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (i = 0; i < nclip; ++i) {
+			const MOT_CLIP* pLibClip = motLibGetClip(pLib, i);
+			int16_t* pMap = &pMaps[pOffs[i]];
+			for (j = 0; j < (int)pLibClip->nnod; ++j) {
+				pMap[j] = -1;
+			}
+			for (j = 0; j < njnt; ++j) {
+				int inod = motFindClipNode(pLibClip, ppNames[j]);
+				if (inod >= 0) {
+					pMap[inod] = (int16_t)j;
+					++nfind;
+				}
+			}
+		}
+		t1 = timestamp();
+		smps[ismp] = t1 - t0;
+	}
+	dtFind = perfsmp(smps, N_PERF_SMP);
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		MOT_BIND tmp;
+		t0 = timestamp();
+		motBindInit(&tmp, ppNames, njnt);
+		nbound = motBindLib(&tmp, pLib, pMaps, pOffs);
+		motBindFree(&tmp);
+		t1 = timestamp();
+		smps[ismp] = t1 - t0;
+	}
+	dtBind = perfsmp(smps, N_PERF_SMP);
+	if (nerr || nfind != nbound * N_PERF_SMP) {
+		fprintf(stderr, "[ERR] Bind: %d mismatches, %d found, %d bound\n", nerr, nfind / N_PERF_SMP, nbound);
+	}
+	printf("Bind: %d joints x %d clips, %d bound, FindClipNode: dt = %f, BindLib: dt = %f, ratio: %f\n",
+	       njnt, nclip, nbound, dtFind, dtBind, dtFind / dtBind);
+	motBindFree(&bind);
+	free(pLib);
+	free(pMaps);
+	free(pOffs);
+	free(pNodeJnt);
+	free(pJntNode);
+	free((void*)ppNames);
+	free(pExtra);
+}
+
+/* nnod nodes with animated pos and rot (log vectors), constant scl, in name hash order with EVAL */
+static MOT_CLIP* synthClip(int nnod, int nfrm) {
+	MOT_CLIP* pClip;
+	MOT_EVAL* pEval;
+	uint8_t* pTop;
+	uint32_t* pOrd;
+	float* pData;
+	size_t hdrSize, dataSize, evalSize, offs;
+	int i, f, kind, chan, icrv;
+	hdrSize = offsetof(MOT_CLIP, nodes) + nnod * sizeof(MOT_NODE);
+	hdrSize = (hdrSize + nnod * sizeof(uint32_t) + 0xF) & ~(size_t)0xF;
+	dataSize = (size_t)nnod * 2 * nfrm * 3 * sizeof(float);
+	evalSize = offsetof(MOT_EVAL, map) + nnod * 6 * sizeof(MOT_CMAP);
+	pClip = (MOT_CLIP*)calloc(1, hdrSize + dataSize + evalSize);
+	pOrd = (uint32_t*)malloc(nnod * 2 * sizeof(uint32_t));
+	if (!pClip || !pOrd) {
+		free(pClip);
+		free(pOrd);
+		return NULL;
+	}
+	pTop = (uint8_t*)pClip;
+	memcpy(pClip->fmt, "MCLP", 4);
+	pClip->size = (uint32_t)(hdrSize + dataSize + evalSize);
+	pClip->rate = 30.0f;
+	pClip->nfrm = nfrm;
+	pClip->nnod = nnod;
+	pClip->hash = (uint32_t)(offsetof(MOT_CLIP, nodes) + nnod * sizeof(MOT_NODE));
+	sprintf(pClip->name.chr, "synth%d", nnod);
+	pClip->name.len = (uint8_t)strlen(pClip->name.chr);
+	for (i = 0; i < nnod; ++i) {
+		char name[16];
+		sprintf(name, "node%03d", i);
+		pOrd[i*2] = libStrHash(name);
+		pOrd[i*2 + 1] = i;
+	}
+	qsort(pOrd, nnod, 2 * sizeof(uint32_t), libHashCmp);
+	offs = hdrSize;
+	for (i = 0; i < nnod; ++i) {
+		MOT_NODE* pNode = &pClip->nodes[i];
+		sprintf(pNode->name.chr, "node%03d", pOrd[i*2 + 1]);
+		pNode->name.len = (uint8_t)strlen(pNode->name.chr);
+		((uint32_t*)(pTop + pClip->hash))[i] = pOrd[i*2];
+		pNode->xord = XORD_SRT;
+		pNode->rord = (uint8_t)(i % 6);
+		for (kind = 0; kind < 2; ++kind) {
+			MOT_TRACK* pTrk = &pNode->trk[kind];
+			float amp = kind == TRK_POS ? 2.0f : 0.4f;
+			pTrk->srcMask = 7;
+			pTrk->dataMask = 7;
+			pTrk->stride = 3;
+			pNode->offs[kind] = (uint32_t)offs;
+			pData = (float*)(pTop + offs);
+			for (f = 0; f < nfrm; ++f) {
+				for (chan = 0; chan < 3; ++chan) {
+					float v = amp * sinf(6.2831853f * (float)f / (float)nfrm * (float)(1 + chan) + (float)(i * 3 + kind));
+					pData[f*3 + chan] = v;
+					pTrk->vmin.s[chan] = f ? fminf(pTrk->vmin.s[chan], v) : v;
+					pTrk->vmax.s[chan] = f ? fmaxf(pTrk->vmax.s[chan], v) : v;
+				}
+			}
+			offs += nfrm * 3 * sizeof(float);
+		}
+		pNode->trk[TRK_SCL].vmin.x = pNode->trk[TRK_SCL].vmin.y = pNode->trk[TRK_SCL].vmin.z = 1.0f;
+		pNode->trk[TRK_SCL].vmax = pNode->trk[TRK_SCL].vmin;
+	}
+	pClip->eval = (uint32_t)offs;
+	pEval = (MOT_EVAL*)(pTop + offs);
+	icrv = 0;
+	for (kind = 0; kind < 2; ++kind) {
+		pEval->ntrk[kind] = nnod;
+		pEval->nchn[kind] = nnod * 3;
+		pEval->ncrv[kind] = nnod * 3;
+		for (i = 0; i < nnod; ++i) {
+			for (chan = 0; chan < 3; ++chan) {
+				pEval->map[icrv].node = (uint16_t)i;
+				pEval->map[icrv].kind = (uint8_t)kind;
+				pEval->map[icrv].chan = (uint8_t)chan;
+				++icrv;
+			}
+		}
+	}
+	free(pOrd);
+	return pClip;
+}
+
+#if defined(__linux__)
+static int cacheMissOpen() {
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+/* random frames, so every pose is a cold read of its two frames; pMiss: -1 without counters */
+static double frameMajorPerfSub(const MOT_CLIP* pClip, int nevl, double* pMiss) {
+	MOT_SAMPLER smp;
+	double smps[N_PERF_SMP];
+	double t0, t1;
+	double sum = 0.0;
+	int ismp, k, nnod;
+	int fd = -1;
+	uint32_t seed = 1;
+	MOT_VEC* pPos;
+	MOT_QUAT* pRot;
+	MOT_VEC* pScl;
+	*pMiss = -1.0;
+	if (!motSamplerInit(&smp, pClip)) return 0.0;
+	nnod = pClip->nnod;
+	pPos = allocVecs(nnod);
+	pRot = allocQuats(nnod);
+	pScl = allocVecs(nnod);
+#if defined(__linux__)
+	fd = cacheMissOpen();
+	if (fd >= 0) {
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			seed = seed * 1664525U + 1013904223U;
+			motSamplerSeek(&smp, (float)(seed >> 8) * (float)pClip->nfrm / 16777216.0f);
+			motSamplerEval(&smp, pPos, pRot, pScl);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / (double)nevl;
+		sum += poseSum(nnod, pPos, pRot, pScl);
+	}
+#if defined(__linux__)
+	if (fd >= 0) {
+		long long cnt = 0;
+		ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(fd, &cnt, sizeof(cnt)) == sizeof(cnt)) {
+			*pMiss = (double)cnt / ((double)N_PERF_SMP * nevl);
+		}
+		close(fd);
+	}
+#endif
+	(void)sum;
+	motSamplerFree(&smp);
+	free(pPos);
+	free(pRot);
+	free(pScl);
+	return perfsmp(smps, N_PERF_SMP);
+}
+
+static void verifyFrameMajor(MOT_CLIP* pClip, MOT_CLIP* pRClip) {
+	MOT_SAMPLER smp;
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
+	float poseErrMax = 0.0f;
+	float smpErr = 0.0f;
+	float nodeErr = 0.0f;
+	int i, k, nnod;
+	nnod = pClip->nnod;
+	if (!motClipFrameMajorCk(pRClip) || !motClipMemCk(pRClip, pRClip->size) || !motSamplerInit(&smp, pRClip)) {
+		fprintf(stderr, "[ERR] FrameMajor: %s: bad clip\n", pClip->name.chr);
+		return;
+	}
+	for (i = 0; i < 2; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+	}
+	for (k = 0; k < (int)pClip->nfrm * 4; ++k) {
+		float f = (float)k * 0.25f;
+		motEvalPose(pClip, f, pPos[0], pRot[0], pScl[0]);
+		motEvalPose(pRClip, f, pPos[1], pRot[1], pScl[1]);
+		poseErrMax = fmaxf(poseErrMax, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+		motSamplerSeek(&smp, f);
+		motSamplerEval(&smp, pPos[1], pRot[1], pScl[1]);
+		smpErr = fmaxf(smpErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+		for (i = 0; i < nnod; ++i) {
+			motSamplerEvalNode(&smp, i, &pPos[1][i], &pRot[1][i], &pScl[1][i]);
+		}
+		nodeErr = fmaxf(nodeErr, poseErr(nnod, pPos[0], pRot[0], pScl[0], pPos[1], pRot[1], pScl[1]));
+	}
+	if (poseErrMax > 1.0e-5f || smpErr > 1.0e-5f || nodeErr > 1.0e-5f) {
+		fprintf(stderr, "[ERR] FrameMajor: %s: pose err = %e, sampler err = %e, node err = %e\n", pClip->name.chr, poseErrMax, smpErr, nodeErr);
+	}
+	motSamplerFree(&smp);
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+	}
+}
+
+static void perfFrameMajorSub(MOT_CLIP* pClip) {
+	MOT_CLIP* pRClip = motClipFrameMajor(pClip);
+	double dtTrk, dtRow, missTrk, missRow;
+	const int nevl = 256;
+	if (!pRClip) {
+		fprintf(stderr, "[ERR] FrameMajor: %s: conversion failed\n", pClip->name.chr);
+		return;
+	}
+	verifyFrameMajor(pClip, pRClip);
+	dtTrk = frameMajorPerfSub(pClip, nevl, &missTrk);
+	dtRow = frameMajorPerfSub(pRClip, nevl, &missRow);
+	printf("FrameMajor %s: %d nodes, row = %d floats, track-major: %f us/pose", pClip->name.chr, pClip->nnod, motClipRowWidth(pRClip), dtTrk);
+	if (missTrk >= 0.0) {
+		printf(" (%.1f misses)", missTrk);
+	}
+	printf(", frame-major: %f us/pose", dtRow);
+	if (missRow >= 0.0) {
+		printf(" (%.1f misses)", missRow);
+	} else {
+		printf(" (cache misses n/a)");
+	}
+	printf(", ratio %f\n", dtTrk / dtRow);
+	free(pRClip);
+}
+
+static void perfFrameMajor(MOT_CLIP* pClip) {
+	static const int nnods[] = { 50, 100, 200, 500 };
+	int i;
+	if (pClip) {
+		perfFrameMajorSub(pClip);
+	}
+	for (i = 0; i < (int)(sizeof(nnods) / sizeof(nnods[0])); ++i) {
+		MOT_CLIP* pSynth = synthClip(nnods[i], 120);
+		if (!pSynth) continue;
+		if (!motClipMemCk(pSynth, pSynth->size)) {
+			fprintf(stderr, "[ERR] FrameMajor: bad synthetic clip\n");
+		} else {
+			perfFrameMajorSub(pSynth);
+		}
+		free(pSynth);
+	}
+}
+
+static MOT_PSQ* psqLoad(const char* pPath) {
+	MOT_PSQ* pPsq = NULL;
+	FILE* f = fopen(pPath, "rb");
+	if (f) {
+		long len = 0;
+		if (0 == fseek(f, 0, SEEK_END)) {
+			len = ftell(f);
+		}
+		fseek(f, 0, SEEK_SET);
+		if (len > (long)sizeof(MOT_PSQ)) {
+			pPsq = (MOT_PSQ*)malloc(len);
+			if (pPsq) {
+				fread(pPsq, len, 1, f);
+				if (!motPsqHeaderCk(pPsq)) {
+					free(pPsq);
+					pPsq = NULL;
+				}
+			}
+		}
+		fclose(f);
+	}
+	return pPsq;
+}
+
+static float quatDiff(const MOT_QUAT q0, const MOT_QUAT q1) {
+	float d = q0.x*q1.x + q0.y*q1.y + q0.z*q1.z + q0.w*q1.w;
+	float s = d < 0.0f ? -1.0f : 1.0f;
+	float err = 0.0f;
+	int i;
+	for (i = 0; i < 4; ++i) {
+		err = fmaxf(err, fabsf(q0.s[i] - q1.s[i]*s));
+	}
+	return err;
+}
+
+/*
+ * Minimal PoseSeq/psq.py writer for the test: the key poses of a clip, every
+ * track relative (no octa quats), rotations with rotCut fraction bits cut as
+ * psq.py does for lossy levels, vectors lossless.
+ */
+static uint32_t psqRelExp(float x) {
+	uint32_t b;
+	int e;
+	memcpy(&b, &x, sizeof(b));
+	e = (int)((b >> 23) & 0xFF) - 127;
+	return (uint32_t)(abs(e) + 1) & 0x7F;
+}
+
+static void psqPutBits(uint8_t* pBits, uint32_t* pPos, uint32_t val, int n) {
+	int i;
+	for (i = 0; i < n; ++i) {
+		if (val & (1U << i)) {
+			pBits[(*pPos + i) >> 3] |= (uint8_t)(1 << ((*pPos + i) & 7));
+		}
+	}
+	*pPos += n;
+}
+
+/* encodeRelVec in psq.py: unary exponent width, then exponent and cut fraction per value */
+static void psqPutRel(uint8_t* pBits, uint32_t* pPos, const float* pRel, int n, int mcut) {
+	uint32_t maxExp = 0;
+	int i, nb = 0;
+	for (i = 0; i < n; ++i) {
+		uint32_t e = psqRelExp(pRel[i]);
+		if (e > maxExp) maxExp = e;
+	}
+	while (maxExp >> nb) ++nb;
+	psqPutBits(pBits, pPos, 1U << nb, nb + 1);
+	for (i = 0; i < n; ++i) {
+		uint32_t m;
+		memcpy(&m, &pRel[i], sizeof(m));
+		psqPutBits(pBits, pPos, psqRelExp(pRel[i]), nb);
+		psqPutBits(pBits, pPos, (m & 0x7FFFFF) >> mcut, 23 - mcut);
+	}
+}
+
+static uint16_t psqHash16(const char* pStr) {
+	uint32_t h = 2166136261;
+	while (*pStr) {
+		h ^= (uint8_t)*pStr++;
+		h *= 16777619;
+	}
+	return (uint16_t)((h >> 16) ^ (h & 0xFFFF));
+}
+
+/* source lanes per node and pose: rot 0..3, pos 4..6, scl 7..9 */
+#define N_PSQ_SMP (10)
+
+static MOT_PSQ* psqSynth(const MOT_CLIP* pClip, int rotCut) {
+	static const E_MOT_TRK kinds[] = { TRK_ROT, TRK_POS, TRK_SCL };
+	static const int lanes[] = { 0, 4, 7 };
+	MOT_PSQ* pPsq;
+	MOT_PSQ_NODE* pNodes;
+	uint8_t* pTop;
+	uint8_t* pBits;
+	uint32_t* pPoseSize;
+	float* pVecs;
+	float* pSmp;
+	float* pBox;
+	MOT_VEC* pPos;
+	MOT_QUAT* pRot;
+	MOT_VEC* pScl;
+	size_t memSize, offs;
+	uint32_t nbits;
+	int i, j, k, kind, nnod, npose, nvec;
+	nnod = pClip->nnod;
+	npose = pClip->nfrm;
+	pSmp = (float*)malloc((size_t)npose * nnod * N_PSQ_SMP * sizeof(float));
+	/* per node and kind: min[4], size[4] */
+	pBox = (float*)malloc((size_t)nnod * 3 * 8 * sizeof(float));
+	pPos = allocVecs(nnod);
+	pRot = allocQuats(nnod);
+	pScl = allocVecs(nnod);
+	for (k = 0; k < npose; ++k) {
+		motEvalPose(pClip, (float)k, pPos, pRot, pScl);
+		for (i = 0; i < nnod; ++i) {
+			float* pDst = &pSmp[((size_t)k * nnod + i) * N_PSQ_SMP];
+			for (j = 0; j < 4; ++j) {
+				pDst[j] = pRot[i].s[j];
+			}
+			for (j = 0; j < 3; ++j) {
+				pDst[4 + j] = pPos[i].s[j];
+				pDst[7 + j] = pScl[i].s[j];
+			}
+		}
+	}
+	free(pPos);
+	free(pRot);
+	free(pScl);
+	nvec = 0;
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			float* pMin = &pBox[(i * 3 + kind) * 8];
+			float* pSize = pMin + 4;
+			int nelem = kind ? 3 : 4;
+			for (j = 0; j < 4; ++j) {
+				float vmin = 1.0f;
+				float vmax = 1.0f;
+				for (k = 0; k < npose && j < nelem; ++k) {
+					float v = pSmp[((size_t)k * nnod + i) * N_PSQ_SMP + lanes[kind] + j];
+					vmin = k ? fminf(vmin, v) : v;
+					vmax = k ? fmaxf(vmax, v) : v;
+				}
+				pMin[j] = vmin;
+				pSize[j] = vmax - vmin;
+			}
+			if (motNodeTrackCk(pClip, i, kinds[kind])) {
+				nvec += (pSize[0] != 0.0f || pSize[1] != 0.0f || pSize[2] != 0.0f || pSize[3] != 0.0f) ? 2 : 1;
+			}
+		}
+	}
+
+	/* a relative record is at most 8 + 4 * (7 + 23) bits */
+	memSize = sizeof(MOT_PSQ) + nvec * 4 * sizeof(float) + nnod * sizeof(MOT_PSQ_NODE)
+	        + npose * sizeof(uint32_t) + (size_t)npose * nnod * 3 * 16 + 8 + nnod * (sizeof(uint16_t) + sizeof(MOT_STRING));
+	pPsq = (MOT_PSQ*)calloc(1, memSize);
+	if (!pPsq) {
+		free(pSmp);
+		free(pBox);
+		return NULL;
+	}
+	pTop = (uint8_t*)pPsq;
+	memcpy(pPsq->fmt, g_motPsqFmt, 4);
+	pPsq->nnod = (uint16_t)nnod;
+	pPsq->npose = (uint16_t)npose;
+	pPsq->nvec = (uint16_t)nvec;
+	pPsq->reserved = 0xFFFF;
+	pPsq->vecs = sizeof(MOT_PSQ);
+	pPsq->nodes = pPsq->vecs + nvec * 4 * sizeof(float);
+	pPsq->poseSize = pPsq->nodes + nnod * sizeof(MOT_PSQ_NODE);
+	pVecs = (float*)(pTop + pPsq->vecs);
+	pNodes = (MOT_PSQ_NODE*)(pTop + pPsq->nodes);
+	pPoseSize = (uint32_t*)(pTop + pPsq->poseSize);
+	pBits = (uint8_t*)(pPoseSize + npose);
+
+	nvec = 0;
+	for (i = 0; i < nnod; ++i) {
+		MOT_PSQ_NODE* pNode = &pNodes[i];
+		pNode->xord = pClip->nodes[i].xord;
+		pNode->rord = pClip->nodes[i].rord;
+		for (kind = 0; kind < 3; ++kind) {
+			const float* pMin = &pBox[(i * 3 + kind) * 8];
+			pNode->vecId[kind][0] = -1;
+			pNode->vecId[kind][1] = -1;
+			if (!motNodeTrackCk(pClip, i, kinds[kind])) continue;
+			pNode->trkMask |= (uint8_t)(1 << kind);
+			for (j = 0; j < 4; ++j) {
+				if (pMin[4 + j] != 0.0f) pNode->axisMask[kind] |= (uint8_t)(1 << j);
+			}
+			memcpy(&pVecs[nvec * 4], pMin, 4 * sizeof(float));
+			pNode->vecId[kind][0] = (int16_t)nvec++;
+			if (pNode->axisMask[kind]) {
+				memcpy(&pVecs[nvec * 4], pMin + 4, 4 * sizeof(float));
+				pNode->vecId[kind][1] = (int16_t)nvec++;
+				pNode->bitInfo[kind] = (uint16_t)(kind == 0 ? rotCut : 0);
+			}
+		}
+	}
+
+	/* pose records: nodes in order, rot pos scl per node */
+	nbits = 0;
+	for (k = 0; k < npose; ++k) {
+		uint32_t org = nbits;
+		for (i = 0; i < nnod; ++i) {
+			const MOT_PSQ_NODE* pNode = &pNodes[i];
+			const float* pSrc = &pSmp[((size_t)k * nnod + i) * N_PSQ_SMP];
+			for (kind = 0; kind < 3; ++kind) {
+				const float* pMin = &pBox[(i * 3 + kind) * 8];
+				float rel[4];
+				int n = 0;
+				if (pNode->vecId[kind][1] < 0) continue;
+				for (j = 0; j < 4; ++j) {
+					if (!(pNode->axisMask[kind] & (1 << j))) continue;
+					rel[n++] = fminf(fmaxf((pSrc[lanes[kind] + j] - pMin[j]) / pMin[4 + j], 0.0f), 1.0f);
+				}
+				psqPutRel(pBits, &nbits, rel, n, pNode->bitInfo[kind]);
+			}
+		}
+		pPoseSize[k] = nbits - org;
+	}
+	pPsq->nbits = nbits;
+
+	offs = (size_t)(pBits - pTop) + ((nbits + 7) >> 3);
+	for (i = 0; i < nnod; ++i) {
+		const char* pName = pClip->nodes[i].name.chr;
+		uint16_t h = psqHash16(pName);
+		pNodes[i].name = (uint32_t)offs;
+		memcpy(pTop + offs, &h, sizeof(h));
+		strcpy((char*)pTop + offs + sizeof(h), pName);
+		offs += sizeof(h) + strlen(pName) + 1;
+	}
+	pPsq->size = (uint32_t)offs;
+	free(pSmp);
+	free(pBox);
+	return pPsq;
+}
+
+/* decoded lane error of a relative track: 23 - mcut fraction bits of rel, then base + rel*size */
+static float psqLaneBound(const MOT_PSQ* pPsq, const MOT_PSQ_NODE* pNode, int kind) {
+	const float* pVecs = (const float*)((const uint8_t*)pPsq + pPsq->vecs);
+	const float* pBase = &pVecs[pNode->vecId[kind][0] * 4];
+	float bound = 0.0f;
+	int j;
+	for (j = 0; j < 4; ++j) {
+		float size = pNode->vecId[kind][1] >= 0 ? pVecs[pNode->vecId[kind][1] * 4 + j] : 0.0f;
+		float b = size * ldexpf(1.0f, (pNode->bitInfo[kind] & 0xFF) - 23) + 2.0f * FLT_EPSILON * (fabsf(pBase[j]) + size);
+		bound = fmaxf(bound, b);
+	}
+	return bound;
+}
+
+/* decoder against the poses it was encoded from, whether or not a .psq file is around */
+static void verifyPsqSynth(void) {
+	const int rotCut = 4;
+	MOT_CLIP* pClip;
+	MOT_PSQ* pPsq;
+	MOT_PSQ_DEC* pDec;
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
+	float vecErr = 0.0f;
+	float rotErr = 0.0f;
+	float vecRatio = 0.0f;
+	float rotRatio = 0.0f;
+	int i, j, k, simd, nnod;
+	pClip = synthClip(50, 60);
+	if (!pClip) return;
+	pPsq = psqSynth(pClip, rotCut);
+	pDec = pPsq ? motPsqDecCreate(pPsq) : NULL;
+	if (!pDec) {
+		fprintf(stderr, "[ERR] PSQ synth: encoder or decoder init failed\n");
+		free(pPsq);
+		free(pClip);
+		return;
+	}
+	nnod = pClip->nnod;
+	for (i = 0; i < 2; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+	}
+	for (simd = SIMD_NONE; simd <= SIMD_NEON; ++simd) {
+		if (!motSIMDCk((E_MOT_SIMD)simd)) continue;
+		motPsqDecSetSIMD(pDec, (E_MOT_SIMD)simd);
+		for (k = 0; k < pPsq->npose; ++k) {
+			motEvalPose(pClip, (float)k, pPos[0], pRot[0], pScl[0]);
+			motPsqDecPose(pDec, k, pPos[1], pRot[1], pScl[1]);
+			for (i = 0; i < nnod; ++i) {
+				const MOT_PSQ_NODE* pNode = motPsqGetNode(pPsq, i);
+				/* renormalizing a quat with lanes off by b moves it by less than 3b */
+				float rb = 4.0f * psqLaneBound(pPsq, pNode, 0);
+				float pb = psqLaneBound(pPsq, pNode, 1);
+				float sb = psqLaneBound(pPsq, pNode, 2);
+				float e = quatDiff(pRot[0][i], pRot[1][i]);
+				rotErr = fmaxf(rotErr, e);
+				rotRatio = fmaxf(rotRatio, e / rb);
+				for (j = 0; j < 3; ++j) {
+					e = fabsf(pPos[0][i].s[j] - pPos[1][i].s[j]);
+					vecErr = fmaxf(vecErr, e);
+					vecRatio = fmaxf(vecRatio, e / pb);
+					e = fabsf(pScl[0][i].s[j] - pScl[1][i].s[j]);
+					vecErr = fmaxf(vecErr, e);
+					vecRatio = fmaxf(vecRatio, e / sb);
+				}
+			}
+		}
+	}
+	motPsqDecSetSIMD(pDec, motGetSIMD());
+	if (motPsqFindNode(pPsq, pClip->nodes[nnod - 1].name.chr) != nnod - 1 || vecRatio > 1.0f || rotRatio > 1.0f) {
+		fprintf(stderr, "[ERR] PSQ synth: vec err = %e (%.2f of bound), rot err = %e (%.2f of bound)\n", vecErr, vecRatio, rotErr, rotRatio);
+	}
+	printf("PSQ synth: %d nodes, %d poses, %d bytes (clip %d), vec err = %e (%.2f of bound), rot err = %e (%.2f of bound)\n",
+	       nnod, pPsq->npose, pPsq->size, pClip->size, vecErr, vecRatio, rotErr, rotRatio);
+	motPsqDecDestroy(pDec);
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+	}
+	free(pPsq);
+	free(pClip);
+}
+
+#define N_PSQ_STEPS (4)
+
+static void perfPsq(MOT_CLIP* pClip, const char* pPsqName) {
+	MOT_PSQ* pPsq;
+	MOT_PSQ_DEC* pDec;
+	int16_t* pMap;
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
+	double smps[N_PERF_SMP];
+	double t0, t1, dt, dtClip;
+	double sum;
+	float vecErr = 0.0f;
+	float rotErr = 0.0f;
+	int i, k, ismp, simd, nnod, npnod, nevl, nmap;
+	if (!pClip) return;
+	pPsq = psqLoad(pPsqName);
+	if (!pPsq) {
+		printf("PSQ: %s not found, skipped (PSQ synth covers the decoder)\n", pPsqName);
+		return;
+	}
+	pDec = motPsqDecCreate(pPsq);
+	if (!pDec) {
+		fprintf(stderr, "[ERR] PSQ: decoder init failed\n");
+		free(pPsq);
+		return;
+	}
+	nnod = pClip->nnod;
+	npnod = pPsq->nnod;
+	nevl = pPsq->npose * N_PSQ_STEPS;
+	pMap = (int16_t*)malloc(npnod * sizeof(int16_t));
+	nmap = 0;
+	for (i = 0; i < npnod; ++i) {
+		pMap[i] = (int16_t)motFindClipNode(pClip, motPsqGetNodeName(pPsq, i));
+		if (pMap[i] >= 0) ++nmap;
+	}
+	pPos[0] = allocVecs(nnod);
+	pRot[0] = allocQuats(nnod);
+	pScl[0] = allocVecs(nnod);
+	pPos[1] = allocVecs(npnod);
+	pRot[1] = allocQuats(npnod);
+	pScl[1] = allocVecs(npnod);
+
+	/* keyframes only: in-betweens differ by design (log-lerp in clips, nlerp in PSQ) */
+	for (k = 0; k < pPsq->npose; ++k) {
+		motEvalPose(pClip, (float)k, pPos[0], pRot[0], pScl[0]);
+		motPsqEval(pDec, (float)k, pPos[1], pRot[1], pScl[1]);
+		for (i = 0; i < npnod; ++i) {
+			int inod = pMap[i];
+			int j;
+			if (inod < 0) continue;
+			if (motNodeTrackCk(pClip, inod, TRK_POS)) {
+				for (j = 0; j < 3; ++j) {
+					vecErr = fmaxf(vecErr, fabsf(pPos[0][inod].s[j] - pPos[1][i].s[j]));
+				}
+			}
+			if (motNodeTrackCk(pClip, inod, TRK_SCL)) {
+				for (j = 0; j < 3; ++j) {
+					vecErr = fmaxf(vecErr, fabsf(pScl[0][inod].s[j] - pScl[1][i].s[j]));
+				}
+			}
+			if (motNodeTrackCk(pClip, inod, TRK_ROT)) {
+				rotErr = fmaxf(rotErr, quatDiff(pRot[0][inod], pRot[1][i]));
+			}
+		}
+	}
+	if (nmap != npnod || vecErr > 1.0e-4f || rotErr > 1.0e-3f) {
+		fprintf(stderr, "[ERR] PSQ: %d/%d nodes mapped, vec err = %e, rot err = %e\n", nmap, npnod, vecErr, rotErr);
+	}
+	printf("PSQ: %d nodes, %d poses, %d bytes (clip %d), vec err = %e, rot err = %e\n",
+	       npnod, pPsq->npose, pPsq->size, pClip->size, vecErr, rotErr);
+
+	sum = 0;
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		for (k = 0; k < nevl; ++k) {
+			motEvalPose(pClip, (float)k / (float)N_PSQ_STEPS, pPos[0], pRot[0], pScl[0]);
+		}
+		t1 = timestamp();
+		smps[ismp] = (t1 - t0) / nevl;
+		sum += poseSum(nnod, pPos[0], pRot[0], pScl[0]);
+	}
+	dtClip = perfsmp(smps, N_PERF_SMP);
+	printf("EvalPose: sum = %f, dt = %f\n", sum, dtClip);
+
+	for (simd = SIMD_NONE; simd <= SIMD_NEON; ++simd) {
+		if (!motSIMDCk((E_MOT_SIMD)simd)) continue;
+		motPsqDecSetSIMD(pDec, (E_MOT_SIMD)simd);
+		sum = 0;
+		for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+			t0 = timestamp();
+			for (k = 0; k < nevl; ++k) {
+				motPsqEval(pDec, (float)k / (float)N_PSQ_STEPS, pPos[1], pRot[1], pScl[1]);
+			}
+			t1 = timestamp();
+			smps[ismp] = (t1 - t0) / nevl;
+			sum += poseSum(npnod, pPos[1], pRot[1], pScl[1]);
+		}
+		dt = perfsmp(smps, N_PERF_SMP);
+		printf("PsqEval[%s]: sum = %f, dt = %f, ratio = %f\n", motSIMDName((E_MOT_SIMD)simd), sum, dt, dtClip / dt);
+		sum = 0;
+		for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+			t0 = timestamp();
+			for (k = 0; k < pPsq->npose; ++k) {
+				/* stride through the sequence so that every pose is a cache miss */
+				motPsqDecPose(pDec, (k * 7) % pPsq->npose, pPos[1], pRot[1], pScl[1]);
+			}
+			t1 = timestamp();
+			smps[ismp] = (t1 - t0) / pPsq->npose;
+			sum += poseSum(npnod, pPos[1], pRot[1], pScl[1]);
+		}
+		dt = perfsmp(smps, N_PERF_SMP);
+		printf("PsqDecPose[%s]: sum = %f, dt = %f\n", motSIMDName((E_MOT_SIMD)simd), sum, dt);
+	}
+	motPsqDecSetSIMD(pDec, motGetSIMD());
+
+	motPsqDecDestroy(pDec);
+	free(pMap);
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+	}
+	free(pPsq);
+}
+
+/* walk samples per node and frame: pos, rot log vector, scl, rot degrees */
+#define N_BLD_SRC (12)
+
+static float* builderSrc(const MOT_CLIP* pClip) {
+	int i, f, nnod, nfrm;
+	float* pSrc;
+	nnod = pClip->nnod;
+	nfrm = pClip->nfrm;
+	pSrc = (float*)malloc((size_t)nnod * nfrm * N_BLD_SRC * sizeof(float));
+	if (!pSrc) return NULL;
+	for (i = 0; i < nnod; ++i) {
+		for (f = 0; f < nfrm; ++f) {
+			float* pDst = &pSrc[((size_t)i * nfrm + f) * N_BLD_SRC];
+			MOT_VEC pos = motGetPos(pClip, i, f);
+			MOT_VEC rot = motGetVec(pClip, i, f, TRK_ROT);
+			MOT_VEC scl = motGetScl(pClip, i, f);
+			MOT_VEC deg = motGetDegrees(pClip, i, f);
+			memcpy(pDst, pos.s, sizeof(MOT_VEC));
+			memcpy(pDst + 3, rot.s, sizeof(MOT_VEC));
+			memcpy(pDst + 6, scl.s, sizeof(MOT_VEC));
+			memcpy(pDst + 9, deg.s, sizeof(MOT_VEC));
+		}
+	}
+	return pSrc;
+}
+
+static void builderSetup(MOT_CLIP_BUILDER* pBld, const MOT_CLIP* pClip, const float* pSrc, E_MOT_BROT rotMode) {
+	int i, kind, chan;
+	int nnod = pClip->nnod;
+	motClipBuilderSetRotMode(pBld, rotMode);
+	/* added in reverse, the builder restores hash order */
+	for (i = nnod; --i >= 0;) {
+		const MOT_NODE* pNode = &pClip->nodes[i];
+		const float* pNodeSrc = &pSrc[(size_t)i * pClip->nfrm * N_BLD_SRC];
+		int inod = motClipBuilderAddNode(pBld, pNode->name.chr, (E_MOT_XORD)pNode->xord, (E_MOT_RORD)pNode->rord);
+		for (kind = 0; kind < 3; ++kind) {
+			int srcMask = pNode->trk[kind].srcMask;
+			int col = kind * 3;
+			if (kind == TRK_ROT && rotMode == BROT_DEGREES && srcMask) {
+				srcMask = 7;
+				col = 9;
+			}
+			for (chan = 0; chan < 3; ++chan) {
+				if (srcMask & (1 << chan)) {
+					motClipBuilderSetChan(pBld, inod, (E_MOT_TRK)kind, chan, pNodeSrc + col + chan, N_BLD_SRC);
+				}
+			}
+		}
+	}
+}
+
+/* max pos/scl and quaternion differences over quarter frames */
+static void builderPoseErr(const MOT_CLIP* pClip, const MOT_CLIP* pBClip, float* pPosErr, float* pRotErr) {
+	MOT_VEC* pPos[2];
+	MOT_QUAT* pRot[2];
+	MOT_VEC* pScl[2];
+	int i, j, k;
+	int nnod = pClip->nnod;
+	*pPosErr = 0.0f;
+	*pRotErr = 0.0f;
+	for (i = 0; i < 2; ++i) {
+		pPos[i] = allocVecs(nnod);
+		pRot[i] = allocQuats(nnod);
+		pScl[i] = allocVecs(nnod);
+	}
+	for (k = 0; k < (int)pClip->nfrm * 4; ++k) {
+		float frm = (float)k * 0.25f;
+		motEvalPose(pClip, frm, pPos[0], pRot[0], pScl[0]);
+		motEvalPose(pBClip, frm, pPos[1], pRot[1], pScl[1]);
+		for (i = 0; i < nnod; ++i) {
+			for (j = 0; j < 3; ++j) {
+				*pPosErr = fmaxf(*pPosErr, fabsf(pPos[0][i].s[j] - pPos[1][i].s[j]));
+				*pPosErr = fmaxf(*pPosErr, fabsf(pScl[0][i].s[j] - pScl[1][i].s[j]));
+			}
+			*pRotErr = fmaxf(*pRotErr, quatDiff(pRot[0][i], pRot[1][i]));
+		}
+	}
+	for (i = 0; i < 2; ++i) {
+		free(pPos[i]);
+		free(pRot[i]);
+		free(pScl[i]);
+	}
+}
+
+static void perfBuilder(MOT_CLIP* pClip) {
+	MOT_CLIP_BUILDER* pBld;
+	MOT_CLIP* pBClip;
+	MOT_CLIP* pDClip;
+	float* pSrc;
+	void* pMem;
+	size_t size;
+	double smps[N_PERF_SMP];
+	double t0, t1, dt;
+	float posErr, rotErr, degPosErr, degRotErr;
+	int ismp, nerr;
+	if (!pClip) return;
+	pSrc = builderSrc(pClip);
+	pBld = motClipBuilderCreate(pClip->name.chr, pClip->nfrm, pClip->rate);
+	if (!pSrc || !pBld) {
+		fprintf(stderr, "[ERR] Builder: init failed\n");
+		free(pSrc);
+		motClipBuilderDestroy(pBld);
+		return;
+	}
+
+	/* from the stored log vectors: the writer's clip, byte for byte */
+	builderSetup(pBld, pClip, pSrc, BROT_LOG);
+	size = motClipBuilderSize(pBld);
+	pBClip = motClipBuilderWrite(pBld, NULL, 0);
+	if (!pBClip || !motClipMemCk(pBClip, pBClip->size)) {
+		fprintf(stderr, "[ERR] Builder: bad clip\n");
+		free(pBClip);
+		free(pSrc);
+		motClipBuilderDestroy(pBld);
+		return;
+	}
+	nerr = pBClip->size != pClip->size || memcmp(pBClip, pClip, pClip->size) != 0;
+	builderPoseErr(pClip, pBClip, &posErr, &rotErr);
+
+	/* from Euler degrees: full log vectors, same poses up to the round trip */
+	motClipBuilderReset(pBld, pClip->name.chr, pClip->nfrm, pClip->rate);
+	builderSetup(pBld, pClip, pSrc, BROT_DEGREES);
+	pDClip = motClipBuilderWrite(pBld, NULL, 0);
+	degPosErr = degRotErr = 1.0f;
+	if (pDClip && motClipMemCk(pDClip, pDClip->size)) {
+		builderPoseErr(pClip, pDClip, &degPosErr, &degRotErr);
+	}
+	free(pDClip);
+	if (nerr || posErr > 0.0f || rotErr > 0.0f || degPosErr > 1.0e-5f || degRotErr > 1.0e-4f) {
+		fprintf(stderr, "[ERR] Builder: clip differs: %d, err = %e, %e, from degrees: %e, %e\n", nerr, posErr, rotErr, degPosErr, degRotErr);
+	}
+
+	/* rebuild rate: nodes and channels set up again, written into one reused buffer */
+	pMem = malloc(size);
+	for (ismp = 0; ismp < N_PERF_SMP; ++ismp) {
+		t0 = timestamp();
+		motClipBuilderReset(pBld, pClip->name.chr, pClip->nfrm, pClip->rate);
+		builderSetup(pBld, pClip, pSrc, BROT_LOG);
+		if (!motClipBuilderWrite(pBld, pMem, size)) ++nerr;
+		t1 = timestamp();
+		smps[ismp] = t1 - t0;
+	}
+	dt = perfsmp(smps, N_PERF_SMP);
+	if (nerr || memcmp(pMem, pBClip, size) != 0) {
+		fprintf(stderr, "[ERR] Builder: rebuilt clip differs\n");
+	}
+	printf("Builder: %d nodes, %d bytes, from degrees: pos err = %e, rot err = %e, dt = %f (%.1f MB/s)\n",
+	       pClip->nnod, (int)size, degPosErr, degRotErr, dt, (double)size / dt);
+	free(pMem);
+	free(pBClip);
+	free(pSrc);
+	motClipBuilderDestroy(pBld);
+}
+
+typedef struct _HCLIP_TEXT {
+	char*  pText;
+	size_t len;
+	size_t size;
+} HCLIP_TEXT;
+
+static void hclipPrintf(HCLIP_TEXT* pTxt, const char* pFmt, ...) {
+	va_list args;
+	int n;
+	if (!pTxt->pText) return;
+	if (pTxt->size - pTxt->len < 0x100) {
+		size_t size = pTxt->size * 2;
+		char* pText = (char*)realloc(pTxt->pText, size);
+		if (!pText) {
+			free(pTxt->pText);
+			pTxt->pText = NULL;
+			return;
+		}
+		pTxt->pText = pText;
+		pTxt->size = size;
+	}
+	va_start(args, pFmt);
+	n = vsnprintf(pTxt->pText + pTxt->len, pTxt->size - pTxt->len, pFmt, args);
+	va_end(args);
+	pTxt->len += n;
+}
+
+/* walk as a Houdini export: t/r/s channels for the source channels (rotations in degrees), constants run-length coded */
+static char* hclipText(const MOT_CLIP* pClip, const float* pSrc, size_t* pLen) {
+	HCLIP_TEXT txt;
+	int i, f, kind, chan, ntrk;
+	int nnod = pClip->nnod;
+	int nfrm = pClip->nfrm;
+	txt.size = 0x10000;
+	txt.len = 0;
+	txt.pText = (char*)malloc(txt.size);
+	ntrk = 0;
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			int srcMask = pClip->nodes[i].trk[kind].srcMask;
+			ntrk += kind == TRK_ROT && srcMask ? 3 : (srcMask & 1) + ((srcMask >> 1) & 1) + ((srcMask >> 2) & 1);
+		}
+		ntrk += 2;
+	}
+	hclipPrintf(&txt, "{\n  rate = %g\n  start = -1\n  tracklength = %d\n  tracks = %d\n", pClip->rate, nfrm, ntrk);
+	for (i = 0; i < nnod; ++i) {
+		const MOT_NODE* pNode = &pClip->nodes[i];
+		const float* pNodeSrc = &pSrc[(size_t)i * nfrm * N_BLD_SRC];
+		/* some with a network path */
+		const char* pPath = (i & 1) ? "/obj/" : "";
+		hclipPrintf(&txt, "  {\n    name = %s%s:xOrd\n    data_rle = @%d %d\n  }\n", pPath, pNode->name.chr, nfrm, pNode->xord);
+		for (kind = 0; kind < 3; ++kind) {
+			int srcMask = pNode->trk[kind].srcMask;
+			int col = kind * 3;
+			if (kind == TRK_ROT && srcMask) {
+				srcMask = 7;
+				col = 9;
+			}
+			for (chan = 0; chan < 3; ++chan) {
+				const float* pVals = pNodeSrc + col + chan;
+				int cnst = 1;
+				if (!(srcMask & (1 << chan))) continue;
+				for (f = 1; f < nfrm; ++f) {
+					cnst &= pVals[f * N_BLD_SRC] == pVals[0];
+				}
+				hclipPrintf(&txt, "  {\n    name = %s%s:%c%c\n", pPath, pNode->name.chr, "trs"[kind], 'x' + chan);
+				if (cnst) {
+					hclipPrintf(&txt, "    data_rle = @%d %.9g\n", nfrm, pVals[0]);
+				} else {
+					hclipPrintf(&txt, "    data =");
+					for (f = 0; f < nfrm; ++f) {
+						hclipPrintf(&txt, " %.9g", pVals[f * N_BLD_SRC]);
+					}
+					hclipPrintf(&txt, "\n");
+				}
+				hclipPrintf(&txt, "  }\n");
+			}
+		}
+		hclipPrintf(&txt, "  {\n    name = %s%s:rOrd\n    data_rle = @%d %d\n  }\n", pPath, pNode->name.chr, nfrm, pNode->rord);
+	}
+	hclipPrintf(&txt, "}\n");
+	*pLen = txt.len;
+	return txt.pText;
+}
+
+/* the whole text through strtod token by token, as the C# readers do */
+static double hclipStrtodSum(const char* pText, size_t len) {
+	char* pCpy = (char*)malloc(len + 1);
+	char* pTok;
+	double sum = 0.0;
+	if (!pCpy) return 0.0;
+	memcpy(pCpy, pText, len);
+	pCpy[len] = 0;
+	for (pTok = strtok(pCpy, " \t\r\n"); pTok; pTok = strtok(NULL, " \t\r\n")) {
+		sum += strtod(pTok, NULL);
+	}
+	free(pCpy);
+	return sum;
+}
+
+static int hclipCk(const MOT_HCLIP* pHClip, const MOT_CLIP* pClip, const float* pSrc) {
+	int i, kind, chan, f;
+	int nerr = 0;
+	if (pHClip->nfrm != (int)pClip->nfrm || pHClip->rate != pClip->rate || pHClip->start != -1) return 1;
+	for (i = 0; i < (int)pClip->nnod; ++i) {
+		const MOT_NODE* pNode = &pClip->nodes[i];
+		const float* pNodeSrc = &pSrc[(size_t)i * pClip->nfrm * N_BLD_SRC];
+		for (kind = 0; kind < 3; ++kind) {
+			int srcMask = pNode->trk[kind].srcMask;
+			int col = kind * 3;
+			if (kind == TRK_ROT && srcMask) {
+				srcMask = 7;
+				col = 9;
+			}
+			for (chan = 0; chan < 3; ++chan) {
+				char chName[3] = { "trs"[kind], (char)('x' + chan), 0 };
+				int itrk = motHClipFindTrack(pHClip, pNode->name.chr, chName);
+				if (!(srcMask & (1 << chan))) {
+					nerr += itrk >= 0;
+					continue;
+				}
+				if (itrk < 0) {
+					++nerr;
+					continue;
+				}
+				for (f = 0; f < (int)pClip->nfrm; ++f) {
+					nerr += pHClip->pTrks[itrk].pData[f] != pNodeSrc[f * N_BLD_SRC + col + chan];
+				}
+			}
+		}
+	}
+	return nerr;
+}
+
+#define N_HCLIP_SMP (10)
+
+static double perfHClipSub(const char* pText, size_t len, int nthr) {
+	MOT_HCLIP hclip;
+	double smps[N_HCLIP_SMP];
+	double t0, t1;
+	int ismp;
+	for (ismp = 0; ismp < N_HCLIP_SMP; ++ismp) {
+		t0 = timestamp();
+		motHClipParse(&hclip, pText, len, nthr);
+		t1 = timestamp();
+		motHClipFree(&hclip);
+		smps[ismp] = t1 - t0;
+	}
+	return perfsmp(smps, N_HCLIP_SMP);
+}
+
+static void perfHClip(MOT_CLIP* pClip) {
+	MOT_HCLIP hclip1;
+	MOT_HCLIP hclipN;
+	MOT_CLIP_BUILDER* pBld;
+	MOT_CLIP* pHClip;
+	float* pSrc;
+	char* pText;
+	size_t len = 0;
+	double smps[N_HCLIP_SMP];
+	double t0, t1, dt1, dtN, dtStrtod;
+	double sum = 0.0;
+	float posErr = 1.0f;
+	float rotErr = 1.0f;
+	int i, nthr, nerr;
+	if (!pClip) return;
+	/* at least 4 chunks so that the split is exercised on small machines too */
+	nthr = motCrowdCPUCount();
+	nthr = nthr > 4 ? nthr : 4;
+	pSrc = builderSrc(pClip);
+	pText = pSrc ? hclipText(pClip, pSrc, &len) : NULL;
+	if (!pText) {
+		fprintf(stderr, "[ERR] HClip: init failed\n");
+		free(pSrc);
+		return;
+	}
+	if (!motHClipParse(&hclip1, pText, len, 1) || !motHClipParse(&hclipN, pText, len, nthr)) {
+		fprintf(stderr, "[ERR] HClip: parse failed\n");
+		motHClipFree(&hclip1);
+		free(pText);
+		free(pSrc);
+		return;
+	}
+	nerr = hclipCk(&hclip1, pClip, pSrc) + hclipCk(&hclipN, pClip, pSrc);
+	nerr += hclip1.ntrk != hclipN.ntrk || memcmp(hclip1.pData, hclipN.pData, (size_t)hclip1.ntrk * hclip1.nfrm * sizeof(float)) != 0;
+	for (i = 0; i < hclip1.ntrk && !nerr; ++i) {
+		nerr += strcmp(hclip1.pTrks[i].pName, hclipN.pTrks[i].pName) != 0;
+	}
+
+	/* straight into the builder, then compared to walk */
+	pBld = motClipBuilderCreate(pClip->name.chr, hclipN.nfrm, hclipN.rate);
+	pHClip = NULL;
+	if (pBld && motHClipBuild(&hclipN, pBld) == (int)pClip->nnod) {
+		pHClip = motClipBuilderWrite(pBld, NULL, 0);
+	}
+	if (pHClip && motClipMemCk(pHClip, pHClip->size)) {
+		builderPoseErr(pClip, pHClip, &posErr, &rotErr);
+	}
+	if (nerr || posErr > 1.0e-5f || rotErr > 1.0e-4f) {
+		fprintf(stderr, "[ERR] HClip: %d value errors, clip err = %e, %e\n", nerr, posErr, rotErr);
+	}
+	free(pHClip);
+	motClipBuilderDestroy(pBld);
+	motHClipFree(&hclip1);
+	motHClipFree(&hclipN);
+
+	dt1 = perfHClipSub(pText, len, 1);
+	dtN = perfHClipSub(pText, len, nthr);
+	for (i = 0; i < N_HCLIP_SMP; ++i) {
+		t0 = timestamp();
+		sum += hclipStrtodSum(pText, len);
+		t1 = timestamp();
+		smps[i] = t1 - t0;
+	}
+	dtStrtod = perfsmp(smps, N_HCLIP_SMP);
+	printf("HClip: %d bytes, strtod tokens: %.1f MB/s, 1 thread: %.1f MB/s, %d threads: %.1f MB/s (%.1fx vs strtod)\n",
+	       (int)len, (double)len / dtStrtod, (double)len / dt1, nthr, (double)len / dtN, dtStrtod / dtN);
+	if (sum == 0.0) printf("\n");
+	free(pText);
+	free(pSrc);
+}
+
+static uint8_t* bclipPkt(uint8_t* pDst, int cls, int tag, uint32_t size) {
+	pDst[0] = (uint8_t)(size >> 24);
+	pDst[1] = (uint8_t)(size >> 16);
+	pDst[2] = (uint8_t)(size >> 8);
+	pDst[3] = (uint8_t)size;
+	pDst[4] = 0;
+	pDst[5] = (uint8_t)cls;
+	pDst[6] = 0;
+	pDst[7] = (uint8_t)tag;
+	return pDst + 8;
+}
+
+static uint8_t* bclipU32(uint8_t* pDst, uint32_t val) {
+	pDst[0] = (uint8_t)(val >> 24);
+	pDst[1] = (uint8_t)(val >> 16);
+	pDst[2] = (uint8_t)(val >> 8);
+	pDst[3] = (uint8_t)val;
+	return pDst + 4;
+}
+
+static uint8_t* bclipF64(uint8_t* pDst, double val) {
+	uint64_t u;
+	memcpy(&u, &val, sizeof(double));
+	pDst = bclipU32(pDst, (uint32_t)(u >> 32));
+	return bclipU32(pDst, (uint32_t)u);
+}
+
+/* channel clip as a Houdini binary clip with f64 info and data */
+static uint8_t* bclipImage(const MOT_HCLIP* pHClip, size_t* pSize) {
+	uint8_t* pMem;
+	uint8_t* pDst;
+	size_t size, trkSize;
+	int i, f;
+	trkSize = 12;
+	for (i = 0; i < pHClip->ntrk; ++i) {
+		trkSize += 8 + 2 + strlen(pHClip->pTrks[i].pName) + 8 + (size_t)pHClip->nfrm * 8 + 8;
+	}
+	size = 4 + 12 + 9 + 16 + 16 + 9 + 12 + trkSize + 8;
+	pMem = (uint8_t*)malloc(size);
+	if (!pMem) return NULL;
+	pDst = pMem;
+	memcpy(pDst, "bclp", 4);
+	pDst = bclipU32(bclipPkt(pDst + 4, 0xF, 9, 12), 3); /* VERSION */
+	*bclipPkt(pDst, 0xF, 0xA, 9) = 1; /* FLOATFIELDDATATYPE */
+	pDst = bclipF64(bclipPkt(pDst + 9, 0xF, 1, 16), pHClip->rate);
+	pDst = bclipF64(bclipPkt(pDst, 0xF, 2, 16), pHClip->start);
+	*bclipPkt(pDst, 0xF, 8, 9) = 1; /* TRACKDATATYPE */
+	pDst = bclipU32(bclipPkt(pDst + 9, 0xF, 3, 12), pHClip->nfrm);
+	pDst = bclipU32(bclipPkt(pDst, 0xF, 5, (uint32_t)trkSize), pHClip->ntrk);
+	for (i = 0; i < pHClip->ntrk; ++i) {
+		const MOT_HCLIP_TRACK* pTrk = &pHClip->pTrks[i];
+		size_t len = strlen(pTrk->pName);
+		pDst = bclipPkt(pDst, 0x10, 1, (uint32_t)(8 + 2 + len));
+		*pDst++ = (uint8_t)(len >> 8);
+		*pDst++ = (uint8_t)len;
+		memcpy(pDst, pTrk->pName, len);
+		pDst = bclipPkt(pDst + len, 0x10, 2, (uint32_t)(8 + pHClip->nfrm * 8));
+		for (f = 0; f < pHClip->nfrm; ++f) {
+			pDst = bclipF64(pDst, pTrk->pData[f]);
+		}
+		pDst = bclipPkt(pDst, 0x10, 0, 8);
+	}
+	bclipPkt(pDst, 0xF, 0, 8);
+	*pSize = size;
+	return pMem;
+}
+
+static MOT_CLIP* bclipBuild(const MOT_HCLIP* pHClip, const char* pName) {
+	MOT_CLIP* pClip = NULL;
+	MOT_CLIP_BUILDER* pBld = motClipBuilderCreate(pName, pHClip->nfrm, pHClip->rate);
+	if (pBld && motHClipBuild(pHClip, pBld) > 0) {
+		pClip = motClipBuilderWrite(pBld, NULL, 0);
+	}
+	motClipBuilderDestroy(pBld);
+	return pClip;
+}
+
+static void perfBClip(MOT_CLIP* pClip) {
+	MOT_HCLIP hclip;
+	MOT_HCLIP bclip;
+	MOT_CLIP* pTxtClip;
+	MOT_CLIP* pBinClip;
+	float* pSrc;
+	char* pText;
+	uint8_t* pBin;
+	size_t len = 0;
+	size_t size = 0;
+	double smps[N_HCLIP_SMP];
+	double t0, t1, dtTxt, dtBin;
+	int i, nerr;
+	if (!pClip) return;
+	pSrc = builderSrc(pClip);
+	pText = pSrc ? hclipText(pClip, pSrc, &len) : NULL;
+	free(pSrc);
+	if (!pText || !motHClipParse(&hclip, pText, len, 1)) {
+		fprintf(stderr, "[ERR] BClip: init failed\n");
+		free(pText);
+		return;
+	}
+	pBin = bclipImage(&hclip, &size);
+	if (!pBin || !motBClipParse(&bclip, pBin, size)) {
+		fprintf(stderr, "[ERR] BClip: parse failed\n");
+		free(pBin);
+		free(pText);
+		motHClipFree(&hclip);
+		return;
+	}
+	nerr = bclip.ntrk != hclip.ntrk || bclip.nfrm != hclip.nfrm || bclip.rate != hclip.rate || bclip.start != hclip.start;
+	for (i = 0; i < hclip.ntrk && !nerr; ++i) {
+		nerr += strcmp(bclip.pTrks[i].pName, hclip.pTrks[i].pName) != 0;
+		nerr += bclip.pTrks[i].vmin != hclip.pTrks[i].vmin || bclip.pTrks[i].vmax != hclip.pTrks[i].vmax;
+	}
+	nerr += !nerr && memcmp(bclip.pData, hclip.pData, (size_t)hclip.ntrk * hclip.nfrm * sizeof(float)) != 0;
+	motHClipFree(&bclip);
+	/* truncated files are rejected */
+	nerr += !nerr && motBClipParse(&bclip, pBin, size / 2);
+	motHClipFree(&bclip);
+
+	/* bclip -> mclp against text -> mclp: the same clip */
+	pTxtClip = bclipBuild(&hclip, pClip->name.chr);
+	for (i = 0; i < N_HCLIP_SMP; ++i) {
+		t0 = timestamp();
+		motBClipParse(&bclip, pBin, size);
+		pBinClip = bclipBuild(&bclip, pClip->name.chr);
+		t1 = timestamp();
+		smps[i] = t1 - t0;
+		nerr += !pTxtClip || !pBinClip || pBinClip->size != pTxtClip->size || memcmp(pBinClip, pTxtClip, pTxtClip->size) != 0;
+		free(pBinClip);
+		motHClipFree(&bclip);
+	}
+	dtBin = perfsmp(smps, N_HCLIP_SMP);
+	for (i = 0; i < N_HCLIP_SMP; ++i) {
+		MOT_HCLIP tclip;
+		t0 = timestamp();
+		motHClipParse(&tclip, pText, len, 1);
+		pBinClip = bclipBuild(&tclip, pClip->name.chr);
+		t1 = timestamp();
+		smps[i] = t1 - t0;
+		free(pBinClip);
+		motHClipFree(&tclip);
+	}
+	dtTxt = perfsmp(smps, N_HCLIP_SMP);
+	if (nerr) {
+		fprintf(stderr, "[ERR] BClip: %d errors\n", nerr);
+	}
+	printf("BClip: %d bytes -> %d bytes clip, bclip: %f, text clip: %f (%.1fx)\n",
+	       (int)size, pTxtClip ? (int)pTxtClip->size : 0, dtBin, dtTxt, dtTxt / dtBin);
+	free(pTxtClip);
+	free(pBin);
+	free(pText);
+	motHClipFree(&hclip);
+}
+
+#define N_LAZY_NODES (1000)
+#define N_LAZY_FRAMES (600)
+#define N_LAZY_PICK (8)
+
+/* a face rig sized clip: many channels, a handful of them read */
+static void perfBClipLazy(void) {
+	const char* pPath = "../dump.bclip";
+	MOT_HCLIP src;
+	MOT_HCLIP full;
+	MOT_BCLIP lazy;
+	FILE* pOut;
+	uint8_t* pBin;
+	float* pVals;
+	size_t size = 0;
+	char names[N_LAZY_PICK][0x40];
+	double smps[N_HCLIP_SMP];
+	double t0, t1, dtFull, dtLazy, dtToc;
+	int i, f, ismp;
+	int nerr = 0;
+	memset(&src, 0, sizeof(MOT_HCLIP));
+	src.rate = 60.0f;
+	src.nfrm = N_LAZY_FRAMES;
+	src.ntrk = N_LAZY_NODES * 3;
+	src.pTrks = (MOT_HCLIP_TRACK*)calloc(src.ntrk, sizeof(MOT_HCLIP_TRACK));
+	src.pData = (float*)malloc((size_t)src.ntrk * src.nfrm * sizeof(float));
+	src.pNames = (char*)malloc((size_t)src.ntrk * 0x20);
+	pVals = (float*)malloc(src.nfrm * sizeof(float));
+	if (!src.pTrks || !src.pData || !src.pNames || !pVals) {
+		fprintf(stderr, "[ERR] BClip lazy: init failed\n");
+		motHClipFree(&src);
+		free(pVals);
+		return;
+	}
+	for (i = 0; i < src.ntrk; ++i) {
+		char* pName = &src.pNames[i * 0x20];
+		sprintf(pName, "/obj/face/ctl%d:t%c", i / 3, 'x' + i % 3);
+		src.pTrks[i].pName = pName;
+		src.pTrks[i].pData = &src.pData[(size_t)i * src.nfrm];
+		for (f = 0; f < src.nfrm; ++f) {
+			src.pTrks[i].pData[f] = sinf((float)f * 0.01f * (float)(1 + i % 17)) * (float)(i % 5);
+		}
+	}
+	pBin = bclipImage(&src, &size);
+	pOut = pBin ? fopen(pPath, "wb") : NULL;
+	if (pOut) {
+		fwrite(pBin, size, 1, pOut);
+		fclose(pOut);
+	}
+	free(pBin);
+	for (i = 0; i < N_LAZY_PICK; ++i) {
+		int itrk = (i * 7919) % src.ntrk;
+		strcpy(names[i], src.pTrks[itrk].pName);
+	}
+
+	/* table of contents: every name found, ranges decoded as the source */
+	if (!motBClipOpen(&lazy, pPath)) {
+		fprintf(stderr, "[ERR] BClip lazy: open failed\n");
+		motHClipFree(&src);
+		free(pVals);
+		return;
+	}
+	nerr += lazy.ntrk != src.ntrk || lazy.nfrm != src.nfrm || lazy.rate != src.rate;
+	for (i = 0; i < src.ntrk && !nerr; ++i) {
+		int frm0 = i % src.nfrm;
+		int n = motBClipReadTrack(&lazy, i, frm0, 100, pVals);
+		nerr += motBClipFindTrack(&lazy, src.pTrks[i].pName) != i;
+		nerr += n != (src.nfrm - frm0 < 100 ? src.nfrm - frm0 : 100);
+		nerr += memcmp(pVals, src.pTrks[i].pData + frm0, n * sizeof(float)) != 0;
+	}
+	nerr += motBClipFindTrack(&lazy, "/obj/face/ctl0:rx") != -1;
+	nerr += motBClipReadTrack(&lazy, 0, src.nfrm, 1, pVals) != 0;
+	motBClipClose(&lazy);
+
+	/* full load then lookup, against open + lookup + decode of the picked tracks */
+	for (ismp = 0; ismp < N_HCLIP_SMP; ++ismp) {
+		t0 = timestamp();
+		motBClipLoad(&full, pPath);
+		for (i = 0; i < N_LAZY_PICK; ++i) {
+			int itrk = -1;
+			int k;
+			for (k = 0; k < full.ntrk && itrk < 0; ++k) {
+				if (strcmp(full.pTrks[k].pName, names[i]) == 0) itrk = k;
+			}
+			nerr += itrk < 0;
+		}
+		t1 = timestamp();
+		motHClipFree(&full);
+		smps[ismp] = t1 - t0;
+	}
+	dtFull = perfsmp(smps, N_HCLIP_SMP);
+	for (ismp = 0; ismp < N_HCLIP_SMP; ++ismp) {
+		t0 = timestamp();
+		motBClipOpen(&lazy, pPath);
+		for (i = 0; i < N_LAZY_PICK; ++i) {
+			nerr += motBClipReadTrack(&lazy, motBClipFindTrack(&lazy, names[i]), 0, lazy.nfrm, pVals) != lazy.nfrm;
+		}
+		t1 = timestamp();
+		motBClipClose(&lazy);
+		smps[ismp] = t1 - t0;
+	}
+	dtLazy = perfsmp(smps, N_HCLIP_SMP);
+	for (ismp = 0; ismp < N_HCLIP_SMP; ++ismp) {
+		t0 = timestamp();
+		motBClipOpen(&lazy, pPath);
+		t1 = timestamp();
+		motBClipClose(&lazy);
+		smps[ismp] = t1 - t0;
+	}
+	dtToc = perfsmp(smps, N_HCLIP_SMP);
+	if (nerr) {
+		fprintf(stderr, "[ERR] BClip lazy: %d errors\n", nerr);
+	}
+	printf("BClip lazy: %d tracks, %d bytes, %d tracks read: full load: %f, lazy: %f (toc %f) (%.1fx)\n",
+	       src.ntrk, (int)size, N_LAZY_PICK, dtFull, dtLazy, dtToc, dtFull / dtLazy);
+	motHClipFree(&src);
+	free(pVals);
+}
+
+static void printSeqEntry(MOT_CLIP* pClip, MOT_SEQ* pSeq, const char* pTrkName) {
+	int inod = pSeq->node;
+	char* pNodeName = pClip->nodes[inod].name.chr;
+	printf("  %s:%s[%d]: ", pNodeName, pTrkName, pSeq->chan);
+	if (pSeq->offs) {
+		if (pSeq->stride) {
+			printf("data @ 0x%X, stride = %d", pSeq->offs, pSeq->stride);
+		} else {
+			printf("const @ 0x%X", pSeq->offs);
+		}
+	} else {
+		printf("--");
+	}
+	printf("\n");
+}
+
+static void printSeqInfo(MOT_CLIP* pClip) {
+	MOT_SEQ* pSeq;
+	int i, npos, nrot, nscl;
+	if (!pClip) return;
+	pSeq = motGetSeqInfo(pClip);
+	if (!pSeq) return;
+	npos = motClipTrackCount(pClip, TRK_POS);
+	nrot = motClipTrackCount(pClip, TRK_ROT);
+	nscl = motClipTrackCount(pClip, TRK_SCL);
+	for (i = 0; i < npos * 3; ++i) {
+		printSeqEntry(pClip, pSeq, "pos");
+		++pSeq;
+	}
+	for (i = 0; i < nrot * 3; ++i) {
+		printSeqEntry(pClip, pSeq, "rot");
+		++pSeq;
+	}
+	for (i = 0; i < nscl * 3; ++i) {
+		printSeqEntry(pClip, pSeq, "rot");
+		++pSeq;
+	}
+}
+
+void init() {
+	const char* pClipName = "../data/walk.mclp";
+	MOT_CLIP* pClip;
+	/* synthetic data, no clip file needed */
+	verifyEulerAry();
+	perfBClipLazy();
+
+	verifyPsqSynth();
+	verifyLibFile("../data/walk.mlib");
+	pClip = clipLoad(pClipName);
+	if (!pClip) return;
+	s_pClip = pClip;
+	verifyFindClipNode(pClip);
+	perfFindClipNode(pClip);
+	perfQuatAry(pClip);
+	perfEulerAry(pClip);
+	verifyEvalPose(pClip);
+	perfEvalPose(pClip);
+	perfPoseBlend(pClip);
+	verifyEvalBlend(pClip);
+	perfEvalBlend(pClip);
+	perfCrowd(pClip);
+	perfSkel(pClip);
+	verifyAffine(pClip);
+	perfAffine(pClip);
+	verifySampler(pClip);
+	perfSampler(pClip);
+	perfQuant(pClip);
+	perfPsq(pClip, "../data/walk.psq");
+	perfKeys(pClip);
+	perfRdft(pClip);
+	perfRdftClip(pClip);
+	verifyClipMap(pClip, pClipName);
+	perfLib(pClip);
+	perfBind(pClip);
+	perfStream(pClip);
+	perfFrameMajor(pClip);
+	perfBuilder(pClip);
+	perfHClip(pClip);
+	perfBClip(pClip);
+	//printSeqInfo(pClip);
+}
+
+void test() {
+	MOT_CLIP* pClip = s_pClip;
+	int i, j, k;
+	int nfrm;
+	int nnod;
+	int npos;
+	int nrot;
+	int nscl;
+	float frm;
+	int nsub = 4;
+	FILE* pOut = NULL;
+	MOT_VEC* pRot = NULL;
+	MOT_QUAT* pQuats = NULL;
+	MOT_MTX* pMtx = NULL;
+	int midx;
+	if (!pClip) return;
+
+	nfrm = pClip->nfrm;
+	nnod = pClip->nnod;
+	npos = 0;
+	nrot = 0;
+	nscl = 0;
+	for (i = 0; i < nnod; ++i) {
+		if (motNodeTrackCk(pClip, i, TRK_POS)) {
+			++npos;
+		}
+		if (motNodeTrackCk(pClip, i, TRK_ROT)) {
+			++nrot;
+		}
+		if (motNodeTrackCk(pClip, i, TRK_SCL)) {
+			++nscl;
+		}
+	}
+	printf("motion clip: %s\n", pClip->name.chr);
+	printf("#nod: %d\n", nnod);
+	printf("#frm: %d\n", nfrm);
+	printf("#pos tracks: %d (%d)\n", npos, motClipTrackCount(pClip, TRK_POS));
+	printf("#rot tracks: %d (%d)\n", nrot, motClipTrackCount(pClip, TRK_ROT));
+	printf("#scl tracks: %d (%d)\n", nscl, motClipTrackCount(pClip, TRK_SCL));
+
+	pOut = fopen("../dump.clip", "w");
+
+	fprintf(pOut, "{\n");
+	fprintf(pOut, "  rate = %.1f\n", pClip->rate);
+	fprintf(pOut, "  start = -1\n");
+	fprintf(pOut, "  tracklength = %d\n", nfrm * nsub);
+	fprintf(pOut, "  tracks = %d\n", nrot * 3);
+
+	pRot = (MOT_VEC*)malloc(nfrm * nsub * sizeof(MOT_VEC));
+	pQuats = allocQuats(nfrm * nsub);
+	pMtx = (MOT_MTX*)malloc(nnod * nfrm * nsub * sizeof(MOT_MTX));
+	midx = 0;
+	for (i = 0; i < nnod; ++i) {
+		frm = 0.0f;
+		for (k = 0; k < nfrm * nsub; ++k) {
+			motEvalTransform(&pMtx[midx], pClip, i, frm, NULL);
+			frm += 1.0f / (float)nsub;
+			++midx;
+		}
+		if (motNodeTrackCk(pClip, i, TRK_ROT)) {
+			frm = 0.0f;
+			for (k = 0; k < nfrm * nsub; ++k) {
+				pRot[k] = motEvalDegrees(pClip, i, frm);
+				frm += 1.0f / (float)nsub;
+			}
+			motQuatFromDegreesAry(pQuats, pRot, nfrm * nsub, motGetRotOrd(pClip, i));
+			motQuatToDegreesAry(pRot, pQuats, nfrm * nsub, motGetRotOrd(pClip, i));
+			for (j = 0; j < 3; ++j) {
+				if (pOut) {
+					fprintf(pOut, "  {\n");
+					fprintf(pOut, "    name = %s:r%c\n", pClip->nodes[i].name.chr, "xyz"[j]);
+					fprintf(pOut, "    data =");
+					for (k = 0; k < nfrm * nsub; ++k) {
+						fprintf(pOut, " %f", pRot[k].s[j]);
+					}
+					fprintf(pOut, "\n");
+					fprintf(pOut, "  }\n");
+				}
+			}
+		}
+	}
+	fprintf(pOut, "}\n");
+	if (pOut) {
+		fclose(pOut);
+		pOut = NULL;
+	}
+	free(pQuats);
+	free(pRot);
+	free(pMtx);
+}
+
 int main() {
 	init();
 	test();
@@ -0,0 +1,440 @@
+/*
+ * Motion Clip crowd evaluation
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ *
+ * Instances are split into chunks, chunks are dealt out to per-worker
+ * queues in contiguous ranges, idle workers steal from the tail of other
+ * queues, trying workers on the same NUMA node first.
+ * POSIX builds need -pthread.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#	define _GNU_SOURCE
+#endif
+
+#include "motcrowd.h"
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN 1
+#	define NOMINMAX
+#	include <Windows.h>
+#else
+#	include <pthread.h>
+#	include <sched.h>
+#	include <unistd.h>
+#endif
+
+#define CROWD_MAX_THREADS (256)
+#define CROWD_CACHE_LINE (64)
+/* output working set per chunk, kept well inside L2 */
+#define CROWD_CHUNK_BYTES (64 * 1024)
+/* enough chunks per worker for stealing to even out the load */
+#define CROWD_CHUNKS_PER_THREAD (8)
+
+typedef struct _CROWD_QUEUE {
+	volatile uint64_t range; /* tail << 32 | head */
+	uint8_t pad[CROWD_CACHE_LINE - sizeof(uint64_t)];
+} CROWD_QUEUE;
+
+typedef struct _CROWD_WORKER {
+	MOT_CROWD* pCrowd;
+	int id;
+	int cpu;
+	int node;
+	int nsteal;
+	int victims[CROWD_MAX_THREADS];
+#if defined(_WIN32)
+	HANDLE hThread;
+#else
+	pthread_t thread;
+#endif
+} CROWD_WORKER;
+
+struct _MOT_CROWD {
+	CROWD_QUEUE queues[CROWD_MAX_THREADS];
+	CROWD_WORKER workers[CROWD_MAX_THREADS];
+	int nthr;
+	int flags;
+	int quit;
+	uint32_t gen;
+	int nbusy;
+	const MOT_CROWD_INST* pInsts;
+	int ninst;
+	int chunkSize;
+#if defined(_WIN32)
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE start;
+	CONDITION_VARIABLE done;
+#else
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t done;
+#endif
+};
+
+static uint64_t atomLoad(volatile uint64_t* p) {
+#if defined(_MSC_VER)
+	return (uint64_t)InterlockedCompareExchange64((volatile LONG64*)p, 0, 0);
+#else
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void atomStore(volatile uint64_t* p, uint64_t val) {
+#if defined(_MSC_VER)
+	InterlockedExchange64((volatile LONG64*)p, (LONG64)val);
+#else
+	__atomic_store_n(p, val, __ATOMIC_RELEASE);
+#endif
+}
+
+static int atomCAS(volatile uint64_t* p, uint64_t cmp, uint64_t val) {
+#if defined(_MSC_VER)
+	return (uint64_t)InterlockedCompareExchange64((volatile LONG64*)p, (LONG64)val, (LONG64)cmp) == cmp;
+#else
+	return __atomic_compare_exchange_n(p, &cmp, val, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static uint64_t qrange(uint32_t head, uint32_t tail) {
+	return ((uint64_t)tail << 32) | head;
+}
+
+/* owner end */
+static int qpop(CROWD_QUEUE* pQue, uint32_t* pChunk) {
+	while (1) {
+		uint64_t r = atomLoad(&pQue->range);
+		uint32_t head = (uint32_t)r;
+		uint32_t tail = (uint32_t)(r >> 32);
+		if (head >= tail) return 0;
+		if (atomCAS(&pQue->range, r, qrange(head + 1, tail))) {
+			*pChunk = head;
+			return 1;
+		}
+	}
+}
+
+/* thief end */
+static int qsteal(CROWD_QUEUE* pQue, uint32_t* pChunk) {
+	while (1) {
+		uint64_t r = atomLoad(&pQue->range);
+		uint32_t head = (uint32_t)r;
+		uint32_t tail = (uint32_t)(r >> 32);
+		if (head >= tail) return 0;
+		if (atomCAS(&pQue->range, r, qrange(head, tail - 1))) {
+			*pChunk = tail - 1;
+			return 1;
+		}
+	}
+}
+
+int motCrowdCPUCount(void) {
+	int n = 1;
+#if defined(_WIN32)
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	n = (int)si.dwNumberOfProcessors;
+#elif defined(__linux__)
+	cpu_set_t set;
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		n = CPU_COUNT(&set);
+	}
+#elif defined(_SC_NPROCESSORS_ONLN)
+	n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (n < 1) n = 1;
+	if (n > CROWD_MAX_THREADS) n = CROWD_MAX_THREADS;
+	return n;
+}
+
+/* n-th CPU the process may run on, -1 if unknown */
+static int cpuid_nth(int n) {
+#if defined(__linux__)
+	cpu_set_t set;
+	int i, cnt = 0;
+	if (sched_getaffinity(0, sizeof(set), &set) != 0) return -1;
+	n %= CPU_COUNT(&set);
+	for (i = 0; i < CPU_SETSIZE; ++i) {
+		if (CPU_ISSET(i, &set)) {
+			if (cnt == n) return i;
+			++cnt;
+		}
+	}
+	return -1;
+#elif defined(_WIN32)
+	return n % motCrowdCPUCount();
+#else
+	return -1;
+#endif
+}
+
+static int cpunode(int cpu) {
+	int node = 0;
+	if (cpu < 0) return 0;
+#if defined(__linux__)
+	{
+		char path[128];
+		int i;
+		for (i = 0; i < 64; ++i) {
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, i);
+			if (access(path, F_OK) == 0) {
+				node = i;
+				break;
+			}
+		}
+	}
+#elif defined(_WIN32)
+	{
+		UCHAR nnode = 0;
+		if (GetNumaProcessorNode((UCHAR)cpu, &nnode)) {
+			node = nnode;
+		}
+	}
+#endif
+	return node;
+}
+
+static void pinthread(const CROWD_WORKER* pWrk) {
+	if (pWrk->cpu < 0) return;
+#if defined(__linux__)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(pWrk->cpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+#elif defined(_WIN32)
+	if (pWrk->cpu < (int)(sizeof(DWORD_PTR) * 8)) {
+		SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << pWrk->cpu);
+	}
+#endif
+}
+
+/* steal order: same node first, then by distance in worker index */
+static void victims(MOT_CROWD* pCrowd, CROWD_WORKER* pWrk) {
+	int i, j, n = 0;
+	int nthr = pCrowd->nthr;
+	for (j = 0; j < 2; ++j) {
+		for (i = 1; i < nthr; ++i) {
+			int v = (pWrk->id + i) % nthr;
+			int sameNode = pCrowd->workers[v].node == pWrk->node;
+			if (sameNode == (j == 0)) {
+				pWrk->victims[n++] = v;
+			}
+		}
+	}
+}
+
+static void evalchunk(MOT_CROWD* pCrowd, uint32_t chunk) {
+	int i;
+	int i0 = (int)chunk * pCrowd->chunkSize;
+	int i1 = i0 + pCrowd->chunkSize;
+	if (i1 > pCrowd->ninst) i1 = pCrowd->ninst;
+	for (i = i0; i < i1; ++i) {
+		const MOT_CROWD_INST* pInst = &pCrowd->pInsts[i];
+		motEvalPose(pInst->pClip, pInst->frm, pInst->pPos, pInst->pRot, pInst->pScl);
+	}
+}
+
+static void crowdwork(MOT_CROWD* pCrowd, CROWD_WORKER* pWrk) {
+	uint32_t chunk;
+	int i;
+	while (qpop(&pCrowd->queues[pWrk->id], &chunk)) {
+		evalchunk(pCrowd, chunk);
+	}
+	/* queues only shrink during a job, one pass over the victims is enough */
+	for (i = 0; i < pCrowd->nthr - 1; ++i) {
+		CROWD_QUEUE* pQue = &pCrowd->queues[pWrk->victims[i]];
+		while (qsteal(pQue, &chunk)) {
+			evalchunk(pCrowd, chunk);
+			++pWrk->nsteal;
+		}
+	}
+}
+
+#if defined(_WIN32)
+#	define CROWD_LOCK(_c) EnterCriticalSection(&(_c)->lock)
+#	define CROWD_UNLOCK(_c) LeaveCriticalSection(&(_c)->lock)
+#	define CROWD_WAIT(_c, _cv) SleepConditionVariableCS(&(_c)->_cv, &(_c)->lock, INFINITE)
+#	define CROWD_SIGNAL(_c, _cv) WakeConditionVariable(&(_c)->_cv)
+#	define CROWD_BROADCAST(_c, _cv) WakeAllConditionVariable(&(_c)->_cv)
+#else
+#	define CROWD_LOCK(_c) pthread_mutex_lock(&(_c)->lock)
+#	define CROWD_UNLOCK(_c) pthread_mutex_unlock(&(_c)->lock)
+#	define CROWD_WAIT(_c, _cv) pthread_cond_wait(&(_c)->_cv, &(_c)->lock)
+#	define CROWD_SIGNAL(_c, _cv) pthread_cond_signal(&(_c)->_cv)
+#	define CROWD_BROADCAST(_c, _cv) pthread_cond_broadcast(&(_c)->_cv)
+#endif
+
+static void workerloop(CROWD_WORKER* pWrk) {
+	MOT_CROWD* pCrowd = pWrk->pCrowd;
+	uint32_t gen = 0;
+	if (pCrowd->flags & MOT_CROWD_PIN) {
+		pinthread(pWrk);
+	}
+	while (1) {
+		CROWD_LOCK(pCrowd);
+		while (pCrowd->gen == gen && !pCrowd->quit) {
+			CROWD_WAIT(pCrowd, start);
+		}
+		gen = pCrowd->gen;
+		CROWD_UNLOCK(pCrowd);
+		if (pCrowd->quit) break;
+		crowdwork(pCrowd, pWrk);
+		CROWD_LOCK(pCrowd);
+		if (--pCrowd->nbusy == 0) {
+			CROWD_SIGNAL(pCrowd, done);
+		}
+		CROWD_UNLOCK(pCrowd);
+	}
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI workerfunc(LPVOID pData) {
+	workerloop((CROWD_WORKER*)pData);
+	return 0;
+}
+#else
+static void* workerfunc(void* pData) {
+	workerloop((CROWD_WORKER*)pData);
+	return NULL;
+}
+#endif
+
+MOT_CROWD* motCrowdCreate(int nthr, int flags) {
+	MOT_CROWD* pCrowd;
+	int i;
+	if (nthr <= 0) {
+		nthr = motCrowdCPUCount();
+	}
+	if (nthr > CROWD_MAX_THREADS) {
+		nthr = CROWD_MAX_THREADS;
+	}
+	pCrowd = (MOT_CROWD*)calloc(1, sizeof(MOT_CROWD));
+	if (!pCrowd) return NULL;
+	pCrowd->nthr = nthr;
+	pCrowd->flags = flags;
+#if defined(_WIN32)
+	InitializeCriticalSection(&pCrowd->lock);
+	InitializeConditionVariable(&pCrowd->start);
+	InitializeConditionVariable(&pCrowd->done);
+#else
+	pthread_mutex_init(&pCrowd->lock, NULL);
+	pthread_cond_init(&pCrowd->start, NULL);
+	pthread_cond_init(&pCrowd->done, NULL);
+#endif
+	for (i = 0; i < nthr; ++i) {
+		CROWD_WORKER* pWrk = &pCrowd->workers[i];
+		pWrk->pCrowd = pCrowd;
+		pWrk->id = i;
+		pWrk->cpu = cpuid_nth(i);
+		pWrk->node = cpunode(pWrk->cpu);
+	}
+	/* worker 0 is the calling thread */
+	if (flags & MOT_CROWD_PIN) {
+		pinthread(&pCrowd->workers[0]);
+	}
+	/* the crowd shrinks to the threads that started; workers read nthr and victims only once a job is posted */
+	for (i = 1; i < nthr; ++i) {
+		CROWD_WORKER* pWrk = &pCrowd->workers[i];
+#if defined(_WIN32)
+		pWrk->hThread = CreateThread(NULL, 0, workerfunc, pWrk, 0, NULL);
+		if (!pWrk->hThread) break;
+#else
+		if (pthread_create(&pWrk->thread, NULL, workerfunc, pWrk) != 0) break;
+#endif
+	}
+	nthr = i;
+	CROWD_LOCK(pCrowd);
+	pCrowd->nthr = nthr;
+	for (i = 0; i < nthr; ++i) {
+		victims(pCrowd, &pCrowd->workers[i]);
+	}
+	CROWD_UNLOCK(pCrowd);
+	return pCrowd;
+}
+
+void motCrowdDestroy(MOT_CROWD* pCrowd) {
+	int i;
+	if (!pCrowd) return;
+	CROWD_LOCK(pCrowd);
+	pCrowd->quit = 1;
+	CROWD_BROADCAST(pCrowd, start);
+	CROWD_UNLOCK(pCrowd);
+	for (i = 1; i < pCrowd->nthr; ++i) {
+#if defined(_WIN32)
+		WaitForSingleObject(pCrowd->workers[i].hThread, INFINITE);
+		CloseHandle(pCrowd->workers[i].hThread);
+#else
+		pthread_join(pCrowd->workers[i].thread, NULL);
+#endif
+	}
+#if defined(_WIN32)
+	DeleteCriticalSection(&pCrowd->lock);
+#else
+	pthread_cond_destroy(&pCrowd->done);
+	pthread_cond_destroy(&pCrowd->start);
+	pthread_mutex_destroy(&pCrowd->lock);
+#endif
+	free(pCrowd);
+}
+
+int motCrowdThreadCount(const MOT_CROWD* pCrowd) {
+	return pCrowd ? pCrowd->nthr : 0;
+}
+
+int motCrowdStealCount(const MOT_CROWD* pCrowd) {
+	int i, n = 0;
+	if (pCrowd) {
+		for (i = 0; i < pCrowd->nthr; ++i) {
+			n += pCrowd->workers[i].nsteal;
+		}
+	}
+	return n;
+}
+
+static int chunksize(const MOT_CROWD_INST* pInsts, int ninst, int nthr) {
+	int size;
+	int maxSize;
+	size_t instBytes = sizeof(MOT_VEC) + sizeof(MOT_QUAT) + sizeof(MOT_VEC);
+	if (pInsts[0].pClip) {
+		instBytes *= pInsts[0].pClip->nnod;
+	}
+	size = (int)(CROWD_CHUNK_BYTES / instBytes);
+	maxSize = ninst / (nthr * CROWD_CHUNKS_PER_THREAD);
+	if (size > maxSize) size = maxSize;
+	if (size < 1) size = 1;
+	return size;
+}
+
+void motCrowdEval(MOT_CROWD* pCrowd, const MOT_CROWD_INST* pInsts, int ninst) {
+	int i, nchunk, nthr;
+	if (!pCrowd || !pInsts || ninst <= 0) return;
+	nthr = pCrowd->nthr;
+	pCrowd->pInsts = pInsts;
+	pCrowd->ninst = ninst;
+	pCrowd->chunkSize = chunksize(pInsts, ninst, nthr);
+	nchunk = (ninst + pCrowd->chunkSize - 1) / pCrowd->chunkSize;
+	if (nthr == 1 || nchunk == 1) {
+		for (i = 0; i < nchunk; ++i) {
+			evalchunk(pCrowd, (uint32_t)i);
+		}
+		return;
+	}
+	for (i = 0; i < nthr; ++i) {
+		uint32_t c0 = (uint32_t)(((int64_t)nchunk * i) / nthr);
+		uint32_t c1 = (uint32_t)(((int64_t)nchunk * (i + 1)) / nthr);
+		atomStore(&pCrowd->queues[i].range, qrange(c0, c1));
+	}
+	CROWD_LOCK(pCrowd);
+	pCrowd->nbusy = nthr - 1;
+	++pCrowd->gen;
+	CROWD_BROADCAST(pCrowd, start);
+	CROWD_UNLOCK(pCrowd);
+	crowdwork(pCrowd, &pCrowd->workers[0]);
+	CROWD_LOCK(pCrowd);
+	while (pCrowd->nbusy > 0) {
+		CROWD_WAIT(pCrowd, done);
+	}
+	CROWD_UNLOCK(pCrowd);
+}
@@ -0,0 +1,37 @@
+/*
+ * Motion Clip crowd evaluation
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ */
+
+#ifndef MOTCROWD_H
+#define MOTCROWD_H
+
+#include "motclip.h"
+
+/*
+ * One crowd instance: pose of pClip at frm written to the caller's
+ * per-node arrays (same layout as motEvalPose, any of them may be NULL).
+ * Instances that share a clip should be kept next to each other in the
+ * array, chunks are formed from contiguous instances.
+ */
+typedef struct _MOT_CROWD_INST {
+	const MOT_CLIP* pClip;
+	float           frm;
+	MOT_VEC*        pPos;
+	MOT_QUAT*       pRot;
+	MOT_VEC*        pScl;
+} MOT_CROWD_INST;
+
+typedef struct _MOT_CROWD MOT_CROWD;
+
+#define MOT_CROWD_PIN (1 << 0)
+
+MOT_EXTERN_FUNC int motCrowdCPUCount(void);
+/* nthr <= 0: one thread per CPU; motCrowdThreadCount gives the threads that actually started */
+MOT_EXTERN_FUNC MOT_CROWD* motCrowdCreate(int nthr, int flags);
+MOT_EXTERN_FUNC void motCrowdDestroy(MOT_CROWD* pCrowd);
+MOT_EXTERN_FUNC int motCrowdThreadCount(const MOT_CROWD* pCrowd);
+MOT_EXTERN_FUNC int motCrowdStealCount(const MOT_CROWD* pCrowd);
+MOT_EXTERN_FUNC void motCrowdEval(MOT_CROWD* pCrowd, const MOT_CROWD_INST* pInsts, int ninst);
+
+#endif /* MOTCROWD_H */
@@ -0,0 +1,564 @@
+/*
+ * Motion Clip Houdini .clip reader
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ *
+ * The file is mapped and parsed in place. The header is read up to
+ * "tracks = n", the rest of the text is cut into per-thread byte ranges,
+ * every thread counts the track openings in its range, and after a prefix
+ * sum parses the tracks that open there (finishing the last one past the
+ * range end) straight into the shared track-major value array.
+ * Numbers are scanned without tokenising: up to 19 significant digits with
+ * a decimal exponent within 10^+-22 are converted exactly in double
+ * precision (then rounded to float, as (float)strtod), other forms go to
+ * strtod. POSIX builds need -pthread.
+ */
+
+#include "mothclip.h"
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN 1
+#	define NOMINMAX
+#	include <Windows.h>
+#else
+#	include <pthread.h>
+#	include <unistd.h>
+#endif
+
+#define HCLIP_MAX_THREADS (64)
+/* smaller ranges are not worth a thread */
+#define HCLIP_MIN_CHUNK (256 * 1024)
+#define HCLIP_MAX_DIGITS (19)
+#define HCLIP_MAX_NUMLEN (64)
+
+typedef struct _HCLIP_CUR {
+	const char* p;
+	const char* pEnd;
+} HCLIP_CUR;
+
+typedef struct _HCLIP_JOB {
+	MOT_HCLIP*  pHClip;
+	const char* pBeg;
+	const char* pEnd;
+	const char* pTextEnd;
+	const char* pLast; /* past the last track parsed */
+	int         count; /* track openings in the range */
+	int         trk0;
+	int         ntrk;
+	int         ok;
+	int         async;
+	void        (*func)(struct _HCLIP_JOB*);
+#if defined(_WIN32)
+	HANDLE      hThread;
+#else
+	pthread_t   thread;
+#endif
+} HCLIP_JOB;
+
+static const double s_p10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int isws(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int isdig(char c) {
+	return (unsigned)(c - '0') < 10;
+}
+
+static void skipws(HCLIP_CUR* pCur) {
+	while (pCur->p < pCur->pEnd && isws(*pCur->p)) {
+		++pCur->p;
+	}
+}
+
+/* next whitespace-delimited token, 0 at the end of text */
+static int nexttok(HCLIP_CUR* pCur, const char** ppTok, size_t* pLen) {
+	const char* p;
+	skipws(pCur);
+	p = pCur->p;
+	if (p >= pCur->pEnd) return 0;
+	while (pCur->p < pCur->pEnd && !isws(*pCur->p)) {
+		++pCur->p;
+	}
+	*ppTok = p;
+	*pLen = (size_t)(pCur->p - p);
+	return 1;
+}
+
+static int tokeq(const char* pTok, size_t len, const char* pStr) {
+	return strlen(pStr) == len && memcmp(pTok, pStr, len) == 0;
+}
+
+static int expect(HCLIP_CUR* pCur, const char* pStr) {
+	const char* pTok;
+	size_t len;
+	return nexttok(pCur, &pTok, &len) && tokeq(pTok, len, pStr);
+}
+
+static int skiptok(HCLIP_CUR* pCur) {
+	const char* pTok;
+	size_t len;
+	return nexttok(pCur, &pTok, &len);
+}
+
+static int scanslow(const char* pTok, size_t len, double* pVal) {
+	char buf[HCLIP_MAX_NUMLEN];
+	char* pNumEnd;
+	if (len >= sizeof(buf)) return 0;
+	memcpy(buf, pTok, len);
+	buf[len] = 0;
+	*pVal = strtod(buf, &pNumEnd);
+	return pNumEnd == buf + len;
+}
+
+/* decimal number token -> float, 0 if the token is not a number */
+static int scanf32(HCLIP_CUR* pCur, float* pVal) {
+	const char* pTok;
+	const char* p;
+	const char* pEnd = pCur->pEnd;
+	uint64_t mant = 0;
+	int nsig = 0;
+	int ndig = 0;
+	int exp10 = 0;
+	int trunc = 0;
+	int neg = 0;
+	double d;
+	skipws(pCur);
+	pTok = p = pCur->p;
+	if (p < pEnd && (*p == '-' || *p == '+')) {
+		neg = *p++ == '-';
+	}
+	for (; p < pEnd && isdig(*p); ++p, ++ndig) {
+		if (nsig < HCLIP_MAX_DIGITS) {
+			mant = mant*10 + (uint64_t)(*p - '0');
+			nsig += mant != 0;
+		} else {
+			++exp10;
+			trunc = 1;
+		}
+	}
+	if (p < pEnd && *p == '.') {
+		for (++p; p < pEnd && isdig(*p); ++p, ++ndig) {
+			if (nsig < HCLIP_MAX_DIGITS) {
+				mant = mant*10 + (uint64_t)(*p - '0');
+				nsig += mant != 0;
+				--exp10;
+			} else {
+				trunc = 1;
+			}
+		}
+	}
+	if (ndig && p < pEnd && (*p == 'e' || *p == 'E')) {
+		const char* pExp = p + 1;
+		int eneg = 0;
+		int e = 0;
+		if (pExp < pEnd && (*pExp == '-' || *pExp == '+')) {
+			eneg = *pExp++ == '-';
+		}
+		if (pExp < pEnd && isdig(*pExp)) {
+			for (; pExp < pEnd && isdig(*pExp); ++pExp) {
+				if (e < 100000) e = e*10 + (*pExp - '0');
+			}
+			exp10 += eneg ? -e : e;
+			p = pExp;
+		}
+	}
+	if (ndig && (p == pEnd || isws(*p)) && !trunc && mant <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+		d = exp10 < 0 ? (double)mant / s_p10[-exp10] : (double)mant * s_p10[exp10];
+		if (neg) d = -d;
+	} else {
+		while (p < pEnd && !isws(*p)) {
+			++p;
+		}
+		if (!scanslow(pTok, (size_t)(p - pTok), &d)) return 0;
+	}
+	pCur->p = p;
+	*pVal = (float)d;
+	return 1;
+}
+
+static int scanint(HCLIP_CUR* pCur, int* pVal) {
+	float val;
+	if (!scanf32(pCur, &val) || val != floorf(val) || fabsf(val) > (float)INT32_MAX) return 0;
+	*pVal = (int)val;
+	return 1;
+}
+
+static int rledata(HCLIP_CUR* pCur, float* pData, int nfrm) {
+	int cnt = 0;
+	while (cnt < nfrm) {
+		int nrle = 1;
+		float val;
+		skipws(pCur);
+		if (pCur->p < pCur->pEnd && *pCur->p == '@') {
+			++pCur->p;
+			if (!scanint(pCur, &nrle) || nrle < 1 || nrle > nfrm - cnt) return 0;
+		}
+		if (!scanf32(pCur, &val)) return 0;
+		while (--nrle >= 0) {
+			pData[cnt++] = val;
+		}
+	}
+	return 1;
+}
+
+/* { name = ... data = ... } at the cursor into track itrk, the name is left pointing into the text */
+static int trkparse(MOT_HCLIP* pHClip, int itrk, HCLIP_CUR* pCur) {
+	MOT_HCLIP_TRACK* pTrk = &pHClip->pTrks[itrk];
+	float* pData = pTrk->pData;
+	int nfrm = pHClip->nfrm;
+	int hasData = 0;
+	int i;
+	if (!expect(pCur, "{")) return 0;
+	while (1) {
+		const char* pTok;
+		size_t len;
+		if (!nexttok(pCur, &pTok, &len)) return 0;
+		if (tokeq(pTok, len, "}")) break;
+		if (!expect(pCur, "=")) return 0;
+		if (tokeq(pTok, len, "name")) {
+			if (!nexttok(pCur, &pTrk->pName, &len)) return 0;
+		} else if (tokeq(pTok, len, "data")) {
+			for (i = 0; i < nfrm; ++i) {
+				if (!scanf32(pCur, &pData[i])) return 0;
+			}
+			hasData = 1;
+		} else if (tokeq(pTok, len, "data_rle")) {
+			if (!rledata(pCur, pData, nfrm)) return 0;
+			hasData = 1;
+		} else if (!skiptok(pCur)) {
+			return 0;
+		}
+	}
+	if (!pTrk->pName) return 0;
+	if (!hasData) {
+		memset(pData, 0, (size_t)nfrm * sizeof(float));
+	}
+	pTrk->vmin = pTrk->vmax = pData[0];
+	for (i = 1; i < nfrm; ++i) {
+		pTrk->vmin = pData[i] < pTrk->vmin ? pData[i] : pTrk->vmin;
+		pTrk->vmax = pData[i] > pTrk->vmax ? pData[i] : pTrk->vmax;
+	}
+	return 1;
+}
+
+static void countjob(HCLIP_JOB* pJob) {
+	const char* p = pJob->pBeg;
+	int n = 0;
+	while (p < pJob->pEnd && (p = (const char*)memchr(p, '{', (size_t)(pJob->pEnd - p))) != NULL) {
+		++n;
+		++p;
+	}
+	pJob->count = n;
+	pJob->ok = 1;
+}
+
+static void parsejob(HCLIP_JOB* pJob) {
+	HCLIP_CUR cur;
+	int i;
+	pJob->ok = 1;
+	if (pJob->ntrk <= 0) return;
+	cur.p = (const char*)memchr(pJob->pBeg, '{', (size_t)(pJob->pEnd - pJob->pBeg));
+	cur.pEnd = pJob->pTextEnd;
+	for (i = 0; i < pJob->ntrk; ++i) {
+		if (!trkparse(pJob->pHClip, pJob->trk0 + i, &cur)) {
+			pJob->ok = 0;
+			return;
+		}
+	}
+	pJob->pLast = cur.p;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI jobfunc(LPVOID pData) {
+	HCLIP_JOB* pJob = (HCLIP_JOB*)pData;
+	pJob->func(pJob);
+	return 0;
+}
+#else
+static void* jobfunc(void* pData) {
+	HCLIP_JOB* pJob = (HCLIP_JOB*)pData;
+	pJob->func(pJob);
+	return NULL;
+}
+#endif
+
+static int cpucount(void) {
+	int n = 1;
+#if defined(_WIN32)
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	n = (int)si.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return n < 1 ? 1 : n;
+}
+
+/* job 0 runs on the calling thread */
+static int runjobs(HCLIP_JOB* pJobs, int njob, void (*func)(HCLIP_JOB*)) {
+	int i;
+	int ok = 1;
+	for (i = 0; i < njob; ++i) {
+		pJobs[i].func = func;
+		pJobs[i].ok = 0;
+	}
+	for (i = 1; i < njob; ++i) {
+#if defined(_WIN32)
+		pJobs[i].hThread = CreateThread(NULL, 0, jobfunc, &pJobs[i], 0, NULL);
+		pJobs[i].async = pJobs[i].hThread != NULL;
+#else
+		pJobs[i].async = pthread_create(&pJobs[i].thread, NULL, jobfunc, &pJobs[i]) == 0;
+#endif
+		if (!pJobs[i].async) func(&pJobs[i]);
+	}
+	func(&pJobs[0]);
+	for (i = 1; i < njob; ++i) {
+		if (!pJobs[i].async) continue;
+#if defined(_WIN32)
+		WaitForSingleObject(pJobs[i].hThread, INFINITE);
+		CloseHandle(pJobs[i].hThread);
+#else
+		pthread_join(pJobs[i].thread, NULL);
+#endif
+	}
+	for (i = 0; i < njob; ++i) {
+		ok &= pJobs[i].ok;
+	}
+	return ok;
+}
+
+/* rate, start, tracklength up to tracks = n, leaves the cursor at the first track */
+static int hdrparse(MOT_HCLIP* pHClip, HCLIP_CUR* pCur) {
+	if (!expect(pCur, "{")) return 0;
+	while (1) {
+		const char* pTok;
+		size_t len;
+		int ok;
+		if (!nexttok(pCur, &pTok, &len) || tokeq(pTok, len, "}")) return 0;
+		if (!expect(pCur, "=")) return 0;
+		if (tokeq(pTok, len, "rate")) {
+			ok = scanf32(pCur, &pHClip->rate);
+		} else if (tokeq(pTok, len, "start")) {
+			ok = scanint(pCur, &pHClip->start);
+		} else if (tokeq(pTok, len, "tracklength")) {
+			ok = scanint(pCur, &pHClip->nfrm);
+		} else if (tokeq(pTok, len, "tracks")) {
+			return scanint(pCur, &pHClip->ntrk) && pHClip->ntrk > 0 && pHClip->nfrm > 0;
+		} else {
+			ok = skiptok(pCur);
+		}
+		if (!ok) return 0;
+	}
+}
+
+/* keys after the tracks; quaternions = order n followed by n index triples */
+static int tailparse(HCLIP_CUR* pCur) {
+	while (1) {
+		const char* pTok;
+		size_t len;
+		if (!nexttok(pCur, &pTok, &len) || tokeq(pTok, len, "}")) return 1;
+		if (!expect(pCur, "=")) return 0;
+		if (tokeq(pTok, len, "quaternions")) {
+			int i, nq;
+			if (!skiptok(pCur) || !scanint(pCur, &nq) || nq < 0) return 0;
+			for (i = 0; i < nq * 3; ++i) {
+				if (!skiptok(pCur)) return 0;
+			}
+		} else if (!skiptok(pCur)) {
+			return 0;
+		}
+	}
+}
+
+static int namepool(MOT_HCLIP* pHClip) {
+	size_t size = 0;
+	char* pDst;
+	int i;
+	/* name tokens are followed by whitespace, at least before the closing brace */
+	for (i = 0; i < pHClip->ntrk; ++i) {
+		size += strcspn(pHClip->pTrks[i].pName, " \t\r\n") + 1;
+	}
+	pHClip->pNames = pDst = (char*)malloc(size);
+	if (!pDst) return 0;
+	for (i = 0; i < pHClip->ntrk; ++i) {
+		const char* pSrc = pHClip->pTrks[i].pName;
+		size_t len = strcspn(pSrc, " \t\r\n");
+		memcpy(pDst, pSrc, len);
+		pDst[len] = 0;
+		pHClip->pTrks[i].pName = pDst;
+		pDst += len + 1;
+	}
+	return 1;
+}
+
+static int hclipparse(MOT_HCLIP* pHClip, const char* pText, size_t len, int nthr) {
+	HCLIP_JOB jobs[HCLIP_MAX_THREADS];
+	HCLIP_CUR cur;
+	size_t span, chunk;
+	int i, njob, trk0;
+	cur.p = pText;
+	cur.pEnd = pText + len;
+	if (!hdrparse(pHClip, &cur)) return 0;
+	pHClip->pTrks = (MOT_HCLIP_TRACK*)calloc((size_t)pHClip->ntrk, sizeof(MOT_HCLIP_TRACK));
+	pHClip->pData = (float*)malloc((size_t)pHClip->ntrk * pHClip->nfrm * sizeof(float));
+	if (!pHClip->pTrks || !pHClip->pData) return 0;
+	for (i = 0; i < pHClip->ntrk; ++i) {
+		pHClip->pTrks[i].pData = &pHClip->pData[(size_t)i * pHClip->nfrm];
+	}
+	if (nthr <= 0) nthr = cpucount();
+	if (nthr > HCLIP_MAX_THREADS) nthr = HCLIP_MAX_THREADS;
+	span = (size_t)(cur.pEnd - cur.p);
+	njob = (int)(span / HCLIP_MIN_CHUNK);
+	njob = njob < 1 ? 1 : njob > nthr ? nthr : njob;
+	chunk = span / njob;
+	memset(jobs, 0, sizeof(jobs));
+	for (i = 0; i < njob; ++i) {
+		jobs[i].pHClip = pHClip;
+		jobs[i].pBeg = cur.p + chunk * i;
+		jobs[i].pEnd = i == njob - 1 ? cur.pEnd : jobs[i].pBeg + chunk;
+		jobs[i].pTextEnd = cur.pEnd;
+	}
+	runjobs(jobs, njob, countjob);
+	trk0 = 0;
+	for (i = 0; i < njob; ++i) {
+		int ntrk = pHClip->ntrk - trk0;
+		jobs[i].trk0 = trk0;
+		jobs[i].ntrk = jobs[i].count < ntrk ? jobs[i].count : ntrk;
+		trk0 += jobs[i].ntrk;
+	}
+	if (trk0 < pHClip->ntrk || !runjobs(jobs, njob, parsejob)) return 0;
+	/* the tracks are contiguous, the last one ends where the header resumes */
+	for (i = njob; --i >= 0;) {
+		if (jobs[i].ntrk > 0) {
+			cur.p = jobs[i].pLast;
+			break;
+		}
+	}
+	return tailparse(&cur) && namepool(pHClip);
+}
+
+int motHClipParse(MOT_HCLIP* pHClip, const char* pText, size_t len, int nthr) {
+	if (!pHClip) return 0;
+	memset(pHClip, 0, sizeof(MOT_HCLIP));
+	if (!pText) return 0;
+	if (!hclipparse(pHClip, pText, len, nthr)) {
+		motHClipFree(pHClip);
+		return 0;
+	}
+	return 1;
+}
+
+int motHClipLoad(MOT_HCLIP* pHClip, const char* pPath, int nthr) {
+	MOT_FMAP map;
+	int res;
+	if (!pHClip) return 0;
+	memset(pHClip, 0, sizeof(MOT_HCLIP));
+	if (!motFileMap(&map, pPath)) return 0;
+	res = motHClipParse(pHClip, (const char*)map.pMem, map.size, nthr);
+	motFileUnmap(&map);
+	return res;
+}
+
+void motHClipFree(MOT_HCLIP* pHClip) {
+	if (!pHClip) return;
+	free(pHClip->pTrks);
+	free(pHClip->pData);
+	free(pHClip->pNames);
+	memset(pHClip, 0, sizeof(MOT_HCLIP));
+}
+
+/* node part of a channel path: after the last '/', before the last ':' */
+static const char* trknode(const char* pName, size_t* pLen, const char** ppChan) {
+	const char* pSep = strrchr(pName, ':');
+	const char* pSlash = strrchr(pName, '/');
+	const char* pNode = pSlash ? pSlash + 1 : pName;
+	if (pSep && pSep < pNode) pSep = NULL;
+	*pLen = pSep ? (size_t)(pSep - pNode) : strlen(pNode);
+	*ppChan = pSep ? pSep + 1 : "";
+	return pNode;
+}
+
+int motHClipFindTrack(const MOT_HCLIP* pHClip, const char* pNodeName, const char* pChanName) {
+	int i;
+	if (!pHClip || !pNodeName || !pChanName) return -1;
+	for (i = 0; i < pHClip->ntrk; ++i) {
+		const char* pChan;
+		size_t len;
+		const char* pNode = trknode(pHClip->pTrks[i].pName, &len, &pChan);
+		if (len == strlen(pNodeName) && memcmp(pNode, pNodeName, len) == 0 && strcmp(pChan, pChanName) == 0) return i;
+	}
+	return -1;
+}
+
+typedef struct _HCLIP_NODE_REF {
+	const char* pNode;
+	const char* pChan;
+	size_t      len;
+	int         itrk;
+} HCLIP_NODE_REF;
+
+static int refcmp(const void* p1, const void* p2) {
+	const HCLIP_NODE_REF* pRef1 = (const HCLIP_NODE_REF*)p1;
+	const HCLIP_NODE_REF* pRef2 = (const HCLIP_NODE_REF*)p2;
+	size_t len = pRef1->len < pRef2->len ? pRef1->len : pRef2->len;
+	int cmp = memcmp(pRef1->pNode, pRef2->pNode, len);
+	if (cmp) return cmp;
+	if (pRef1->len != pRef2->len) return pRef1->len < pRef2->len ? -1 : 1;
+	return pRef1->itrk - pRef2->itrk;
+}
+
+/* one node from a run of its channel references */
+static int buildnode(const MOT_HCLIP* pHClip, MOT_CLIP_BUILDER* pBld, const HCLIP_NODE_REF* pRefs, int nref) {
+	char name[sizeof(MOT_STRING)];
+	int xord = XORD_SRT;
+	int rord = RORD_XYZ;
+	int i, inod;
+	if (pRefs[0].len >= sizeof(name)) return 0;
+	memcpy(name, pRefs[0].pNode, pRefs[0].len);
+	name[pRefs[0].len] = 0;
+	for (i = 0; i < nref; ++i) {
+		const float* pData = pHClip->pTrks[pRefs[i].itrk].pData;
+		if (strcmp(pRefs[i].pChan, "xOrd") == 0) xord = (int)pData[0];
+		if (strcmp(pRefs[i].pChan, "rOrd") == 0) rord = (int)pData[0];
+	}
+	inod = motClipBuilderAddNode(pBld, name, (E_MOT_XORD)xord, (E_MOT_RORD)rord);
+	if (inod < 0) return 0;
+	for (i = 0; i < nref; ++i) {
+		const char* pChan = pRefs[i].pChan;
+		const char* pKind = pChan[0] ? strchr("trs", pChan[0]) : NULL;
+		if (pKind && pChan[1] >= 'x' && pChan[1] <= 'z' && !pChan[2]) {
+			motClipBuilderSetChan(pBld, inod, (E_MOT_TRK)(pKind - "trs"), pChan[1] - 'x', pHClip->pTrks[pRefs[i].itrk].pData, 1);
+		}
+	}
+	return 1;
+}
+
+int motHClipBuild(const MOT_HCLIP* pHClip, MOT_CLIP_BUILDER* pBld) {
+	HCLIP_NODE_REF* pRefs;
+	int i, n;
+	int nnod = 0;
+	if (!pHClip || !pBld || pHClip->ntrk <= 0) return -1;
+	n = pHClip->ntrk;
+	pRefs = (HCLIP_NODE_REF*)malloc((size_t)n * sizeof(HCLIP_NODE_REF));
+	if (!pRefs) return -1;
+	for (i = 0; i < n; ++i) {
+		pRefs[i].pNode = trknode(pHClip->pTrks[i].pName, &pRefs[i].len, &pRefs[i].pChan);
+		pRefs[i].itrk = i;
+	}
+	/* grouped by node name, channels in file order within a node */
+	qsort(pRefs, n, sizeof(HCLIP_NODE_REF), refcmp);
+	motClipBuilderSetRotMode(pBld, BROT_DEGREES);
+	for (i = 0; i < n && nnod >= 0;) {
+		int nref = 1;
+		while (i + nref < n && pRefs[i + nref].len == pRefs[i].len && memcmp(pRefs[i + nref].pNode, pRefs[i].pNode, pRefs[i].len) == 0) {
+			++nref;
+		}
+		nnod = buildnode(pHClip, pBld, &pRefs[i], nref) ? nnod + 1 : -1;
+		i += nref;
+	}
+	free(pRefs);
+	return nnod;
+}
@@ -0,0 +1,48 @@
+/*
+ * Motion Clip Houdini .clip reader
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ */
+
+#ifndef MOTHCLIP_H
+#define MOTHCLIP_H
+
+#include "motbuild.h"
+
+/*
+ * Text channel clips as exported by Houdini/TouchDesigner CHOPs:
+ * { rate = r start = s tracklength = n tracks = m { name = node:tx data = ... } ... }
+ * Tracks are given as data (n values) or data_rle (@count value runs).
+ * Values are parsed as (float)strtod would parse them, as hclip.cs does.
+ */
+typedef struct _MOT_HCLIP_TRACK {
+	const char* pName; /* full channel path, e.g. /obj/root:tx */
+	float*      pData; /* nfrm values */
+	float       vmin;
+	float       vmax;
+} MOT_HCLIP_TRACK;
+
+typedef struct _MOT_HCLIP {
+	float            rate;
+	int              start; /* as stored, one less than the first frame number */
+	int              nfrm;
+	int              ntrk;
+	MOT_HCLIP_TRACK* pTrks;
+	float*           pData;  /* ntrk * nfrm values, track-major */
+	char*            pNames;
+} MOT_HCLIP;
+
+/* nthr <= 0: one thread per CPU */
+MOT_EXTERN_FUNC int motHClipParse(MOT_HCLIP* pHClip, const char* pText, size_t len, int nthr);
+MOT_EXTERN_FUNC int motHClipLoad(MOT_HCLIP* pHClip, const char* pPath, int nthr);
+MOT_EXTERN_FUNC void motHClipFree(MOT_HCLIP* pHClip);
+MOT_EXTERN_FUNC int motHClipFindTrack(const MOT_HCLIP* pHClip, const char* pNodeName, const char* pChanName);
+
+/*
+ * Adds a node per distinct node name with its t[xyz], r[xyz], s[xyz]
+ * channels and xOrd/rOrd orders, as cMotClipWriter does; rotations are
+ * Euler degrees (BROT_DEGREES). The builder references the track data,
+ * so pHClip must outlive motClipBuilderWrite. Returns the node count or -1.
+ */
+MOT_EXTERN_FUNC int motHClipBuild(const MOT_HCLIP* pHClip, MOT_CLIP_BUILDER* pBld);
+
+#endif /* MOTHCLIP_H */
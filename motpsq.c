@@ -0,0 +1,537 @@
+/*
+ * Motion Clip PoseSeq (PSQ) decoder
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ *
+ * Poses are variable-length bit records (see PoseSeq/psq.py), so a pose is
+ * decoded in two passes: the bit stream is unpacked into raw relative
+ * values, then all lanes are rebased with base + rel*size in one batch.
+ * Two decoded poses are cached, forward playback decodes each pose once.
+ */
+
+#include "motpsq.h"
+
+#if !defined(MOT_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#	define MOT_SIMD_X86 1
+#	include <immintrin.h>
+#elif !defined(MOT_NO_SIMD) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#	define MOT_SIMD_NEON 1
+#	include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define MOT_TARGET(_t) __attribute__((target(_t)))
+#else
+#	define MOT_TARGET(_t)
+#endif
+
+const char g_motPsqFmt[4] = { 'P', 'S', 'Q', 0 };
+
+/* track order in PSQ records */
+#define PSQ_ROT (0)
+#define PSQ_POS (1)
+#define PSQ_SCL (2)
+
+/* pose slot: pos[3*nnod], rot[4*nnod], scl[3*nnod] */
+#define PSQ_SLOT_SIZE(_nnod) ((_nnod) * (3 + 4 + 3))
+
+typedef struct _PSQ_TRK {
+	int32_t  lane;  /* first lane for relative tracks, rot slot index for octa */
+	uint16_t node;
+	uint8_t  nelem; /* 0: octa quat */
+	uint8_t  mcut;
+	uint8_t  axisBits;
+	uint8_t  angleBits;
+	uint8_t  reserved[2];
+} PSQ_TRK;
+
+struct _MOT_PSQ_DEC {
+	const MOT_PSQ* pPsq;
+	const uint8_t* pBits;
+	size_t nbytes;
+	int nnod;
+	int npose;
+	int ntrk;
+	int nlane;
+	int nnrm;
+	E_MOT_SIMD simd;
+	PSQ_TRK* pTrk;
+	uint32_t* pPoseOrg;
+	float* pBase;
+	float* pSize;
+	int32_t* pDst;
+	float* pRel;
+	int32_t* pNrm;  /* rot slot indices of quats to renormalize */
+	float* pSlot[2];
+	int slotPose[2];
+	void* pMem;
+};
+
+int motPsqHeaderCk(const MOT_PSQ* pPsq) {
+	int i;
+	if (!pPsq) return 0;
+	for (i = 0; i < 4; ++i) {
+		if (pPsq->fmt[i] != g_motPsqFmt[i]) return 0;
+	}
+	return 1;
+}
+
+const MOT_PSQ_NODE* motPsqGetNode(const MOT_PSQ* pPsq, int nodeIdx) {
+	if (!pPsq || (uint32_t)nodeIdx >= pPsq->nnod) return NULL;
+	return (const MOT_PSQ_NODE*)((const uint8_t*)pPsq + pPsq->nodes + nodeIdx*sizeof(MOT_PSQ_NODE));
+}
+
+const char* motPsqGetNodeName(const MOT_PSQ* pPsq, int nodeIdx) {
+	const MOT_PSQ_NODE* pNode = motPsqGetNode(pPsq, nodeIdx);
+	if (!pNode || !pNode->name) return NULL;
+	return (const char*)pPsq + pNode->name + sizeof(uint16_t);
+}
+
+static uint16_t strhash16(const char* pStr) {
+	uint32_t h = 2166136261;
+	while (*pStr) {
+		h ^= (uint8_t)*pStr++;
+		h *= 16777619;
+	}
+	return (uint16_t)((h >> 16) ^ (h & 0xFFFF));
+}
+
+int motPsqFindNode(const MOT_PSQ* pPsq, const char* pName) {
+	int i;
+	uint16_t h;
+	if (!pPsq || !pName) return -1;
+	h = strhash16(pName);
+	for (i = 0; i < pPsq->nnod; ++i) {
+		const MOT_PSQ_NODE* pNode = motPsqGetNode(pPsq, i);
+		const uint8_t* pRec = (const uint8_t*)pPsq + pNode->name;
+		if (pNode->name && (pRec[0] | (pRec[1] << 8)) == h) {
+			if (strcmp((const char*)pRec + 2, pName) == 0) return i;
+		}
+	}
+	return -1;
+}
+
+static const float* psqvec(const MOT_PSQ* pPsq, int id) {
+	if (id < 0 || id >= pPsq->nvec) return NULL;
+	return (const float*)((const uint8_t*)pPsq + pPsq->vecs) + id*4;
+}
+
+static int psqbitcnt(int mask) {
+	int n = 0;
+	while (mask) {
+		n += mask & 1;
+		mask >>= 1;
+	}
+	return n;
+}
+
+static int psqctz(uint32_t x) {
+	int n = 0;
+	if (!x) return 32;
+	while (!(x & 1)) {
+		x >>= 1;
+		++n;
+	}
+	return n;
+}
+
+/* LSB-first bit stream, n <= 32 */
+static uint32_t getbits(const uint8_t* pBits, size_t nbytes, uint32_t pos, int n) {
+	size_t offs = pos >> 3;
+	uint64_t w = 0;
+	if (offs + 8 <= nbytes) {
+		memcpy(&w, pBits + offs, 8);
+	} else {
+		int i;
+		for (i = 0; i < 8 && offs + i < nbytes; ++i) {
+			w |= (uint64_t)pBits[offs + i] << (i*8);
+		}
+	}
+	w >>= pos & 7;
+	return (uint32_t)(w & ((1ULL << n) - 1));
+}
+
+static float signnz(float x) {
+	return x >= 0.0f ? 1.0f : -1.0f;
+}
+
+static float sunit(uint32_t x, int bits) {
+	int32_t m = (1 << (bits - 1)) - 1;
+	int32_t i = m - (int32_t)((x & ((1U << bits) - 1)) ^ (uint32_t)m);
+	return (float)i / (float)m;
+}
+
+static void octaquat(float q[4], uint32_t ox, uint32_t oy, uint32_t ia, int axisBits, int angleBits) {
+	float ang = (float)ia * (6.28318548f / (float)(1U << angleBits));
+	q[0] = 0.0f;
+	q[1] = 0.0f;
+	q[2] = 0.0f;
+	q[3] = 1.0f;
+	if (ia) {
+		float x = sunit(ox, axisBits);
+		float y = sunit(oy, axisBits);
+		float ax = fabsf(x);
+		float ay = fabsf(y);
+		float z = 1.0f - ax - ay;
+		float len, s;
+		if (z < 0.0f) {
+			x = (1.0f - ay) * signnz(x);
+			y = (1.0f - ax) * signnz(y);
+		}
+		len = sqrtf(x*x + y*y + z*z);
+		s = len > 0.0f ? sinf(ang * 0.5f) / len : 0.0f;
+		q[0] = x * s;
+		q[1] = y * s;
+		q[2] = z * s;
+		q[3] = cosf(ang * 0.5f);
+	} else if (ox | oy) {
+		q[3] = -1.0f;
+	}
+}
+
+static void qnrm(float q[4]) {
+	float s = q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3];
+	if (s > 0.0f) {
+		int i;
+		s = 1.0f / sqrtf(s);
+		for (i = 0; i < 4; ++i) {
+			q[i] *= s;
+		}
+	}
+}
+
+static int slotofs(int nnod, int kind, int node) {
+	switch (kind) {
+		case PSQ_POS: return node*3;
+		case PSQ_ROT: return nnod*3 + node*4;
+		default: break;
+	}
+	return nnod*7 + node*3;
+}
+
+static void slotinit(MOT_PSQ_DEC* pDec, float* pSlot) {
+	const MOT_PSQ* pPsq = pDec->pPsq;
+	int nnod = pDec->nnod;
+	int i, k, kind;
+	for (i = 0; i < nnod; ++i) {
+		const MOT_PSQ_NODE* pNode = motPsqGetNode(pPsq, i);
+		for (kind = 0; kind < 3; ++kind) {
+			float* pDst = &pSlot[slotofs(nnod, kind, i)];
+			int nelem = kind == PSQ_ROT ? 4 : 3;
+			const float* pBase = NULL;
+			for (k = 0; k < nelem; ++k) {
+				pDst[k] = (kind == PSQ_SCL || k == 3) ? 1.0f : 0.0f;
+			}
+			if (!(pNode->trkMask & (1 << kind))) continue;
+			pBase = psqvec(pPsq, pNode->vecId[kind][0]);
+			if (pBase) {
+				for (k = 0; k < nelem; ++k) {
+					pDst[k] = pBase[k];
+				}
+				if (kind == PSQ_ROT) {
+					qnrm(pDst);
+				}
+			}
+		}
+	}
+}
+
+MOT_PSQ_DEC* motPsqDecCreate(const MOT_PSQ* pPsq) {
+	MOT_PSQ_DEC* pDec;
+	uint8_t* pMem;
+	size_t memSize;
+	int i, k, kind, nnod, npose, ntrk, nlane, nnrm;
+	uint32_t org;
+	if (!motPsqHeaderCk(pPsq)) return NULL;
+	nnod = pPsq->nnod;
+	npose = pPsq->npose;
+	if (nnod <= 0 || npose <= 0) return NULL;
+	ntrk = 0;
+	nlane = 0;
+	nnrm = 0;
+	for (i = 0; i < nnod; ++i) {
+		const MOT_PSQ_NODE* pNode = motPsqGetNode(pPsq, i);
+		for (kind = 0; kind < 3; ++kind) {
+			if (!(pNode->trkMask & (1 << kind))) continue;
+			if (kind == PSQ_ROT && (pNode->bitInfo[kind] >> 8)) {
+				++ntrk;
+			} else if (pNode->vecId[kind][1] >= 0) {
+				++ntrk;
+				nlane += psqbitcnt(pNode->axisMask[kind]);
+				if (kind == PSQ_ROT) ++nnrm;
+			}
+		}
+	}
+	memSize = sizeof(MOT_PSQ_DEC) + ntrk*sizeof(PSQ_TRK) + (npose + 1)*sizeof(uint32_t)
+	        + nlane*(3*sizeof(float) + sizeof(int32_t)) + nnrm*sizeof(int32_t)
+	        + 2*PSQ_SLOT_SIZE(nnod)*sizeof(float) + 0x40;
+	pMem = (uint8_t*)malloc(memSize);
+	if (!pMem) return NULL;
+	memset(pMem, 0, memSize);
+	pDec = (MOT_PSQ_DEC*)pMem;
+	pDec->pMem = pMem;
+	pMem += sizeof(MOT_PSQ_DEC);
+	pDec->pPsq = pPsq;
+	pDec->nnod = nnod;
+	pDec->npose = npose;
+	pDec->ntrk = ntrk;
+	pDec->nlane = nlane;
+	pDec->nnrm = nnrm;
+	pDec->simd = motGetSIMD();
+	pDec->pTrk = (PSQ_TRK*)pMem;
+	pMem += ntrk*sizeof(PSQ_TRK);
+	pDec->pPoseOrg = (uint32_t*)pMem;
+	pMem += (npose + 1)*sizeof(uint32_t);
+	pDec->pBase = (float*)pMem;
+	pMem += nlane*sizeof(float);
+	pDec->pSize = (float*)pMem;
+	pMem += nlane*sizeof(float);
+	pDec->pRel = (float*)pMem;
+	pMem += nlane*sizeof(float);
+	pDec->pDst = (int32_t*)pMem;
+	pMem += nlane*sizeof(int32_t);
+	pDec->pNrm = (int32_t*)pMem;
+	pMem += nnrm*sizeof(int32_t);
+	for (k = 0; k < 2; ++k) {
+		pDec->pSlot[k] = (float*)pMem;
+		pMem += PSQ_SLOT_SIZE(nnod)*sizeof(float);
+		pDec->slotPose[k] = -1;
+	}
+
+	/* pose bit origins from the size list, the bit stream follows it */
+	org = 0;
+	for (i = 0; i < npose; ++i) {
+		pDec->pPoseOrg[i] = org;
+		if (pPsq->poseSize) {
+			org += ((const uint32_t*)((const uint8_t*)pPsq + pPsq->poseSize))[i];
+		}
+	}
+	pDec->pPoseOrg[npose] = org;
+	if (pPsq->poseSize) {
+		pDec->pBits = (const uint8_t*)pPsq + pPsq->poseSize + npose*sizeof(uint32_t);
+		pDec->nbytes = (pPsq->nbits + 7) >> 3;
+	}
+
+	/* tracks in record order */
+	ntrk = 0;
+	nlane = 0;
+	nnrm = 0;
+	for (i = 0; i < nnod; ++i) {
+		const MOT_PSQ_NODE* pNode = motPsqGetNode(pPsq, i);
+		for (kind = 0; kind < 3; ++kind) {
+			PSQ_TRK* pTrk = &pDec->pTrk[ntrk];
+			int info = pNode->bitInfo[kind];
+			if (!(pNode->trkMask & (1 << kind))) continue;
+			if (kind == PSQ_ROT && (info >> 8)) {
+				pTrk->node = (uint16_t)i;
+				pTrk->nelem = 0;
+				pTrk->axisBits = (uint8_t)(info & 0xFF);
+				pTrk->angleBits = (uint8_t)(info >> 8);
+				pTrk->lane = slotofs(nnod, kind, i);
+				++ntrk;
+			} else if (pNode->vecId[kind][1] >= 0) {
+				const float* pBase = psqvec(pPsq, pNode->vecId[kind][0]);
+				const float* pSize = psqvec(pPsq, pNode->vecId[kind][1]);
+				int nelem = kind == PSQ_ROT ? 4 : 3;
+				pTrk->node = (uint16_t)i;
+				pTrk->nelem = (uint8_t)psqbitcnt(pNode->axisMask[kind]);
+				pTrk->mcut = (uint8_t)info;
+				pTrk->lane = nlane;
+				for (k = 0; k < nelem; ++k) {
+					if (!(pNode->axisMask[kind] & (1 << k))) continue;
+					pDec->pBase[nlane] = pBase ? pBase[k] : 0.0f;
+					pDec->pSize[nlane] = pSize ? pSize[k] : 0.0f;
+					pDec->pDst[nlane] = slotofs(nnod, kind, i) + k;
+					++nlane;
+				}
+				if (kind == PSQ_ROT) {
+					pDec->pNrm[nnrm++] = slotofs(nnod, kind, i);
+				}
+				++ntrk;
+			}
+		}
+	}
+	for (k = 0; k < 2; ++k) {
+		slotinit(pDec, pDec->pSlot[k]);
+	}
+	return pDec;
+}
+
+void motPsqDecDestroy(MOT_PSQ_DEC* pDec) {
+	if (pDec) {
+		free(pDec->pMem);
+	}
+}
+
+void motPsqDecSetSIMD(MOT_PSQ_DEC* pDec, E_MOT_SIMD simd) {
+	if (pDec) {
+		pDec->simd = motSIMDCk(simd) ? simd : motGetSIMD();
+	}
+}
+
+/* pass 1: bit records -> raw relative values (octa quats go straight to the slot) */
+static void unpackpose(MOT_PSQ_DEC* pDec, int pose, float* pSlot) {
+	const uint8_t* pBits = pDec->pBits;
+	size_t nbytes = pDec->nbytes;
+	uint32_t pos = pDec->pPoseOrg[pose];
+	uint32_t* pRel = (uint32_t*)pDec->pRel;
+	int i, j;
+	for (i = 0; i < pDec->ntrk; ++i) {
+		const PSQ_TRK* pTrk = &pDec->pTrk[i];
+		if (pTrk->nelem) {
+			int mbits = 23 - pTrk->mcut;
+			int n = psqctz(getbits(pBits, nbytes, pos, 8));
+			uint32_t* pDst = &pRel[pTrk->lane];
+			pos += n + 1;
+			for (j = 0; j < pTrk->nelem; ++j) {
+				int32_t e = (int32_t)getbits(pBits, nbytes, pos, n) - 1;
+				uint32_t m;
+				pos += n;
+				m = getbits(pBits, nbytes, pos, mbits) << pTrk->mcut;
+				pos += mbits;
+				if (e) {
+					e = e < 0 ? -127 : -e;
+				}
+				pDst[j] = ((uint32_t)(e + 127) << 23) | m;
+			}
+		} else {
+			int ab = pTrk->axisBits;
+			uint32_t ox = getbits(pBits, nbytes, pos, ab);
+			uint32_t oy = getbits(pBits, nbytes, pos + ab, ab);
+			uint32_t ia = getbits(pBits, nbytes, pos + ab*2, pTrk->angleBits);
+			pos += ab*2 + pTrk->angleBits;
+			octaquat(&pSlot[pTrk->lane], ox, oy, ia, ab, pTrk->angleBits);
+		}
+	}
+}
+
+/* pass 2: rebase all lanes */
+static void rebase(float* pSlot, const float* pRel, const float* pBase, const float* pSize, const int32_t* pDst, int i0, int n) {
+	int i;
+	for (i = i0; i < n; ++i) {
+		pSlot[pDst[i]] = pBase[i] + pRel[i]*pSize[i];
+	}
+}
+
+#if MOT_SIMD_X86
+static MOT_TARGET("avx2") void rebaseAVX2(float* pSlot, const float* pRel, const float* pBase, const float* pSize, const int32_t* pDst, int n) {
+	float res[8];
+	int i, k;
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256 v = _mm256_add_ps(_mm256_loadu_ps(&pBase[i]), _mm256_mul_ps(_mm256_loadu_ps(&pRel[i]), _mm256_loadu_ps(&pSize[i])));
+		_mm256_storeu_ps(res, v);
+		for (k = 0; k < 8; ++k) {
+			pSlot[pDst[i + k]] = res[k];
+		}
+	}
+	rebase(pSlot, pRel, pBase, pSize, pDst, i, n);
+}
+#endif
+
+#if MOT_SIMD_NEON
+static void rebaseNEON(float* pSlot, const float* pRel, const float* pBase, const float* pSize, const int32_t* pDst, int n) {
+	float res[4];
+	int i, k;
+	for (i = 0; i + 4 <= n; i += 4) {
+		float32x4_t v = vmlaq_f32(vld1q_f32(&pBase[i]), vld1q_f32(&pRel[i]), vld1q_f32(&pSize[i]));
+		vst1q_f32(res, v);
+		for (k = 0; k < 4; ++k) {
+			pSlot[pDst[i + k]] = res[k];
+		}
+	}
+	rebase(pSlot, pRel, pBase, pSize, pDst, i, n);
+}
+#endif
+
+static float* decslot(MOT_PSQ_DEC* pDec, int pose, int keep) {
+	int k;
+	float* pSlot;
+	for (k = 0; k < 2; ++k) {
+		if (pDec->slotPose[k] == pose) return pDec->pSlot[k];
+	}
+	k = pDec->slotPose[0] == keep ? 1 : 0;
+	pSlot = pDec->pSlot[k];
+	pDec->slotPose[k] = pose;
+	if (!pDec->pBits) return pSlot;
+	unpackpose(pDec, pose, pSlot);
+	switch (pDec->simd) {
+#if MOT_SIMD_X86
+		case SIMD_AVX2:
+			rebaseAVX2(pSlot, pDec->pRel, pDec->pBase, pDec->pSize, pDec->pDst, pDec->nlane);
+			break;
+#endif
+#if MOT_SIMD_NEON
+		case SIMD_NEON:
+			rebaseNEON(pSlot, pDec->pRel, pDec->pBase, pDec->pSize, pDec->pDst, pDec->nlane);
+			break;
+#endif
+		default:
+			rebase(pSlot, pDec->pRel, pDec->pBase, pDec->pSize, pDec->pDst, 0, pDec->nlane);
+			break;
+	}
+	for (k = 0; k < pDec->nnrm; ++k) {
+		qnrm(&pSlot[pDec->pNrm[k]]);
+	}
+	return pSlot;
+}
+
+static void slotout(const MOT_PSQ_DEC* pDec, const float* pSlot, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	int nnod = pDec->nnod;
+	if (pPos) memcpy(pPos, &pSlot[slotofs(nnod, PSQ_POS, 0)], nnod*sizeof(MOT_VEC));
+	if (pRot) memcpy(pRot, &pSlot[slotofs(nnod, PSQ_ROT, 0)], nnod*sizeof(MOT_QUAT));
+	if (pScl) memcpy(pScl, &pSlot[slotofs(nnod, PSQ_SCL, 0)], nnod*sizeof(MOT_VEC));
+}
+
+void motPsqDecPose(MOT_PSQ_DEC* pDec, int pose, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	if (!pDec || (uint32_t)pose >= (uint32_t)pDec->npose) return;
+	slotout(pDec, decslot(pDec, pose, -1), pPos, pRot, pScl);
+}
+
+static void veclerp(float* pDst, const float* pA, const float* pB, float t, int n) {
+	int i;
+	for (i = 0; i < n; ++i) {
+		pDst[i] = pA[i] + (pB[i] - pA[i])*t;
+	}
+}
+
+void motPsqEval(MOT_PSQ_DEC* pDec, float frm, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	const float* pA;
+	const float* pB;
+	float f, t;
+	int i, fno, next, nnod;
+	if (!pDec) return;
+	nnod = pDec->nnod;
+	f = fmodf(fabsf(frm), (float)pDec->npose);
+	fno = (int)f;
+	t = f - (float)fno;
+	next = fno < pDec->npose - 1 ? fno + 1 : 0;
+	pA = decslot(pDec, fno, next);
+	if (t == 0.0f) {
+		slotout(pDec, pA, pPos, pRot, pScl);
+		return;
+	}
+	pB = decslot(pDec, next, fno);
+	if (pPos) {
+		int ofs = slotofs(nnod, PSQ_POS, 0);
+		veclerp(pPos->s, &pA[ofs], &pB[ofs], t, nnod*3);
+	}
+	if (pScl) {
+		int ofs = slotofs(nnod, PSQ_SCL, 0);
+		veclerp(pScl->s, &pA[ofs], &pB[ofs], t, nnod*3);
+	}
+	if (pRot) {
+		const float* pQA = &pA[slotofs(nnod, PSQ_ROT, 0)];
+		const float* pQB = &pB[slotofs(nnod, PSQ_ROT, 0)];
+		for (i = 0; i < nnod; ++i) {
+			float* pQ = pRot[i].s;
+			float d = pQA[0]*pQB[0] + pQA[1]*pQB[1] + pQA[2]*pQB[2] + pQA[3]*pQB[3];
+			float tb = d < 0.0f ? -t : t;
+			int k;
+			for (k = 0; k < 4; ++k) {
+				pQ[k] = pQA[k]*(1.0f - t) + pQB[k]*tb;
+			}
+			qnrm(pQ);
+			pQA += 4;
+			pQB += 4;
+		}
+	}
+}
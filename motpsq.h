@@ -0,0 +1,50 @@
+/*
+ * Motion Clip PoseSeq (PSQ) decoder
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ */
+
+#ifndef MOTPSQ_H
+#define MOTPSQ_H
+
+#include "motclip.h"
+
+/* layout written by PoseSeq/psq.py */
+typedef struct _MOT_PSQ_NODE {
+	uint32_t name;       /* -> u16 hash16, C string */
+	uint8_t  xord;
+	uint8_t  rord;
+	uint16_t bitInfo[3]; /* rot, pos, scl */
+	int16_t  vecId[3][2]; /* rot, pos, scl: base, size */
+	uint8_t  axisMask[3];
+	uint8_t  trkMask;    /* 1: rot, 2: pos, 4: scl */
+} MOT_PSQ_NODE;
+
+typedef struct _MOT_PSQ {
+	char     fmt[4];
+	uint32_t size;
+	uint16_t nnod;
+	uint16_t npose;
+	uint16_t nvec;
+	uint16_t reserved;
+	uint32_t nodes;
+	uint32_t poseSize;
+	uint32_t vecs;
+	uint32_t nbits;
+} MOT_PSQ;
+
+typedef struct _MOT_PSQ_DEC MOT_PSQ_DEC;
+
+MOT_EXTERN_DATA const char g_motPsqFmt[4];
+
+MOT_EXTERN_FUNC int motPsqHeaderCk(const MOT_PSQ* pPsq);
+MOT_EXTERN_FUNC const MOT_PSQ_NODE* motPsqGetNode(const MOT_PSQ* pPsq, int nodeIdx);
+MOT_EXTERN_FUNC const char* motPsqGetNodeName(const MOT_PSQ* pPsq, int nodeIdx);
+MOT_EXTERN_FUNC int motPsqFindNode(const MOT_PSQ* pPsq, const char* pName);
+
+MOT_EXTERN_FUNC MOT_PSQ_DEC* motPsqDecCreate(const MOT_PSQ* pPsq);
+MOT_EXTERN_FUNC void motPsqDecDestroy(MOT_PSQ_DEC* pDec);
+MOT_EXTERN_FUNC void motPsqDecSetSIMD(MOT_PSQ_DEC* pDec, E_MOT_SIMD simd);
+MOT_EXTERN_FUNC void motPsqDecPose(MOT_PSQ_DEC* pDec, int pose, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl);
+MOT_EXTERN_FUNC void motPsqEval(MOT_PSQ_DEC* pDec, float frm, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl);
+
+#endif /* MOTPSQ_H */
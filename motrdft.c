@@ -0,0 +1,431 @@
+/*
+ * Motion Clip truncated RDFT evaluation
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ *
+ * CPU counterpart of CUDA_mot_eval.cu: every channel of a frame uses the
+ * same cos(k*w), sin(k*w), so they are generated once per frame with the
+ * NR (5.4.6) recurrence, stepped 8 terms at a time in the SIMD variants.
+ * Channels are sorted by series length and evaluated 8 at a time, one per
+ * lane, from blocks of their coefficients stored term by term, so short
+ * series cost their own length rather than a padded row each.
+ * Channels are split across threads with OpenMP when built with -fopenmp.
+ */
+
+#include "motrdft.h"
+
+#if !defined(MOT_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#	define MOT_SIMD_X86 1
+#	include <immintrin.h>
+#elif !defined(MOT_NO_SIMD) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#	define MOT_SIMD_NEON 1
+#	include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#	define MOT_TARGET(_t) __attribute__((target(_t)))
+#else
+#	define MOT_TARGET(_t)
+#endif
+
+/* channels * terms below which a frame is not worth a parallel region */
+#define RDFT_OMP_MIN_WORK (1 << 14)
+
+#define RDFT_BLK_STRIDE (MOT_RDFT_LANES * 2)
+
+typedef void (*RDFT_LANES_FUNC)(float* pRes, const float* pBlk, const float* pTrig, int cut, int tpad);
+
+static int rdftpad(int n) {
+	return (n + MOT_RDFT_LANES - 1) & ~(MOT_RDFT_LANES - 1);
+}
+
+static int rdftchans(const MOT_CLIP* pClip, MOT_CMAP* pMap) {
+	int i, kind, chan;
+	int n = 0;
+	for (i = 0; i < (int)pClip->nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			const MOT_TRACK* pTrk = &pClip->nodes[i].trk[kind];
+			if (!pTrk->srcMask || !motGetTrackData(pClip, i, (E_MOT_TRK)kind)) continue;
+			for (chan = 0; chan < 3; ++chan) {
+				if (pTrk->dataMask & (1 << chan)) {
+					if (pMap) {
+						pMap[n].node = (uint16_t)i;
+						pMap[n].kind = (uint8_t)kind;
+						pMap[n].chan = (uint8_t)chan;
+					}
+					++n;
+				}
+			}
+		}
+	}
+	return n;
+}
+
+/* stored series of a Fourier-encoded track channel (see motClipRdft) */
+static const uint32_t* rdftblk(const MOT_CLIP* pClip, const MOT_CMAP* pMap) {
+	const uint8_t* pBlk = (const uint8_t*)motGetTrackData(pClip, pMap->node, (E_MOT_TRK)pMap->kind);
+	int dataMask = pClip->nodes[pMap->node].trk[pMap->kind].dataMask;
+	int chan;
+	for (chan = 0; chan < pMap->chan; ++chan) {
+		if (dataMask & (1 << chan)) {
+			pBlk += sizeof(uint32_t) + (*(const uint32_t*)pBlk * 2 - 1) * sizeof(float);
+		}
+	}
+	return (const uint32_t*)pBlk;
+}
+
+int motRdftInit(MOT_RDFT* pRdft, const MOT_CLIP* pClip, float tol) {
+	int i, j, k, nnod, nfrm, nh, nchn, maxCut, tpad, kind;
+	size_t ncoef, specSize, memSize;
+	uint8_t* pMem;
+	float* pSpec;
+	float* pSmp;
+	MOT_CMAP* pMap;
+	int32_t* pCut;
+	int32_t* pOrd;
+	int32_t* pCnt;
+	if (!pRdft) return 0;
+	memset(pRdft, 0, sizeof(MOT_RDFT));
+	if (!motClipHeaderCk(pClip) || pClip->nfrm < 2) return 0;
+	nnod = pClip->nnod;
+	nfrm = pClip->nfrm;
+	nh = nfrm / 2;
+	nchn = rdftchans(pClip, NULL);
+
+	/* full spectra first, the cuts decide the packed size */
+	specSize = (size_t)nchn * (nh + 1) * 2;
+	pSpec = (float*)malloc((specSize + nfrm) * sizeof(float) + nchn * (sizeof(MOT_CMAP) + 2 * sizeof(int32_t)) + (nh + 3) * sizeof(int32_t));
+	if (!pSpec) return 0;
+	pSmp = pSpec + specSize;
+	pMap = (MOT_CMAP*)(pSmp + nfrm);
+	pCut = (int32_t*)(pMap + nchn);
+	pOrd = pCut + nchn;
+	pCnt = pOrd + nchn;
+	rdftchans(pClip, pMap);
+	maxCut = 1;
+	for (i = 0; i < nchn; ++i) {
+		float* pA = &pSpec[(size_t)i * (nh + 1) * 2];
+		float* pB = pA + nh + 1;
+		int cut = 1;
+		if (pClip->nodes[pMap[i].node].trk[pMap[i].kind].rdft) {
+			/* already a series: taken as stored, no transform */
+			const uint32_t* pBlk = rdftblk(pClip, &pMap[i]);
+			const float* pSrc = (const float*)(pBlk + 1);
+			cut = (int)*pBlk;
+			cut = cut < nh + 1 ? cut : nh + 1;
+			memset(pA, 0, (nh + 1) * 2 * sizeof(float));
+			memcpy(pA, pSrc, cut * sizeof(float));
+			memcpy(pB + 1, pSrc + *pBlk, (cut - 1) * sizeof(float));
+		} else {
+			for (j = 0; j < nfrm; ++j) {
+				pSmp[j] = motGetVec(pClip, pMap[i].node, j, (E_MOT_TRK)pMap[i].kind).s[pMap[i].chan];
+			}
+			motRdftFwd(pA, pB, pSmp, 1, nfrm);
+			/* drop the tail of terms below tol */
+			for (k = 1; k <= nh; ++k) {
+				if (tol <= 0.0f || fabsf(pA[k]) >= tol || fabsf(pB[k]) >= tol) {
+					cut = k + 1;
+				}
+			}
+		}
+		pCut[i] = cut;
+		if (cut > maxCut) maxCut = cut;
+	}
+	tpad = rdftpad(maxCut);
+
+	/* stable counting sort by cut: neighbouring lanes have series of about the same length */
+	memset(pCnt, 0, (nh + 3) * sizeof(int32_t));
+	for (i = 0; i < nchn; ++i) {
+		++pCnt[pCut[i] + 1];
+	}
+	for (k = 0; k <= nh + 1; ++k) {
+		pCnt[k + 1] += pCnt[k];
+	}
+	for (i = 0; i < nchn; ++i) {
+		pOrd[pCnt[pCut[i]]++] = i;
+	}
+	/* a block holds as many terms as its last (longest) channel */
+	ncoef = 0;
+	for (i = 0; i < nchn; i += MOT_RDFT_LANES) {
+		int last = i + MOT_RDFT_LANES < nchn ? i + MOT_RDFT_LANES - 1 : nchn - 1;
+		ncoef += (size_t)pCut[pOrd[last]] * RDFT_BLK_STRIDE;
+	}
+
+	/* trig rows and coefficients first, 32-byte aligned for the SIMD loads */
+	memSize = (tpad * 2 + ncoef) * sizeof(float) + 32;
+	memSize += nchn * (sizeof(MOT_CMAP) + sizeof(int32_t) + sizeof(uint32_t) + sizeof(float)) + nnod * 4 * sizeof(MOT_VEC);
+	pMem = (uint8_t*)malloc(memSize);
+	if (!pMem) {
+		free(pSpec);
+		return 0;
+	}
+	memset(pMem, 0, memSize);
+	pRdft->pMem = pMem;
+	pRdft->pTrig = (float*)(((uintptr_t)pMem + 31) & ~(uintptr_t)31);
+	pRdft->pCoefs = pRdft->pTrig + tpad * 2;
+	pMem = (uint8_t*)(pRdft->pCoefs + ncoef);
+	pRdft->pMap = (MOT_CMAP*)pMem;
+	pMem += nchn * sizeof(MOT_CMAP);
+	pRdft->pCut = (int32_t*)pMem;
+	pMem += nchn * sizeof(int32_t);
+	pRdft->pOffs = (uint32_t*)pMem;
+	pMem += nchn * sizeof(uint32_t);
+	pRdft->pRes = (float*)pMem;
+	pMem += nchn * sizeof(float);
+	for (kind = 0; kind < 3; ++kind) {
+		pRdft->pBase[kind] = (MOT_VEC*)pMem;
+		pMem += nnod * sizeof(MOT_VEC);
+	}
+	pRdft->pLog = (MOT_VEC*)pMem;
+	ncoef = 0;
+	for (i = 0; i < nchn; ++i) {
+		int src = pOrd[i];
+		int lane = i % MOT_RDFT_LANES;
+		const float* pA = &pSpec[(size_t)src * (nh + 1) * 2];
+		const float* pB = pA + nh + 1;
+		float* pDst = &pRdft->pCoefs[ncoef + lane];
+		pRdft->pMap[i] = pMap[src];
+		pRdft->pCut[i] = pCut[src];
+		pRdft->pOffs[i] = (uint32_t)ncoef;
+		pDst[0] = pA[0];
+		for (k = 1; k < pCut[src]; ++k) {
+			pDst[k * RDFT_BLK_STRIDE] = pA[k];
+			pDst[k * RDFT_BLK_STRIDE + MOT_RDFT_LANES] = pB[k];
+		}
+		if (lane == MOT_RDFT_LANES - 1 || i == nchn - 1) {
+			ncoef += (size_t)pCut[src] * RDFT_BLK_STRIDE;
+		}
+	}
+	free(pSpec);
+
+	for (i = 0; i < nnod; ++i) {
+		for (kind = 0; kind < 3; ++kind) {
+			const MOT_TRACK* pTrk = &pClip->nodes[i].trk[kind];
+			float defVal = kind == TRK_SCL ? 1.0f : 0.0f;
+			for (j = 0; j < 3; ++j) {
+				pRdft->pBase[kind][i].s[j] = (pTrk->srcMask & (1 << j)) ? pTrk->vmin.s[j] : defVal;
+			}
+		}
+	}
+	pRdft->pClip = pClip;
+	pRdft->nchn = nchn;
+	pRdft->nfrm = nfrm;
+	pRdft->maxCut = maxCut;
+	pRdft->simd = motGetSIMD();
+	return 1;
+}
+
+void motRdftFree(MOT_RDFT* pRdft) {
+	if (pRdft) {
+		if (pRdft->pMem) {
+			free(pRdft->pMem);
+		}
+		memset(pRdft, 0, sizeof(MOT_RDFT));
+	}
+}
+
+void motRdftSetSIMD(MOT_RDFT* pRdft, E_MOT_SIMD simd) {
+	if (pRdft) {
+		pRdft->simd = motSIMDCk(simd) ? simd : motGetSIMD();
+	}
+}
+
+size_t motRdftCoefSize(const MOT_RDFT* pRdft) {
+	size_t n = 0;
+	int i;
+	if (!pRdft) return 0;
+	for (i = 0; i < pRdft->nchn; ++i) {
+		n += pRdft->pCut[i] * 2 - 1;
+	}
+	return n * sizeof(float);
+}
+
+/* NR ed3 (5.4.6): cos/sin of (k+1)*w from k*w without drift-prone products */
+static void rdfttrig(float* pCos, float* pSin, int i0, int n, float w) {
+	float a = sinf(w * 0.5f);
+	float b = sinf(w);
+	float c = pCos[i0 - 1];
+	float s = pSin[i0 - 1];
+	int i;
+	a = 2.0f * a * a;
+	for (i = i0; i < n; ++i) {
+		float ci = c - (a*c + b*s);
+		float si = s - (a*s - b*c);
+		pCos[i] = ci;
+		pSin[i] = si;
+		c = ci;
+		s = si;
+	}
+}
+
+/* MOT_RDFT_LANES channels of one block, term by term */
+static void rdftlanes(float* pRes, const float* pBlk, const float* pTrig, int cut, int tpad) {
+	const float* pCos = pTrig;
+	const float* pSin = pTrig + tpad;
+	float acc[MOT_RDFT_LANES];
+	int j, k;
+	for (j = 0; j < MOT_RDFT_LANES; ++j) {
+		acc[j] = pBlk[j];
+	}
+	for (k = 1; k < cut; ++k) {
+		const float* pA = &pBlk[k * RDFT_BLK_STRIDE];
+		const float* pB = pA + MOT_RDFT_LANES;
+		float c = pCos[k];
+		float s = pSin[k];
+		for (j = 0; j < MOT_RDFT_LANES; ++j) {
+			acc[j] += pA[j]*c + pB[j]*s;
+		}
+	}
+	for (j = 0; j < MOT_RDFT_LANES; ++j) {
+		pRes[j] = acc[j];
+	}
+}
+
+#if MOT_SIMD_X86
+/* 8 terms per step: the recurrence above with w replaced by 8*w, one lane per term */
+static MOT_TARGET("avx2") void rdfttrigAVX2(float* pCos, float* pSin, int n, float w) {
+	float a = sinf(w * 4.0f);
+	__m256 va = _mm256_set1_ps(2.0f * a * a);
+	__m256 vb = _mm256_set1_ps(sinf(w * 8.0f));
+	__m256 c = _mm256_load_ps(pCos);
+	__m256 s = _mm256_load_ps(pSin);
+	int i;
+	for (i = 8; i < n; i += 8) {
+		__m256 ci = _mm256_sub_ps(c, _mm256_add_ps(_mm256_mul_ps(va, c), _mm256_mul_ps(vb, s)));
+		__m256 si = _mm256_sub_ps(s, _mm256_sub_ps(_mm256_mul_ps(va, s), _mm256_mul_ps(vb, c)));
+		_mm256_store_ps(&pCos[i], ci);
+		_mm256_store_ps(&pSin[i], si);
+		c = ci;
+		s = si;
+	}
+}
+
+static MOT_TARGET("avx2") void rdftlanesAVX2(float* pRes, const float* pBlk, const float* pTrig, int cut, int tpad) {
+	__m256 acc = _mm256_load_ps(pBlk);
+	int k;
+	for (k = 1; k < cut; ++k) {
+		const float* pA = &pBlk[k * RDFT_BLK_STRIDE];
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_load_ps(pA), _mm256_broadcast_ss(&pTrig[k])));
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_load_ps(pA + 8), _mm256_broadcast_ss(&pTrig[tpad + k])));
+	}
+	_mm256_storeu_ps(pRes, acc);
+}
+
+static MOT_TARGET("sse4.1") void rdftlanesSSE4(float* pRes, const float* pBlk, const float* pTrig, int cut, int tpad) {
+	__m128 acc0 = _mm_load_ps(pBlk);
+	__m128 acc1 = _mm_load_ps(pBlk + 4);
+	int k;
+	for (k = 1; k < cut; ++k) {
+		const float* pA = &pBlk[k * RDFT_BLK_STRIDE];
+		__m128 c = _mm_set1_ps(pTrig[k]);
+		__m128 s = _mm_set1_ps(pTrig[tpad + k]);
+		acc0 = _mm_add_ps(acc0, _mm_add_ps(_mm_mul_ps(_mm_load_ps(pA), c), _mm_mul_ps(_mm_load_ps(pA + 8), s)));
+		acc1 = _mm_add_ps(acc1, _mm_add_ps(_mm_mul_ps(_mm_load_ps(pA + 4), c), _mm_mul_ps(_mm_load_ps(pA + 12), s)));
+	}
+	_mm_storeu_ps(pRes, acc0);
+	_mm_storeu_ps(pRes + 4, acc1);
+}
+#endif
+
+#if MOT_SIMD_NEON
+static void rdftlanesNEON(float* pRes, const float* pBlk, const float* pTrig, int cut, int tpad) {
+	float32x4_t acc0 = vld1q_f32(pBlk);
+	float32x4_t acc1 = vld1q_f32(pBlk + 4);
+	int k;
+	for (k = 1; k < cut; ++k) {
+		const float* pA = &pBlk[k * RDFT_BLK_STRIDE];
+		float c = pTrig[k];
+		float s = pTrig[tpad + k];
+		acc0 = vmlaq_n_f32(vmlaq_n_f32(acc0, vld1q_f32(pA), c), vld1q_f32(pA + 8), s);
+		acc1 = vmlaq_n_f32(vmlaq_n_f32(acc1, vld1q_f32(pA + 4), c), vld1q_f32(pA + 12), s);
+	}
+	vst1q_f32(pRes, acc0);
+	vst1q_f32(pRes + 4, acc1);
+}
+#endif
+
+void motRdftEval(MOT_RDFT* pRdft, float frm, float* pRes) {
+	RDFT_LANES_FUNC lanes = rdftlanes;
+	const float* pCoefs;
+	const uint32_t* pOffs;
+	const int32_t* pCut;
+	float* pCos;
+	float* pSin;
+	float f, w;
+	int i, nchn, nblk, tpad;
+	if (!pRdft || !pRdft->pMem || !pRes) return;
+	nchn = pRdft->nchn;
+	tpad = rdftpad(pRdft->maxCut);
+	f = fmodf(fabsf(frm), (float)pRdft->nfrm);
+	w = f * (float)(2.0 * MOT_PI) / (float)pRdft->nfrm;
+	pCos = pRdft->pTrig;
+	pSin = pCos + tpad;
+	pCos[0] = 1.0f;
+	pSin[0] = 0.0f;
+	switch (pRdft->simd) {
+#if MOT_SIMD_X86
+		case SIMD_AVX2:
+			rdfttrig(pCos, pSin, 1, MOT_RDFT_LANES, w);
+			rdfttrigAVX2(pCos, pSin, tpad, w);
+			lanes = rdftlanesAVX2;
+			break;
+		case SIMD_SSE4:
+			rdfttrig(pCos, pSin, 1, tpad, w);
+			lanes = rdftlanesSSE4;
+			break;
+#endif
+#if MOT_SIMD_NEON
+		case SIMD_NEON:
+			rdfttrig(pCos, pSin, 1, tpad, w);
+			lanes = rdftlanesNEON;
+			break;
+#endif
+		default:
+			rdfttrig(pCos, pSin, 1, tpad, w);
+			break;
+	}
+	pCoefs = pRdft->pCoefs;
+	pOffs = pRdft->pOffs;
+	pCut = pRdft->pCut;
+	nblk = (nchn + MOT_RDFT_LANES - 1) / MOT_RDFT_LANES;
+#ifdef _OPENMP
+#	pragma omp parallel for schedule(static) if (nchn * tpad >= RDFT_OMP_MIN_WORK)
+#endif
+	for (i = 0; i < nblk; ++i) {
+		int ich = i * MOT_RDFT_LANES;
+		int n = nchn - ich < MOT_RDFT_LANES ? nchn - ich : MOT_RDFT_LANES;
+		int cut = pCut[ich + n - 1];
+		if (n == MOT_RDFT_LANES) {
+			lanes(&pRes[ich], &pCoefs[pOffs[ich]], pCos, cut, tpad);
+		} else {
+			/* last block: unused lanes hold zeros */
+			float res[MOT_RDFT_LANES];
+			lanes(res, &pCoefs[pOffs[ich]], pCos, cut, tpad);
+			memcpy(&pRes[ich], res, n * sizeof(float));
+		}
+	}
+}
+
+void motRdftEvalPose(MOT_RDFT* pRdft, float frm, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	MOT_VEC* pDst[3];
+	int i, nnod;
+	if (!pRdft || !pRdft->pMem) return;
+	nnod = pRdft->pClip->nnod;
+	pDst[TRK_POS] = pPos;
+	pDst[TRK_ROT] = pRot ? pRdft->pLog : NULL;
+	pDst[TRK_SCL] = pScl;
+	for (i = 0; i < 3; ++i) {
+		if (pDst[i]) {
+			memcpy(pDst[i], pRdft->pBase[i], nnod * sizeof(MOT_VEC));
+		}
+	}
+	motRdftEval(pRdft, frm, pRdft->pRes);
+	for (i = 0; i < pRdft->nchn; ++i) {
+		const MOT_CMAP* pMap = &pRdft->pMap[i];
+		if (pDst[pMap->kind]) {
+			pDst[pMap->kind][pMap->node].s[pMap->chan] = pRdft->pRes[i];
+		}
+	}
+	if (pRot) {
+		motQuatExpAry(pRot, pRdft->pLog, nnod);
+	}
+}
@@ -0,0 +1,48 @@
+/*
+ * Motion Clip truncated RDFT evaluation
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ */
+
+#ifndef MOTRDFT_H
+#define MOTRDFT_H
+
+#include "motclip.h"
+
+/* channels evaluated together, one per SIMD lane; trig rows are padded to a multiple of it */
+#define MOT_RDFT_LANES (8)
+
+/*
+ * Animated channels of a clip as truncated Fourier series over the loop:
+ * v(frm) = a[0] + sum(k = 1 .. cut-1) a[k]*cos(k*w) + b[k]*sin(k*w), w = 2*pi*frm/nfrm.
+ * Channels are ordered by cut and packed MOT_RDFT_LANES to a block, term-major:
+ * term k of a block is a[k] of its channels, then b[k] (b[0] = 0), and a block holds
+ * as many terms as its longest series. Channel i is lane i % MOT_RDFT_LANES of the
+ * block at pOffs[i]: a[k] = pCoefs[pOffs[i] + k*2*MOT_RDFT_LANES + i % MOT_RDFT_LANES].
+ * pTrig holds cos(k*w) and sin(k*w) of the last evaluated frame, shared by all channels.
+ * Tracks stored as series (motClipRdft) are taken as is, tol only cuts transformed tracks.
+ */
+typedef struct _MOT_RDFT {
+	const MOT_CLIP* pClip;
+	int       nchn;
+	int       nfrm;
+	int       maxCut;
+	E_MOT_SIMD simd;
+	MOT_CMAP* pMap;
+	int32_t*  pCut;
+	uint32_t* pOffs;
+	float*    pCoefs;
+	float*    pTrig;
+	float*    pRes;
+	MOT_VEC*  pBase[3];
+	MOT_VEC*  pLog;
+	void*     pMem;
+} MOT_RDFT;
+
+MOT_EXTERN_FUNC int motRdftInit(MOT_RDFT* pRdft, const MOT_CLIP* pClip, float tol);
+MOT_EXTERN_FUNC void motRdftFree(MOT_RDFT* pRdft);
+MOT_EXTERN_FUNC void motRdftSetSIMD(MOT_RDFT* pRdft, E_MOT_SIMD simd);
+MOT_EXTERN_FUNC void motRdftEval(MOT_RDFT* pRdft, float frm, float* pRes);
+MOT_EXTERN_FUNC void motRdftEvalPose(MOT_RDFT* pRdft, float frm, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl);
+MOT_EXTERN_FUNC size_t motRdftCoefSize(const MOT_RDFT* pRdft);
+
+#endif /* MOTRDFT_H */
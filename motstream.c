@@ -0,0 +1,556 @@
+/*
+ * Motion Clip time-blocked streaming
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ *
+ * Only a window of nwin blocks is resident: evaluations keep the prefetch
+ * thread reading the next nwin - 1 blocks ahead of the current one into the
+ * least recently used slots while the current block plays. A block that is
+ * not resident (seek, window too small for the playback speed) is read
+ * synchronously and counted as a stall.
+ * POSIX builds need -pthread.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#	define _GNU_SOURCE
+#endif
+
+#include "motstream.h"
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN 1
+#	define NOMINMAX
+#	include <Windows.h>
+#else
+#	include <pthread.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+const char g_motStmFmt[4] = { 'M', 'S', 'T', 'M' };
+
+#define STM_MAX_WIN (64)
+
+typedef enum _E_STM_SLOT { STM_EMPTY, STM_LOADING, STM_READY } E_STM_SLOT;
+
+typedef struct _STM_SLOT {
+	int      blk;
+	int      state;
+	uint32_t used; /* LRU tick */
+	float*   pData;
+} STM_SLOT;
+
+struct _MOT_STREAM {
+	MOT_STM         hdr;
+	uint8_t*        pHead; /* file bytes up to the first block */
+	const MOT_CLIP* pClip;
+	const MOT_CMAP* pMap;
+	const uint32_t* pIndex;
+	int             nnod;
+	int             nfrm;
+	int             nwin;
+	uint32_t        tick;
+	STM_SLOT        slots[STM_MAX_WIN];
+	size_t          slotSize;
+	float*          pWork; /* pos, log rot, scl per node, constants preset */
+	MOT_VEC*        pBase;
+	int32_t*        pDst;
+	void*           pSlotMem;
+	int             req;   /* slot queued for the prefetch thread, -1: none */
+	int             quit;
+	MOT_STREAM_STATS stats;
+#if defined(_WIN32)
+	HANDLE          hFile;
+	HANDLE          hThread;
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE wake;
+	CONDITION_VARIABLE done;
+#else
+	int             fd;
+	pthread_t       thread;
+	pthread_mutex_t lock;
+	pthread_cond_t  wake;
+	pthread_cond_t  done;
+#endif
+};
+
+#if defined(_WIN32)
+#	define STM_LOCK(_s) EnterCriticalSection(&(_s)->lock)
+#	define STM_UNLOCK(_s) LeaveCriticalSection(&(_s)->lock)
+#	define STM_WAIT(_s, _cv) SleepConditionVariableCS(&(_s)->_cv, &(_s)->lock, INFINITE)
+#	define STM_SIGNAL(_s, _cv) WakeConditionVariable(&(_s)->_cv)
+#	define STM_BROADCAST(_s, _cv) WakeAllConditionVariable(&(_s)->_cv)
+#else
+#	define STM_LOCK(_s) pthread_mutex_lock(&(_s)->lock)
+#	define STM_UNLOCK(_s) pthread_mutex_unlock(&(_s)->lock)
+#	define STM_WAIT(_s, _cv) pthread_cond_wait(&(_s)->_cv, &(_s)->lock)
+#	define STM_SIGNAL(_s, _cv) pthread_cond_signal(&(_s)->_cv)
+#	define STM_BROADCAST(_s, _cv) pthread_cond_broadcast(&(_s)->_cv)
+#endif
+
+static size_t alignsz(size_t size, size_t align) {
+	return (size + align - 1) & ~(align - 1);
+}
+
+int motStmHeaderCk(const MOT_STM* pStm) {
+	int i;
+	if (!pStm) return 0;
+	for (i = 0; i < 4; ++i) {
+		if (pStm->fmt[i] != g_motStmFmt[i]) return 0;
+	}
+	return 1;
+}
+
+/* frames stored in block blk, including the shared frame at its end */
+static int stmblkfrms(int blkFrms, int nfrm, int blk) {
+	int n = nfrm - blk * blkFrms;
+	return (n < blkFrms ? n : blkFrms) + 1;
+}
+
+static int stmchans(const MOT_CLIP* pClip, MOT_CMAP* pMap) {
+	int i, kind, chan;
+	int n = 0;
+	for (kind = 0; kind < 3; ++kind) {
+		for (i = 0; i < (int)pClip->nnod; ++i) {
+			const MOT_TRACK* pTrk = &pClip->nodes[i].trk[kind];
+			if (!pTrk->srcMask || !motGetTrackData(pClip, i, (E_MOT_TRK)kind)) continue;
+			for (chan = 0; chan < 3; ++chan) {
+				if (pTrk->dataMask & (1 << chan)) {
+					if (pMap) {
+						pMap[n].node = (uint16_t)i;
+						pMap[n].kind = (uint8_t)kind;
+						pMap[n].chan = (uint8_t)chan;
+					}
+					++n;
+				}
+			}
+		}
+	}
+	return n;
+}
+
+/* any clip encoding: channels are sampled at frames with motGetVec */
+MOT_STM* motStmBuild(const MOT_CLIP* pClip, int blkFrms) {
+	MOT_STM* pStm;
+	MOT_CLIP* pHdrClip;
+	MOT_CMAP* pMap;
+	uint32_t* pIndex;
+	uint8_t* pTop;
+	size_t clipSize, nodesSize, offs, memSize;
+	int i, kind, blk, j, nnod, nfrm, nblk, nchn;
+	if (!motClipHeaderCk(pClip) || blkFrms < 1 || pClip->nfrm < 1) return NULL;
+	nnod = pClip->nnod;
+	nfrm = pClip->nfrm;
+	nblk = (nfrm + blkFrms - 1) / blkFrms;
+	nchn = stmchans(pClip, NULL);
+	nodesSize = offsetof(MOT_CLIP, nodes) + nnod * sizeof(MOT_NODE);
+	clipSize = alignsz(nodesSize, 4) + (pClip->hash ? nnod * sizeof(uint32_t) : 0);
+	offs = alignsz(sizeof(MOT_STM), 0x10);
+	offs += alignsz(clipSize, 0x10);
+	offs += alignsz(nchn * sizeof(MOT_CMAP), 0x10);
+	offs += alignsz((nblk + 1) * sizeof(uint32_t), 0x10);
+	memSize = offs;
+	for (blk = 0; blk < nblk; ++blk) {
+		memSize += (size_t)stmblkfrms(blkFrms, nfrm, blk) * nchn * sizeof(float);
+	}
+	if (memSize > UINT32_MAX) return NULL;
+	pStm = (MOT_STM*)calloc(1, memSize);
+	if (!pStm) return NULL;
+	pTop = (uint8_t*)pStm;
+	memcpy(pStm->fmt, g_motStmFmt, 4);
+	pStm->size = (uint32_t)memSize;
+	pStm->nblk = nblk;
+	pStm->blkFrms = blkFrms;
+	pStm->nchn = nchn;
+	pStm->clip = (uint32_t)alignsz(sizeof(MOT_STM), 0x10);
+	pStm->map = pStm->clip + (uint32_t)alignsz(clipSize, 0x10);
+	pStm->index = pStm->map + (uint32_t)alignsz(nchn * sizeof(MOT_CMAP), 0x10);
+
+	/* header clip: node info and constants, no data */
+	pHdrClip = (MOT_CLIP*)&pTop[pStm->clip];
+	memcpy(pHdrClip, pClip, nodesSize);
+	pHdrClip->size = (uint32_t)clipSize;
+	pHdrClip->hash = 0;
+	pHdrClip->eval = 0;
+	pHdrClip->seq = 0;
+	if (pClip->hash) {
+		pHdrClip->hash = (uint32_t)alignsz(nodesSize, 4);
+		memcpy((uint8_t*)pHdrClip + pHdrClip->hash, (const uint8_t*)pClip + pClip->hash, nnod * sizeof(uint32_t));
+	}
+	for (i = 0; i < nnod; ++i) {
+		MOT_NODE* pNode = &pHdrClip->nodes[i];
+		for (kind = 0; kind < 3; ++kind) {
+			MOT_TRACK* pTrk = &pNode->trk[kind];
+			pNode->offs[kind] = 0;
+			pTrk->qbits = 0;
+			pTrk->spline = 0;
+			pTrk->rdft = 0;
+		}
+	}
+
+	pMap = (MOT_CMAP*)&pTop[pStm->map];
+	stmchans(pClip, pMap);
+	pIndex = (uint32_t*)&pTop[pStm->index];
+	for (blk = 0; blk < nblk; ++blk) {
+		float* pDst = (float*)&pTop[offs];
+		int nf = stmblkfrms(blkFrms, nfrm, blk);
+		pIndex[blk] = (uint32_t)offs;
+		for (j = 0; j < nf; ++j) {
+			int fno = (blk * blkFrms + j) % nfrm;
+			for (i = 0; i < nchn; ++i) {
+				const MOT_CMAP* pCh = &pMap[i];
+				*pDst++ = motGetVec(pClip, pCh->node, fno, (E_MOT_TRK)pCh->kind).s[pCh->chan];
+			}
+		}
+		offs += (size_t)nf * nchn * sizeof(float);
+	}
+	pIndex[nblk] = (uint32_t)offs;
+	return pStm;
+}
+
+static int stmread(MOT_STREAM* pStrm, void* pDst, uint32_t offs, size_t size) {
+	uint8_t* p = (uint8_t*)pDst;
+	while (size > 0) {
+#if defined(_WIN32)
+		OVERLAPPED ovl;
+		DWORD nread = 0;
+		DWORD nreq = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+		memset(&ovl, 0, sizeof(ovl));
+		ovl.Offset = offs;
+		if (!ReadFile(pStrm->hFile, p, nreq, &nread, &ovl) || nread == 0) return 0;
+#else
+		ssize_t nread = pread(pStrm->fd, p, size, (off_t)offs);
+		if (nread <= 0) return 0;
+#endif
+		p += nread;
+		offs += (uint32_t)nread;
+		size -= (size_t)nread;
+	}
+	return 1;
+}
+
+static int stmloadblk(MOT_STREAM* pStrm, STM_SLOT* pSlot, int blk) {
+	uint32_t org = pStrm->pIndex[blk];
+	return stmread(pStrm, pSlot->pData, org, pStrm->pIndex[blk + 1] - org);
+}
+
+static void prefetchloop(MOT_STREAM* pStrm) {
+	while (1) {
+		STM_SLOT* pSlot;
+		int ok;
+		STM_LOCK(pStrm);
+		while (pStrm->req < 0 && !pStrm->quit) {
+			STM_WAIT(pStrm, wake);
+		}
+		if (pStrm->quit) {
+			STM_UNLOCK(pStrm);
+			break;
+		}
+		pSlot = &pStrm->slots[pStrm->req];
+		pStrm->req = -1;
+		STM_UNLOCK(pStrm);
+		ok = stmloadblk(pStrm, pSlot, pSlot->blk);
+		STM_LOCK(pStrm);
+		pSlot->state = ok ? STM_READY : STM_EMPTY;
+		if (ok) {
+			++pStrm->stats.nload;
+			++pStrm->stats.nprefetch;
+		}
+		STM_BROADCAST(pStrm, done);
+		STM_UNLOCK(pStrm);
+	}
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI prefetchfunc(LPVOID pData) {
+	prefetchloop((MOT_STREAM*)pData);
+	return 0;
+}
+#else
+static void* prefetchfunc(void* pData) {
+	prefetchloop((MOT_STREAM*)pData);
+	return NULL;
+}
+#endif
+
+static int stmfind(const MOT_STREAM* pStrm, int blk) {
+	int i;
+	for (i = 0; i < pStrm->nwin; ++i) {
+		if (pStrm->slots[i].state != STM_EMPTY && pStrm->slots[i].blk == blk) return i;
+	}
+	return -1;
+}
+
+/* least recently used slot that is not loading and not one of the nkeep blocks from cur on */
+static int stmvictim(const MOT_STREAM* pStrm, int cur, int nkeep) {
+	int i;
+	int res = -1;
+	int nblk = (int)pStrm->hdr.nblk;
+	for (i = 0; i < pStrm->nwin; ++i) {
+		const STM_SLOT* pSlot = &pStrm->slots[i];
+		if (pSlot->state == STM_LOADING) continue;
+		if (pSlot->state == STM_EMPTY) return i;
+		if ((pSlot->blk - cur + nblk) % nblk < nkeep) continue;
+		if (res < 0 || (int32_t)(pSlot->used - pStrm->slots[res].used) < 0) {
+			res = i;
+		}
+	}
+	return res;
+}
+
+/* resident slot of blk, waits for or reads it if necessary; called with the lock held */
+static STM_SLOT* stmacquire(MOT_STREAM* pStrm, int blk) {
+	STM_SLOT* pSlot;
+	int islot = stmfind(pStrm, blk);
+	if (islot >= 0 && pStrm->slots[islot].state == STM_LOADING) {
+		++pStrm->stats.nstall;
+		while (pStrm->slots[islot].state == STM_LOADING) {
+			STM_WAIT(pStrm, done);
+		}
+		islot = stmfind(pStrm, blk);
+	}
+	if (islot < 0) {
+		int ok;
+		while ((islot = stmvictim(pStrm, blk, 0)) < 0) {
+			STM_WAIT(pStrm, done);
+		}
+		pSlot = &pStrm->slots[islot];
+		pSlot->blk = blk;
+		pSlot->state = STM_LOADING;
+		++pStrm->stats.nstall;
+		STM_UNLOCK(pStrm);
+		ok = stmloadblk(pStrm, pSlot, blk);
+		STM_LOCK(pStrm);
+		pSlot->state = ok ? STM_READY : STM_EMPTY;
+		if (!ok) return NULL;
+		++pStrm->stats.nload;
+	}
+	pSlot = &pStrm->slots[islot];
+	pSlot->used = ++pStrm->tick;
+	return pSlot;
+}
+
+/* read-ahead of the nwin - 1 blocks after cur, one request in flight at a time */
+static void stmprefetch(MOT_STREAM* pStrm, int cur) {
+	int d, islot;
+	int nblk = (int)pStrm->hdr.nblk;
+	if (pStrm->req >= 0) return;
+	for (d = 1; d < pStrm->nwin && d < nblk; ++d) {
+		int blk = (cur + d) % nblk;
+		if (stmfind(pStrm, blk) >= 0) continue;
+		islot = stmvictim(pStrm, cur, d);
+		if (islot < 0) return;
+		pStrm->slots[islot].blk = blk;
+		pStrm->slots[islot].state = STM_LOADING;
+		pStrm->slots[islot].used = ++pStrm->tick;
+		pStrm->req = islot;
+		STM_SIGNAL(pStrm, wake);
+		return;
+	}
+}
+
+static int streaminit(MOT_STREAM* pStrm, const char* pPath) {
+	size_t headSize, maxBlk, workSize;
+	int i, kind, chan;
+	uint8_t* pSlotMem;
+#if defined(_WIN32)
+	pStrm->hFile = CreateFileA(pPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (pStrm->hFile == INVALID_HANDLE_VALUE) return 0;
+#else
+	pStrm->fd = open(pPath, O_RDONLY);
+	if (pStrm->fd < 0) return 0;
+#endif
+	if (!stmread(pStrm, &pStrm->hdr, 0, sizeof(MOT_STM)) || !motStmHeaderCk(&pStrm->hdr)) return 0;
+	if (pStrm->hdr.nblk < 1 || pStrm->hdr.blkFrms < 1) return 0;
+	if (pStrm->hdr.index > pStrm->hdr.size || (pStrm->hdr.nblk + 1) > (pStrm->hdr.size - pStrm->hdr.index) / sizeof(uint32_t)) return 0;
+	if ((pStrm->hdr.clip | pStrm->hdr.map | pStrm->hdr.index) & 3) return 0;
+	headSize = pStrm->hdr.index + (pStrm->hdr.nblk + 1) * sizeof(uint32_t);
+	pStrm->pHead = (uint8_t*)malloc(headSize);
+	if (!pStrm->pHead || !stmread(pStrm, pStrm->pHead, 0, headSize)) return 0;
+	pStrm->pClip = (const MOT_CLIP*)&pStrm->pHead[pStrm->hdr.clip];
+	pStrm->pMap = (const MOT_CMAP*)&pStrm->pHead[pStrm->hdr.map];
+	pStrm->pIndex = (const uint32_t*)&pStrm->pHead[pStrm->hdr.index];
+	if (pStrm->hdr.clip > pStrm->hdr.map || !motClipMemCk(pStrm->pClip, pStrm->hdr.map - pStrm->hdr.clip)) return 0;
+	if (pStrm->hdr.map > pStrm->hdr.index || pStrm->hdr.nchn > (pStrm->hdr.index - pStrm->hdr.map) / sizeof(MOT_CMAP)) return 0;
+	pStrm->nnod = (int)pStrm->pClip->nnod;
+	pStrm->nfrm = (int)pStrm->pClip->nfrm;
+	if ((uint64_t)pStrm->hdr.nblk * pStrm->hdr.blkFrms < (uint64_t)pStrm->nfrm || (uint64_t)(pStrm->hdr.nblk - 1) * pStrm->hdr.blkFrms >= (uint64_t)pStrm->nfrm) return 0;
+	maxBlk = 0;
+	for (i = 0; i < (int)pStrm->hdr.nblk; ++i) {
+		size_t blkSize = (size_t)stmblkfrms((int)pStrm->hdr.blkFrms, pStrm->nfrm, i) * pStrm->hdr.nchn * sizeof(float);
+		if (pStrm->pIndex[i] < headSize || pStrm->pIndex[i] > pStrm->hdr.size || pStrm->pIndex[i + 1] < pStrm->pIndex[i]) return 0;
+		if (pStrm->pIndex[i + 1] - pStrm->pIndex[i] != blkSize || pStrm->pIndex[i + 1] > pStrm->hdr.size) return 0;
+		if (blkSize > maxBlk) maxBlk = blkSize;
+	}
+	for (i = 0; i < (int)pStrm->hdr.nchn; ++i) {
+		const MOT_CMAP* pCh = &pStrm->pMap[i];
+		if (pCh->node >= pStrm->nnod || pCh->kind > 2 || pCh->chan > 2) return 0;
+	}
+
+	/* window slots and the pose work area in one allocation */
+	pStrm->slotSize = alignsz(maxBlk, 0x40);
+	workSize = pStrm->nnod * 3 * sizeof(MOT_VEC) * 2 + pStrm->hdr.nchn * sizeof(int32_t);
+	pSlotMem = (uint8_t*)malloc(pStrm->slotSize * pStrm->nwin + workSize + 0x40);
+	if (!pSlotMem) return 0;
+	pStrm->pSlotMem = pSlotMem;
+	pSlotMem = (uint8_t*)alignsz((size_t)pSlotMem, 0x40);
+	for (i = 0; i < pStrm->nwin; ++i) {
+		pStrm->slots[i].blk = -1;
+		pStrm->slots[i].state = STM_EMPTY;
+		pStrm->slots[i].pData = (float*)&pSlotMem[pStrm->slotSize * i];
+	}
+	pStrm->pWork = (float*)&pSlotMem[pStrm->slotSize * pStrm->nwin];
+	pStrm->pBase = (MOT_VEC*)(pStrm->pWork + pStrm->nnod * 9);
+	pStrm->pDst = (int32_t*)(pStrm->pBase + pStrm->nnod * 3);
+	for (kind = 0; kind < 3; ++kind) {
+		float defVal = kind == TRK_SCL ? 1.0f : 0.0f;
+		for (i = 0; i < pStrm->nnod; ++i) {
+			const MOT_TRACK* pTrk = &pStrm->pClip->nodes[i].trk[kind];
+			MOT_VEC* pVal = &pStrm->pBase[kind*pStrm->nnod + i];
+			for (chan = 0; chan < 3; ++chan) {
+				pVal->s[chan] = (pTrk->srcMask & (1 << chan)) ? pTrk->vmin.s[chan] : defVal;
+			}
+		}
+	}
+	for (i = 0; i < (int)pStrm->hdr.nchn; ++i) {
+		const MOT_CMAP* pCh = &pStrm->pMap[i];
+		pStrm->pDst[i] = (pCh->kind*pStrm->nnod + pCh->node)*3 + pCh->chan;
+	}
+	pStrm->stats.resident = headSize + pStrm->slotSize * pStrm->nwin;
+	return 1;
+}
+
+MOT_STREAM* motStreamOpen(const char* pPath, int nwin) {
+	MOT_STREAM* pStrm;
+	int ok;
+	if (!pPath) return NULL;
+	if (nwin < 2) nwin = 2;
+	if (nwin > STM_MAX_WIN) nwin = STM_MAX_WIN;
+	pStrm = (MOT_STREAM*)calloc(1, sizeof(MOT_STREAM));
+	if (!pStrm) return NULL;
+	pStrm->nwin = nwin;
+	pStrm->req = -1;
+#if defined(_WIN32)
+	pStrm->hFile = INVALID_HANDLE_VALUE;
+#else
+	pStrm->fd = -1;
+#endif
+	ok = streaminit(pStrm, pPath);
+	if (ok) {
+#if defined(_WIN32)
+		InitializeCriticalSection(&pStrm->lock);
+		InitializeConditionVariable(&pStrm->wake);
+		InitializeConditionVariable(&pStrm->done);
+		pStrm->hThread = CreateThread(NULL, 0, prefetchfunc, pStrm, 0, NULL);
+		ok = pStrm->hThread != NULL;
+		if (!ok) {
+			DeleteCriticalSection(&pStrm->lock);
+		}
+#else
+		pthread_mutex_init(&pStrm->lock, NULL);
+		pthread_cond_init(&pStrm->wake, NULL);
+		pthread_cond_init(&pStrm->done, NULL);
+		ok = pthread_create(&pStrm->thread, NULL, prefetchfunc, pStrm) == 0;
+		if (!ok) {
+			pthread_mutex_destroy(&pStrm->lock);
+			pthread_cond_destroy(&pStrm->wake);
+			pthread_cond_destroy(&pStrm->done);
+		}
+#endif
+	}
+	if (!ok) {
+#if defined(_WIN32)
+		if (pStrm->hFile != INVALID_HANDLE_VALUE) CloseHandle(pStrm->hFile);
+#else
+		if (pStrm->fd >= 0) close(pStrm->fd);
+#endif
+		free(pStrm->pHead);
+		free(pStrm->pSlotMem);
+		free(pStrm);
+		return NULL;
+	}
+	return pStrm;
+}
+
+void motStreamClose(MOT_STREAM* pStrm) {
+	if (!pStrm) return;
+	STM_LOCK(pStrm);
+	pStrm->quit = 1;
+	STM_BROADCAST(pStrm, wake);
+	STM_UNLOCK(pStrm);
+#if defined(_WIN32)
+	WaitForSingleObject(pStrm->hThread, INFINITE);
+	CloseHandle(pStrm->hThread);
+	DeleteCriticalSection(&pStrm->lock);
+	CloseHandle(pStrm->hFile);
+#else
+	pthread_join(pStrm->thread, NULL);
+	pthread_mutex_destroy(&pStrm->lock);
+	pthread_cond_destroy(&pStrm->wake);
+	pthread_cond_destroy(&pStrm->done);
+	close(pStrm->fd);
+#endif
+	free(pStrm->pHead);
+	free(pStrm->pSlotMem);
+	free(pStrm);
+}
+
+const MOT_CLIP* motStreamGetClip(const MOT_STREAM* pStrm) {
+	return pStrm ? pStrm->pClip : NULL;
+}
+
+/* pose at frm, same layout as motEvalPose; 0 if the block could not be read */
+int motStreamEval(MOT_STREAM* pStrm, float frm, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl) {
+	STM_SLOT* pSlot;
+	const float* pSrc;
+	const float* pNext;
+	float* pWork;
+	float f, t;
+	int i, fno, blk, nchn, nnod, nblk;
+	if (!pStrm) return 0;
+	nnod = pStrm->nnod;
+	nchn = (int)pStrm->hdr.nchn;
+	nblk = (int)pStrm->hdr.nblk;
+	f = fmodf(fabsf(frm), (float)pStrm->nfrm);
+	fno = (int)f;
+	t = f - (float)fno;
+	blk = fno / (int)pStrm->hdr.blkFrms;
+	STM_LOCK(pStrm);
+	pSlot = stmacquire(pStrm, blk);
+	if (pSlot && nblk > 1) {
+		stmprefetch(pStrm, blk);
+	}
+	STM_UNLOCK(pStrm);
+	if (!pSlot) return 0;
+
+	/* only this thread evicts slots, the current block stays put until the next call */
+	pWork = pStrm->pWork;
+	memcpy(pWork, pStrm->pBase, nnod * 3 * sizeof(MOT_VEC));
+	pSrc = pSlot->pData + (size_t)(fno - blk * (int)pStrm->hdr.blkFrms) * nchn;
+	pNext = pSrc + nchn;
+	if (t != 0.0f) {
+		for (i = 0; i < nchn; ++i) {
+			pWork[pStrm->pDst[i]] = pSrc[i] + (pNext[i] - pSrc[i]) * t;
+		}
+	} else {
+		for (i = 0; i < nchn; ++i) {
+			pWork[pStrm->pDst[i]] = pSrc[i];
+		}
+	}
+	if (pPos) {
+		memcpy(pPos, pWork, nnod * sizeof(MOT_VEC));
+	}
+	if (pRot) {
+		motQuatExpAry(pRot, (const MOT_VEC*)pWork + nnod, nnod);
+	}
+	if (pScl) {
+		memcpy(pScl, (const MOT_VEC*)pWork + nnod * 2, nnod * sizeof(MOT_VEC));
+	}
+	return 1;
+}
+
+void motStreamGetStats(const MOT_STREAM* pStrm, MOT_STREAM_STATS* pStats) {
+	if (!pStrm || !pStats) return;
+	STM_LOCK((MOT_STREAM*)pStrm);
+	*pStats = pStrm->stats;
+	STM_UNLOCK((MOT_STREAM*)pStrm);
+}
@@ -0,0 +1,66 @@
+/*
+ * Motion Clip time-blocked streaming
+ * Author: Sergey Chaban <sergey.chaban@gmail.com>
+ */
+
+#ifndef MOTSTREAM_H
+#define MOTSTREAM_H
+
+#include "motclip.h"
+
+/*
+ * Streaming clip file: a header-only MOT_CLIP (names, orders, constant
+ * values, no track data) followed by time blocks. Block b holds frames
+ * b*blkFrms .. b*blkFrms + blkFrms of every animated channel, frame-major,
+ * so its last frame repeats as the first of the next block (the loop's
+ * frame 0 for the last block) and one block is enough to lerp any of its frames.
+ * Rotations are stored as log vectors, as in MCLP tracks.
+ */
+typedef struct _MOT_STM {
+	char     fmt[4];
+	uint32_t size;
+	uint32_t nblk;
+	uint32_t blkFrms;
+	uint32_t nchn;  /* animated channels, values per stored frame */
+	uint32_t clip;  /* -> MOT_CLIP header */
+	uint32_t map;   /* -> MOT_CMAP[nchn]: pos, rot, scl channels */
+	uint32_t index; /* -> uint32 block offsets [nblk + 1], the last one is the end */
+} MOT_STM;
+
+typedef struct _MOT_STREAM MOT_STREAM;
+
+typedef struct _MOT_STREAM_STATS {
+	int    nload;     /* blocks read */
+	int    nprefetch; /* of those, read ahead by the prefetch thread */
+	int    nstall;    /* evaluations that had to wait for their block */
+	size_t resident;  /* window memory: header + nwin block slots */
+} MOT_STREAM_STATS;
+
+/*
+ * Stalls in forward playback: when the prefetch thread has a CPU to itself
+ * and a block plays for longer than it takes to read one, only the first
+ * block is waited for. With one CPU the prefetch thread mostly runs while
+ * the player is blocked, so any block entered may stall: the bound is then
+ * one stall per block entered.
+ */
+
+MOT_EXTERN_DATA const char g_motStmFmt[4];
+
+MOT_EXTERN_FUNC int motStmHeaderCk(const MOT_STM* pStm);
+MOT_EXTERN_FUNC MOT_STM* motStmBuild(const MOT_CLIP* pClip, int blkFrms);
+
+/*
+ * A MOT_STREAM is not reentrant: motStreamEval decodes through one pWork
+ * buffer per stream and reads the current block after dropping the lock,
+ * relying on the calling thread being the only one that picks slots to
+ * evict (the prefetch thread just fills the slot it is handed). Evaluate
+ * a stream from one thread at a time, or open one stream per thread;
+ * motStreamGetStats may be called from any thread.
+ */
+MOT_EXTERN_FUNC MOT_STREAM* motStreamOpen(const char* pPath, int nwin);
+MOT_EXTERN_FUNC void motStreamClose(MOT_STREAM* pStrm);
+MOT_EXTERN_FUNC const MOT_CLIP* motStreamGetClip(const MOT_STREAM* pStrm);
+MOT_EXTERN_FUNC int motStreamEval(MOT_STREAM* pStrm, float frm, MOT_VEC* pPos, MOT_QUAT* pRot, MOT_VEC* pScl);
+MOT_EXTERN_FUNC void motStreamGetStats(const MOT_STREAM* pStrm, MOT_STREAM_STATS* pStats);
+
+#endif /* MOTSTREAM_H */